@@ -189,6 +189,23 @@ BASE_CFLAGS += -pg
 BASE_LDFLAGS += -pg
 endif
 
+# enable C declaration parser counters and phase timers
+ifeq ($(ENABLE_CDCL_STATS),)
+$(info C declaration parser statistics: Disabled)
+else
+$(info C declaration parser statistics: Enabled)
+BASE_CFLAGS += -DPDXCP_CDCL_ENABLE_STATS
+endif
+
+# default string map hash function, wyhash or fnv1a
+STRMAP_HASH ?= wyhash
+ifeq ($(STRMAP_HASH),fnv1a)
+BASE_CFLAGS += -DPDXCP_STRMAP_HASH_FNV1A
+else ifneq ($(STRMAP_HASH),wyhash)
+$(error STRMAP_HASH must be wyhash or fnv1a)
+endif
+$(info String map hash: $(STRMAP_HASH))
+
 # base C++ compile flags. expand simply to avoid picking up further updates
 BASE_CXXFLAGS := $(BASE_CFLAGS)
 
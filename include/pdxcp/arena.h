@@ -0,0 +1,101 @@
+/**
+ * @file arena.h
+ * @author Derek Huang
+ * @brief C/C++ header for a bump-pointer memory arena
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_ARENA_H_
+#define PDXCP_ARENA_H_
+
+#include <stddef.h>
+
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Default number of usable bytes in each arena block.
+ */
+#define PDXCP_ARENA_BLOCK_SIZE 4096
+
+/**
+ * Opaque arena block type.
+ */
+typedef struct pdxcp_arena_block pdxcp_arena_block;
+
+/**
+ * Struct for a memory arena that allocates by bumping a pointer.
+ *
+ * Memory is obtained from a list of large blocks and is never freed piecemeal.
+ * Instead, the entire arena is reset for reuse or destroyed all at once. Any
+ * blocks allocated are retained across resets so that steady-state use of a
+ * reset arena performs no further calls to `malloc`.
+ *
+ * @param head First block in the block list
+ * @param cur Block currently being allocated from
+ * @param block_size Minimum number of usable bytes in each new block
+ */
+typedef struct {
+  pdxcp_arena_block *head;
+  pdxcp_arena_block *cur;
+  size_t block_size;
+} pdxcp_arena;
+
+/**
+ * Initialize a `pdxcp_arena` structure.
+ *
+ * No memory is allocated until the first allocation is made from the arena.
+ *
+ * @param arena Arena to initialize
+ * @param block_size Minimum usable bytes per block, if zero then
+ *  `PDXCP_ARENA_BLOCK_SIZE` is used instead
+ */
+void
+pdxcp_arena_init(pdxcp_arena *arena, size_t block_size) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_arena` structure, freeing all its blocks.
+ *
+ * If the struct is to be reused, `pdxcp_arena_init` must first be called.
+ *
+ * @param arena Arena to destroy
+ */
+void
+pdxcp_arena_destroy(pdxcp_arena *arena) PDXCP_NOEXCEPT;
+
+/**
+ * Reset the arena so that all its memory can be reused.
+ *
+ * All pointers previously returned from the arena become invalid.
+ *
+ * @param arena Arena to reset
+ */
+void
+pdxcp_arena_reset(pdxcp_arena *arena) PDXCP_NOEXCEPT;
+
+/**
+ * Allocate memory from the arena.
+ *
+ * The returned memory is suitably aligned for any object type.
+ *
+ * @param arena Arena to allocate from
+ * @param size Number of bytes to allocate
+ * @returns Pointer to uninitialized memory, `NULL` on error (`errno` is ENOMEM)
+ */
+void *
+pdxcp_arena_alloc(pdxcp_arena *arena, size_t size) PDXCP_NOEXCEPT;
+
+/**
+ * Copy a null-terminated string into memory allocated from the arena.
+ *
+ * @param arena Arena to allocate from
+ * @param s Null-terminated string to copy
+ * @returns Pointer to the copy, `NULL` on error (`errno` is ENOMEM)
+ */
+char *
+pdxcp_arena_strdup(pdxcp_arena *arena, const char *s) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_ARENA_H_
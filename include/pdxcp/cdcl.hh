@@ -0,0 +1,1454 @@
+/**
+ * @file cdcl.hh
+ * @author Derek Huang
+ * @brief C++ header for compile-time and runtime C declaration parsing
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_HH_
+#define PDXCP_CDCL_HH_
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+
+namespace pdxcp {
+namespace cdcl {
+
+/**
+ * Index value indicating no declaration or declaration node.
+ */
+inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+/**
+ * Exception thrown when a declaration cannot be lexed or parsed.
+ *
+ * When parsing at compile time, reaching the `throw` is what turns a bad
+ * declaration into a compile error. The compiler diagnostic points at the
+ * `throw` whose message describes the error.
+ */
+class parse_error : public std::runtime_error {
+public:
+  /**
+   * Ctor.
+   *
+   * @param status Parser status, one of `pdxcp_cdcl_parser_status_lexer_err`,
+   *  `pdxcp_cdcl_parser_status_parse_err`, or `pdxcp_cdcl_parser_status_eof`
+   * @param error Parser error code, `pdxcp_cdcl_parser_error_none` for lexer
+   *  errors and errors with no C parser equivalent
+   * @param offset Byte offset of the token at which the error was detected
+   * @param message Error message
+   */
+  parse_error(
+    pdxcp_cdcl_parser_status status,
+    pdxcp_cdcl_parser_error error,
+    std::size_t offset,
+    const char* message)
+    : std::runtime_error{message}, status_{status}, error_{error}, offset_{offset}
+  {}
+
+  /**
+   * Return the parser status.
+   */
+  auto status() const noexcept { return status_; }
+
+  /**
+   * Return the parser error code.
+   */
+  auto error() const noexcept { return error_; }
+
+  /**
+   * Return the byte offset of the token at which the error was detected.
+   */
+  auto offset() const noexcept { return offset_; }
+
+private:
+  pdxcp_cdcl_parser_status status_;
+  pdxcp_cdcl_parser_error error_;
+  std::size_t offset_;
+};
+
+/**
+ * Token read from a declaration string.
+ *
+ * @param type Token type
+ * @param text Identifier, number, or struct/enum tag text, otherwise empty
+ * @param offset Byte offset of the first character of the token
+ */
+struct token {
+  pdxcp_cdcl_token_type type = pdxcp_cdcl_token_type_error;
+  std::string_view text;
+  std::size_t offset = 0;
+};
+
+/**
+ * Declaration node.
+ *
+ * The compile-time counterpart of `pdxcp_cdcl_decl_node`. Links are indices
+ * into the owning `literal_decls` instead of pointers.
+ *
+ * @param kind Node kind
+ * @param quals Bitwise OR of `PDXCP_CDCL_QUAL_*` qualifier flags
+ * @param type Base type token type, only meaningful for type nodes
+ * @param name Struct or enum tag for type nodes, otherwise empty
+ * @param size Array size for array nodes, zero if the size is unspecified
+ * @param params Index of the first parameter declaration for function nodes,
+ *  `npos` if the parameter list is empty
+ * @param next Index of the next (inner) node, `npos` for type nodes
+ */
+struct node {
+  pdxcp_cdcl_decl_kind kind = pdxcp_cdcl_decl_kind_type;
+  unsigned int quals = 0;
+  pdxcp_cdcl_token_type type = pdxcp_cdcl_token_type_error;
+  std::string_view name;
+  std::size_t size = 0;
+  std::size_t params = npos;
+  std::size_t next = npos;
+};
+
+/**
+ * Parsed declaration.
+ *
+ * The compile-time counterpart of `pdxcp_cdcl_decl`.
+ *
+ * @param iden Identifier name, empty only for abstract parameter declarations
+ * @param node Index of the first (outermost) declaration node
+ * @param next Index of the next declaration in a parameter list, else `npos`
+ */
+struct decl {
+  std::string_view iden;
+  std::size_t node = npos;
+  std::size_t next = npos;
+};
+
+namespace detail {
+template <std::size_t N>
+class literal_parser;
+}  // namespace detail
+
+/**
+ * Declarations parsed from a string literal.
+ *
+ * All storage is inline so the parse result can be a `constexpr` variable.
+ * Every node and declaration consumes at least one input character, so an
+ * input of `N - 1` characters never needs more than `N` of each.
+ *
+ * @tparam N Size of the string literal, including the null terminator
+ */
+template <std::size_t N>
+class literal_decls {
+public:
+  /**
+   * Return the number of top-level declarations.
+   */
+  constexpr auto size() const noexcept { return n_top_; }
+
+  /**
+   * Return the top-level declaration at the given position.
+   *
+   * @param i Position of the top-level declaration, less than `size()`
+   */
+  constexpr const auto& operator[](std::size_t i) const { return decls_[top_[i]]; }
+
+  /**
+   * Return the declaration with the given index.
+   *
+   * @param i Index from a `decl::next` or `node::params` member
+   */
+  constexpr const auto& decl_at(std::size_t i) const { return decls_[i]; }
+
+  /**
+   * Return the declaration node with the given index.
+   *
+   * @param i Index from a `decl::node` or `node::next` member
+   */
+  constexpr const auto& node_at(std::size_t i) const { return nodes_[i]; }
+
+private:
+  friend class detail::literal_parser<N>;
+  std::array<node, N> nodes_{};
+  std::size_t n_nodes_ = 0;
+  std::array<decl, N> decls_{};
+  std::size_t n_decls_ = 0;
+  std::array<std::size_t, N> top_{};
+  std::size_t n_top_ = 0;
+};
+
+/**
+ * Fixed-capacity null-terminated text usable in constant expressions.
+ *
+ * @tparam N Maximum number of characters, excluding the null terminator
+ */
+template <std::size_t N>
+class fixed_text {
+public:
+  /**
+   * Return the number of characters.
+   */
+  constexpr auto size() const noexcept { return size_; }
+
+  /**
+   * Return a pointer to the null-terminated text.
+   */
+  constexpr const char* c_str() const noexcept { return data_; }
+
+  /**
+   * Return a view of the text.
+   */
+  constexpr std::string_view view() const noexcept { return {data_, size_}; }
+
+  /**
+   * Append characters to the text.
+   *
+   * @param text Characters to append
+   */
+  constexpr void append(std::string_view text)
+  {
+    if (text.size() > N - size_)
+      throw std::length_error{"fixed_text capacity exceeded"};
+    for (auto c : text)
+      data_[size_++] = c;
+    data_[size_] = '\0';
+  }
+
+private:
+  char data_[N + 1]{};
+  std::size_t size_ = 0;
+};
+
+/**
+ * Maximum expansion of one input character in an English description.
+ *
+ * The worst case is `*`, which is described as `" pointer to"`.
+ */
+inline constexpr std::size_t describe_ratio = 11;
+
+namespace detail {
+
+/**
+ * Check if a character is whitespace in the C locale.
+ */
+constexpr bool is_space(char c) noexcept
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+    c == '\r';
+}
+
+/**
+ * Check if a character is a decimal digit.
+ */
+constexpr bool is_digit(char c) noexcept
+{
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * Return the value of a hexadecimal digit, -1 if not a hexadecimal digit.
+ */
+constexpr int xdigit_value(char c) noexcept
+{
+  if (is_digit(c))
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ * Check if a character is a hexadecimal digit.
+ */
+constexpr bool is_xdigit(char c) noexcept
+{
+  return xdigit_value(c) >= 0;
+}
+
+/**
+ * Check if a character can start a C identifier.
+ */
+constexpr bool is_iden_first(char c) noexcept
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+/**
+ * Check if a character can continue a C identifier.
+ */
+constexpr bool is_iden(char c) noexcept
+{
+  return is_iden_first(c) || is_digit(c);
+}
+
+/**
+ * Return the token type for identifier text, which may be a keyword.
+ *
+ * @param text Identifier text
+ */
+constexpr pdxcp_cdcl_token_type keyword_type(std::string_view text) noexcept
+{
+  if (text == "const")
+    return pdxcp_cdcl_token_type_q_const;
+  if (text == "volatile")
+    return pdxcp_cdcl_token_type_q_volatile;
+  if (text == "signed")
+    return pdxcp_cdcl_token_type_q_signed;
+  if (text == "unsigned")
+    return pdxcp_cdcl_token_type_q_unsigned;
+  if (text == "struct")
+    return pdxcp_cdcl_token_type_struct;
+  if (text == "enum")
+    return pdxcp_cdcl_token_type_enum;
+  if (text == "void")
+    return pdxcp_cdcl_token_type_t_void;
+  if (text == "char")
+    return pdxcp_cdcl_token_type_t_char;
+  if (text == "int")
+    return pdxcp_cdcl_token_type_t_int;
+  if (text == "long")
+    return pdxcp_cdcl_token_type_t_long;
+  if (text == "float")
+    return pdxcp_cdcl_token_type_t_float;
+  if (text == "double")
+    return pdxcp_cdcl_token_type_t_double;
+  return pdxcp_cdcl_token_type_iden;
+}
+
+/**
+ * Check if a token type is a type specifier or qualifier.
+ */
+constexpr bool is_specifier(pdxcp_cdcl_token_type type) noexcept
+{
+  switch (type) {
+    case pdxcp_cdcl_token_type_struct:
+    case pdxcp_cdcl_token_type_enum:
+    case pdxcp_cdcl_token_type_q_const:
+    case pdxcp_cdcl_token_type_q_volatile:
+    case pdxcp_cdcl_token_type_q_signed:
+    case pdxcp_cdcl_token_type_q_unsigned:
+    case pdxcp_cdcl_token_type_t_void:
+    case pdxcp_cdcl_token_type_t_char:
+    case pdxcp_cdcl_token_type_t_int:
+    case pdxcp_cdcl_token_type_t_long:
+    case pdxcp_cdcl_token_type_t_float:
+    case pdxcp_cdcl_token_type_t_double:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Lexer reading tokens from a string.
+ *
+ * Tokens are lexed exactly as `pdxcp_cdcl_get_token_buf` does. Lexer errors
+ * throw a `parse_error` with `pdxcp_cdcl_parser_status_lexer_err` status.
+ */
+class literal_lexer {
+public:
+  /**
+   * Ctor.
+   *
+   * @param in Input text
+   */
+  constexpr explicit literal_lexer(std::string_view in) noexcept : in_{in} {}
+
+  /**
+   * Read the next token.
+   *
+   * @param tok Token to write to
+   * @returns `true` on success, `false` at the end of the input
+   */
+  constexpr bool next(token& tok)
+  {
+    // skip whitespace and any comments
+    if (!skip_space())
+      return false;
+    while (in_[pos_] == '/') {
+      // lone '/' is a token, even if it is the last char in the input
+      if (pos_ + 1 == in_.size() || (in_[pos_ + 1] != '*' && in_[pos_ + 1] != '/')) {
+        tok = {pdxcp_cdcl_token_type_slash, {}, pos_++};
+        return true;
+      }
+      // C block comment. unterminated comment runs to the end of the input
+      if (in_[pos_ + 1] == '*') {
+        auto end = in_.find("*/", pos_ + 2);
+        if (end == std::string_view::npos) {
+          pos_ = in_.size();
+          return false;
+        }
+        pos_ = end + 2;
+      }
+      // C++ line comment, which must end with a newline
+      else {
+        auto end = in_.find('\n', pos_);
+        if (end == std::string_view::npos) {
+          pos_ = in_.size();
+          return false;
+        }
+        pos_ = end + 1;
+      }
+      if (!skip_space())
+        return false;
+    }
+    tok.offset = pos_;
+    tok.text = {};
+    auto c = in_[pos_];
+    // identifier or keyword. struct and enum keep the tag as their text
+    if (is_iden_first(c)) {
+      auto text = iden_text();
+      tok.type = keyword_type(text);
+      if (tok.type == pdxcp_cdcl_token_type_iden)
+        tok.text = text;
+      else if (
+        tok.type == pdxcp_cdcl_token_type_struct ||
+        tok.type == pdxcp_cdcl_token_type_enum
+      ) {
+        // like the C lexer, only whitespace may precede the tag
+        while (pos_ < in_.size() && is_space(in_[pos_]))
+          pos_++;
+        if (pos_ == in_.size())
+          return false;
+        if (!is_iden_first(in_[pos_]))
+          throw parse_error{
+            pdxcp_cdcl_parser_status_lexer_err,
+            pdxcp_cdcl_parser_error_none,
+            pos_,
+            "Next token to read is not an identifier"
+          };
+        tok.text = iden_text();
+      }
+      return true;
+    }
+    // number. if the first digit is '0' then 'x' or 'X' must follow for hex
+    if (is_digit(c)) {
+      auto first = pos_++;
+      bool hex = (c == '0');
+      if (hex) {
+        if (pos_ == in_.size())
+          return false;
+        if (in_[pos_] != 'x' && in_[pos_] != 'X')
+          throw parse_error{
+            pdxcp_cdcl_parser_status_lexer_err,
+            pdxcp_cdcl_parser_error_none,
+            first,
+            "Malformed token read when attempting to parse number"
+          };
+        pos_++;
+      }
+      while (
+        pos_ < in_.size() && (hex ? is_xdigit(in_[pos_]) : is_digit(in_[pos_]))
+      )
+        pos_++;
+      tok.type = pdxcp_cdcl_token_type_num;
+      tok.text = in_.substr(first, pos_ - first);
+      if (tok.text.size() > PDXCP_CDCL_MAX_TOKEN_LEN)
+        throw parse_error{
+          pdxcp_cdcl_parser_status_lexer_err,
+          pdxcp_cdcl_parser_error_none,
+          first,
+          "Token too large"
+        };
+      return true;
+    }
+    // else single-character token
+    pos_++;
+    switch (c) {
+      case '(':
+        tok.type = pdxcp_cdcl_token_type_lparen;
+        break;
+      case ')':
+        tok.type = pdxcp_cdcl_token_type_rparen;
+        break;
+      case '[':
+        tok.type = pdxcp_cdcl_token_type_langle;
+        break;
+      case ']':
+        tok.type = pdxcp_cdcl_token_type_rangle;
+        break;
+      case ',':
+        tok.type = pdxcp_cdcl_token_type_comma;
+        break;
+      case '*':
+        tok.type = pdxcp_cdcl_token_type_star;
+        break;
+      case ';':
+        tok.type = pdxcp_cdcl_token_type_semicolon;
+        break;
+      default:
+        throw parse_error{
+          pdxcp_cdcl_parser_status_lexer_err,
+          pdxcp_cdcl_parser_error_none,
+          tok.offset,
+          "Unknown character token"
+        };
+    }
+    return true;
+  }
+
+  /**
+   * Return the current input position.
+   */
+  constexpr auto pos() const noexcept { return pos_; }
+
+private:
+  std::string_view in_;
+  std::size_t pos_ = 0;
+
+  /**
+   * Skip whitespace, returning `false` at the end of the input.
+   */
+  constexpr bool skip_space() noexcept
+  {
+    while (pos_ < in_.size() && is_space(in_[pos_]))
+      pos_++;
+    return pos_ < in_.size();
+  }
+
+  /**
+   * Read identifier text starting at the current position.
+   */
+  constexpr std::string_view iden_text()
+  {
+    auto first = pos_;
+    while (pos_ < in_.size() && is_iden(in_[pos_]))
+      pos_++;
+    if (pos_ - first > PDXCP_CDCL_MAX_TOKEN_LEN)
+      throw parse_error{
+        pdxcp_cdcl_parser_status_lexer_err,
+        pdxcp_cdcl_parser_error_none,
+        first,
+        "Token too large"
+      };
+    return in_.substr(first, pos_ - first);
+  }
+};
+
+/**
+ * Parser for declarations in a string literal.
+ *
+ * This is a separate, hand-written `constexpr` transcription of
+ * `stream_parse_declarator` and its helpers in `cdcl_parser.c`. It does not
+ * share the C parser's rule table, so the two are only kept in step by tests
+ * comparing their results. It reports the same `pdxcp_cdcl_parser_error`
+ * codes but has no typedef name table, so it matches the C parser used
+ * without one, where an identifier in type position is an error. The token
+ * stack and the parse result use inline storage sized by the literal instead
+ * of an arena.
+ *
+ * @tparam N Size of the string literal, including the null terminator
+ */
+template <std::size_t N>
+class literal_parser {
+public:
+  /**
+   * Ctor.
+   *
+   * @param in Input text
+   */
+  constexpr explicit literal_parser(std::string_view in) noexcept
+    : lexer_{in}, end_{in.size()}
+  {}
+
+  /**
+   * Parse all the declarations in the input.
+   */
+  constexpr auto parse()
+  {
+    // end of input before the first token means there are no declarations
+    while (lexer_.next(token_)) {
+      auto i = add_decl();
+      result_.top_[result_.n_top_++] = i;
+      parse_decl(i);
+    }
+    return result_;
+  }
+
+private:
+  literal_lexer lexer_;
+  std::size_t end_;
+  literal_decls<N> result_;
+  std::array<token, N> stack_{};
+  std::size_t n_stack_ = 0;
+  token token_;
+  token next_;
+  bool has_next_ = false;
+  unsigned int depth_ = 0;
+
+  /**
+   * Throw a `parse_error` for a parser error at the current token.
+   *
+   * @param error Parser error code
+   * @param message Error message
+   */
+  [[noreturn]] constexpr void fail(
+    pdxcp_cdcl_parser_error error, const char* message) const
+  {
+    throw parse_error{
+      pdxcp_cdcl_parser_status_parse_err, error, token_.offset, message
+    };
+  }
+
+  /**
+   * Read a token, throwing at the end of the input.
+   *
+   * Only called after the first token of a declaration, so the end of the
+   * input here means the declaration is incomplete.
+   *
+   * @param tok Token to write to
+   */
+  constexpr void lex(token& tok)
+  {
+    if (!lexer_.next(tok))
+      throw parse_error{
+        pdxcp_cdcl_parser_status_eof,
+        pdxcp_cdcl_parser_error_none,
+        end_,
+        "Input ended before the end of the declaration"
+      };
+  }
+
+  /**
+   * Advance to the next token, consuming the lookahead token if any.
+   */
+  constexpr void advance()
+  {
+    if (has_next_) {
+      token_ = next_;
+      has_next_ = false;
+    }
+    else
+      lex(token_);
+  }
+
+  /**
+   * Read the lookahead token if it has not already been read.
+   */
+  constexpr void peek()
+  {
+    if (!has_next_) {
+      lex(next_);
+      has_next_ = true;
+    }
+  }
+
+  /**
+   * Return the token on the top of the token stack.
+   */
+  constexpr const auto& head() const { return stack_[n_stack_ - 1]; }
+
+  /**
+   * Add an empty declaration and return its index.
+   */
+  constexpr std::size_t add_decl()
+  {
+    return result_.n_decls_++;
+  }
+
+  /**
+   * Append a declaration node to a node list and return a reference to it.
+   *
+   * @param tail Address of the index the new node's index is written to
+   * @param kind Kind of node to append
+   */
+  constexpr auto& add_node(std::size_t*& tail, pdxcp_cdcl_decl_kind kind)
+  {
+    auto i = result_.n_nodes_++;
+    auto& n = result_.nodes_[i];
+    n.kind = kind;
+    *tail = i;
+    tail = &n.next;
+    return n;
+  }
+
+  /**
+   * Push tokens onto the token stack until the identifier is reached.
+   *
+   * @param is_param `true` if parsing a parameter declaration
+   */
+  constexpr void to_iden(bool is_param)
+  {
+    while (token_.type != pdxcp_cdcl_token_type_iden) {
+      // parameter declarations may omit the identifier
+      if (is_param && token_.type != pdxcp_cdcl_token_type_star) {
+        // '(' is for grouping unless it starts a parameter list
+        if (token_.type == pdxcp_cdcl_token_type_lparen) {
+          peek();
+          if (
+            next_.type == pdxcp_cdcl_token_type_rparen ||
+            is_specifier(next_.type)
+          )
+            return;
+        }
+        else if (!is_specifier(token_.type))
+          return;
+      }
+      stack_[n_stack_++] = token_;
+      advance();
+    }
+  }
+
+  /**
+   * Pop tokens off of the token stack to handle pointers in the declarator.
+   *
+   * @param tail Node list tail
+   * @param base Number of tokens belonging to enclosing declarations
+   */
+  constexpr void ptrs(std::size_t*& tail, std::size_t base)
+  {
+    bool has_const = false;
+    bool has_volatile = false;
+    while (n_stack_ > base) {
+      switch (head().type) {
+        case pdxcp_cdcl_token_type_q_const:
+          if (has_const)
+            fail(
+              pdxcp_cdcl_parser_error_ptr_dup_const,
+              "Duplicate pointer const qualifier"
+            );
+          has_const = true;
+          break;
+        case pdxcp_cdcl_token_type_q_volatile:
+          if (has_volatile)
+            fail(
+              pdxcp_cdcl_parser_error_ptr_dup_volatile,
+              "Duplicate pointer volatile qualifier"
+            );
+          has_volatile = true;
+          break;
+        case pdxcp_cdcl_token_type_star: {
+          auto& n = add_node(tail, pdxcp_cdcl_decl_kind_pointer);
+          if (has_const)
+            n.quals |= PDXCP_CDCL_QUAL_CONST;
+          if (has_volatile)
+            n.quals |= PDXCP_CDCL_QUAL_VOLATILE;
+          has_const = has_volatile = false;
+          break;
+        }
+        // qualifiers must be followed by '*', otherwise pointers are done
+        default:
+          if (has_const || has_volatile)
+            fail(
+              pdxcp_cdcl_parser_error_ptr_token,
+              "Unexpected token when parsing pointers"
+            );
+          return;
+      }
+      n_stack_--;
+    }
+    fail(
+      pdxcp_cdcl_parser_error_ptr_no_type,
+      "Unexpectedly ran out of tokens when parsing pointers, missing type"
+    );
+  }
+
+  /**
+   * Convert number token text to an array size.
+   *
+   * Text starting with `0x` is hexadecimal, otherwise decimal, as with
+   * `strtol` base 0 in the C parser. Values that would not fit in a `long`
+   * are clamped to `LONG_MAX` as `strtol` does.
+   *
+   * @param text Number token text
+   */
+  static constexpr long array_size(std::string_view text) noexcept
+  {
+    long base = 10;
+    if (text.size() > 1 && (text[1] == 'x' || text[1] == 'X')) {
+      base = 16;
+      text.remove_prefix(2);
+    }
+    long value = 0;
+    for (auto c : text) {
+      long digit = xdigit_value(c);
+      if (digit < 0 || digit >= base)
+        break;
+      if (value > (LONG_MAX - digit) / base)
+        return LONG_MAX;
+      value = value * base + digit;
+    }
+    return value;
+  }
+
+  /**
+   * Parse array specifiers, starting with the current '[' token.
+   *
+   * @param tail Node list tail
+   */
+  constexpr void arrays(std::size_t*& tail)
+  {
+    bool unmatched_langle = true;
+    std::size_t size = 0;
+    unsigned int n_specs = 0;
+    while (true) {
+      advance();
+      switch (token_.type) {
+        case pdxcp_cdcl_token_type_langle:
+          if (unmatched_langle)
+            fail(
+              pdxcp_cdcl_parser_error_array_dup_langle,
+              "Array specifier contains duplicate left angle bracket"
+            );
+          unmatched_langle = true;
+          break;
+        case pdxcp_cdcl_token_type_num: {
+          if (!unmatched_langle)
+            fail(
+              pdxcp_cdcl_parser_error_array_size_no_langle,
+              "Array specifier size read without matching left angle bracket"
+            );
+          auto value = array_size(token_.text);
+          if (value == LONG_MAX)
+            fail(
+              pdxcp_cdcl_parser_error_array_size_range,
+              "Array specifier size out of range"
+            );
+          if (!value)
+            fail(
+              pdxcp_cdcl_parser_error_array_size_zero,
+              "Array specifier size is 0"
+            );
+          size = static_cast<std::size_t>(value);
+          break;
+        }
+        case pdxcp_cdcl_token_type_rangle: {
+          if (!unmatched_langle)
+            fail(
+              pdxcp_cdcl_parser_error_array_no_langle,
+              "Array specifier missing matching left angle bracket"
+            );
+          if (!size && n_specs)
+            fail(
+              pdxcp_cdcl_parser_error_array_no_bounds,
+              "Multidimensional array specifier must have bounds for all "
+                "dimensions except for the first"
+            );
+          add_node(tail, pdxcp_cdcl_decl_kind_array).size = size;
+          unmatched_langle = false;
+          size = 0;
+          n_specs++;
+          break;
+        }
+        // other tokens end the specifiers unless inside one or a '(' follows
+        default:
+          if (unmatched_langle || token_.type == pdxcp_cdcl_token_type_lparen)
+            fail(
+              pdxcp_cdcl_parser_error_array_token,
+              "Unexpected token when parsing array specifiers"
+            );
+          return;
+      }
+    }
+  }
+
+  /**
+   * Parse a function parameter list, starting with the current '(' token.
+   *
+   * @param tail Node list tail
+   */
+  constexpr void params(std::size_t*& tail)
+  {
+    if (depth_ == PDXCP_CDCL_PARSER_MAX_DEPTH)
+      fail(
+        pdxcp_cdcl_parser_error_params_depth,
+        "Function parameter lists nested too deeply"
+      );
+    auto& n = add_node(tail, pdxcp_cdcl_decl_kind_function);
+    auto* param_tail = &n.params;
+    advance();
+    while (token_.type != pdxcp_cdcl_token_type_rparen) {
+      auto i = add_decl();
+      depth_++;
+      unsigned int n_groups = 0;
+      declarator(i, true, n_groups);
+      depth_--;
+      *param_tail = i;
+      param_tail = &result_.decls_[i].next;
+      // ')' ends the list, ',' separates parameters so another must follow
+      if (token_.type == pdxcp_cdcl_token_type_rparen)
+        break;
+      if (token_.type == pdxcp_cdcl_token_type_comma) {
+        advance();
+        if (token_.type != pdxcp_cdcl_token_type_rparen)
+          continue;
+      }
+      fail(
+        pdxcp_cdcl_parser_error_params_token,
+        "Unexpected token when parsing function parameters"
+      );
+    }
+    // void is only allowed as the sole unnamed parameter, e.g. int f(void)
+    for (auto i = n.params; i != npos; i = result_.decls_[i].next) {
+      const auto& param = result_.decls_[i];
+      const auto& head = result_.nodes_[param.node];
+      if (
+        head.kind == pdxcp_cdcl_decl_kind_type &&
+        head.type == pdxcp_cdcl_token_type_t_void &&
+        (
+          !param.iden.empty() || head.quals || i != n.params ||
+          param.next != npos
+        )
+      )
+        fail(
+          pdxcp_cdcl_parser_error_params_void,
+          "A void parameter must be unnamed, unqualified, and the only "
+          "parameter"
+        );
+    }
+    advance();
+  }
+
+  /**
+   * Check that the layers of a parsed declaration can be composed.
+   *
+   * Functions cannot return arrays or functions and arrays cannot hold
+   * functions, however the layers are grouped.
+   *
+   * @param i Index of the parsed declaration
+   */
+  constexpr void check_nodes(std::size_t i) const
+  {
+    for (
+      auto j = result_.decls_[i].node;
+      j != npos && result_.nodes_[j].next != npos;
+      j = result_.nodes_[j].next
+    ) {
+      const auto& n = result_.nodes_[j];
+      auto next_kind = result_.nodes_[n.next].kind;
+      if (n.kind == pdxcp_cdcl_decl_kind_function) {
+        if (next_kind == pdxcp_cdcl_decl_kind_array)
+          fail(
+            pdxcp_cdcl_parser_error_return_array,
+            "Function cannot return an array"
+          );
+        if (next_kind == pdxcp_cdcl_decl_kind_function)
+          fail(
+            pdxcp_cdcl_parser_error_return_function,
+            "Function cannot return a function"
+          );
+      }
+      else if (
+        n.kind == pdxcp_cdcl_decl_kind_array &&
+        next_kind == pdxcp_cdcl_decl_kind_function
+      )
+        fail(
+          pdxcp_cdcl_parser_error_array_function,
+          "Array elements cannot be functions"
+        );
+    }
+  }
+
+  /**
+   * Pop tokens off of the token stack to handle the qualified base type.
+   *
+   * @param tail Node list tail
+   * @param base Number of tokens belonging to enclosing declarations
+   */
+  constexpr void type(std::size_t*& tail, std::size_t base)
+  {
+    bool has_const = false;
+    bool has_volatile = false;
+    bool is_signed = false;
+    bool is_unsigned = false;
+    token type_token;
+    while (n_stack_ > base) {
+      switch (head().type) {
+        case pdxcp_cdcl_token_type_q_const:
+          if (has_const)
+            fail(
+              pdxcp_cdcl_parser_error_type_dup_const,
+              "Duplicate type const qualifier"
+            );
+          has_const = true;
+          break;
+        case pdxcp_cdcl_token_type_q_volatile:
+          if (has_volatile)
+            fail(
+              pdxcp_cdcl_parser_error_type_dup_volatile,
+              "Duplicate type volatile qualifier"
+            );
+          has_volatile = true;
+          break;
+        case pdxcp_cdcl_token_type_q_signed:
+          if (is_signed)
+            fail(
+              pdxcp_cdcl_parser_error_type_dup_signed,
+              "Duplicate signed type qualifier"
+            );
+          if (is_unsigned)
+            fail(
+              pdxcp_cdcl_parser_error_type_signed_unsigned,
+              "Type already qualified as unsigned, cannot re-qualify as signed"
+            );
+          is_signed = true;
+          break;
+        case pdxcp_cdcl_token_type_q_unsigned:
+          if (is_unsigned)
+            fail(
+              pdxcp_cdcl_parser_error_type_dup_unsigned,
+              "Duplicate unsigned type qualifier"
+            );
+          if (is_signed)
+            fail(
+              pdxcp_cdcl_parser_error_type_unsigned_signed,
+              "Type already qualified as signed, cannot re-qualify as unsigned"
+            );
+          is_unsigned = true;
+          break;
+        case pdxcp_cdcl_token_type_struct:
+        case pdxcp_cdcl_token_type_enum:
+        case pdxcp_cdcl_token_type_t_void:
+        case pdxcp_cdcl_token_type_t_char:
+        case pdxcp_cdcl_token_type_t_int:
+        case pdxcp_cdcl_token_type_t_long:
+        case pdxcp_cdcl_token_type_t_float:
+        case pdxcp_cdcl_token_type_t_double:
+          if (type_token.type != pdxcp_cdcl_token_type_error)
+            fail(
+              pdxcp_cdcl_parser_error_type_redefined,
+              "Type provided when identifier already has a type"
+            );
+          type_token = head();
+          break;
+        default:
+          fail(
+            pdxcp_cdcl_parser_error_type_token,
+            "Unexpected token when parsing identifier type"
+          );
+      }
+      n_stack_--;
+    }
+    if (type_token.type == pdxcp_cdcl_token_type_error)
+      fail(
+        pdxcp_cdcl_parser_error_type_missing,
+        "Identifier missing required type"
+      );
+    // only char, int, and long can have sign qualifiers
+    switch (type_token.type) {
+      case pdxcp_cdcl_token_type_t_char:
+      case pdxcp_cdcl_token_type_t_int:
+      case pdxcp_cdcl_token_type_t_long:
+        break;
+      default:
+        if (is_signed || is_unsigned)
+          fail(
+            pdxcp_cdcl_parser_error_type_bad_sign,
+            "Only char, int, or long can be signed or unsigned"
+          );
+        break;
+    }
+    auto& n = add_node(tail, pdxcp_cdcl_decl_kind_type);
+    n.type = type_token.type;
+    n.name = type_token.text;
+    if (has_const)
+      n.quals |= PDXCP_CDCL_QUAL_CONST;
+    if (has_volatile)
+      n.quals |= PDXCP_CDCL_QUAL_VOLATILE;
+    if (is_signed)
+      n.quals |= PDXCP_CDCL_QUAL_SIGNED;
+    if (is_unsigned)
+      n.quals |= PDXCP_CDCL_QUAL_UNSIGNED;
+  }
+
+  /**
+   * Parse a declarator together with its specifiers into a declaration.
+   *
+   * @param i Index of the declaration to write the parse result to
+   * @param is_param `true` if parsing a parameter declaration
+   * @param n_groups Number of grouping parenthesis pairs, written on return
+   */
+  constexpr void declarator(std::size_t i, bool is_param, unsigned int& n_groups)
+  {
+    auto base = n_stack_;
+    n_groups = 0;
+    to_iden(is_param);
+    auto* tail = &result_.decls_[i].node;
+    if (token_.type == pdxcp_cdcl_token_type_iden) {
+      result_.decls_[i].iden = token_.text;
+      advance();
+    }
+    // unwind the declarator one grouping level at a time
+    while (true) {
+      // a suffix following another one is parsed too so check_nodes can
+      // reject e.g. a function returning an array
+      while (true) {
+        if (token_.type == pdxcp_cdcl_token_type_langle)
+          arrays(tail);
+        else if (token_.type == pdxcp_cdcl_token_type_lparen)
+          params(tail);
+        else
+          break;
+      }
+      ptrs(tail, base);
+      if (head().type != pdxcp_cdcl_token_type_lparen)
+        break;
+      if (token_.type != pdxcp_cdcl_token_type_rparen)
+        fail(
+          pdxcp_cdcl_parser_error_paren_mismatch,
+          "Mismatched parentheses when parsing pointers"
+        );
+      n_stack_--;
+      n_groups++;
+      advance();
+    }
+    type(tail, base);
+    check_nodes(i);
+  }
+
+  /**
+   * Parse a top-level declaration whose first token is the current token.
+   *
+   * @param i Index of the declaration to write the parse result to
+   */
+  constexpr void parse_decl(std::size_t i)
+  {
+    n_stack_ = 0;
+    unsigned int n_groups = 0;
+    declarator(i, false, n_groups);
+    if (token_.type == pdxcp_cdcl_token_type_rparen)
+      fail(
+        pdxcp_cdcl_parser_error_paren_mismatch,
+        "Mismatched parentheses when parsing pointers"
+      );
+    if (token_.type != pdxcp_cdcl_token_type_semicolon)
+      fail(
+        pdxcp_cdcl_parser_error_incomplete,
+        "Incomplete declaration"
+      );
+  }
+};
+
+/**
+ * Writer of English descriptions into fixed-capacity text.
+ *
+ * This mirrors `decl_render` in `cdcl_parser.c`, so descriptions are
+ * identical to those from `pdxcp_cdcl_decl_render`.
+ *
+ * @tparam N Size of the string literal, including the null terminator
+ */
+template <std::size_t N>
+class literal_describer {
+public:
+  /**
+   * Ctor.
+   *
+   * @param decls Parsed declarations
+   */
+  constexpr explicit literal_describer(const literal_decls<N>& decls) noexcept
+    : decls_{decls}
+  {}
+
+  /**
+   * Describe all the top-level declarations, one line each.
+   */
+  constexpr auto describe()
+  {
+    for (std::size_t i = 0; i < decls_.size(); i++) {
+      put(decls_[i].iden);
+      put(":");
+      put_nodes(decls_[i].node);
+      put("\n");
+    }
+    return text_;
+  }
+
+private:
+  const literal_decls<N>& decls_;
+  fixed_text<describe_ratio * N> text_;
+  bool trim_ = false;
+
+  /**
+   * Append text, dropping a leading space if requested.
+   *
+   * @param s Text to append
+   */
+  constexpr void put(std::string_view s)
+  {
+    if (trim_ && !s.empty() && s.front() == ' ')
+      s.remove_prefix(1);
+    trim_ = false;
+    text_.append(s);
+  }
+
+  /**
+   * Append the decimal representation of a size.
+   *
+   * @param value Value to append
+   */
+  constexpr void put_size(std::size_t value)
+  {
+    char digits[20]{};
+    std::size_t first = sizeof digits;
+    do {
+      digits[--first] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    }
+    while (value);
+    put({digits + first, sizeof digits - first});
+  }
+
+  /**
+   * Append the description of a qualified base type.
+   *
+   * @param n Type declaration node
+   */
+  constexpr void put_type(const node& n)
+  {
+    if (n.quals & PDXCP_CDCL_QUAL_CONST)
+      put(" const");
+    if (n.quals & PDXCP_CDCL_QUAL_VOLATILE)
+      put(" volatile");
+    if (n.quals & PDXCP_CDCL_QUAL_SIGNED)
+      put(" signed");
+    if (n.quals & PDXCP_CDCL_QUAL_UNSIGNED)
+      put(" unsigned");
+    switch (n.type) {
+      case pdxcp_cdcl_token_type_struct:
+        put(" struct ");
+        put(n.name);
+        break;
+      case pdxcp_cdcl_token_type_enum:
+        put(" enum ");
+        put(n.name);
+        break;
+      case pdxcp_cdcl_token_type_t_void:
+        put(" void");
+        break;
+      case pdxcp_cdcl_token_type_t_char:
+        put(" char");
+        break;
+      case pdxcp_cdcl_token_type_t_int:
+        put(" int");
+        break;
+      case pdxcp_cdcl_token_type_t_long:
+        put(" long");
+        break;
+      case pdxcp_cdcl_token_type_t_float:
+        put(" float");
+        break;
+      case pdxcp_cdcl_token_type_t_double:
+        put(" double");
+        break;
+      default:
+        break;
+    }
+  }
+
+  /**
+   * Append the description of a declaration node list.
+   *
+   * @param i Index of the first (outermost) declaration node
+   */
+  constexpr void put_nodes(std::size_t i)
+  {
+    for (; i != npos; i = decls_.node_at(i).next) {
+      const auto& n = decls_.node_at(i);
+      switch (n.kind) {
+        case pdxcp_cdcl_decl_kind_pointer:
+          if (n.quals & PDXCP_CDCL_QUAL_CONST)
+            put(" const");
+          if (n.quals & PDXCP_CDCL_QUAL_VOLATILE)
+            put(" volatile");
+          put(" pointer to");
+          break;
+        case pdxcp_cdcl_decl_kind_array:
+          put(" array[");
+          if (n.size)
+            put_size(n.size);
+          put("] of");
+          break;
+        case pdxcp_cdcl_decl_kind_function:
+          put(" function(");
+          put_params(n.params);
+          put(") returning");
+          break;
+        default:
+          put_type(n);
+          break;
+      }
+    }
+  }
+
+  /**
+   * Append the description of a function parameter list.
+   *
+   * @param first Index of the first parameter, `npos` if none
+   */
+  constexpr void put_params(std::size_t first)
+  {
+    for (auto i = first; i != npos; i = decls_.decl_at(i).next) {
+      const auto& param = decls_.decl_at(i);
+      if (i != first)
+        put(", ");
+      if (param.iden.empty())
+        trim_ = true;
+      else {
+        put(param.iden);
+        put(":");
+      }
+      put_nodes(param.node);
+    }
+  }
+};
+
+/**
+ * Per-thread scratch state for runtime parsing.
+ *
+ * The arena and byte vector keep their memory between declarations, so a
+ * thread that has parsed a declaration no longer allocates for declarations
+ * no larger than it.
+ */
+class runtime_state {
+public:
+  /**
+   * Ctor.
+   */
+  runtime_state() noexcept
+  {
+    pdxcp_arena_init(&arena, 0);
+    pdxcp_bvector_init(&text);
+  }
+
+  /**
+   * Deleted copy ctor.
+   */
+  runtime_state(const runtime_state&) = delete;
+
+  /**
+   * Dtor.
+   */
+  ~runtime_state()
+  {
+    pdxcp_bvector_destroy(&text);
+    pdxcp_arena_destroy(&arena);
+  }
+
+  pdxcp_arena arena;
+  pdxcp_bvector text;
+};
+
+}  // namespace detail
+
+/**
+ * Parse the declarations in a string literal.
+ *
+ * The literal may contain any number of `;`-terminated declarations with the
+ * grammar of `pdxcp_cdcl_parse_decl` without typedef names. When used to
+ * initialize a `constexpr` variable, nothing is lexed or parsed at runtime
+ * and a bad declaration is a compile error. When called at runtime, a
+ * `parse_error` is thrown instead. For example:
+ *
+ * @code{.cc}
+ * constexpr auto decls = pdxcp::cdcl::parse_literal("char *argv[];");
+ * static_assert(decls[0].iden == "argv");
+ * static_assert(decls.node_at(decls[0].node).kind == pdxcp_cdcl_decl_kind_array);
+ * @endcode
+ *
+ * @tparam N Size of the string literal, including the null terminator
+ *
+ * @param input String literal
+ */
+template <std::size_t N>
+constexpr auto parse_literal(const char (&input)[N])
+{
+  return detail::literal_parser<N>{{input, N - 1}}.parse();
+}
+
+/**
+ * Return the English description of parsed declarations.
+ *
+ * Each declaration is described on its own newline-terminated line exactly
+ * as `pdxcp_cdcl_decl_render` would describe it.
+ *
+ * @tparam N Size of the parsed string literal, including the null terminator
+ *
+ * @param decls Parsed declarations
+ */
+template <std::size_t N>
+constexpr auto describe(const literal_decls<N>& decls)
+{
+  return detail::literal_describer<N>{decls}.describe();
+}
+
+/**
+ * Return the English description of the declarations in a string literal.
+ *
+ * For example, the following has no runtime cost:
+ *
+ * @code{.cc}
+ * constexpr auto text = pdxcp::cdcl::describe_literal("int (*f)(char);");
+ * static_assert(text.view() == "f: pointer to function(char) returning int\n");
+ * @endcode
+ *
+ * @tparam N Size of the string literal, including the null terminator
+ *
+ * @param input String literal
+ */
+template <std::size_t N>
+constexpr auto describe_literal(const char (&input)[N])
+{
+  return describe(parse_literal(input));
+}
+
+/**
+ * Parse a declaration at runtime and write its English description.
+ *
+ * This is `pdxcp_cdcl_parse_decl_buf` followed by `pdxcp_cdcl_decl_render`,
+ * so unlike `pdxcp_cdcl_stream_parse` no `FILE *` is opened for the input or
+ * the output. The declaration is parsed and rendered once, into an arena and
+ * a byte vector reused by each thread, and the description is then copied
+ * into the output string, whose storage is also reused. On error the output
+ * string is left empty.
+ *
+ * For example:
+ *
+ * @code{.cc}
+ * std::string text;
+ * for (std::string_view input : inputs)
+ *   if (PDXCP_CDCL_PARSER_OK(pdxcp::cdcl::parse(input, text)))
+ *     std::cout << text;
+ * @endcode
+ *
+ * @param input Declaration text
+ * @param out String to write the newline-terminated description to
+ * @param errinfo Error info structure, can be `nullptr`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+inline auto parse(
+  std::string_view input,
+  std::string& out,
+  pdxcp_cdcl_parser_errinfo* errinfo = nullptr)
+{
+  thread_local detail::runtime_state state;
+  out.clear();
+  // empty views may have a null data pointer
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(
+    &buf, (input.data()) ? input.data() : "", input.size()
+  );
+  pdxcp_arena_reset(&state.arena);
+  pdxcp_cdcl_decl decl;
+  auto status = pdxcp_cdcl_parse_decl_buf(&buf, &state.arena, &decl, errinfo);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  state.text.size = 0;
+  status = pdxcp_cdcl_decl_render(&decl, &state.text);
+  if (PDXCP_CDCL_PARSER_OK(status))
+    out.assign(
+      reinterpret_cast<const char*>(state.text.data), state.text.size
+    );
+  return status;
+}
+
+}  // namespace cdcl
+}  // namespace pdxcp
+
+#endif  // PDXCP_CDCL_HH_
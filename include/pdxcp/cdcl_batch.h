@@ -0,0 +1,84 @@
+/**
+ * @file cdcl_batch.h
+ * @author Derek Huang
+ * @brief C/C++ header for multithreaded batch C declaration parsing
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_BATCH_H_
+#define PDXCP_CDCL_BATCH_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_render.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Default target number of input bytes in each batch work unit.
+ *
+ * Work units are split only at declaration boundaries, so actual work unit
+ * sizes will be slightly larger than the target.
+ */
+#define PDXCP_CDCL_BATCH_UNIT_SIZE 65536
+
+/**
+ * Return offset one past the end of the next top-level declaration.
+ *
+ * Declarations end with a `;` that is not inside a C block comment or C++
+ * line comment. The scan for `;` uses `memchr`, only falling back to a
+ * byte-by-byte scan when a `/` that may start a comment precedes the `;`.
+ *
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Number of bytes in the input buffer
+ * @returns Offset one past the terminating `;`, `in_size` if there is none
+ */
+size_t
+pdxcp_cdcl_next_decl_end(const char *in, size_t in_size) PDXCP_NOEXCEPT;
+
+/**
+ * Parse declarations from a buffer using multiple threads.
+ *
+ * The input is split at declaration boundaries into work units that are
+ * parsed concurrently, each thread reusing its own `pdxcp_cdcl_parser` state.
+ * The declarations, rendered in the given output format, are then written to
+ * the output stream in input order, so the output is the same as if the
+ * declarations were parsed one at a time. If there is an error, only
+ * declarations preceding the first error in input order are written and the
+ * error is written to `errinfo`.
+ *
+ * Parsing is typedef-aware. Typedef names are first collected from the
+ * declarations starting with `typedef` in a single pass over the input, so
+ * the threads only read the typedef name table. If a typedef declaration
+ * cannot be parsed in that pass, all parsing is done on the calling thread.
+ *
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Number of bytes in the input buffer
+ * @param out Output stream
+ * @param format Output format
+ * @param n_threads Number of threads to use, if zero then the number of online
+ *  processors is used. If one, all parsing is done on the calling thread
+ * @param cache_size Capacity of each thread's `pdxcp_cdcl_cache` of parse
+ *  results, if zero then no caching is done
+ * @param n_decls Address to write the number of declarations written to the
+ *  output stream to, ignored if `NULL`
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_batch_parse(
+  const char *in,
+  size_t in_size,
+  FILE *out,
+  pdxcp_cdcl_output_format format,
+  unsigned int n_threads,
+  size_t cache_size,
+  size_t *n_decls,
+  pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_BATCH_H_
@@ -0,0 +1,115 @@
+/**
+ * @file cdcl_cache.h
+ * @author Derek Huang
+ * @brief C/C++ header for the C declaration parse result cache
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_CACHE_H_
+#define PDXCP_CDCL_CACHE_H_
+
+#include <stddef.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_render.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Opaque cache entry type.
+ */
+typedef struct pdxcp_cdcl_cache_entry pdxcp_cdcl_cache_entry;
+
+/**
+ * Bounded LRU cache of rendered declaration descriptions.
+ *
+ * Entries are keyed by the declaration's normalized token sequence, which is
+ * the declaration text with comments removed and whitespace kept only where
+ * it separates two identifier characters, e.g. `char  * argv [ ];` and
+ * `char*argv[];` share the key `char*argv[];`. Since normalization does not
+ * require lexing, repeated declarations skip both lexing and parsing.
+ *
+ * @param buckets Hash table buckets, `NULL` until the first insertion
+ * @param n_buckets Number of hash table buckets, a power of two
+ * @param head Most recently used entry
+ * @param tail Least recently used entry, evicted first
+ * @param size Number of entries in the cache
+ * @param capacity Maximum number of entries in the cache
+ * @param hits Number of lookups that found an entry
+ * @param misses Number of lookups that did not find an entry
+ * @param key Scratch byte vector holding the most recent normalized key
+ * @param format Output format of the cached renderings, which is
+ *  `pdxcp_cdcl_output_format_text` after initialization. Must only be changed
+ *  before the first call to `pdxcp_cdcl_cache_parse`
+ */
+typedef struct {
+  pdxcp_cdcl_cache_entry **buckets;
+  size_t n_buckets;
+  pdxcp_cdcl_cache_entry *head;
+  pdxcp_cdcl_cache_entry *tail;
+  size_t size;
+  size_t capacity;
+  size_t hits;
+  size_t misses;
+  pdxcp_bvector key;
+  pdxcp_cdcl_output_format format;
+} pdxcp_cdcl_cache;
+
+/**
+ * Initialize a `pdxcp_cdcl_cache` structure.
+ *
+ * No memory is allocated until the first entry is inserted.
+ *
+ * @param cache Cache to initialize
+ * @param capacity Maximum number of entries. Zero is treated as one, since a
+ *  cache must hold the entry it just inserted
+ */
+void
+pdxcp_cdcl_cache_init(pdxcp_cdcl_cache *cache, size_t capacity) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_cdcl_cache` structure, freeing all its entries.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_cache_init` must first be called.
+ *
+ * @param cache Cache to destroy
+ */
+void
+pdxcp_cdcl_cache_destroy(pdxcp_cdcl_cache *cache) PDXCP_NOEXCEPT;
+
+/**
+ * Parse declarations from a buffer through the cache.
+ *
+ * Each declaration, rendered in the cache's output format, is appended to the
+ * output byte vector, taken from the cache if the declaration's normalized
+ * token sequence was seen before, otherwise by parsing and rendering the
+ * declaration and then inserting the result. On error, renderings of the
+ * declarations preceding the error are still appended, the error details are
+ * in the parser state's `errinfo`, and the parser state's `n_decls` gives the
+ * number of successfully parsed declarations, including cache hits.
+ *
+ * Misses are parsed with the parser state's typedef name table, if any.
+ * Declarations that declare or use typedef names are not cached, so cached
+ * renderings never depend on the table and a cache may be used with parser
+ * states that have different tables.
+ *
+ * @param cache Cache to use
+ * @param parser Parser state to use on cache misses
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Number of bytes in the input buffer
+ * @param out Byte vector to append rendered declarations to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_cache_parse(
+  pdxcp_cdcl_cache *cache,
+  pdxcp_cdcl_parser *parser,
+  const char *in,
+  size_t in_size,
+  pdxcp_bvector *out) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_CACHE_H_
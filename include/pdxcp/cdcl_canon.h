@@ -0,0 +1,72 @@
+/**
+ * @file cdcl_canon.h
+ * @author Derek Huang
+ * @brief C/C++ header for C declaration type canonicalization and hashing
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_CANON_H_
+#define PDXCP_CDCL_CANON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Canonicalize the type of a parsed declaration in place.
+ *
+ * Qualifiers are stored as `PDXCP_CDCL_QUAL_*` flags so their order never
+ * matters. In addition, the following rewrites are made:
+ *
+ * - `signed` is removed from `int` and `long`, which are always signed. It is
+ *   kept for `char` as `signed char` and `char` are distinct types.
+ * - Parameter declarations are adjusted as when forming a function type, so
+ *   array parameters become pointers, function parameters become pointers to
+ *   functions, and top-level cv-qualifiers are removed.
+ *
+ * Identifiers are left as-is and `f()` is kept distinct from `f(void)`.
+ *
+ * @param decl Parsed declaration
+ * @param arena Arena to allocate pointer nodes for function parameters from.
+ *  This should be the arena the declaration was allocated from.
+ * @returns `true` on success, `false` on memory allocation failure
+ */
+bool
+pdxcp_cdcl_decl_canonicalize(
+  pdxcp_cdcl_decl *decl, pdxcp_arena *arena) PDXCP_NOEXCEPT;
+
+/**
+ * Return a stable 64-bit structural hash of a parsed declaration's type.
+ *
+ * The hash is the 64-bit FNV-1a hash of a byte encoding of the canonical type
+ * that uses the fixed `PDXCP_CDCL_TLV_*` codes, so it does not depend on the
+ * platform, build, or token type values and can be persisted. Identifiers
+ * are not part of the type. The declaration need not be canonicalized first,
+ * as the hash is computed as if `pdxcp_cdcl_decl_canonicalize` were called.
+ *
+ * @param decl Parsed declaration
+ */
+uint64_t
+pdxcp_cdcl_decl_type_hash(const pdxcp_cdcl_decl *decl) PDXCP_NOEXCEPT;
+
+/**
+ * Check if two parsed declarations have the same canonical type.
+ *
+ * This is used to resolve collisions of `pdxcp_cdcl_decl_type_hash`, so it
+ * also ignores identifiers and does not require canonicalized declarations.
+ *
+ * @param a First parsed declaration
+ * @param b Second parsed declaration
+ */
+bool
+pdxcp_cdcl_decl_type_equal(
+  const pdxcp_cdcl_decl *a, const pdxcp_cdcl_decl *b) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_CANON_H_
@@ -0,0 +1,185 @@
+/**
+ * @file cdcl_doc.h
+ * @author Derek Huang
+ * @brief C/C++ header for incrementally reparsed C declaration documents
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_DOC_H_
+#define PDXCP_CDCL_DOC_H_
+
+#include <stddef.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Document token.
+ *
+ * Tokens are located by their offsets into the document text instead of
+ * holding a copy of their text. Tokens the lexer rejects are kept as
+ * `pdxcp_cdcl_token_type_error` tokens spanning the rejected text.
+ *
+ * @param offset Byte offset of the first character of the token
+ * @param size Number of bytes in the token. For struct and enum tokens this
+ *  includes the whitespace and tag following the keyword
+ * @param type Token type
+ */
+typedef struct {
+  size_t offset;
+  size_t size;
+  pdxcp_cdcl_token_type type;
+} pdxcp_cdcl_doc_token;
+
+/**
+ * Document declaration.
+ *
+ * Each declaration is the run of tokens up to and including a `;` token. Any
+ * tokens after the last `;` in the document form a final, unterminated
+ * declaration, so each token belongs to exactly one declaration.
+ *
+ * @param first Index of the first token of the declaration
+ * @param n_tokens Number of tokens in the declaration, always positive
+ * @param status Parser status for the declaration
+ * @param decl Parsed declaration, only valid if `status` is
+ *  `pdxcp_cdcl_parser_status_ok`
+ * @param errinfo Error info if `status` is not `pdxcp_cdcl_parser_status_ok`,
+ *  otherwise `NULL`. The error offset is relative to the offset of the first
+ *  token of the declaration. `NULL` if the error info could not be allocated
+ * @param arena Arena the parsed declaration and error info are allocated from
+ */
+typedef struct {
+  size_t first;
+  size_t n_tokens;
+  pdxcp_cdcl_parser_status status;
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_errinfo *errinfo;
+  pdxcp_arena arena;
+} pdxcp_cdcl_doc_decl;
+
+/**
+ * Document of C declarations that is reparsed incrementally as it is edited.
+ *
+ * The document keeps its text, its tokens, and the parse result of each of
+ * its declarations. When the text is edited, lexing restarts from the end of
+ * the last token before the edit and stops at the first token past the edit
+ * that starts where an old token started, since lexing from there on gives
+ * the same tokens as before. Only declarations containing a relexed token are
+ * split again at their `;` tokens and reparsed. The lexing and parsing work
+ * for an edit therefore depends on the size of the edit and of the
+ * declarations it touches rather than on the size of the document, although
+ * the text and the token and declaration arrays after the edit are still
+ * moved and their offsets shifted.
+ *
+ * @param text Document text
+ * @param tokens Document tokens in text order
+ * @param n_tokens Number of tokens
+ * @param tokens_capacity Capacity of `tokens`
+ * @param decls Document declarations in text order
+ * @param n_decls Number of declarations
+ * @param decls_capacity Capacity of `decls`
+ * @param scratch Tokens lexed by the most recent edit
+ * @param scratch_capacity Capacity of `scratch`
+ * @param n_lexed Number of tokens lexed by the most recent edit
+ * @param first_parsed Index of the first declaration parsed by the most recent
+ *  edit, only meaningful if `n_parsed` is positive
+ * @param n_parsed Number of declarations parsed by the most recent edit
+ */
+typedef struct {
+  pdxcp_bvector text;
+  pdxcp_cdcl_doc_token *tokens;
+  size_t n_tokens;
+  size_t tokens_capacity;
+  pdxcp_cdcl_doc_decl *decls;
+  size_t n_decls;
+  size_t decls_capacity;
+  pdxcp_cdcl_doc_token *scratch;
+  size_t scratch_capacity;
+  size_t n_lexed;
+  size_t first_parsed;
+  size_t n_parsed;
+} pdxcp_cdcl_doc;
+
+/**
+ * Initialize an empty document.
+ *
+ * No memory is allocated until text is added.
+ *
+ * @param doc Document to initialize
+ */
+void
+pdxcp_cdcl_doc_init(pdxcp_cdcl_doc *doc) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a document.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_doc_init` must first be called.
+ *
+ * @param doc Document to destroy
+ */
+void
+pdxcp_cdcl_doc_destroy(pdxcp_cdcl_doc *doc) PDXCP_NOEXCEPT;
+
+/**
+ * Edit the document text, relexing and reparsing only what the edit affects.
+ *
+ * Syntax errors in the text are not errors of the edit but are reported in
+ * the status of the affected declarations.
+ *
+ * @param doc Document
+ * @param offset Byte offset of the edit
+ * @param n_removed Number of bytes removed starting at `offset`
+ * @param inserted Text inserted at `offset`, can be `NULL` if `n_inserted` is
+ *  zero. Need not be null-terminated
+ * @param n_inserted Number of bytes inserted
+ * @returns `pdxcp_cdcl_parser_status` parser status, which is
+ *  `pdxcp_cdcl_parser_status_bad_edit` without changing the document if the
+ *  removed range is not within the text. On allocation failure the document
+ *  is left empty
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_doc_edit(
+  pdxcp_cdcl_doc *doc,
+  size_t offset,
+  size_t n_removed,
+  const char *inserted,
+  size_t n_inserted) PDXCP_NOEXCEPT;
+
+/**
+ * Replace the entire document text.
+ *
+ * This is an edit that removes all the text, so everything is relexed and
+ * reparsed.
+ *
+ * @param doc Document
+ * @param text New text, can be `NULL` if `size` is zero
+ * @param size Number of bytes of new text
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_doc_set(
+  pdxcp_cdcl_doc *doc, const char *text, size_t size) PDXCP_NOEXCEPT;
+
+/**
+ * Find the declaration containing a byte offset with a binary search.
+ *
+ * A declaration contains the offsets from the start of its first token up to
+ * and including the end of its last token, so a cursor placed just after a
+ * `;` is still in the declaration the `;` ends.
+ *
+ * @param doc Document
+ * @param offset Byte offset
+ * @returns Index of the declaration, `doc->n_decls` if no declaration
+ *  contains the offset
+ */
+size_t
+pdxcp_cdcl_doc_find(const pdxcp_cdcl_doc *doc, size_t offset) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_DOC_H_
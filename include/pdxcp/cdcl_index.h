@@ -0,0 +1,271 @@
+/**
+ * @file cdcl_index.h
+ * @author Derek Huang
+ * @brief C/C++ header for the parallel C declaration source tree indexer
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_INDEX_H_
+#define PDXCP_CDCL_INDEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Index file magic bytes.
+ */
+#define PDXCP_CDCL_INDEX_MAGIC "PDXCPIDX"
+
+/**
+ * Index file format version.
+ */
+#define PDXCP_CDCL_INDEX_VERSION 1u
+
+/**
+ * Number of bytes in the index file header.
+ *
+ * All integers in an index file are little-endian. The header is the 8 magic
+ * bytes, the 32-bit format version, 4 reserved zero bytes, the 64-bit number
+ * of files, and the 64-bit number of entries. It is followed by a 64-bit
+ * string offset for each file path, `PDXCP_CDCL_INDEX_ENTRY_SIZE` bytes for
+ * each entry, and the string pool, whose null-terminated strings are located
+ * by their offsets from the start of the pool.
+ */
+#define PDXCP_CDCL_INDEX_HEADER_SIZE 32
+
+/**
+ * Number of bytes in each index file entry.
+ *
+ * Each entry is the 64-bit string offsets of the identifier and declaration
+ * text, the 64-bit file number, and the 64-bit byte offset of the declaration
+ * in the file. Entries are sorted by identifier, then file number, then byte
+ * offset, so all declarations of an identifier are adjacent.
+ */
+#define PDXCP_CDCL_INDEX_ENTRY_SIZE 32
+
+/**
+ * List of source file paths to index.
+ *
+ * @param arena Arena path strings are allocated from
+ * @param paths Array of null-terminated paths
+ * @param n_paths Number of paths
+ * @param capacity Capacity of `paths`
+ */
+typedef struct {
+  pdxcp_arena arena;
+  const char **paths;
+  size_t n_paths;
+  size_t capacity;
+} pdxcp_cdcl_index_paths;
+
+/**
+ * Initialize a source file path list.
+ *
+ * @param paths Path list to initialize
+ */
+void
+pdxcp_cdcl_index_paths_init(pdxcp_cdcl_index_paths *paths) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a source file path list.
+ *
+ * @param paths Path list to destroy
+ */
+void
+pdxcp_cdcl_index_paths_destroy(pdxcp_cdcl_index_paths *paths) PDXCP_NOEXCEPT;
+
+/**
+ * Add a source file path to the list.
+ *
+ * @param paths Path list
+ * @param path Null-terminated path, copied into the list
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+bool
+pdxcp_cdcl_index_paths_add(
+  pdxcp_cdcl_index_paths *paths, const char *path) PDXCP_NOEXCEPT;
+
+/**
+ * Add all `.c` and `.h` regular files under a directory tree to the list.
+ *
+ * The tree is walked with `fts` in sorted name order without following
+ * symbolic links, so paths are added in the same order on every run. If
+ * `root` is a regular file it is added regardless of its extension.
+ * Unreadable subdirectories are skipped.
+ *
+ * @param paths Path list
+ * @param root Directory tree root
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+bool
+pdxcp_cdcl_index_paths_add_tree(
+  pdxcp_cdcl_index_paths *paths, const char *root) PDXCP_NOEXCEPT;
+
+/**
+ * Find the next top-level declaration in C source text.
+ *
+ * Comments, string and character literals, preprocessor directives, and
+ * brace-enclosed blocks are skipped, as are declarations containing literals
+ * or blocks outside of initializers and function bodies, e.g. struct
+ * definitions. A function definition yields the declaration text before its
+ * body. Blocks of `extern "C"` are not skipped and the `"C"` of a single
+ * `extern "C"` declaration is dropped. The declaration text is
+ * written with comments and whitespace runs collapsed to single spaces,
+ * leading `extern`, `static`, and `inline` removed, any initializer removed,
+ * and a terminating `;`, so it can be handed directly to the parser. The text
+ * is also null-terminated, though the null terminator is not counted in its
+ * size. Declarations with several declarators are skipped.
+ *
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Number of bytes in the input buffer
+ * @param pos Address of the offset to start scanning at, updated to the
+ *  offset one past the end of the declaration or to `in_size`
+ * @param start Address to write the declaration's starting offset to
+ * @param text Byte vector to write the declaration text to, cleared first
+ * @returns `true` if a declaration was found, `false` at end of input or on
+ *  allocation failure (`errno` is ENOMEM)
+ */
+bool
+pdxcp_cdcl_index_next_decl(
+  const char *in,
+  size_t in_size,
+  size_t *pos,
+  size_t *start,
+  pdxcp_bvector *text) PDXCP_NOEXCEPT;
+
+/**
+ * Indexing statistics.
+ *
+ * @param n_files Number of files read
+ * @param n_failed Number of files that could not be read
+ * @param n_entries Number of declarations indexed
+ * @param n_skipped Number of declarations the parser does not support
+ */
+typedef struct {
+  size_t n_files;
+  size_t n_failed;
+  size_t n_entries;
+  size_t n_skipped;
+} pdxcp_cdcl_index_stats;
+
+/**
+ * Index the top-level declarations of source files using multiple threads.
+ *
+ * Each thread starts with an equal range of files and parses them with its
+ * own parser state. A thread that runs out of files steals half of the
+ * remaining range of another thread, so uneven file sizes are balanced. The
+ * index is written to the output stream sorted by identifier, so the output
+ * only depends on the input files and not on thread scheduling. Files that
+ * cannot be read are counted but are not an error.
+ *
+ * Parsing is typedef-aware with a typedef name table per file, so typedef
+ * declarations are indexed and typedef names are types in the rest of the
+ * file declaring them. Declarations using typedef names from other files,
+ * e.g. included headers, are skipped.
+ *
+ * @param paths Source file paths
+ * @param out Output stream
+ * @param n_threads Number of threads to use, if zero then the number of online
+ *  processors is used. If one, all parsing is done on the calling thread
+ * @param stats Address to write indexing statistics to, ignored if `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_index_build(
+  const pdxcp_cdcl_index_paths *paths,
+  FILE *out,
+  unsigned int n_threads,
+  pdxcp_cdcl_index_stats *stats) PDXCP_NOEXCEPT;
+
+/**
+ * Read-only view of an index, usually of a memory-mapped index file.
+ *
+ * @param data Index data
+ * @param n_files Number of files
+ * @param n_entries Number of entries
+ * @param files File path string offsets
+ * @param entries Entries
+ * @param strings String pool
+ * @param strings_size Number of bytes in the string pool
+ */
+typedef struct {
+  const unsigned char *data;
+  size_t n_files;
+  size_t n_entries;
+  const unsigned char *files;
+  const unsigned char *entries;
+  const char *strings;
+  size_t strings_size;
+} pdxcp_cdcl_index;
+
+/**
+ * Index entry.
+ *
+ * @param name Identifier
+ * @param decl Declaration text
+ * @param path Path of the file containing the declaration
+ * @param pos Byte offset of the declaration in the file
+ */
+typedef struct {
+  const char *name;
+  const char *decl;
+  const char *path;
+  uint64_t pos;
+} pdxcp_cdcl_index_entry;
+
+/**
+ * Open a view of index data.
+ *
+ * The header, table sizes, and string pool termination are validated here,
+ * while the string offsets and file number of an entry are validated when the
+ * entry is read.
+ *
+ * @param index Index view to initialize
+ * @param data Index data, which must outlive the view
+ * @param size Number of bytes of index data
+ * @returns `true` on success, `false` if the data is not a valid index
+ */
+bool
+pdxcp_cdcl_index_open(
+  pdxcp_cdcl_index *index, const void *data, size_t size) PDXCP_NOEXCEPT;
+
+/**
+ * Read an index entry.
+ *
+ * @param index Index view
+ * @param i Entry number, must be less than `index->n_entries`
+ * @param entry Entry to write to
+ * @returns `true` on success, `false` if the entry has invalid offsets
+ */
+bool
+pdxcp_cdcl_index_get(
+  const pdxcp_cdcl_index *index,
+  size_t i,
+  pdxcp_cdcl_index_entry *entry) PDXCP_NOEXCEPT;
+
+/**
+ * Find the entries for an identifier with a binary search.
+ *
+ * @param index Index view
+ * @param name Null-terminated identifier
+ * @param n_found Address to write the number of matching entries to
+ * @returns Entry number of the first matching entry
+ */
+size_t
+pdxcp_cdcl_index_find(
+  const pdxcp_cdcl_index *index,
+  const char *name,
+  size_t *n_found) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_INDEX_H_
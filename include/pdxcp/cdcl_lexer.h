@@ -8,6 +8,7 @@
 #ifndef PDXCP_CDCL_LEXER_H_
 #define PDXCP_CDCL_LEXER_H_
 
+#include <stdbool.h>
 #include <stdio.h>
 
 #include "pdxcp/common.h"
@@ -16,6 +17,9 @@ PDXCP_EXTERN_C_BEGIN
 
 /**
  * Token type enumeration.
+ *
+ * The lexer never produces `pdxcp_cdcl_token_type_t_name`. The parser uses it
+ * for identifiers that are in its typedef name table.
  */
 typedef enum {
   pdxcp_cdcl_token_type_error,       // error, unknown token
@@ -41,6 +45,7 @@ typedef enum {
   pdxcp_cdcl_token_type_t_double,    // double
   pdxcp_cdcl_token_type_num,         // <text> (number)
   pdxcp_cdcl_token_type_iden,        // <text> (identifier)
+  pdxcp_cdcl_token_type_t_name,      // <text> (typedef name, parser only)
   pdxcp_cdcl_token_type_max          // number of valid token types
 } pdxcp_cdcl_token_type;
 
@@ -130,6 +135,55 @@ typedef struct pdxcp_cdcl_token {
 pdxcp_cdcl_lexer_status
 pdxcp_cdcl_get_token(FILE *in, pdxcp_cdcl_token *token) PDXCP_NOEXCEPT;
 
+/**
+ * Input buffer cursor for the buffer lexer.
+ *
+ * @param start First character in the buffer, which offsets are relative to
+ * @param pos Next character to read
+ * @param end One past the last character in the buffer
+ * @param token First character of the most recently read token, so the token
+ *  spans `token` to `pos`. Equal to `end` once the end of the buffer is read
+ */
+typedef struct {
+  const char *start;
+  const char *pos;
+  const char *end;
+  const char *token;
+} pdxcp_cdcl_lexer_buf;
+
+/**
+ * Initialize an input buffer cursor to the start of a buffer.
+ *
+ * @param buf Pointer to a `pdxcp_cdcl_lexer_buf`
+ * @param data Input buffer, need not be null-terminated
+ * @param size Number of bytes in the input buffer
+ */
+#define PDXCP_CDCL_LEXER_BUF_INIT(buf, data, size) \
+  do { \
+    (buf)->start = (buf)->pos = (buf)->token = (data); \
+    (buf)->end = (data) + (size); \
+  } \
+  while (false)
+
+/**
+ * Get the next token from the specified input buffer.
+ *
+ * Tokens are the same as those returned by `pdxcp_cdcl_get_token`, but since
+ * the whole input is already in memory, no per-character stream calls are
+ * made and identifiers are copied into the token text with a single `memcpy`.
+ * Reaching the end of the buffer is reported as
+ * `pdxcp_cdcl_lexer_status_fgetc_eof` just like EOF for a stream.
+ *
+ * @param in Input buffer cursor, advanced past the token read
+ * @param token Token to write to
+ * @returns `pdxcp_cdcl_lexer_status` status code. If
+ *  `pdxcp_cdcl_lexer_status_bad_token` is returned, the token type is
+ *  `pdxcp_cdcl_token_type_error` and token text has error details
+ */
+pdxcp_cdcl_lexer_status
+pdxcp_cdcl_get_token_buf(
+  pdxcp_cdcl_lexer_buf *in, pdxcp_cdcl_token *token) PDXCP_NOEXCEPT;
+
 PDXCP_EXTERN_C_END
 
 #endif  // PDXCP_CDCL_LEXER_H_
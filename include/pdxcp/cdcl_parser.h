@@ -10,35 +10,84 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
 #include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_typedefs.h"
 #include "pdxcp/common.h"
 
 PDXCP_EXTERN_C_BEGIN
 
 /**
- * Number of tokens that can fit in a single parser token stack.
+ * Number of token handles that fit in a token stack before it spills.
+ *
+ * Most declarations push only a handful of tokens, so the inline storage is
+ * enough and the token stack never needs to allocate.
+ */
+#define PDXCP_CDCL_PARSER_STACK_SIZE 16
+
+/**
+ * Maximum nesting depth of function parameter lists.
+ *
+ * Parameter lists are the only part of a declaration parsed recursively, so
+ * limiting their nesting bounds the C call stack used by the parser. Pointers
+ * and grouping parentheses of any depth only use the token stack.
  */
-#define PDXCP_CDCL_PARSER_STACK_SIZE 20
+#define PDXCP_CDCL_PARSER_MAX_DEPTH 64
+
+/**
+ * Compact token handle stored on the token stack.
+ *
+ * Only struct, enum, and typedef name tokens carry text, so instead of copying
+ * entire tokens onto the stack, the text of these tokens is copied into an
+ * arena and the handle just points to it.
+ *
+ * @param type Token type
+ * @param text Null-terminated token text, empty string if no text
+ */
+typedef struct {
+  pdxcp_cdcl_token_type type;
+  const char *text;
+} pdxcp_cdcl_token_handle;
 
 /**
  * Token stack.
  *
+ * Token handles are stored inline until the inline storage is full, after
+ * which they spill to storage allocated from the arena passed to
+ * `pdxcp_cdcl_token_stack_push`. Since the token stack owns no memory, it
+ * needs no destruction, but it must be reinitialized whenever the arena it
+ * was used with is reset.
+ *
  * @param n_tokens Number of tokens currently in the stack
- * @param tokens Array of saved tokens
+ * @param capacity Number of token handles the current storage can hold
+ * @param spill Arena-allocated token handle storage, `NULL` if inline
+ * @param tokens Inline token handle storage
  */
 typedef struct {
   size_t n_tokens;
-  pdxcp_cdcl_token tokens[PDXCP_CDCL_PARSER_STACK_SIZE];
+  size_t capacity;
+  pdxcp_cdcl_token_handle *spill;
+  pdxcp_cdcl_token_handle tokens[PDXCP_CDCL_PARSER_STACK_SIZE];
 } pdxcp_cdcl_token_stack;
 
 /**
  * Initialize a token stack by setting its size to zero.
  *
+ * Any previously spilled storage is dropped in favor of the inline storage.
+ *
  * @param stack Pointer to a valid `pdxcp_cdcl_token_stack`
  */
-#define PDXCP_CDCL_TOKEN_STACK_INIT(stack) (stack)->n_tokens = 0
+#define PDXCP_CDCL_TOKEN_STACK_INIT(stack) \
+  do { \
+    (stack)->n_tokens = 0; \
+    (stack)->capacity = PDXCP_CDCL_PARSER_STACK_SIZE; \
+    (stack)->spill = NULL; \
+  } \
+  while (false)
 
 /**
  * Macro for checking if the token stack is empty or not.
@@ -48,46 +97,49 @@ typedef struct {
 #define PDXCP_CDCL_TOKEN_STACK_EMPTY(stack) !(stack)->n_tokens
 
 /**
- * Macro for checking if the token stack is full or not.
+ * Macro for getting a pointer to the token stack's token handle storage.
  *
  * @param stack Pointer to a valid `pdxcp_cdcl_token_stack`
  */
-#define PDXCP_CDCL_TOKEN_STACK_FULL(stack) \
-  ((stack)->n_tokens >= PDXCP_CDCL_PARSER_STACK_SIZE)
+#define PDXCP_CDCL_TOKEN_STACK_DATA(stack) \
+  ((stack)->spill ? (stack)->spill : (stack)->tokens)
 
 /**
- * Macro for getting a pointer to the token on the top of the stack.
+ * Macro for getting a pointer to the token handle on the top of the stack.
  *
  * @note Behavior is undefined if the stack is empty.
  *
  * @param stack Pointer to a valid `pdxcp_cdcl_token_stack`
  */
 #define PDXCP_CDCL_TOKEN_STACK_HEAD(stack) \
-  ((stack)->tokens + (stack)->n_tokens - 1)
+  (PDXCP_CDCL_TOKEN_STACK_DATA(stack) + (stack)->n_tokens - 1)
 
 /**
- * Macro for pushing a token onto the stack.
+ * Macro for popping a token off of the stack.
  *
- * @note Behavior is undefined if the stack is full.
+ * @note Behavior is undefined if the stack is empty.
  *
  * @param stack Pointer to a valid `pdxcp_cdcl_token_stack`
- * @param token Pointer to a valid `pdxcp_cdcl_token`
  */
-#define PDXCP_CDCL_TOKEN_STACK_PUSH(stack, token) \
-  do { \
-    memcpy(PDXCP_CDCL_TOKEN_STACK_HEAD(stack) + 1, token, sizeof *(token)); \
-    (stack)->n_tokens++; \
-  } \
-  while (false)
+#define PDXCP_CDCL_TOKEN_STACK_POP(stack) (stack)->n_tokens--
 
 /**
- * Macro for popping a token off of the stack.
+ * Push a token onto the token stack.
  *
- * @note Behavior is undefined if the stack is empty.
+ * If the token has text, the text is copied into the arena. If the stack is
+ * full, its contents are moved to new storage with double the capacity that
+ * is allocated from the arena.
  *
- * @param stack Pointer to a valid `pdxcp_cdcl_token_stack`
+ * @param stack Token stack to push onto
+ * @param arena Arena to allocate token text and spilled storage from
+ * @param token Token to push
+ * @returns `true` on success, `false` on allocation failure
  */
-#define PDXCP_CDCL_TOKEN_STACK_POP(stack) (stack)->n_tokens--
+bool
+pdxcp_cdcl_token_stack_push(
+  pdxcp_cdcl_token_stack *stack,
+  pdxcp_arena *arena,
+  const pdxcp_cdcl_token *token) PDXCP_NOEXCEPT;
 
 /**
  * Parser status codes.
@@ -103,7 +155,7 @@ typedef enum {
   pdxcp_cdcl_parser_status_eof,
   // lexer error, check errinfo
   pdxcp_cdcl_parser_status_lexer_err,
-  // token stack overflow
+  // token stack overflow (no longer returned, token stack is growable)
   pdxcp_cdcl_parser_status_token_overflow,
   // error writing parser output to FILE *
   pdxcp_cdcl_parser_status_out_err,
@@ -111,10 +163,26 @@ typedef enum {
   pdxcp_cdcl_parser_status_parse_err,
   // bad token (may be removed, could be duplicate as lexer checks tokens)
   pdxcp_cdcl_parser_status_bad_token,
-  // parser error text is NULL when it should not be
+  // parser error text is NULL (no longer returned, error text is formatted)
   pdxcp_cdcl_parser_status_null_err_text,
-  // supplied parser error text is too long and therefore truncated
-  pdxcp_cdcl_parser_status_err_text_too_long
+  // parser error text truncated (no longer returned, error text is formatted)
+  pdxcp_cdcl_parser_status_err_text_too_long,
+  // arena to allocate declaration nodes from is NULL
+  pdxcp_cdcl_parser_status_arena_null,
+  // declaration to write parse result to is NULL
+  pdxcp_cdcl_parser_status_decl_null,
+  // memory allocation failure
+  pdxcp_cdcl_parser_status_no_mem,
+  // caller-provided output buffer too small, output truncated
+  pdxcp_cdcl_parser_status_out_too_small,
+  // declaration callback is NULL
+  pdxcp_cdcl_parser_status_callback_null,
+  // failed to open input buffer as a stream
+  pdxcp_cdcl_parser_status_buf_open_err,
+  // unknown output format
+  pdxcp_cdcl_parser_status_bad_format,
+  // edit range is outside of the document
+  pdxcp_cdcl_parser_status_bad_edit
 } pdxcp_cdcl_parser_status;
 
 /**
@@ -147,17 +215,110 @@ pdxcp_cdcl_parser_status_message(pdxcp_cdcl_parser_status status) PDXCP_NOEXCEPT
 #define PDXCP_CDCL_PARSER_OK(status) ((status) == pdxcp_cdcl_parser_status_ok)
 
 /**
- * Maximum length of parser error text.
+ * Parser error codes.
+ *
+ * Each code identifies one kind of parse error, i.e. one error message. The
+ * parser only records the code and the structured data the message needs, so
+ * failing is cheap when the error text is never looked at.
+ */
+typedef enum {
+  // no parse error
+  pdxcp_cdcl_parser_error_none,
+  // duplicate pointer const qualifier
+  pdxcp_cdcl_parser_error_ptr_dup_const,
+  // duplicate pointer volatile qualifier
+  pdxcp_cdcl_parser_error_ptr_dup_volatile,
+  // unexpected token when parsing pointers, see token + name
+  pdxcp_cdcl_parser_error_ptr_token,
+  // ran out of tokens when parsing pointers
+  pdxcp_cdcl_parser_error_ptr_no_type,
+  // mismatched parentheses, see n_lparen + n_rparen
+  pdxcp_cdcl_parser_error_paren_mismatch,
+  // internal error, array parsing started without '['
+  pdxcp_cdcl_parser_error_array_internal,
+  // duplicate '[' in array specifier
+  pdxcp_cdcl_parser_error_array_dup_langle,
+  // array size without preceding '['
+  pdxcp_cdcl_parser_error_array_size_no_langle,
+  // array size out of range
+  pdxcp_cdcl_parser_error_array_size_range,
+  // array size is zero
+  pdxcp_cdcl_parser_error_array_size_zero,
+  // array size is negative
+  pdxcp_cdcl_parser_error_array_size_negative,
+  // ']' without preceding '['
+  pdxcp_cdcl_parser_error_array_no_langle,
+  // unsized array dimension other than the first
+  pdxcp_cdcl_parser_error_array_no_bounds,
+  // unexpected token when parsing array specifiers, see token + name
+  pdxcp_cdcl_parser_error_array_token,
+  // function parameter lists nested too deeply
+  pdxcp_cdcl_parser_error_params_depth,
+  // unexpected token when parsing function parameters, see token + name
+  pdxcp_cdcl_parser_error_params_token,
+  // void parameter that is named, qualified, or not the only parameter
+  pdxcp_cdcl_parser_error_params_void,
+  // function returning an array
+  pdxcp_cdcl_parser_error_return_array,
+  // function returning a function
+  pdxcp_cdcl_parser_error_return_function,
+  // array of functions
+  pdxcp_cdcl_parser_error_array_function,
+  // duplicate type const qualifier
+  pdxcp_cdcl_parser_error_type_dup_const,
+  // duplicate type volatile qualifier
+  pdxcp_cdcl_parser_error_type_dup_volatile,
+  // duplicate signed qualifier
+  pdxcp_cdcl_parser_error_type_dup_signed,
+  // duplicate unsigned qualifier
+  pdxcp_cdcl_parser_error_type_dup_unsigned,
+  // signed qualifier on unsigned type
+  pdxcp_cdcl_parser_error_type_signed_unsigned,
+  // unsigned qualifier on signed type
+  pdxcp_cdcl_parser_error_type_unsigned_signed,
+  // second type specifier, see token + type
+  pdxcp_cdcl_parser_error_type_redefined,
+  // unexpected token when parsing the type, see token + name
+  pdxcp_cdcl_parser_error_type_token,
+  // no type specifier
+  pdxcp_cdcl_parser_error_type_missing,
+  // sign qualifier on a type other than char, int, or long, see token
+  pdxcp_cdcl_parser_error_type_bad_sign,
+  // tokens following the declarator, see name
+  pdxcp_cdcl_parser_error_incomplete
+} pdxcp_cdcl_parser_error;
+
+/**
+ * Return a string for the given parser error code.
+ *
+ * If the value is unknown, a pointer to `"(unknown)"` is returned.
+ *
+ * @param error Parser error code
+ */
+const char *
+pdxcp_cdcl_parser_error_string(pdxcp_cdcl_parser_error error) PDXCP_NOEXCEPT;
+
+/**
+ * Buffer size that always fits formatted parser error text.
+ *
+ * This excludes the null terminator.
  */
 #define PDXCP_CDCL_PARSER_ERROR_TEXT_LEN 255
 
 /**
  * Struct to hold parser error information.
  *
- * @todo Rename + rework to hold parser error info as well, not just lexer.
+ * Errors are stored as structured data and are only formatted as text by
+ * `pdxcp_cdcl_parser_errinfo_format`.
  *
  * @param lexer Lexer error info
  * @param parser Parser error info
+ * @param offset Byte offset of the first character of the token at which the
+ *  error was detected. For buffers the offset is from the buffer cursor's
+ *  `start`. For streams only the end of the token is known, so the offset is
+ *  the `ftell` position just past the token, `SIZE_MAX` if unknown
+ * @param span Number of bytes in the token at which the error was detected,
+ *  always zero for streams
  */
 typedef struct {
   /**
@@ -175,31 +336,510 @@ typedef struct {
   /**
    * Parser error info.
    *
-   * @note Size of parser error text may be changed later.
+   * Members other than `status` and `error` are only meaningful for the
+   * error codes that mention them.
    *
    * @param status Parser status
-   * @param text Null-terminated parser error text
+   * @param error Parser error code, `pdxcp_cdcl_parser_error_none` unless
+   *  `status` is `pdxcp_cdcl_parser_status_parse_err`
+   * @param token Type of the token the error is about
+   * @param type Type specifier token type already read when another is read
+   * @param n_lparen Number of '(' read
+   * @param n_rparen Number of ')' read
+   * @param name Null-terminated text of the token the error is about, or the
+   *  identifier of an incomplete declaration
    */
   struct {
     pdxcp_cdcl_parser_status status;
-    char text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
+    pdxcp_cdcl_parser_error error;
+    pdxcp_cdcl_token_type token;
+    pdxcp_cdcl_token_type type;
+    unsigned int n_lparen;
+    unsigned int n_rparen;
+    char name[PDXCP_CDCL_MAX_TOKEN_LEN + 1];
   } parser;
+  size_t offset;
+  size_t span;
 } pdxcp_cdcl_parser_errinfo;
 
+/**
+ * Format the error text for the given error info.
+ *
+ * Parse errors are formatted from the parser error code and its structured
+ * data, lexer errors include the lexer status and lexer error text, and other
+ * errors use `pdxcp_cdcl_parser_status_message`. Like `snprintf`, the text is
+ * truncated if the buffer is too small and is always null-terminated if
+ * `buf_size` is nonzero. A buffer of `PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1`
+ * bytes is always large enough.
+ *
+ * @param errinfo Error info
+ * @param buf Output buffer
+ * @param buf_size Output buffer size in bytes
+ * @returns Untruncated text length, excluding the null terminator
+ */
+size_t
+pdxcp_cdcl_parser_errinfo_format(
+  const pdxcp_cdcl_parser_errinfo *errinfo,
+  char *buf,
+  size_t buf_size) PDXCP_NOEXCEPT;
+
+/**
+ * Declaration node kinds.
+ */
+typedef enum {
+  pdxcp_cdcl_decl_kind_type,      // (qualified) base type, always last node
+  pdxcp_cdcl_decl_kind_pointer,   // (qualified) pointer to
+  pdxcp_cdcl_decl_kind_array,     // array of
+  pdxcp_cdcl_decl_kind_function   // function returning
+} pdxcp_cdcl_decl_kind;
+
+/**
+ * Return a string for the given declaration node kind.
+ *
+ * If the value is unknown, a pointer to `"(unknown)"` is returned.
+ *
+ * @param kind Declaration node kind
+ */
+const char *
+pdxcp_cdcl_decl_kind_string(pdxcp_cdcl_decl_kind kind) PDXCP_NOEXCEPT;
+
+/**
+ * Qualifier bit flags for declaration nodes.
+ *
+ * Pointer nodes may only be cv-qualified while type nodes may also be sign
+ * qualified. At most one of the sign qualifiers is ever set.
+ */
+#define PDXCP_CDCL_QUAL_CONST 0x1u
+#define PDXCP_CDCL_QUAL_VOLATILE 0x2u
+#define PDXCP_CDCL_QUAL_SIGNED 0x4u
+#define PDXCP_CDCL_QUAL_UNSIGNED 0x8u
+
+struct pdxcp_cdcl_decl;
+
+/**
+ * Declaration node.
+ *
+ * Each node is one layer of the declared type, linked from the outermost layer
+ * that applies directly to the identifier to the base type. For example, the
+ * chain for `const char *argv[10]` is array, pointer, then type, which reads
+ * as "array[10] of pointer to const char", while the chain for
+ * `int (*f)(char)` is pointer, function, then type, which reads as "pointer
+ * to function(char) returning int". All nodes are arena-allocated.
+ *
+ * @param kind Node kind
+ * @param quals Bitwise OR of `PDXCP_CDCL_QUAL_*` qualifier flags
+ * @param type Base type token type, only meaningful for type nodes
+ * @param name Struct or enum tag or typedef name for type nodes, otherwise
+ *  `NULL`. Typedef names have type `pdxcp_cdcl_token_type_t_name`
+ * @param size Array size for array nodes, zero if the size is unspecified
+ * @param params Function parameter list for function nodes, `NULL` if empty
+ * @param next Next (inner) layer of the type, `NULL` for type nodes
+ */
+typedef struct pdxcp_cdcl_decl_node {
+  pdxcp_cdcl_decl_kind kind;
+  unsigned int quals;
+  pdxcp_cdcl_token_type type;
+  union {
+    const char *name;
+    size_t size;
+    struct pdxcp_cdcl_decl *params;
+  };
+  struct pdxcp_cdcl_decl_node *next;
+} pdxcp_cdcl_decl_node;
+
+/**
+ * Parsed declaration.
+ *
+ * @param iden Null-terminated identifier name, arena-allocated. `NULL` only
+ *  for abstract parameter declarations, e.g. the `char *` in `int f(char *)`
+ * @param node First (outermost) declaration node
+ * @param next Next declaration in a parameter list, otherwise `NULL`
+ * @param is_typedef `true` if the declaration is a `typedef` declaration of
+ *  `iden` as a name for the declared type. Only typedef-aware parsing
+ *  produces these, see `pdxcp_cdcl_parser`
+ */
+typedef struct pdxcp_cdcl_decl {
+  const char *iden;
+  pdxcp_cdcl_decl_node *node;
+  struct pdxcp_cdcl_decl *next;
+  bool is_typedef;
+} pdxcp_cdcl_decl;
+
+/**
+ * Parse a declaration from the input stream into a declaration node tree.
+ *
+ * All the memory for the parsed declaration is allocated from the arena, so
+ * the declaration remains valid until the arena is reset or destroyed. Many
+ * declarations can be parsed with the same arena with a single reset when the
+ * whole batch is no longer needed. Nothing is ever freed node by node.
+ *
+ * The full declarator grammar is supported, including function declarators
+ * with (possibly abstract) parameter declarations and arbitrary nesting, e.g.
+ * `int (*x[10])(char *, double);`. Parsing is done in a single pass over the
+ * input and takes time linear in the number of tokens.
+ *
+ * @param in Input stream
+ * @param arena Arena to allocate declaration nodes from
+ * @param decl Declaration to write parse result to
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_decl(
+  FILE *in,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
+
+/**
+ * Parse a declaration from the input buffer into a declaration node tree.
+ *
+ * Behaves like `pdxcp_cdcl_parse_decl` but lexes directly from memory with
+ * `pdxcp_cdcl_get_token_buf`, so no `FILE *` is needed. On return the buffer
+ * cursor is positioned after the last token read.
+ *
+ * @param in Input buffer cursor
+ * @param arena Arena to allocate declaration nodes from
+ * @param decl Declaration to write parse result to
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_decl_buf(
+  pdxcp_cdcl_lexer_buf *in,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
+
+/**
+ * Append an English description of a parsed declaration to a byte vector.
+ *
+ * The description is terminated with a newline but not null-terminated. The
+ * byte vector is not cleared first, so one byte vector can be reused for many
+ * declarations by setting its size to zero between calls.
+ *
+ * @param decl Parsed declaration
+ * @param out Byte vector to append to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render(
+  const pdxcp_cdcl_decl *decl, pdxcp_bvector *out) PDXCP_NOEXCEPT;
+
+/**
+ * Write an English description of a parsed declaration into a buffer.
+ *
+ * The description is terminated with a newline and is always null-terminated
+ * if `buf_size` is nonzero. Like `snprintf`, if the buffer is too small, the
+ * output is truncated and the full length is still written to `len`.
+ *
+ * @param decl Parsed declaration
+ * @param buf Output buffer
+ * @param buf_size Output buffer size in bytes
+ * @param len Address to write the untruncated description length to,
+ *  excluding the null terminator. Ignored if `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status, which is
+ *  `pdxcp_cdcl_parser_status_out_too_small` if the output was truncated
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_buf(
+  const pdxcp_cdcl_decl *decl,
+  char *buf,
+  size_t buf_size,
+  size_t *len) PDXCP_NOEXCEPT;
+
+/**
+ * Write an English description of a parsed declaration to the output stream.
+ *
+ * The description is terminated with a newline. It is rendered into a buffer
+ * first and then written with a single call to `fwrite`.
+ *
+ * @param out Output stream
+ * @param decl Parsed declaration
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_write(FILE *out, const pdxcp_cdcl_decl *decl) PDXCP_NOEXCEPT;
+
+/**
+ * Parser phases timed when parser statistics are enabled.
+ */
+typedef enum {
+  pdxcp_cdcl_parser_phase_to_iden,  // pushing tokens up to the identifier
+  pdxcp_cdcl_parser_phase_ptrs,     // popping pointers and their qualifiers
+  pdxcp_cdcl_parser_phase_arrays,   // array suffixes
+  pdxcp_cdcl_parser_phase_type,     // base type specifiers and qualifiers
+  pdxcp_cdcl_parser_phase_max       // number of timed phases
+} pdxcp_cdcl_parser_phase;
+
+/**
+ * Return a string for the given parser phase value.
+ *
+ * If the value is unknown, a pointer to `"(unknown)"` is returned.
+ *
+ * @param phase Parser phase value
+ */
+const char *
+pdxcp_cdcl_parser_phase_string(pdxcp_cdcl_parser_phase phase) PDXCP_NOEXCEPT;
+
+/**
+ * Per-phase parser statistics.
+ *
+ * Statistics are only collected if the library is compiled with
+ * `PDXCP_CDCL_ENABLE_STATS` defined, e.g. by configuring CMake with
+ * `-DENABLE_CDCL_STATS=ON` or by running `make ENABLE_CDCL_STATS=1`.
+ * Otherwise the counting and timing code is compiled out and the statistics
+ * are left as-is. Statistics are accumulated, so they must be zeroed with
+ * `pdxcp_cdcl_parser_stats_init` before first use.
+ *
+ * Phase times are exclusive, so time spent in a phase nested in another,
+ * e.g. in the declarator of a function parameter, is only charged to the
+ * nested phase. Lexing is charged to the phase that reads the token.
+ *
+ * @param n_tokens Number of tokens successfully lexed
+ * @param max_depth Maximum number of tokens on the token stack
+ * @param phase_ns Nanoseconds spent in each `pdxcp_cdcl_parser_phase`
+ * @param out_bytes Number of output bytes written
+ */
+typedef struct {
+  size_t n_tokens;
+  size_t max_depth;
+  uint64_t phase_ns[pdxcp_cdcl_parser_phase_max];
+  size_t out_bytes;
+} pdxcp_cdcl_parser_stats;
+
+/**
+ * Zero a `pdxcp_cdcl_parser_stats` structure.
+ *
+ * @param stats Parser statistics to zero
+ */
+void
+pdxcp_cdcl_parser_stats_init(pdxcp_cdcl_parser_stats *stats) PDXCP_NOEXCEPT;
+
+/**
+ * Return `true` if the library was compiled to collect parser statistics.
+ */
+bool
+pdxcp_cdcl_parser_stats_enabled(void) PDXCP_NOEXCEPT;
+
 /**
  * Parse text from the input stream and write output to the output stream.
  *
  * This routine parses valid C declarations from the input stream and writes a
- * description of the declaration to the output stream.
+ * description of the declaration to the output stream. It is equivalent to
+ * calling `pdxcp_cdcl_parse_decl` followed by `pdxcp_cdcl_decl_write` with a
+ * temporary arena. The output is atomic in that nothing is written if there
+ * is a parsing error and a successful parse is written all at once.
  *
- * @note Parser is currently not atomic in its operation. It can write partial
- *  output before hitting an error since it is basically a pushdown automata,
- *  storing tokens for later consumption on a stack.
+ * @param in Input stream
+ * @param out Output stream
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
  */
 pdxcp_cdcl_parser_status
 pdxcp_cdcl_stream_parse(
   FILE *in, FILE *out, pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
 
+/**
+ * Parse text from the input stream and write output to the output stream,
+ * accumulating parser statistics.
+ *
+ * Behaves like `pdxcp_cdcl_stream_parse`. The number of output bytes is only
+ * counted if the output was successfully written.
+ *
+ * @param in Input stream
+ * @param out Output stream
+ * @param errinfo Error info structure, can be `NULL`
+ * @param stats Parser statistics to accumulate into, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_stats(
+  FILE *in,
+  FILE *out,
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  pdxcp_cdcl_parser_stats *stats) PDXCP_NOEXCEPT;
+
+/**
+ * Parse text from the input buffer and write output to the output buffer.
+ *
+ * This is the in-memory counterpart of `pdxcp_cdcl_stream_parse` and is
+ * equivalent to calling `pdxcp_cdcl_parse_decl_buf` followed by
+ * `pdxcp_cdcl_decl_render_buf` with a temporary arena, so no `FILE *` is
+ * needed for either the input or the output. Like `snprintf`, if the output
+ * buffer is too small, the output is truncated and the full length is still
+ * written to `len`, so the caller can retry with a large enough buffer.
+ *
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Input buffer size in bytes
+ * @param out Output buffer, can be `NULL` if `out_size` is zero
+ * @param out_size Output buffer size in bytes
+ * @param len Address to write the untruncated description length to,
+ *  excluding the null terminator. Ignored if `NULL`
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status, which is
+ *  `pdxcp_cdcl_parser_status_out_too_small` if the output was truncated
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_buf(
+  const char *in,
+  size_t in_size,
+  char *out,
+  size_t out_size,
+  size_t *len,
+  pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
+
+/**
+ * Reusable parser state for parsing many declarations.
+ *
+ * Holds everything the parser needs between declarations so that parsing a
+ * stream of many declarations does no per-declaration setup or allocation
+ * once the arena and buffer have grown to their steady-state sizes.
+ *
+ * @param arena Arena declarations are allocated from, reset per declaration
+ * @param buf Reusable byte vector callbacks may render declarations into
+ * @param stack Token stack
+ * @param errinfo Error info for the most recent parser error
+ * @param n_decls Number of declarations successfully parsed by the most recent
+ *  call to `pdxcp_cdcl_stream_parse_all` or `pdxcp_cdcl_buf_parse_all`
+ * @param recover `true` to resume parsing after lexer and parser errors,
+ *  `false` by default. See `pdxcp_cdcl_stream_parse_all` for details
+ * @param n_errors Number of errors reported by the most recent call to
+ *  `pdxcp_cdcl_stream_parse_all` or `pdxcp_cdcl_buf_parse_all`
+ * @param stats Parser statistics accumulated over all calls to
+ *  `pdxcp_cdcl_stream_parse_all` and `pdxcp_cdcl_buf_parse_all` since
+ *  initialization. Since callbacks do the writing, `out_bytes` is only
+ *  updated by callbacks that choose to
+ * @param typedefs Typedef name table, `NULL` by default. If not `NULL`,
+ *  parsing is typedef-aware: identifiers in the table are type specifiers
+ *  unless another type specifier precedes them, and declarations starting
+ *  with `typedef` are parsed and their identifiers added to the table. The
+ *  table is not owned by the parser and may be shared by parsers that are
+ *  not used concurrently. Since names already in the table are not added
+ *  again, a table holding every typedef name in the input is only read and
+ *  may then be shared by parsers used concurrently
+ */
+typedef struct pdxcp_cdcl_parser {
+  pdxcp_arena arena;
+  pdxcp_bvector buf;
+  pdxcp_cdcl_token_stack stack;
+  pdxcp_cdcl_parser_errinfo errinfo;
+  size_t n_decls;
+  bool recover;
+  size_t n_errors;
+  pdxcp_cdcl_parser_stats stats;
+  pdxcp_cdcl_typedefs *typedefs;
+} pdxcp_cdcl_parser;
+
+/**
+ * Initialize a `pdxcp_cdcl_parser` structure.
+ *
+ * @param parser Parser state to initialize
+ */
+void
+pdxcp_cdcl_parser_init(pdxcp_cdcl_parser *parser) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_cdcl_parser` structure.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_parser_init` must first be called.
+ *
+ * @param parser Parser state to destroy
+ */
+void
+pdxcp_cdcl_parser_destroy(pdxcp_cdcl_parser *parser) PDXCP_NOEXCEPT;
+
+/**
+ * Parse a declaration from the input buffer using the parser state.
+ *
+ * Behaves like `pdxcp_cdcl_parse_decl_buf` with the parser state's arena and
+ * error info but is typedef-aware if the parser state has a typedef name
+ * table. The arena is not reset first, so the caller decides how long parsed
+ * declarations live.
+ *
+ * @param parser Parser state
+ * @param in Input buffer cursor
+ * @param decl Declaration to write parse result to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parser_parse_decl_buf(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_lexer_buf *in,
+  pdxcp_cdcl_decl *decl) PDXCP_NOEXCEPT;
+
+/**
+ * Callback invoked by `pdxcp_cdcl_stream_parse_all` and
+ * `pdxcp_cdcl_buf_parse_all` per declaration.
+ *
+ * @param parser Parser state. On error, `errinfo` has error details
+ * @param status Parser status for the declaration
+ * @param decl Parsed declaration, `NULL` on error. Only valid until the
+ *  callback returns since the parser arena is reset per declaration
+ * @param data User data passed to the parsing function
+ * @returns `true` to continue parsing, `false` to stop. Ignored on error
+ *  unless the parser is in recovery mode
+ */
+typedef bool (*pdxcp_cdcl_parse_callback)(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_parser_status status,
+  const pdxcp_cdcl_decl *decl,
+  void *data);
+
+/**
+ * Parse declarations from the input stream until EOF.
+ *
+ * The callback is invoked once for each parsed declaration. The parser state's
+ * token stack, arena, byte vector, and error info are reused across all the
+ * declarations. Parsing stops on the first error, after the callback has been
+ * invoked with the error status, or when the callback returns `false`.
+ *
+ * If `parser->recover` is `true`, after a lexer or parser error is reported
+ * the rest of the failed declaration is skipped up to and including the next
+ * `;`, even inside unbalanced parentheses or brackets, and parsing resumes
+ * from there.
+ * The callback can still stop parsing by returning `false`. This allows input
+ * with malformed declarations to be processed in a single pass.
+ *
+ * @param parser Parser state
+ * @param in Input stream
+ * @param callback Callback to invoke per declaration
+ * @param data User data to pass to the callback, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status, which is
+ *  `pdxcp_cdcl_parser_status_ok` if EOF was reached or if the callback
+ *  requested that parsing stop. In recovery mode, check `parser->n_errors`
+ *  to see if any errors were skipped
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_all(
+  pdxcp_cdcl_parser *parser,
+  FILE *in,
+  pdxcp_cdcl_parse_callback callback,
+  void *data) PDXCP_NOEXCEPT;
+
+/**
+ * Parse declarations from the input buffer until the end of the buffer.
+ *
+ * Behaves like `pdxcp_cdcl_stream_parse_all` but lexes directly from memory,
+ * avoiding the per-character `FILE *` overhead of the stream lexer.
+ *
+ * @param parser Parser state
+ * @param in Input buffer, need not be null-terminated
+ * @param in_size Number of bytes in the input buffer
+ * @param callback Callback to invoke per declaration
+ * @param data User data to pass to the callback, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status, which is
+ *  `pdxcp_cdcl_parser_status_ok` if the end of the buffer was reached or if
+ *  the callback requested that parsing stop
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_buf_parse_all(
+  pdxcp_cdcl_parser *parser,
+  const char *in,
+  size_t in_size,
+  pdxcp_cdcl_parse_callback callback,
+  void *data) PDXCP_NOEXCEPT;
+
 PDXCP_EXTERN_C_END
 
 #endif  // PDXCP_CDCL_PARSER_H_
@@ -0,0 +1,162 @@
+/**
+ * @file cdcl_render.h
+ * @author Derek Huang
+ * @brief C/C++ header for machine-readable C declaration renderers
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_RENDER_H_
+#define PDXCP_CDCL_RENDER_H_
+
+#include <stdio.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Output formats for rendered declarations.
+ */
+typedef enum {
+  // English description, as from pdxcp_cdcl_decl_render
+  pdxcp_cdcl_output_format_text,
+  // one JSON object per line
+  pdxcp_cdcl_output_format_json,
+  // binary tag-length-value records
+  pdxcp_cdcl_output_format_tlv
+} pdxcp_cdcl_output_format;
+
+/**
+ * Return a string for the given output format.
+ *
+ * If the value is unknown, a pointer to `"(unknown)"` is returned.
+ *
+ * @param format Output format
+ */
+const char *
+pdxcp_cdcl_output_format_string(pdxcp_cdcl_output_format format) PDXCP_NOEXCEPT;
+
+/**
+ * TLV record tags.
+ *
+ * Each TLV record is a 1-byte tag, a 32-bit big-endian value length, and the
+ * value. Each declaration is a `DECL` record whose value is an optional `IDEN`
+ * record holding the identifier bytes, an empty `TYPEDEF` record if the
+ * declaration is a `typedef` declaration, and one record per declaration
+ * node, outermost first:
+ *
+ * - `POINTER`: 1 byte of `PDXCP_CDCL_QUAL_*` flags
+ * - `ARRAY`: 64-bit big-endian size, zero if the size is unspecified
+ * - `FUNCTION`: one `DECL` record per parameter, possibly none
+ * - `TYPE`: 1 byte of `PDXCP_CDCL_QUAL_*` flags, 1 byte `PDXCP_CDCL_TLV_BASE_*`
+ *   base type, then the tag name bytes for struct and enum types or the
+ *   typedef name bytes for typedef names
+ */
+#define PDXCP_CDCL_TLV_DECL 0x01u
+#define PDXCP_CDCL_TLV_IDEN 0x02u
+#define PDXCP_CDCL_TLV_TYPEDEF 0x03u
+#define PDXCP_CDCL_TLV_POINTER 0x10u
+#define PDXCP_CDCL_TLV_ARRAY 0x11u
+#define PDXCP_CDCL_TLV_FUNCTION 0x12u
+#define PDXCP_CDCL_TLV_TYPE 0x13u
+
+/**
+ * Number of bytes in a TLV record header.
+ */
+#define PDXCP_CDCL_TLV_HEADER_SIZE 5
+
+/**
+ * TLV base type codes.
+ *
+ * These are fixed so TLV output stays stable if the token types change.
+ */
+#define PDXCP_CDCL_TLV_BASE_VOID 0x01u
+#define PDXCP_CDCL_TLV_BASE_CHAR 0x02u
+#define PDXCP_CDCL_TLV_BASE_INT 0x03u
+#define PDXCP_CDCL_TLV_BASE_LONG 0x04u
+#define PDXCP_CDCL_TLV_BASE_FLOAT 0x05u
+#define PDXCP_CDCL_TLV_BASE_DOUBLE 0x06u
+#define PDXCP_CDCL_TLV_BASE_STRUCT 0x07u
+#define PDXCP_CDCL_TLV_BASE_ENUM 0x08u
+#define PDXCP_CDCL_TLV_BASE_TYPEDEF 0x09u
+
+/**
+ * Append a JSON object describing a parsed declaration to a byte vector.
+ *
+ * The object is written on a single line terminated with a newline, so many
+ * declarations form a stream of newline-delimited JSON. For example,
+ * `const char *argv[10]` is rendered as follows, without the line breaks:
+ *
+ * @code{.json}
+ * {"iden":"argv","type":[{"kind":"array","size":10},
+ * {"kind":"pointer","quals":[]},{"kind":"type","quals":["const"],
+ * "name":"char"}]}
+ * @endcode
+ *
+ * Function nodes have a `"params"` array of declaration objects whose
+ * `"iden"` is `null` for abstract parameters, unsized array nodes have a
+ * `null` `"size"`, and struct and enum type nodes also have a `"tag"`. Type
+ * nodes for typedef names have the typedef name as their `"name"` and a
+ * `true` `"typedef"`, as do the objects of `typedef` declarations.
+ *
+ * @param decl Parsed declaration
+ * @param out Byte vector to append to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_json(
+  const pdxcp_cdcl_decl *decl, pdxcp_bvector *out) PDXCP_NOEXCEPT;
+
+/**
+ * Append a binary TLV record describing a parsed declaration to a byte vector.
+ *
+ * See `PDXCP_CDCL_TLV_DECL` for the record layout.
+ *
+ * @param decl Parsed declaration
+ * @param out Byte vector to append to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_tlv(
+  const pdxcp_cdcl_decl *decl, pdxcp_bvector *out) PDXCP_NOEXCEPT;
+
+/**
+ * Append a parsed declaration in the given output format to a byte vector.
+ *
+ * As with `pdxcp_cdcl_decl_render`, nothing is appended on error.
+ *
+ * @param decl Parsed declaration
+ * @param format Output format
+ * @param out Byte vector to append to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_as(
+  const pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_output_format format,
+  pdxcp_bvector *out) PDXCP_NOEXCEPT;
+
+/**
+ * Parse text from the input stream and write it in the given output format.
+ *
+ * Like `pdxcp_cdcl_stream_parse`, nothing is written if there is a parsing
+ * error and a successful parse is written all at once.
+ *
+ * @param in Input stream
+ * @param out Output stream
+ * @param format Output format
+ * @param errinfo Error info structure, can be `NULL`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_as(
+  FILE *in,
+  FILE *out,
+  pdxcp_cdcl_output_format format,
+  pdxcp_cdcl_parser_errinfo *errinfo) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_RENDER_H_
@@ -0,0 +1,202 @@
+/**
+ * @file cdcl_service.h
+ * @author Derek Huang
+ * @brief C/C++ header for the C declaration Unix domain socket service
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_SERVICE_H_
+#define PDXCP_CDCL_SERVICE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_cache.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Maximum number of declaration bytes in a single service request.
+ *
+ * Requests declaring a larger size are rejected by closing the connection so
+ * that a misbehaving client cannot make a worker allocate unbounded memory.
+ */
+#define PDXCP_CDCL_SERVICE_MAX_REQUEST (1u << 24)
+
+/**
+ * Number of bytes in a service request header.
+ *
+ * A request is a 32-bit big-endian byte count followed by that many bytes of
+ * declaration text, which need not be null-terminated.
+ */
+#define PDXCP_CDCL_SERVICE_REQUEST_HEADER_SIZE 4
+
+/**
+ * Number of bytes in a service response header.
+ *
+ * A response is five 32-bit big-endian fields, the parser status, the number
+ * of declarations parsed, the number of bytes of rendered text, the number of
+ * bytes of error text, and the byte offset of the error in the request,
+ * followed by the rendered text and error text. As with
+ * `pdxcp_cdcl_cache_parse`, on error the rendered text contains the
+ * declarations preceding the error. Neither text is null-terminated.
+ */
+#define PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE 20
+
+/**
+ * Service response.
+ *
+ * @param status Parser status
+ * @param n_decls Number of declarations successfully parsed
+ * @param text_size Number of bytes of rendered text in the response data
+ * @param err_offset Byte offset in the request of the token at which the
+ *  error was detected, zero if there was no error or if it was not an input
+ *  error
+ * @param data Rendered text followed by error text, empty if no error
+ */
+typedef struct {
+  pdxcp_cdcl_parser_status status;
+  size_t n_decls;
+  size_t text_size;
+  size_t err_offset;
+  pdxcp_bvector data;
+} pdxcp_cdcl_service_response;
+
+/**
+ * Initialize a `pdxcp_cdcl_service_response` structure.
+ *
+ * @param response Response to initialize
+ */
+void
+pdxcp_cdcl_service_response_init(
+  pdxcp_cdcl_service_response *response) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_cdcl_service_response` structure.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_service_response_init` must
+ * first be called.
+ *
+ * @param response Response to destroy
+ */
+void
+pdxcp_cdcl_service_response_destroy(
+  pdxcp_cdcl_service_response *response) PDXCP_NOEXCEPT;
+
+/**
+ * Per-thread service worker state.
+ *
+ * Everything needed to serve a request is kept here and reused across all
+ * the requests and connections a worker serves, so that a warm worker does
+ * no allocation per request and repeated declarations are cache hits.
+ *
+ * @param parser Parser state used on cache misses
+ * @param typedefs Typedef name table of the connection being served, used by
+ *  the parser state
+ * @param cache Parse result cache, unused if `use_cache` is `false`
+ * @param use_cache `true` if the parse result cache is used
+ * @param in Request buffer
+ * @param out Rendered text buffer
+ * @param n_requests Number of requests served
+ */
+typedef struct {
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_cache cache;
+  bool use_cache;
+  pdxcp_bvector in;
+  pdxcp_bvector out;
+  size_t n_requests;
+} pdxcp_cdcl_service_worker;
+
+/**
+ * Initialize a `pdxcp_cdcl_service_worker` structure.
+ *
+ * @param worker Worker state to initialize
+ * @param cache_size Parse result cache capacity, zero for no caching
+ */
+void
+pdxcp_cdcl_service_worker_init(
+  pdxcp_cdcl_service_worker *worker, size_t cache_size) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_cdcl_service_worker` structure.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_service_worker_init` must first
+ * be called.
+ *
+ * @param worker Worker state to destroy
+ */
+void
+pdxcp_cdcl_service_worker_destroy(
+  pdxcp_cdcl_service_worker *worker) PDXCP_NOEXCEPT;
+
+/**
+ * Serve requests on a connected socket until the peer closes the connection.
+ *
+ * Requests on the same connection are served one at a time in order. Each
+ * response is written with a single `sendmsg` call. Parser errors are sent to
+ * the client and do not end the connection.
+ *
+ * Parsing is typedef-aware. Typedef names declared by a request are known to
+ * the later requests on the same connection but not to other connections.
+ *
+ * If the socket has a receive timeout, i.e. `SO_RCVTIMEO`, a connection that
+ * stays idle between requests for longer than the timeout is treated like a
+ * close by the peer, while a timeout in the middle of a request is an error.
+ *
+ * @param worker Worker state
+ * @param fd Connected socket file descriptor, not closed
+ * @returns `true` if the peer closed the connection or it timed out between
+ *  requests, `false` on I/O error, allocation failure, or an oversized or
+ *  truncated request, with `errno` set to indicate the error. `errno` is
+ *  `ETIMEDOUT` if a socket timeout expired partway through a request
+ */
+bool
+pdxcp_cdcl_service_serve(
+  pdxcp_cdcl_service_worker *worker, int fd) PDXCP_NOEXCEPT;
+
+/**
+ * Send a request on a connected socket and read the response.
+ *
+ * @param fd Connected socket file descriptor
+ * @param in Declaration text, need not be null-terminated
+ * @param in_size Number of bytes of declaration text, at most
+ *  `PDXCP_CDCL_SERVICE_MAX_REQUEST`
+ * @param response Response to write to
+ * @returns `true` on success, `false` on I/O error, allocation failure, or a
+ *  truncated response, with `errno` set to indicate the error
+ */
+bool
+pdxcp_cdcl_service_request(
+  int fd,
+  const char *in,
+  size_t in_size,
+  pdxcp_cdcl_service_response *response) PDXCP_NOEXCEPT;
+
+/**
+ * Create a Unix domain stream socket listening on the given path.
+ *
+ * @param path Socket path, must not already exist
+ * @param backlog Maximum length of the pending connection queue
+ * @returns Listening socket file descriptor, -1 on error with `errno` set
+ */
+int
+pdxcp_cdcl_service_listen(const char *path, int backlog) PDXCP_NOEXCEPT;
+
+/**
+ * Connect to a Unix domain stream socket at the given path.
+ *
+ * @param path Socket path
+ * @returns Connected socket file descriptor, -1 on error with `errno` set
+ */
+int
+pdxcp_cdcl_service_connect(const char *path) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_SERVICE_H_
@@ -0,0 +1,77 @@
+/**
+ * @file cdcl_typedefs.h
+ * @author Derek Huang
+ * @brief C/C++ header for the C declaration parser typedef name table
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_CDCL_TYPEDEFS_H_
+#define PDXCP_CDCL_TYPEDEFS_H_
+
+#include <stdbool.h>
+
+#include "pdxcp/common.h"
+#include "pdxcp/strmap.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Set of typedef names the parser treats as type specifiers.
+ *
+ * The names are the keys of a `pdxcp_strmap`, so lookups take expected
+ * constant time and usually touch one group of control bytes and one entry.
+ * Names are copied into the map's entries. Names are never removed.
+ *
+ * @param names String map whose keys are the typedef names
+ */
+typedef struct {
+  pdxcp_strmap names;
+} pdxcp_cdcl_typedefs;
+
+/**
+ * Initialize an empty typedef name table.
+ *
+ * No memory is allocated until a name is added.
+ *
+ * @param typedefs Typedef name table to initialize
+ */
+void
+pdxcp_cdcl_typedefs_init(pdxcp_cdcl_typedefs *typedefs) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a typedef name table.
+ *
+ * If the struct is to be reused, `pdxcp_cdcl_typedefs_init` must first be
+ * called.
+ *
+ * @param typedefs Typedef name table to destroy
+ */
+void
+pdxcp_cdcl_typedefs_destroy(pdxcp_cdcl_typedefs *typedefs) PDXCP_NOEXCEPT;
+
+/**
+ * Add a typedef name to the table.
+ *
+ * Adding a name that is already in the table does nothing.
+ *
+ * @param typedefs Typedef name table
+ * @param name Null-terminated typedef name, copied into the table
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+bool
+pdxcp_cdcl_typedefs_add(
+  pdxcp_cdcl_typedefs *typedefs, const char *name) PDXCP_NOEXCEPT;
+
+/**
+ * Check if a name is in the typedef name table.
+ *
+ * @param typedefs Typedef name table
+ * @param name Null-terminated name
+ */
+bool
+pdxcp_cdcl_typedefs_find(
+  const pdxcp_cdcl_typedefs *typedefs, const char *name) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_CDCL_TYPEDEFS_H_
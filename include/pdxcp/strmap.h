@@ -0,0 +1,420 @@
+/**
+ * @file strmap.h
+ * @author Derek Huang
+ * @brief C/C++ header for resizable string-keyed hash maps
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_STRMAP_H_
+#define PDXCP_STRMAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/common.h"
+
+PDXCP_EXTERN_C_BEGIN
+
+/**
+ * Number of slots in a group, the unit in which slots are probed.
+ *
+ * A group's control bytes are exactly one SSE2 register wide.
+ */
+#define PDXCP_STRMAP_GROUP_SIZE 16
+
+/**
+ * Number of slots allocated when the first key is inserted.
+ */
+#define PDXCP_STRMAP_INIT_CAPACITY PDXCP_STRMAP_GROUP_SIZE
+
+/**
+ * Maximum number of full or deleted slots in a map with the given capacity.
+ *
+ * When inserting a new key would exceed this 7/8 load factor the map is
+ * rehashed, so probe sequences stay short no matter how many keys there are.
+ *
+ * @param capacity Number of slots
+ */
+#define PDXCP_STRMAP_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+/**
+ * Control byte of an empty slot.
+ */
+#define PDXCP_STRMAP_CTRL_EMPTY 0x80u
+
+/**
+ * Control byte of a slot whose entry was erased.
+ *
+ * Unlike an empty slot, a deleted slot does not end a probe sequence.
+ */
+#define PDXCP_STRMAP_CTRL_DELETED 0xfeu
+
+/**
+ * Check if a control byte belongs to a full slot.
+ *
+ * Full slots hold the low 7 bits of the entry's hash as their control byte,
+ * so their high bit is clear.
+ *
+ * @param ctrl Control byte
+ */
+#define PDXCP_STRMAP_CTRL_FULL(ctrl) (!((ctrl) & 0x80u))
+
+/**
+ * Number of usable bytes in each block of a map's entry arena.
+ */
+#define PDXCP_STRMAP_ARENA_BLOCK_SIZE 16384
+
+/**
+ * Granularity in bytes of entry allocation sizes.
+ */
+#define PDXCP_STRMAP_ENTRY_ALIGN 16
+
+/**
+ * Number of entry size classes whose erased entries are kept for reuse.
+ *
+ * Class `i` holds entries of `(i + 1) * PDXCP_STRMAP_ENTRY_ALIGN` bytes.
+ * Erased entries larger than the largest class are only reclaimed when the
+ * map is destroyed.
+ */
+#define PDXCP_STRMAP_FREE_CLASSES 32
+
+/**
+ * String hash function type.
+ *
+ * @param key Key bytes, need not be null-terminated
+ * @param len Number of key bytes
+ * @returns 64-bit hash of the key
+ */
+typedef uint64_t (*pdxcp_strmap_hash_fn)(const char *key, size_t len);
+
+/**
+ * FNV-1a 64-bit offset basis, the hash of zero bytes.
+ */
+#define PDXCP_STRMAP_FNV1A_OFFSET 0xcbf29ce484222325u
+
+/**
+ * Compute the FNV-1a hash of a key.
+ *
+ * FNV-1a consumes one byte per multiply, so each step depends on the last.
+ * It is simple and fast for short keys but slower on long paths.
+ *
+ * @param key Key bytes, need not be null-terminated
+ * @param len Number of key bytes
+ */
+uint64_t
+pdxcp_strmap_hash_fnv1a(const char *key, size_t len) PDXCP_NOEXCEPT;
+
+/**
+ * Update a FNV-1a hash with more bytes.
+ *
+ * Hashing data piece by piece starting from `PDXCP_STRMAP_FNV1A_OFFSET` gives
+ * the same result as `pdxcp_strmap_hash_fnv1a` on all of it at once.
+ *
+ * @param hash Current hash
+ * @param key Bytes to hash, need not be null-terminated
+ * @param len Number of bytes
+ */
+uint64_t
+pdxcp_strmap_hash_fnv1a_update(
+  uint64_t hash, const char *key, size_t len) PDXCP_NOEXCEPT;
+
+/**
+ * Compute the wyhash hash of a key.
+ *
+ * wyhash mixes 8 bytes at a time with a 64x64 to 128-bit multiply. Keys over
+ * 48 bytes are consumed in a bulk loop with three independent lanes, so the
+ * multiplies overlap in the pipeline and long paths hash several times faster
+ * than with FNV-1a.
+ *
+ * @param key Key bytes, need not be null-terminated
+ * @param len Number of key bytes
+ */
+uint64_t
+pdxcp_strmap_hash_wyhash(const char *key, size_t len) PDXCP_NOEXCEPT;
+
+/**
+ * Compute the hash of a key with the default hash function.
+ *
+ * The default is chosen when the library is built and is used by
+ * `pdxcp_strmap_init`. It is `pdxcp_strmap_hash_wyhash` unless the library
+ * was built with `PDXCP_STRMAP_HASH_FNV1A` defined, in which case it is
+ * `pdxcp_strmap_hash_fnv1a`.
+ *
+ * @param key Key bytes, need not be null-terminated
+ * @param len Number of key bytes
+ */
+uint64_t
+pdxcp_strmap_hash_default(const char *key, size_t len) PDXCP_NOEXCEPT;
+
+/**
+ * Return the name of the default hash function, e.g. "wyhash".
+ */
+const char *
+pdxcp_strmap_hash_default_name(void) PDXCP_NOEXCEPT;
+
+/**
+ * String map entry.
+ *
+ * @note This is the `file_struct` of the book's `find_filename` example,
+ *  generalized to carry a user value. Entries live out of line, so the slot
+ *  arrays stay compact and entries do not move when the map is rehashed.
+ *  The key is stored inline, so each entry is a single allocation from the
+ *  map's arena and comparing its key does not chase another pointer.
+ *
+ * @param hash Hash of the key, compared before the key itself
+ * @param value User value, `NULL` for a newly inserted key
+ * @param key Null-terminated key owned by the map
+ */
+typedef struct {
+  uint64_t hash;
+  void *value;
+  char key[];
+} pdxcp_strmap_entry;
+
+/**
+ * Struct for a hash map with null-terminated string keys.
+ *
+ * The map is an open-addressing table in the style of Abseil's Swiss tables.
+ * Each slot has a control byte holding 7 bits of its entry's hash, and slots
+ * are probed a group of `PDXCP_STRMAP_GROUP_SIZE` at a time by comparing the
+ * group's control bytes against the key's 7-bit tag all at once, with SSE2
+ * if available. Only slots whose tags match have their entries and keys
+ * loaded, so a lookup usually reads one line of control bytes and one entry.
+ *
+ * A key's probe sequence starts at group `(hash >> 7) % n_groups`, using the
+ * hash bits above the tag, and moves to the next group, wrapping around,
+ * until a group with an empty slot is found.
+ * The capacity is a power of two that is doubled whenever the number of full
+ * and deleted slots would exceed `PDXCP_STRMAP_MAX_LOAD`, so insertion,
+ * lookup, and erasure all take expected constant time. Each map is an
+ * independent instance.
+ *
+ * Entries are bump-allocated from an arena owned by the map, so inserting a
+ * key usually does not call `malloc` and destroying the map frees a handful
+ * of large blocks. Erased entries are pushed onto a free list by size class
+ * and reused by later insertions of keys of similar length.
+ *
+ * @param ctrl Control bytes, `NULL` until the first key is inserted. Aligned
+ *  to `PDXCP_STRMAP_GROUP_SIZE` bytes
+ * @param entries Entry pointers, only meaningful for full slots
+ * @param capacity Number of slots, zero or a power of two multiple of
+ *  `PDXCP_STRMAP_GROUP_SIZE`
+ * @param size Number of entries in the map
+ * @param n_deleted Number of deleted slots
+ * @param hash Hash function used for the keys
+ * @param arena Arena the entries are allocated from
+ * @param free_lists Erased entries by size class, linked through their
+ *  `value` members
+ */
+typedef struct {
+  unsigned char *ctrl;
+  pdxcp_strmap_entry **entries;
+  size_t capacity;
+  size_t size;
+  size_t n_deleted;
+  pdxcp_strmap_hash_fn hash;
+  pdxcp_arena arena;
+  pdxcp_strmap_entry *free_lists[PDXCP_STRMAP_FREE_CLASSES];
+} pdxcp_strmap;
+
+/**
+ * Initialize an empty `pdxcp_strmap` structure.
+ *
+ * No memory is allocated until the first key is inserted. The keys are hashed
+ * with `pdxcp_strmap_hash_default`.
+ *
+ * @param map String map to initialize
+ */
+void
+pdxcp_strmap_init(pdxcp_strmap *map) PDXCP_NOEXCEPT;
+
+/**
+ * Initialize an empty `pdxcp_strmap` structure using the given hash function.
+ *
+ * @param map String map to initialize
+ * @param hash Hash function used for the keys
+ */
+void
+pdxcp_strmap_init_hash(
+  pdxcp_strmap *map, pdxcp_strmap_hash_fn hash) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_strmap` structure, freeing all its entries.
+ *
+ * The entry values are not freed. If the struct is to be reused,
+ * `pdxcp_strmap_init` must first be called.
+ *
+ * @param map String map to destroy
+ */
+void
+pdxcp_strmap_destroy(pdxcp_strmap *map) PDXCP_NOEXCEPT;
+
+/**
+ * Locate the entry for a key, inserting a new entry if necessary.
+ *
+ * A new entry holds a copy of the key and has a `NULL` value. Entry addresses
+ * are stable until the entry is erased, even if the map is rehashed.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @param inserted Address to write `true` to if a new entry was inserted and
+ *  `false` to if the key was already present. Ignored if `NULL`
+ * @returns Entry for the key on success, `NULL` on error (`errno` is ENOMEM)
+ */
+pdxcp_strmap_entry *
+pdxcp_strmap_insert(
+  pdxcp_strmap *map, const char *key, bool *inserted) PDXCP_NOEXCEPT;
+
+/**
+ * Locate the entry for a key.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @returns Entry for the key, `NULL` if the key is not present
+ */
+pdxcp_strmap_entry *
+pdxcp_strmap_find(const pdxcp_strmap *map, const char *key) PDXCP_NOEXCEPT;
+
+/**
+ * Erase the entry for a key.
+ *
+ * The map never shrinks, so later insertions reuse the slots. Slots that are
+ * marked deleted are reclaimed when the map is next rehashed. The entry's
+ * memory is kept for a later insertion of a key of similar length.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @param value Address to write the erased entry's value to so the caller can
+ *  release it. Ignored if `NULL` or if the key is not present
+ * @returns `true` if the key was present and erased, `false` otherwise
+ */
+bool
+pdxcp_strmap_erase(
+  pdxcp_strmap *map, const char *key, void **value) PDXCP_NOEXCEPT;
+
+/**
+ * Default number of shards in a `pdxcp_strmap_sync`.
+ */
+#define PDXCP_STRMAP_SYNC_SHARDS 64
+
+/**
+ * Opaque shard of a `pdxcp_strmap_sync`, a string map with its own lock.
+ */
+typedef struct pdxcp_strmap_shard pdxcp_strmap_shard;
+
+/**
+ * Struct for a string map that can be used by many threads at once.
+ *
+ * The keys are split across a power of two number of shards, each a
+ * `pdxcp_strmap` guarded by its own reader-writer lock, by bits 32 and up of
+ * their hashes. Those bits are not used to place keys within a shard until it
+ * has over 2^25 groups. Lookups in a shard hold its read lock, so any number
+ * of threads can look up keys at once, and insertions and erasures only
+ * serialize with operations on the same shard. Keys are hashed before any
+ * lock is taken and the shards are cache line aligned, so threads working on
+ * different shards do not contend at all.
+ *
+ * @param shards Shards of the map
+ * @param n_shards Number of shards, a power of two
+ * @param hash Hash function used for the keys
+ */
+typedef struct {
+  pdxcp_strmap_shard *shards;
+  size_t n_shards;
+  pdxcp_strmap_hash_fn hash;
+} pdxcp_strmap_sync;
+
+/**
+ * Initialize an empty `pdxcp_strmap_sync` structure.
+ *
+ * The keys are hashed with `pdxcp_strmap_hash_default`.
+ *
+ * @param map Concurrent string map to initialize
+ * @param n_shards Number of shards, rounded up to a power of two. If zero,
+ *  `PDXCP_STRMAP_SYNC_SHARDS` is used
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+bool
+pdxcp_strmap_sync_init(
+  pdxcp_strmap_sync *map, size_t n_shards) PDXCP_NOEXCEPT;
+
+/**
+ * Destroy a `pdxcp_strmap_sync` structure, freeing all its entries.
+ *
+ * No other thread may be using the map. The entry values are not freed.
+ *
+ * @param map Concurrent string map to destroy
+ */
+void
+pdxcp_strmap_sync_destroy(pdxcp_strmap_sync *map) PDXCP_NOEXCEPT;
+
+/**
+ * Locate the entry for a key, inserting it with the given value if absent.
+ *
+ * If several threads insert the same key at once exactly one of them inserts
+ * it and all of them get the same entry. The value is only stored if the key
+ * was inserted, so other threads never see a new entry without its value.
+ * The entry's value may be modified afterwards only with synchronization
+ * between the threads using it.
+ *
+ * @param map Concurrent string map
+ * @param key Null-terminated key
+ * @param value Value of the entry if the key is inserted
+ * @param inserted Address to write `true` to if a new entry was inserted and
+ *  `false` to if the key was already present. Ignored if `NULL`
+ * @returns Entry for the key on success, `NULL` on error with `errno` set
+ */
+pdxcp_strmap_entry *
+pdxcp_strmap_sync_insert(
+  pdxcp_strmap_sync *map,
+  const char *key,
+  void *value,
+  bool *inserted) PDXCP_NOEXCEPT;
+
+/**
+ * Locate the entry for a key.
+ *
+ * The entry remains valid until its key is erased.
+ *
+ * @param map Concurrent string map
+ * @param key Null-terminated key
+ * @returns Entry for the key, `NULL` if the key is not present or on error
+ *  with `errno` set
+ */
+pdxcp_strmap_entry *
+pdxcp_strmap_sync_find(
+  pdxcp_strmap_sync *map, const char *key) PDXCP_NOEXCEPT;
+
+/**
+ * Erase the entry for a key.
+ *
+ * The entry may be reused for another key, so the caller must ensure that no
+ * other thread still uses an entry it got for the key.
+ *
+ * @param map Concurrent string map
+ * @param key Null-terminated key
+ * @param value Address to write the erased entry's value to so the caller can
+ *  release it. Ignored if `NULL` or if the key is not present
+ * @returns `true` if the key was present and erased, `false` otherwise or on
+ *  error with `errno` set
+ */
+bool
+pdxcp_strmap_sync_erase(
+  pdxcp_strmap_sync *map, const char *key, void **value) PDXCP_NOEXCEPT;
+
+/**
+ * Return the number of entries in a `pdxcp_strmap_sync`.
+ *
+ * The shards are counted one at a time, so the result is only exact if no
+ * other thread is modifying the map.
+ *
+ * @param map Concurrent string map
+ */
+size_t
+pdxcp_strmap_sync_size(pdxcp_strmap_sync *map) PDXCP_NOEXCEPT;
+
+PDXCP_EXTERN_C_END
+
+#endif  // PDXCP_STRMAP_H_
@@ -0,0 +1,149 @@
+/**
+ * @file arena.c
+ * @author Derek Huang
+ * @brief C source for a bump-pointer memory arena
+ * @copyright MIT License
+ */
+
+#include "pdxcp/arena.h"
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/common.h"
+
+/**
+ * Arena block.
+ *
+ * The flexible array member is declared as `max_align_t` so that the start of
+ * the usable memory is aligned for any object type.
+ *
+ * @param next Next block in the block list
+ * @param capacity Number of usable bytes in the block
+ * @param size Number of bytes already allocated from the block
+ * @param data Usable block memory
+ */
+struct pdxcp_arena_block {
+  struct pdxcp_arena_block *next;
+  size_t capacity;
+  size_t size;
+  max_align_t data[];
+};
+
+/**
+ * Round a size up to a multiple of the maximum fundamental alignment.
+ *
+ * @param size Size to round up
+ */
+#define PDXCP_ARENA_ALIGN_UP(size) \
+  (((size) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+void
+pdxcp_arena_init(pdxcp_arena *arena, size_t block_size) PDXCP_NOEXCEPT
+{
+  arena->head = NULL;
+  arena->cur = NULL;
+  arena->block_size = (block_size) ? block_size : PDXCP_ARENA_BLOCK_SIZE;
+}
+
+void
+pdxcp_arena_destroy(pdxcp_arena *arena) PDXCP_NOEXCEPT
+{
+  pdxcp_arena_block *block = arena->head;
+  while (block) {
+    pdxcp_arena_block *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+void
+pdxcp_arena_reset(pdxcp_arena *arena) PDXCP_NOEXCEPT
+{
+  // retained blocks are marked empty as the current block advances to them
+  arena->cur = arena->head;
+  if (arena->cur)
+    arena->cur->size = 0;
+}
+
+/**
+ * Allocate a new empty arena block.
+ *
+ * @param capacity Number of usable bytes in the block
+ * @returns New block, `NULL` on error (`errno` is ENOMEM)
+ */
+static pdxcp_arena_block *
+pdxcp_arena_block_new(size_t capacity)
+{
+  // guard against overflow when adding the block header size
+  if (capacity > SIZE_MAX - sizeof(pdxcp_arena_block)) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  pdxcp_arena_block *block = malloc(sizeof(pdxcp_arena_block) + capacity);
+  if (!block)
+    return NULL;
+  block->next = NULL;
+  block->capacity = capacity;
+  block->size = 0;
+  return block;
+}
+
+void *
+pdxcp_arena_alloc(pdxcp_arena *arena, size_t size) PDXCP_NOEXCEPT
+{
+  // zero-size requests still get a unique address
+  if (!size)
+    size = 1;
+  // guard against overflow when aligning
+  if (size > SIZE_MAX - alignof(max_align_t)) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  size = PDXCP_ARENA_ALIGN_UP(size);
+  // bump the pointer if the current block has room
+  pdxcp_arena_block *block = arena->cur;
+  while (block && block->capacity - block->size < size) {
+    // no more retained blocks, need a new one
+    if (!block->next)
+      break;
+    // move to the next retained block. since blocks after the current block
+    // are unused since the last reset, they are marked empty here
+    block = block->next;
+    block->size = 0;
+  }
+  // allocate a new block at the end of the list if none have room
+  if (!block || block->capacity - block->size < size) {
+    pdxcp_arena_block *new_block = pdxcp_arena_block_new(
+      (size > arena->block_size) ? size : arena->block_size
+    );
+    if (!new_block)
+      return NULL;
+    // block is either NULL (empty arena) or the last block in the list
+    if (block)
+      block->next = new_block;
+    else
+      arena->head = new_block;
+    block = new_block;
+  }
+  // bump and return
+  arena->cur = block;
+  void *ptr = (unsigned char *) block->data + block->size;
+  block->size += size;
+  return ptr;
+}
+
+char *
+pdxcp_arena_strdup(pdxcp_arena *arena, const char *s) PDXCP_NOEXCEPT
+{
+  size_t len = strlen(s);
+  char *copy = pdxcp_arena_alloc(arena, len + 1);
+  if (!copy)
+    return NULL;
+  memcpy(copy, s, len + 1);
+  return copy;
+}
@@ -57,7 +57,7 @@ pdxcp_bvector_add(pdxcp_bvector *vec, unsigned char c) PDXCP_NOEXCEPT
 
 bool
 pdxcp_bvector_add_n(
-  pdxcp_bvector *vec, unsigned char *buf, size_t buf_size) PDXCP_NOEXCEPT
+  pdxcp_bvector *vec, const unsigned char *buf, size_t buf_size) PDXCP_NOEXCEPT
 {
   // repeatedly expand as necessary
   while (vec->capacity <= vec->size + buf_size)
@@ -0,0 +1,766 @@
+/**
+ * @file strmap.c
+ * @author Derek Huang
+ * @brief C source for resizable string-keyed hash maps
+ * @copyright MIT License
+ */
+
+#include "pdxcp/strmap.h"
+
+#include <pthread.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // defined(__SSE2__)
+
+#include "pdxcp/arena.h"
+#include "pdxcp/common.h"
+
+/**
+ * FNV-1a 64-bit prime.
+ */
+#define PDXCP_STRMAP_FNV_PRIME 0x100000001b3u
+
+/**
+ * Default hash function and its name, chosen when the library is built.
+ *
+ * Maps store the selected function itself rather than
+ * `pdxcp_strmap_hash_default` to avoid a second call per hash.
+ */
+#if defined(PDXCP_STRMAP_HASH_FNV1A)
+#define PDXCP_STRMAP_HASH_DEFAULT pdxcp_strmap_hash_fnv1a
+#define PDXCP_STRMAP_HASH_DEFAULT_NAME "fnv1a"
+#else
+#define PDXCP_STRMAP_HASH_DEFAULT pdxcp_strmap_hash_wyhash
+#define PDXCP_STRMAP_HASH_DEFAULT_NAME "wyhash"
+#endif  // !defined(PDXCP_STRMAP_HASH_FNV1A)
+
+/**
+ * wyhash default secret, four odd 64-bit constants with balanced bits.
+ */
+static const uint64_t strmap_wy_secret[4] = {
+  0x2d358dccaa6c78a5u,
+  0x8bb84b93962eacc9u,
+  0x4b33a62ed433d4a3u,
+  0x4d5a2da51de1aa47u
+};
+
+uint64_t
+pdxcp_strmap_hash_fnv1a(const char *key, size_t len) PDXCP_NOEXCEPT
+{
+  return pdxcp_strmap_hash_fnv1a_update(PDXCP_STRMAP_FNV1A_OFFSET, key, len);
+}
+
+uint64_t
+pdxcp_strmap_hash_fnv1a_update(
+  uint64_t hash, const char *key, size_t len) PDXCP_NOEXCEPT
+{
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ (unsigned char) key[i]) * PDXCP_STRMAP_FNV_PRIME;
+  return hash;
+}
+
+/**
+ * Multiply two 64-bit values into a 128-bit product split across both.
+ *
+ * @param a Address of the first value, replaced by the low product half
+ * @param b Address of the second value, replaced by the high product half
+ */
+static inline void
+strmap_wy_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  // schoolbook multiply on 32-bit halves
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif  // !defined(__SIZEOF_INT128__)
+}
+
+/**
+ * Multiply two 64-bit values and fold the 128-bit product to 64 bits.
+ *
+ * @param a First value
+ * @param b Second value
+ */
+static inline uint64_t
+strmap_wy_mix(uint64_t a, uint64_t b)
+{
+  strmap_wy_mum(&a, &b);
+  return a ^ b;
+}
+
+/**
+ * Read 8 unaligned bytes as a native-endian 64-bit value.
+ *
+ * @param p Bytes to read
+ */
+static inline uint64_t
+strmap_wy_r8(const unsigned char *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+/**
+ * Read 4 unaligned bytes as a native-endian 32-bit value.
+ *
+ * @param p Bytes to read
+ */
+static inline uint64_t
+strmap_wy_r4(const unsigned char *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+/**
+ * Read 1 to 3 bytes as a value using the first, middle, and last bytes.
+ *
+ * @param p Bytes to read
+ * @param k Number of bytes, from 1 to 3
+ */
+static inline uint64_t
+strmap_wy_r3(const unsigned char *p, size_t k)
+{
+  return ((uint64_t) p[0] << 16) | ((uint64_t) p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t
+pdxcp_strmap_hash_wyhash(const char *key, size_t len) PDXCP_NOEXCEPT
+{
+  const uint64_t *secret = strmap_wy_secret;
+  const unsigned char *p = (const unsigned char *) key;
+  uint64_t seed = strmap_wy_mix(secret[0], secret[1]);
+  uint64_t a, b;
+  // short keys are read with at most four overlapping loads
+  if (len <= 16) {
+    if (len >= 4) {
+      size_t mid = (len >> 3) << 2;
+      a = (strmap_wy_r4(p) << 32) | strmap_wy_r4(p + mid);
+      b = (strmap_wy_r4(p + len - 4) << 32) | strmap_wy_r4(p + len - 4 - mid);
+    }
+    else if (len) {
+      a = strmap_wy_r3(p, len);
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else {
+    size_t i = len;
+    // bulk loop: three independent lanes so the multiplies can overlap
+    if (i >= 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = strmap_wy_mix(
+          strmap_wy_r8(p) ^ secret[1], strmap_wy_r8(p + 8) ^ seed
+        );
+        see1 = strmap_wy_mix(
+          strmap_wy_r8(p + 16) ^ secret[2], strmap_wy_r8(p + 24) ^ see1
+        );
+        see2 = strmap_wy_mix(
+          strmap_wy_r8(p + 32) ^ secret[3], strmap_wy_r8(p + 40) ^ see2
+        );
+        p += 48;
+        i -= 48;
+      }
+      while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = strmap_wy_mix(
+        strmap_wy_r8(p) ^ secret[1], strmap_wy_r8(p + 8) ^ seed
+      );
+      p += 16;
+      i -= 16;
+    }
+    // last 16 bytes, overlapping the previous block if needed
+    a = strmap_wy_r8(p + i - 16);
+    b = strmap_wy_r8(p + i - 8);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  strmap_wy_mum(&a, &b);
+  return strmap_wy_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+uint64_t
+pdxcp_strmap_hash_default(const char *key, size_t len) PDXCP_NOEXCEPT
+{
+  return PDXCP_STRMAP_HASH_DEFAULT(key, len);
+}
+
+const char *
+pdxcp_strmap_hash_default_name(void) PDXCP_NOEXCEPT
+{
+  return PDXCP_STRMAP_HASH_DEFAULT_NAME;
+}
+
+void
+pdxcp_strmap_init(pdxcp_strmap *map) PDXCP_NOEXCEPT
+{
+  pdxcp_strmap_init_hash(map, PDXCP_STRMAP_HASH_DEFAULT);
+}
+
+void
+pdxcp_strmap_init_hash(
+  pdxcp_strmap *map, pdxcp_strmap_hash_fn hash) PDXCP_NOEXCEPT
+{
+  map->ctrl = NULL;
+  map->entries = NULL;
+  map->capacity = 0;
+  map->size = 0;
+  map->n_deleted = 0;
+  map->hash = hash;
+  pdxcp_arena_init(&map->arena, PDXCP_STRMAP_ARENA_BLOCK_SIZE);
+  for (size_t i = 0; i < PDXCP_STRMAP_FREE_CLASSES; i++)
+    map->free_lists[i] = NULL;
+}
+
+void
+pdxcp_strmap_destroy(pdxcp_strmap *map) PDXCP_NOEXCEPT
+{
+  // entries live in the arena, entry pointers share the control byte allocation
+  pdxcp_arena_destroy(&map->arena);
+  free(map->ctrl);
+}
+
+/**
+ * Return the 7-bit tag stored in the control byte of a key's slot.
+ *
+ * @param hash Hash of the key
+ */
+static inline unsigned char
+strmap_tag(uint64_t hash)
+{
+  return (unsigned char) (hash & 0x7fu);
+}
+
+/**
+ * Return the index of the group a key's probe sequence starts at.
+ *
+ * The tag bits are excluded so that keys in the same group rarely share tags.
+ *
+ * @param map String map with nonzero capacity
+ * @param hash Hash of the key
+ */
+static inline size_t
+strmap_home(const pdxcp_strmap *map, uint64_t hash)
+{
+  return (size_t) (hash >> 7) & (map->capacity / PDXCP_STRMAP_GROUP_SIZE - 1);
+}
+
+/**
+ * Return a bit mask of the slots in a group whose control byte matches.
+ *
+ * Bit `i` of the mask is set if the control byte of slot `i` equals `c`.
+ *
+ * @param group First control byte of the group, group-aligned
+ * @param c Control byte to match
+ */
+static inline unsigned
+strmap_group_match(const unsigned char *group, unsigned char c)
+{
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_load_si128((const __m128i *) group);
+  return (unsigned) _mm_movemask_epi8(
+    _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) c))
+  );
+#else
+  unsigned mask = 0;
+  for (unsigned i = 0; i < PDXCP_STRMAP_GROUP_SIZE; i++)
+    mask |= (unsigned) (group[i] == c) << i;
+  return mask;
+#endif  // !defined(__SSE2__)
+}
+
+/**
+ * Return a bit mask of the empty or deleted slots in a group.
+ *
+ * @param group First control byte of the group, group-aligned
+ */
+static inline unsigned
+strmap_group_free(const unsigned char *group)
+{
+#if defined(__SSE2__)
+  // empty and deleted are the only control bytes with the high bit set
+  return (unsigned) _mm_movemask_epi8(
+    _mm_load_si128((const __m128i *) group)
+  );
+#else
+  unsigned mask = 0;
+  for (unsigned i = 0; i < PDXCP_STRMAP_GROUP_SIZE; i++)
+    mask |= (unsigned) !PDXCP_STRMAP_CTRL_FULL(group[i]) << i;
+  return mask;
+#endif  // !defined(__SSE2__)
+}
+
+/**
+ * Return the index of the lowest set bit of a nonzero mask.
+ *
+ * @param mask Nonzero bit mask
+ */
+static inline unsigned
+strmap_first_bit(unsigned mask)
+{
+#if defined(__GNUC__)
+  return (unsigned) __builtin_ctz(mask);
+#else
+  unsigned i = 0;
+  for (; !(mask & 1u); mask >>= 1)
+    i++;
+  return i;
+#endif  // !defined(__GNUC__)
+}
+
+/**
+ * Return the slot index of the entry for a key.
+ *
+ * @param map String map with nonzero capacity
+ * @param key Null-terminated key
+ * @param hash Hash of the key
+ * @returns Slot index, `map->capacity` if the key is not present
+ */
+static size_t
+strmap_find_slot(const pdxcp_strmap *map, const char *key, uint64_t hash)
+{
+  size_t group_mask = map->capacity / PDXCP_STRMAP_GROUP_SIZE - 1;
+  unsigned char tag = strmap_tag(hash);
+  // the load factor guarantees an empty slot so the probing ends
+  for (size_t g = strmap_home(map, hash); ; g = (g + 1) & group_mask) {
+    const unsigned char *group = map->ctrl + g * PDXCP_STRMAP_GROUP_SIZE;
+    // only entries with matching tags are loaded, about 1 in 128 by chance
+    for (
+      unsigned mask = strmap_group_match(group, tag);
+      mask;
+      mask &= mask - 1
+    ) {
+      size_t i = g * PDXCP_STRMAP_GROUP_SIZE + strmap_first_bit(mask);
+      const pdxcp_strmap_entry *entry = map->entries[i];
+      if (entry->hash == hash && !strcmp(entry->key, key))
+        return i;
+    }
+    if (strmap_group_match(group, PDXCP_STRMAP_CTRL_EMPTY))
+      return map->capacity;
+  }
+}
+
+/**
+ * Return the index of the first empty or deleted slot in a probe sequence.
+ *
+ * @param map String map with nonzero capacity
+ * @param hash Hash of the key
+ */
+static size_t
+strmap_free_slot(const pdxcp_strmap *map, uint64_t hash)
+{
+  size_t group_mask = map->capacity / PDXCP_STRMAP_GROUP_SIZE - 1;
+  for (size_t g = strmap_home(map, hash); ; g = (g + 1) & group_mask) {
+    unsigned mask = strmap_group_free(
+      map->ctrl + g * PDXCP_STRMAP_GROUP_SIZE
+    );
+    if (mask)
+      return g * PDXCP_STRMAP_GROUP_SIZE + strmap_first_bit(mask);
+  }
+}
+
+/**
+ * Rehash all entries into new slot arrays, dropping deleted slots.
+ *
+ * @param map String map
+ * @param capacity New number of slots, a power of two multiple of
+ *  `PDXCP_STRMAP_GROUP_SIZE` with room for all the entries
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+strmap_rehash(pdxcp_strmap *map, size_t capacity)
+{
+  // control bytes and entry pointers share one allocation. the control bytes
+  // come first so each group is aligned for SSE2 loads
+  unsigned char *ctrl = aligned_alloc(
+    PDXCP_STRMAP_GROUP_SIZE,
+    capacity + capacity * sizeof(pdxcp_strmap_entry *)
+  );
+  if (!ctrl) {
+    errno = ENOMEM;
+    return false;
+  }
+  memset(ctrl, PDXCP_STRMAP_CTRL_EMPTY, capacity);
+  pdxcp_strmap old = *map;
+  map->ctrl = ctrl;
+  map->entries = (pdxcp_strmap_entry **) (ctrl + capacity);
+  map->capacity = capacity;
+  map->n_deleted = 0;
+  // entries are placed using their saved hashes, so no key is rehashed
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (!PDXCP_STRMAP_CTRL_FULL(old.ctrl[i]))
+      continue;
+    pdxcp_strmap_entry *entry = old.entries[i];
+    size_t slot = strmap_free_slot(map, entry->hash);
+    map->ctrl[slot] = strmap_tag(entry->hash);
+    map->entries[slot] = entry;
+  }
+  free(old.ctrl);
+  return true;
+}
+
+/**
+ * Return the size class of an entry for a key of the given length.
+ *
+ * Entries of class `i` are `(i + 1) * PDXCP_STRMAP_ENTRY_ALIGN` bytes.
+ *
+ * @param key_len Length of the key
+ */
+static inline size_t
+strmap_entry_class(size_t key_len)
+{
+  return (sizeof(pdxcp_strmap_entry) + key_len) / PDXCP_STRMAP_ENTRY_ALIGN;
+}
+
+/**
+ * Allocate an entry for a key of the given length.
+ *
+ * An erased entry of the same size class is reused if there is one.
+ *
+ * @param map String map
+ * @param key_len Length of the key
+ * @returns Uninitialized entry, `NULL` on error (`errno` is ENOMEM)
+ */
+static pdxcp_strmap_entry *
+strmap_entry_alloc(pdxcp_strmap *map, size_t key_len)
+{
+  size_t c = strmap_entry_class(key_len);
+  if (c < PDXCP_STRMAP_FREE_CLASSES && map->free_lists[c]) {
+    pdxcp_strmap_entry *entry = map->free_lists[c];
+    map->free_lists[c] = entry->value;
+    return entry;
+  }
+  // guard against overflow when rounding up to the class size
+  if (c > SIZE_MAX / PDXCP_STRMAP_ENTRY_ALIGN - 1) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  // sizes are rounded up so any entry of a class fits any key of the class
+  return pdxcp_arena_alloc(&map->arena, (c + 1) * PDXCP_STRMAP_ENTRY_ALIGN);
+}
+
+/**
+ * Locate the entry for a key with a known hash, inserting it if necessary.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @param key_len Length of the key
+ * @param hash Hash of the key
+ * @param inserted Address to write whether a new entry was inserted to,
+ *  ignored if `NULL`
+ * @returns Entry for the key on success, `NULL` on error (`errno` is ENOMEM)
+ */
+static pdxcp_strmap_entry *
+strmap_insert_hashed(
+  pdxcp_strmap *map,
+  const char *key,
+  size_t key_len,
+  uint64_t hash,
+  bool *inserted)
+{
+  // allocate slots on first insertion
+  if (!map->capacity && !strmap_rehash(map, PDXCP_STRMAP_INIT_CAPACITY))
+    return NULL;
+  size_t slot = strmap_find_slot(map, key, hash);
+  if (slot < map->capacity) {
+    if (inserted)
+      *inserted = false;
+    return map->entries[slot];
+  }
+  // rehash before inserting if the new entry would exceed the load factor.
+  // if mostly deleted slots are to blame, rehashing in place reclaims them
+  if (map->size + map->n_deleted + 1 > PDXCP_STRMAP_MAX_LOAD(map->capacity)) {
+    size_t capacity = map->capacity;
+    if (map->size + 1 > PDXCP_STRMAP_MAX_LOAD(capacity) / 2)
+      capacity *= 2;
+    if (!strmap_rehash(map, capacity))
+      return NULL;
+  }
+  // allocate new entry with the key copied inline
+  pdxcp_strmap_entry *entry = strmap_entry_alloc(map, key_len);
+  if (!entry)
+    return NULL;
+  memcpy(entry->key, key, key_len + 1);
+  entry->hash = hash;
+  entry->value = NULL;
+  // reuse the first deleted or empty slot in the probe sequence
+  slot = strmap_free_slot(map, hash);
+  if (map->ctrl[slot] == PDXCP_STRMAP_CTRL_DELETED)
+    map->n_deleted--;
+  map->ctrl[slot] = strmap_tag(hash);
+  map->entries[slot] = entry;
+  map->size++;
+  if (inserted)
+    *inserted = true;
+  return entry;
+}
+
+/**
+ * Locate the entry for a key with a known hash.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @param hash Hash of the key
+ * @returns Entry for the key, `NULL` if the key is not present
+ */
+static pdxcp_strmap_entry *
+strmap_find_hashed(const pdxcp_strmap *map, const char *key, uint64_t hash)
+{
+  if (!map->size)
+    return NULL;
+  size_t slot = strmap_find_slot(map, key, hash);
+  return (slot < map->capacity) ? map->entries[slot] : NULL;
+}
+
+/**
+ * Erase the entry for a key with a known hash.
+ *
+ * @param map String map
+ * @param key Null-terminated key
+ * @param hash Hash of the key
+ * @param value Address to write the erased entry's value to, ignored if
+ *  `NULL` or if the key is not present
+ * @returns `true` if the key was present and erased, `false` otherwise
+ */
+static bool
+strmap_erase_hashed(
+  pdxcp_strmap *map, const char *key, uint64_t hash, void **value)
+{
+  if (!map->size)
+    return false;
+  size_t slot = strmap_find_slot(map, key, hash);
+  if (slot == map->capacity)
+    return false;
+  // hand the value back to the caller and keep the entry for reuse
+  pdxcp_strmap_entry *entry = map->entries[slot];
+  if (value)
+    *value = entry->value;
+  size_t c = strmap_entry_class(strlen(entry->key));
+  if (c < PDXCP_STRMAP_FREE_CLASSES) {
+    entry->value = map->free_lists[c];
+    map->free_lists[c] = entry;
+  }
+  map->size--;
+  // probing stops at a group with an empty slot, so if the group already has
+  // one no probe sequence continues past it and the slot can be made empty
+  const unsigned char *group = map->ctrl +
+    slot / PDXCP_STRMAP_GROUP_SIZE * PDXCP_STRMAP_GROUP_SIZE;
+  if (strmap_group_match(group, PDXCP_STRMAP_CTRL_EMPTY))
+    map->ctrl[slot] = PDXCP_STRMAP_CTRL_EMPTY;
+  else {
+    map->ctrl[slot] = PDXCP_STRMAP_CTRL_DELETED;
+    map->n_deleted++;
+  }
+  return true;
+}
+
+pdxcp_strmap_entry *
+pdxcp_strmap_insert(
+  pdxcp_strmap *map, const char *key, bool *inserted) PDXCP_NOEXCEPT
+{
+  size_t key_len = strlen(key);
+  return strmap_insert_hashed(
+    map, key, key_len, map->hash(key, key_len), inserted
+  );
+}
+
+pdxcp_strmap_entry *
+pdxcp_strmap_find(const pdxcp_strmap *map, const char *key) PDXCP_NOEXCEPT
+{
+  if (!map->size)
+    return NULL;
+  return strmap_find_hashed(map, key, map->hash(key, strlen(key)));
+}
+
+bool
+pdxcp_strmap_erase(
+  pdxcp_strmap *map, const char *key, void **value) PDXCP_NOEXCEPT
+{
+  if (!map->size)
+    return false;
+  return strmap_erase_hashed(map, key, map->hash(key, strlen(key)), value);
+}
+
+/**
+ * Alignment of each `pdxcp_strmap_sync` shard, the size of a cache line.
+ */
+#define PDXCP_STRMAP_SYNC_ALIGN 64
+
+/**
+ * Shard of a `pdxcp_strmap_sync`.
+ *
+ * Aligning the lock to a cache line also pads the struct to a whole number of
+ * cache lines, so locking one shard never invalidates a neighbor's line.
+ *
+ * @param lock Reader-writer lock guarding the map
+ * @param map String map holding the keys of the shard
+ */
+struct pdxcp_strmap_shard {
+  _Alignas(PDXCP_STRMAP_SYNC_ALIGN) pthread_rwlock_t lock;
+  pdxcp_strmap map;
+};
+
+/**
+ * Return the shard holding a key.
+ *
+ * @param map Concurrent string map
+ * @param hash Hash of the key
+ */
+static inline pdxcp_strmap_shard *
+strmap_sync_shard(const pdxcp_strmap_sync *map, uint64_t hash)
+{
+  return map->shards + ((size_t) (hash >> 32) & (map->n_shards - 1));
+}
+
+bool
+pdxcp_strmap_sync_init(
+  pdxcp_strmap_sync *map, size_t n_shards) PDXCP_NOEXCEPT
+{
+  if (!n_shards)
+    n_shards = PDXCP_STRMAP_SYNC_SHARDS;
+  // round up to a power of two
+  size_t n = 1;
+  while (n < n_shards)
+    n *= 2;
+  map->shards = aligned_alloc(
+    PDXCP_STRMAP_SYNC_ALIGN, n * sizeof(pdxcp_strmap_shard)
+  );
+  if (!map->shards) {
+    errno = ENOMEM;
+    return false;
+  }
+  map->n_shards = n;
+  map->hash = PDXCP_STRMAP_HASH_DEFAULT;
+  for (size_t i = 0; i < n; i++) {
+    int status = pthread_rwlock_init(&map->shards[i].lock, NULL);
+    if (status) {
+      // destroy the locks initialized so far
+      while (i--)
+        pthread_rwlock_destroy(&map->shards[i].lock);
+      free(map->shards);
+      errno = status;
+      return false;
+    }
+    pdxcp_strmap_init_hash(&map->shards[i].map, map->hash);
+  }
+  return true;
+}
+
+void
+pdxcp_strmap_sync_destroy(pdxcp_strmap_sync *map) PDXCP_NOEXCEPT
+{
+  for (size_t i = 0; i < map->n_shards; i++) {
+    pdxcp_strmap_destroy(&map->shards[i].map);
+    pthread_rwlock_destroy(&map->shards[i].lock);
+  }
+  free(map->shards);
+}
+
+pdxcp_strmap_entry *
+pdxcp_strmap_sync_insert(
+  pdxcp_strmap_sync *map,
+  const char *key,
+  void *value,
+  bool *inserted) PDXCP_NOEXCEPT
+{
+  size_t key_len = strlen(key);
+  uint64_t hash = map->hash(key, key_len);
+  pdxcp_strmap_shard *shard = strmap_sync_shard(map, hash);
+  // most keys are already present, so first look under the read lock
+  int status = pthread_rwlock_rdlock(&shard->lock);
+  if (status) {
+    errno = status;
+    return NULL;
+  }
+  pdxcp_strmap_entry *entry = strmap_find_hashed(&shard->map, key, hash);
+  pthread_rwlock_unlock(&shard->lock);
+  if (entry) {
+    if (inserted)
+      *inserted = false;
+    return entry;
+  }
+  // another thread may insert the key before the write lock is taken, in
+  // which case its entry is found and returned
+  if ((status = pthread_rwlock_wrlock(&shard->lock))) {
+    errno = status;
+    return NULL;
+  }
+  bool added;
+  entry = strmap_insert_hashed(&shard->map, key, key_len, hash, &added);
+  if (entry && added)
+    entry->value = value;
+  pthread_rwlock_unlock(&shard->lock);
+  if (entry && inserted)
+    *inserted = added;
+  return entry;
+}
+
+pdxcp_strmap_entry *
+pdxcp_strmap_sync_find(
+  pdxcp_strmap_sync *map, const char *key) PDXCP_NOEXCEPT
+{
+  uint64_t hash = map->hash(key, strlen(key));
+  pdxcp_strmap_shard *shard = strmap_sync_shard(map, hash);
+  int status = pthread_rwlock_rdlock(&shard->lock);
+  if (status) {
+    errno = status;
+    return NULL;
+  }
+  pdxcp_strmap_entry *entry = strmap_find_hashed(&shard->map, key, hash);
+  pthread_rwlock_unlock(&shard->lock);
+  return entry;
+}
+
+bool
+pdxcp_strmap_sync_erase(
+  pdxcp_strmap_sync *map, const char *key, void **value) PDXCP_NOEXCEPT
+{
+  uint64_t hash = map->hash(key, strlen(key));
+  pdxcp_strmap_shard *shard = strmap_sync_shard(map, hash);
+  int status = pthread_rwlock_wrlock(&shard->lock);
+  if (status) {
+    errno = status;
+    return false;
+  }
+  bool erased = strmap_erase_hashed(&shard->map, key, hash, value);
+  pthread_rwlock_unlock(&shard->lock);
+  return erased;
+}
+
+size_t
+pdxcp_strmap_sync_size(pdxcp_strmap_sync *map) PDXCP_NOEXCEPT
+{
+  size_t size = 0;
+  for (size_t i = 0; i < map->n_shards; i++) {
+    // a shard that cannot be locked is skipped
+    if (pthread_rwlock_rdlock(&map->shards[i].lock))
+      continue;
+    size += map->shards[i].map.size;
+    pthread_rwlock_unlock(&map->shards[i].lock);
+  }
+  return size;
+}
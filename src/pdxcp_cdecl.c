@@ -0,0 +1,582 @@
+/**
+ * @file pdxcp_cdecl.c
+ * @author Derek Huang
+ * @brief High-throughput cdecl program using the C declaration parser
+ * @copyright MIT License
+ */
+
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_batch.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_render.h"
+#include "pdxcp/cdcl_service.h"
+#include "pdxcp/cdcl_typedefs.h"
+
+/**
+ * Size of the fully buffered `stdout` buffer.
+ *
+ * Rendered declarations are short, so a large buffer keeps the number of
+ * `write` calls low when output is piped to another program.
+ */
+#define PDXCP_CDECL_OUT_BUF_SIZE (1 << 20)
+
+/**
+ * Number of bytes requested per `fread` call when reading input.
+ */
+#define PDXCP_CDECL_READ_SIZE (1 << 16)
+
+/**
+ * Default per-thread parse result cache capacity.
+ *
+ * Caching only pays off when the input repeats many declarations, e.g. from
+ * included headers, and otherwise just adds hashing overhead, so it is off.
+ */
+#define PDXCP_CDECL_CACHE_SIZE 0
+
+/**
+ * Program options.
+ *
+ * @param n_threads Number of parsing threads, zero for all online processors
+ * @param cache_size Per-thread cache capacity, zero for no caching
+ * @param format Output format
+ * @param stats `true` to print throughput statistics to `stderr`
+ * @param keep_going `true` to report and skip malformed declarations
+ * @param socket_path `pdxcp_cdecld` socket path, `NULL` to parse in-process
+ * @param paths Input file paths, `"-"` for `stdin`
+ * @param n_paths Number of input file paths, zero to read from `stdin`
+ */
+typedef struct {
+  unsigned int n_threads;
+  size_t cache_size;
+  pdxcp_cdcl_output_format format;
+  bool stats;
+  bool keep_going;
+  const char *socket_path;
+  char **paths;
+  int n_paths;
+} cdecl_options;
+
+/**
+ * Print the program usage to the given stream.
+ *
+ * @param out Output stream
+ * @param progname Program name
+ */
+static void
+print_usage(FILE *out, const char *progname)
+{
+  fprintf(
+    out,
+    "Usage: %s [-h] [-j N] [-k] [--cache N] [--format FORMAT]\n"
+    "       [--connect SOCKET] [--stats] [FILE]...\n"
+    "\n"
+    "Describe each C declaration read from the FILEs in English, one per\n"
+    "line. With no FILE, or when FILE is -, read standard input.\n"
+    "\n"
+    "Each input is read into memory whole and lexed directly from memory, so\n"
+    "this is suited to being a pipeline stage over large amounts of code.\n"
+    "\n"
+    "Typedef declarations are described too, and the typedef names they\n"
+    "declare are types in the rest of the same FILE. With --connect, they\n"
+    "are types in the rest of the connection, i.e. in the later FILEs too.\n"
+    "\n"
+    "Options:\n"
+    "  -h, --help         Print this usage and exit\n"
+    "  -j, --threads N    Parse with N threads, 0 for all processors [1]\n"
+    "  -k, --keep-going   Report each malformed declaration with its byte\n"
+    "                     offset and resume at the next ;. Parses on one\n"
+    "                     thread without caching, so -j and --cache are\n"
+    "                     ignored\n"
+    "  --cache N          Per-thread cache capacity, 0 to disable [%d]\n"
+    "  --format FORMAT    Output format, one of text, json, or tlv [text]\n"
+    "  --connect SOCKET   Send inputs to the pdxcp_cdecld at SOCKET instead\n"
+    "                     of parsing in-process. -j and --cache are ignored\n"
+    "                     and only text output is supported\n"
+    "  --stats            Print declarations/second to standard error\n",
+    progname,
+    PDXCP_CDECL_CACHE_SIZE
+  );
+}
+
+/**
+ * Parse a nonnegative integer option value.
+ *
+ * @param progname Program name
+ * @param opt Option name
+ * @param text Option value text, can be `NULL` if the value is missing
+ * @param value Address to write the parsed value to
+ * @returns `true` on success, `false` if `text` is not a valid value
+ */
+static bool
+parse_size_opt(
+  const char *progname, const char *opt, const char *text, size_t *value)
+{
+  if (!text) {
+    fprintf(stderr, "Error: %s: %s requires a value\n", progname, opt);
+    return false;
+  }
+  char *end;
+  errno = 0;
+  unsigned long long v = strtoull(text, &end, 10);
+  if (!*text || *end || *text == '-' || errno) {
+    fprintf(
+      stderr, "Error: %s: Invalid %s value \"%s\"\n", progname, opt, text
+    );
+    return false;
+  }
+  *value = (size_t) v;
+  return true;
+}
+
+/**
+ * Parse command-line arguments into the program options.
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Program options to write to
+ * @returns `EXIT_SUCCESS` to continue, `EXIT_FAILURE` on error, or -1 if the
+ *  usage was printed and the program should exit successfully
+ */
+static int
+parse_args(int argc, char *argv[], cdecl_options *opts)
+{
+  opts->n_threads = 1;
+  opts->cache_size = PDXCP_CDECL_CACHE_SIZE;
+  opts->format = pdxcp_cdcl_output_format_text;
+  opts->stats = false;
+  opts->keep_going = false;
+  opts->socket_path = NULL;
+  opts->paths = argv + argc;
+  opts->n_paths = 0;
+  int i;
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    // "--" ends options and a lone "-" is stdin, so both end option parsing
+    if (!strcmp(arg, "--")) {
+      i++;
+      break;
+    }
+    if (arg[0] != '-' || !arg[1])
+      break;
+    size_t value;
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      print_usage(stdout, argv[0]);
+      return -1;
+    }
+    else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads")) {
+      if (!parse_size_opt(argv[0], arg, argv[++i], &value))
+        return EXIT_FAILURE;
+      opts->n_threads = (unsigned int) value;
+    }
+    else if (!strcmp(arg, "-k") || !strcmp(arg, "--keep-going"))
+      opts->keep_going = true;
+    else if (!strcmp(arg, "--cache")) {
+      if (!parse_size_opt(argv[0], arg, argv[++i], &value))
+        return EXIT_FAILURE;
+      opts->cache_size = value;
+    }
+    else if (!strcmp(arg, "--format")) {
+      const char *name = argv[++i];
+      if (name && !strcmp(name, "text"))
+        opts->format = pdxcp_cdcl_output_format_text;
+      else if (name && !strcmp(name, "json"))
+        opts->format = pdxcp_cdcl_output_format_json;
+      else if (name && !strcmp(name, "tlv"))
+        opts->format = pdxcp_cdcl_output_format_tlv;
+      else {
+        fprintf(
+          stderr,
+          "Error: %s: %s must be one of text, json, or tlv\n",
+          argv[0],
+          arg
+        );
+        return EXIT_FAILURE;
+      }
+    }
+    else if (!strcmp(arg, "--connect")) {
+      if (!(opts->socket_path = argv[++i])) {
+        fprintf(stderr, "Error: %s: %s requires a value\n", argv[0], arg);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (!strcmp(arg, "--stats"))
+      opts->stats = true;
+    else {
+      fprintf(stderr, "Error: %s: Unknown option %s\n", argv[0], arg);
+      print_usage(stderr, argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (opts->socket_path && opts->format != pdxcp_cdcl_output_format_text) {
+    fprintf(stderr, "Error: %s: --connect requires text output\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (opts->socket_path && opts->keep_going) {
+    fprintf(
+      stderr, "Error: %s: --connect cannot be used with --keep-going\n", argv[0]
+    );
+    return EXIT_FAILURE;
+  }
+  if (i < argc) {
+    opts->paths = argv + i;
+    opts->n_paths = argc - i;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Read the entire contents of a stream into a byte vector.
+ *
+ * The byte vector is cleared first. Reads are done in large chunks directly
+ * into the byte vector's buffer to avoid an intermediate copy.
+ *
+ * @param in Input stream
+ * @param buf Byte vector to read into
+ * @returns `true` on success, `false` on read or allocation error
+ */
+static bool
+read_all(FILE *in, pdxcp_bvector *buf)
+{
+  buf->size = 0;
+  while (true) {
+    while (buf->capacity - buf->size < PDXCP_CDECL_READ_SIZE)
+      if (!pdxcp_bvector_expand(buf))
+        return false;
+    size_t n_read = fread(
+      buf->data + buf->size, 1, buf->capacity - buf->size, in
+    );
+    buf->size += n_read;
+    if (!n_read)
+      return !ferror(in);
+  }
+}
+
+/**
+ * Print the parser error for the given input to `stderr`.
+ *
+ * The error is located by its byte offset in the input, the same way in all
+ * parsing modes.
+ *
+ * @param path Input file path
+ * @param errinfo Parser error info
+ */
+static void
+print_parse_err(const char *path, const pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  char text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
+  pdxcp_cdcl_parser_errinfo_format(errinfo, text, sizeof text);
+  fprintf(stderr, "Error: %s:%zu: %s\n", path, errinfo->offset, text);
+}
+
+/**
+ * Parse an input in-process and write the descriptions to `stdout`.
+ *
+ * @param opts Program options
+ * @param path Input file path
+ * @param buf Input contents
+ * @param n_decls Address to write the number of declarations written to
+ * @returns `true` on success, `false` on error
+ */
+static bool
+parse_local(
+  const cdecl_options *opts,
+  const char *path,
+  const pdxcp_bvector *buf,
+  size_t *n_decls)
+{
+  // pass non-NULL data for empty input
+  *n_decls = 0;
+  pdxcp_cdcl_parser_errinfo errinfo;
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_batch_parse(
+    (buf->data) ? (const char *) buf->data : "",
+    buf->size,
+    stdout,
+    opts->format,
+    opts->n_threads,
+    opts->cache_size,
+    n_decls,
+    &errinfo
+  );
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    // flush so descriptions preceding the error come before the message
+    fflush(stdout);
+    print_parse_err(path, &errinfo);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Parse callback state for `parse_keep_going`.
+ *
+ * @param path Input file path
+ * @param format Output format
+ * @param status First error status, e.g. from rendering
+ */
+typedef struct {
+  const char *path;
+  pdxcp_cdcl_output_format format;
+  pdxcp_cdcl_parser_status status;
+} keep_going_state;
+
+/**
+ * Parse callback that writes each declaration or reports each error.
+ *
+ * @param parser Parser state
+ * @param status Parser status for the declaration
+ * @param decl Parsed declaration, `NULL` on error
+ * @param data Address of the `keep_going_state`
+ * @returns `true` to continue parsing, `false` on render error
+ */
+static bool
+keep_going_decl(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_parser_status status,
+  const pdxcp_cdcl_decl *decl,
+  void *data)
+{
+  keep_going_state *state = data;
+  // report error with its location and keep going
+  if (!decl) {
+    fflush(stdout);
+    print_parse_err(state->path, &parser->errinfo);
+    return true;
+  }
+  // render into the parser byte vector to write each declaration at once
+  parser->buf.size = 0;
+  status = pdxcp_cdcl_decl_render_as(decl, state->format, &parser->buf);
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    state->status = status;
+    return false;
+  }
+  fwrite(parser->buf.data, 1, parser->buf.size, stdout);
+  return true;
+}
+
+/**
+ * Parse an input in-process, skipping malformed declarations.
+ *
+ * Each error is written to `stderr` with its byte offset in the input.
+ *
+ * @param opts Program options
+ * @param path Input file path
+ * @param buf Input contents
+ * @param n_decls Address to write the number of declarations written to
+ * @returns `true` if there were no errors, `false` otherwise
+ */
+static bool
+parse_keep_going(
+  const cdecl_options *opts,
+  const char *path,
+  const pdxcp_bvector *buf,
+  size_t *n_decls)
+{
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  parser.recover = true;
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  parser.typedefs = &typedefs;
+  keep_going_state state = {path, opts->format, pdxcp_cdcl_parser_status_ok};
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_buf_parse_all(
+    &parser,
+    (buf->data) ? (const char *) buf->data : "",
+    buf->size,
+    keep_going_decl,
+    &state
+  );
+  *n_decls = parser.n_decls;
+  bool ok = !parser.n_errors;
+  // render errors stop parsing since they are not input errors
+  if (PDXCP_CDCL_PARSER_OK(status))
+    status = state.status;
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    fflush(stdout);
+    fprintf(
+      stderr, "Error: %s: %s\n", path, pdxcp_cdcl_parser_status_string(status)
+    );
+    ok = false;
+  }
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+  pdxcp_cdcl_parser_destroy(&parser);
+  return ok;
+}
+
+/**
+ * Send an input to `pdxcp_cdecld` and write the descriptions to `stdout`.
+ *
+ * Inputs larger than `PDXCP_CDCL_SERVICE_MAX_REQUEST` are sent as several
+ * requests split at declaration boundaries.
+ *
+ * @param fd Socket connected to `pdxcp_cdecld`
+ * @param path Input file path
+ * @param buf Input contents
+ * @param response Response reused across requests
+ * @param n_decls Address to write the number of declarations written to
+ * @returns `true` on success, `false` on error
+ */
+static bool
+parse_remote(
+  int fd,
+  const char *path,
+  const pdxcp_bvector *buf,
+  pdxcp_cdcl_service_response *response,
+  size_t *n_decls)
+{
+  const char *in = (buf->data) ? (const char *) buf->data : "";
+  *n_decls = 0;
+  size_t pos = 0;
+  do {
+    // take whole declarations up to the request limit, but at least one
+    size_t end = pos;
+    while (end < buf->size) {
+      size_t next = end + pdxcp_cdcl_next_decl_end(in + end, buf->size - end);
+      if (next - pos > PDXCP_CDCL_SERVICE_MAX_REQUEST && end > pos)
+        break;
+      end = next;
+    }
+    if (!pdxcp_cdcl_service_request(fd, in + pos, end - pos, response)) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    *n_decls += response->n_decls;
+    fwrite(response->data.data, 1, response->text_size, stdout);
+    if (!PDXCP_CDCL_PARSER_OK(response->status)) {
+      fflush(stdout);
+      // the error offset is relative to the start of the request
+      fprintf(
+        stderr,
+        "Error: %s:%zu: %.*s\n",
+        path,
+        pos + response->err_offset,
+        (int) (response->data.size - response->text_size),
+        (const char *) response->data.data + response->text_size
+      );
+      return false;
+    }
+    pos = end;
+  }
+  while (pos < buf->size);
+  return true;
+}
+
+/**
+ * Return seconds elapsed since the given monotonic clock time.
+ *
+ * @param start Start time from `clock_gettime(CLOCK_MONOTONIC, ...)`
+ */
+static double
+elapsed_since(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) (now.tv_sec - start->tv_sec) +
+    1e-9 * (double) (now.tv_nsec - start->tv_nsec);
+}
+
+int
+main(int argc, char *argv[])
+{
+  cdecl_options opts;
+  int status = parse_args(argc, argv, &opts);
+  if (status)
+    return (status < 0) ? EXIT_SUCCESS : status;
+  // fully buffer output since it is usually piped
+  setvbuf(stdout, NULL, _IOFBF, PDXCP_CDECL_OUT_BUF_SIZE);
+  // read from stdin if no files are given
+  static char stdin_path[] = "-";
+  static char *stdin_paths[] = {stdin_path};
+  if (!opts.n_paths) {
+    opts.paths = stdin_paths;
+    opts.n_paths = 1;
+  }
+  // connect once and send every input on the same connection
+  int fd = -1;
+  if (
+    opts.socket_path &&
+    (fd = pdxcp_cdcl_service_connect(opts.socket_path)) < 0
+  ) {
+    fprintf(stderr, "Error: %s: %s\n", opts.socket_path, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // input buffer and response reused for each file
+  pdxcp_bvector buf;
+  pdxcp_bvector_init(&buf);
+  pdxcp_cdcl_service_response response;
+  pdxcp_cdcl_service_response_init(&response);
+  size_t n_total = 0;
+  size_t n_bytes = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  status = EXIT_SUCCESS;
+  for (int i = 0; i < opts.n_paths; i++) {
+    const char *path = opts.paths[i];
+    bool use_stdin = !strcmp(path, "-");
+    // read whole input
+    FILE *in = (use_stdin) ? stdin : fopen(path, "rb");
+    if (!in) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+      status = EXIT_FAILURE;
+      break;
+    }
+    bool read_ok = read_all(in, &buf);
+    int read_err = errno;
+    if (!use_stdin)
+      fclose(in);
+    if (!read_ok) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(read_err));
+      status = EXIT_FAILURE;
+      break;
+    }
+    n_bytes += buf.size;
+    // parse and write descriptions
+    size_t n_decls;
+    bool parse_ok;
+    if (fd >= 0)
+      parse_ok = parse_remote(fd, path, &buf, &response, &n_decls);
+    else if (opts.keep_going)
+      parse_ok = parse_keep_going(&opts, path, &buf, &n_decls);
+    else
+      parse_ok = parse_local(&opts, path, &buf, &n_decls);
+    n_total += n_decls;
+    if (!parse_ok) {
+      status = EXIT_FAILURE;
+      // errors were already skipped over, so move on to the next input
+      if (opts.keep_going)
+        continue;
+      break;
+    }
+  }
+  pdxcp_cdcl_service_response_destroy(&response);
+  pdxcp_bvector_destroy(&buf);
+  if (fd >= 0)
+    close(fd);
+  if (fflush(stdout)) {
+    fprintf(stderr, "Error: stdout: %s\n", strerror(errno));
+    status = EXIT_FAILURE;
+  }
+  // report throughput, including reading input and writing output
+  if (opts.stats) {
+    double seconds = elapsed_since(&start);
+    fprintf(
+      stderr,
+      "decls: %zu, bytes: %zu, seconds: %.6f, decls/sec: %.0f\n",
+      n_total,
+      n_bytes,
+      seconds,
+      (seconds > 0) ? (double) n_total / seconds : 0.
+    );
+  }
+  return status;
+}
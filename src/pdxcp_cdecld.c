@@ -0,0 +1,446 @@
+/**
+ * @file pdxcp_cdecld.c
+ * @author Derek Huang
+ * @brief cdecl service daemon serving requests over a Unix domain socket
+ * @copyright MIT License
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/cdcl_service.h"
+
+/**
+ * Default number of worker threads.
+ */
+#define PDXCP_CDECLD_N_WORKERS 4
+
+/**
+ * Default per-worker parse result cache capacity.
+ *
+ * Tooling tends to ask about the same declarations over and over, so unlike
+ * `pdxcp_cdecl` the daemon caches by default.
+ */
+#define PDXCP_CDECLD_CACHE_SIZE 4096
+
+/**
+ * Maximum length of the pending connection queue.
+ */
+#define PDXCP_CDECLD_BACKLOG 128
+
+/**
+ * Default connection timeout in seconds.
+ *
+ * A worker serves one connection at a time, so without a timeout idle or
+ * stalled clients could hold every worker while new connections wait.
+ */
+#define PDXCP_CDECLD_TIMEOUT 30
+
+/**
+ * Program options.
+ *
+ * @param n_workers Number of worker threads, zero for all online processors
+ * @param cache_size Per-worker cache capacity, zero for no caching
+ * @param timeout Seconds a connection may block a worker waiting to send or
+ *  receive, zero for no timeout
+ * @param path Socket path
+ */
+typedef struct {
+  unsigned int n_workers;
+  size_t cache_size;
+  size_t timeout;
+  const char *path;
+} cdecld_options;
+
+/**
+ * Queue of accepted connections shared by the accepting thread and workers.
+ *
+ * Connections are appended by the accepting thread and removed by whichever
+ * idle worker wakes first. Each worker serves a connection until the client
+ * closes it or it times out, so a client that sends many requests on one
+ * connection always hits the same warm cache.
+ *
+ * @param mut Mutex guarding all other members
+ * @param cond Condition variable signaled when a connection is queued
+ * @param fds Circular buffer of connected socket file descriptors
+ * @param capacity Capacity of `fds`
+ * @param head Index of the first queued connection
+ * @param size Number of queued connections
+ */
+typedef struct {
+  pthread_mutex_t mut;
+  pthread_cond_t cond;
+  int *fds;
+  size_t capacity;
+  size_t head;
+  size_t size;
+} conn_queue;
+
+/**
+ * Worker thread payload.
+ *
+ * @param queue Connection queue
+ * @param cache_size Per-worker cache capacity
+ */
+typedef struct {
+  conn_queue *queue;
+  size_t cache_size;
+} worker_payload;
+
+/**
+ * Self-pipe written to by the termination signal handler.
+ *
+ * The accepting thread polls the read end together with the listening socket,
+ * so a signal arriving at any point is noticed by the next poll.
+ */
+static int stop_pipe[2] = {-1, -1};
+
+/**
+ * Termination signal handler.
+ *
+ * The write end is nonblocking, so repeated signals cannot block the handler
+ * once the pipe is full. One unread byte is enough to stop.
+ *
+ * @param signum Signal number
+ */
+static void
+handle_stop(int signum)
+{
+  (void) signum;
+  int saved_errno = errno;
+  ssize_t n_written = write(stop_pipe[1], "", 1);
+  (void) n_written;
+  errno = saved_errno;
+}
+
+/**
+ * Print the program usage to the given stream.
+ *
+ * @param out Output stream
+ * @param progname Program name
+ */
+static void
+print_usage(FILE *out, const char *progname)
+{
+  fprintf(
+    out,
+    "Usage: %s [-h] [-j N] [--cache N] [--timeout N] SOCKET\n"
+    "\n"
+    "Serve C declaration parse requests on the Unix domain socket SOCKET,\n"
+    "which is created on startup and removed on SIGINT or SIGTERM.\n"
+    "\n"
+    "Each request is a 32-bit big-endian byte count followed by declaration\n"
+    "text. Each response is the 32-bit big-endian parser status, declaration\n"
+    "count, rendered text size, error text size, and error byte offset,\n"
+    "followed by the rendered text and error text. Connections may carry\n"
+    "many requests. Connections idle for the timeout are closed.\n"
+    "\n"
+    "Options:\n"
+    "  -h, --help         Print this usage and exit\n"
+    "  -j, --workers N    Serve with N workers, 0 for all processors [%d]\n"
+    "  --cache N          Per-worker cache capacity, 0 to disable [%d]\n"
+    "  --timeout N        Connection timeout in seconds, 0 to disable [%d]\n",
+    progname,
+    PDXCP_CDECLD_N_WORKERS,
+    PDXCP_CDECLD_CACHE_SIZE,
+    PDXCP_CDECLD_TIMEOUT
+  );
+}
+
+/**
+ * Parse a nonnegative integer option value.
+ *
+ * @param progname Program name
+ * @param opt Option name
+ * @param text Option value text, can be `NULL` if the value is missing
+ * @param value Address to write the parsed value to
+ * @returns `true` on success, `false` if `text` is not a valid value
+ */
+static bool
+parse_size_opt(
+  const char *progname, const char *opt, const char *text, size_t *value)
+{
+  if (!text) {
+    fprintf(stderr, "Error: %s: %s requires a value\n", progname, opt);
+    return false;
+  }
+  char *end;
+  errno = 0;
+  unsigned long long v = strtoull(text, &end, 10);
+  if (!*text || *end || *text == '-' || errno) {
+    fprintf(
+      stderr, "Error: %s: Invalid %s value \"%s\"\n", progname, opt, text
+    );
+    return false;
+  }
+  *value = (size_t) v;
+  return true;
+}
+
+/**
+ * Parse command-line arguments into the program options.
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Program options to write to
+ * @returns `EXIT_SUCCESS` to continue, `EXIT_FAILURE` on error, or -1 if the
+ *  usage was printed and the program should exit successfully
+ */
+static int
+parse_args(int argc, char *argv[], cdecld_options *opts)
+{
+  opts->n_workers = PDXCP_CDECLD_N_WORKERS;
+  opts->cache_size = PDXCP_CDECLD_CACHE_SIZE;
+  opts->timeout = PDXCP_CDECLD_TIMEOUT;
+  opts->path = NULL;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    size_t value;
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      print_usage(stdout, argv[0]);
+      return -1;
+    }
+    else if (!strcmp(arg, "-j") || !strcmp(arg, "--workers")) {
+      if (!parse_size_opt(argv[0], arg, argv[++i], &value))
+        return EXIT_FAILURE;
+      opts->n_workers = (unsigned int) value;
+    }
+    else if (!strcmp(arg, "--cache")) {
+      if (!parse_size_opt(argv[0], arg, argv[++i], &value))
+        return EXIT_FAILURE;
+      opts->cache_size = value;
+    }
+    else if (!strcmp(arg, "--timeout")) {
+      if (!parse_size_opt(argv[0], arg, argv[++i], &value))
+        return EXIT_FAILURE;
+      opts->timeout = value;
+    }
+    else if (arg[0] == '-') {
+      fprintf(stderr, "Error: %s: Unknown option %s\n", argv[0], arg);
+      print_usage(stderr, argv[0]);
+      return EXIT_FAILURE;
+    }
+    else if (opts->path) {
+      fprintf(stderr, "Error: %s: Only one SOCKET allowed\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+    else
+      opts->path = arg;
+  }
+  if (!opts->path) {
+    print_usage(stderr, argv[0]);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Set the send and receive timeouts of a connected socket.
+ *
+ * A worker blocked on a connection for longer than the timeout gives it up,
+ * see `pdxcp_cdcl_service_serve`.
+ *
+ * @param fd Connected socket file descriptor
+ * @param timeout Timeout in seconds, zero for no timeout
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+static bool
+set_conn_timeout(int fd, size_t timeout)
+{
+  if (!timeout)
+    return true;
+  struct timeval tv = {(time_t) timeout, 0};
+  return
+    !setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv) &&
+    !setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+}
+
+/**
+ * Append a connection to the queue, growing the queue if necessary.
+ *
+ * @param queue Connection queue
+ * @param fd Connected socket file descriptor
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+conn_queue_push(conn_queue *queue, int fd)
+{
+  pthread_mutex_lock(&queue->mut);
+  if (queue->size == queue->capacity) {
+    size_t capacity = (queue->capacity) ? 2 * queue->capacity : 16;
+    int *fds = malloc(capacity * sizeof *fds);
+    if (!fds) {
+      pthread_mutex_unlock(&queue->mut);
+      return false;
+    }
+    // unwrap circular buffer into the new buffer
+    for (size_t i = 0; i < queue->size; i++)
+      fds[i] = queue->fds[(queue->head + i) % queue->capacity];
+    free(queue->fds);
+    queue->fds = fds;
+    queue->capacity = capacity;
+    queue->head = 0;
+  }
+  queue->fds[(queue->head + queue->size) % queue->capacity] = fd;
+  queue->size++;
+  pthread_cond_signal(&queue->cond);
+  pthread_mutex_unlock(&queue->mut);
+  return true;
+}
+
+/**
+ * Remove the first connection from the queue, waiting until there is one.
+ *
+ * @param queue Connection queue
+ * @returns Connected socket file descriptor
+ */
+static int
+conn_queue_pop(conn_queue *queue)
+{
+  pthread_mutex_lock(&queue->mut);
+  while (!queue->size)
+    pthread_cond_wait(&queue->cond, &queue->mut);
+  int fd = queue->fds[queue->head];
+  queue->head = (queue->head + 1) % queue->capacity;
+  queue->size--;
+  pthread_mutex_unlock(&queue->mut);
+  return fd;
+}
+
+/**
+ * Worker thread routine.
+ *
+ * Each worker owns its parser state and cache for its whole lifetime, so no
+ * locking is needed when serving and the cache stays warm across connections.
+ *
+ * @param arg Address of the `worker_payload`
+ * @returns `NULL`
+ */
+static void *
+worker_main(void *arg)
+{
+  worker_payload *payload = arg;
+  pdxcp_cdcl_service_worker worker;
+  pdxcp_cdcl_service_worker_init(&worker, payload->cache_size);
+  // runs until the process exits
+  while (true) {
+    int fd = conn_queue_pop(payload->queue);
+    if (!pdxcp_cdcl_service_serve(&worker, fd))
+      fprintf(stderr, "Warning: dropped connection: %s\n", strerror(errno));
+    close(fd);
+  }
+  return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+  cdecld_options opts;
+  int status = parse_args(argc, argv, &opts);
+  if (status)
+    return (status < 0) ? EXIT_SUCCESS : status;
+  // use all online processors if worker count is unspecified
+  if (!opts.n_workers) {
+    long n_procs = sysconf(_SC_NPROCESSORS_ONLN);
+    opts.n_workers = (n_procs > 0) ? (unsigned int) n_procs : 1;
+  }
+  // self-pipe the signal handler writes to
+  if (
+    pipe(stop_pipe) ||
+    fcntl(stop_pipe[1], F_SETFL, fcntl(stop_pipe[1], F_GETFL) | O_NONBLOCK)
+  ) {
+    fprintf(stderr, "Error: pipe: %s\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // stop on SIGINT and SIGTERM. no SA_RESTART so a blocked accept returns
+  // EINTR and the loop goes back to polling the self-pipe
+  struct sigaction action;
+  memset(&action, 0, sizeof action);
+  action.sa_handler = handle_stop;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGINT, &action, NULL) || sigaction(SIGTERM, &action, NULL)) {
+    fprintf(stderr, "Error: sigaction: %s\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // create socket
+  int listen_fd = pdxcp_cdcl_service_listen(opts.path, PDXCP_CDECLD_BACKLOG);
+  if (listen_fd < 0) {
+    fprintf(stderr, "Error: %s: %s\n", opts.path, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // start workers, which run until the process exits. workers inherit a
+  // mask blocking SIGINT and SIGTERM so only this thread runs the handler.
+  // signals arriving while blocked here are delivered once unblocked
+  sigset_t stop_signals, old_mask;
+  sigemptyset(&stop_signals);
+  sigaddset(&stop_signals, SIGINT);
+  sigaddset(&stop_signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+  conn_queue queue = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0, 0
+  };
+  worker_payload payload = {&queue, opts.cache_size};
+  status = EXIT_SUCCESS;
+  for (unsigned int i = 0; i < opts.n_workers; i++) {
+    pthread_t thread;
+    int err = pthread_create(&thread, NULL, worker_main, &payload);
+    if (err) {
+      fprintf(stderr, "Error: pthread_create: %s\n", strerror(err));
+      status = EXIT_FAILURE;
+      break;
+    }
+    pthread_detach(thread);
+  }
+  pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+  // accept connections until the self-pipe becomes readable
+  struct pollfd poll_fds[] = {
+    {listen_fd, POLLIN, 0},
+    {stop_pipe[0], POLLIN, 0}
+  };
+  while (status == EXIT_SUCCESS) {
+    if (poll(poll_fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "Error: poll: %s\n", strerror(errno));
+      status = EXIT_FAILURE;
+      break;
+    }
+    if (poll_fds[1].revents)
+      break;
+    if (!poll_fds[0].revents)
+      continue;
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      fprintf(stderr, "Error: accept: %s\n", strerror(errno));
+      status = EXIT_FAILURE;
+    }
+    else if (!set_conn_timeout(fd, opts.timeout)) {
+      fprintf(stderr, "Warning: dropped connection: %s\n", strerror(errno));
+      close(fd);
+    }
+    else if (!conn_queue_push(&queue, fd)) {
+      fprintf(stderr, "Warning: dropped connection: %s\n", strerror(ENOMEM));
+      close(fd);
+    }
+  }
+  // in-flight connections are dropped when the process exits
+  close(listen_fd);
+  unlink(opts.path);
+  close(stop_pipe[0]);
+  close(stop_pipe[1]);
+  return status;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file pdxcp_cdindex.c
+ * @author Derek Huang
+ * @brief Parallel C declaration indexer for source trees
+ * @copyright MIT License
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/cdcl_index.h"
+#include "pdxcp/cdcl_parser.h"
+
+/**
+ * Program options.
+ *
+ * @param n_threads Number of threads, zero for all online processors
+ * @param out_path Index file to write, `NULL` when querying
+ * @param name Identifier to query, `NULL` when indexing
+ * @param args First positional argument
+ * @param n_args Number of positional arguments
+ */
+typedef struct {
+  unsigned int n_threads;
+  const char *out_path;
+  const char *name;
+  char **args;
+  int n_args;
+} cdindex_options;
+
+/**
+ * Print the program usage to the given stream.
+ *
+ * @param out Output stream
+ * @param progname Program name
+ */
+static void
+print_usage(FILE *out, const char *progname)
+{
+  fprintf(
+    out,
+    "Usage: %s [-h] [-j N] -o INDEX DIR...\n"
+    "       %s -q NAME INDEX\n"
+    "\n"
+    "Index the top-level declarations of the .c and .h files under each DIR\n"
+    "into the index file INDEX, or print the declarations of the identifier\n"
+    "NAME from INDEX as PATH:OFFSET: DECLARATION lines.\n"
+    "\n"
+    "Function definitions are indexed as the declaration before the body.\n"
+    "Typedef names are types in the rest of the file that declares them.\n"
+    "Declarations the parser does not support, e.g. those using typedef\n"
+    "names from other files, are skipped. The index is sorted by identifier\n"
+    "and is queried in place with mmap, so lookups do not depend on the\n"
+    "index size.\n"
+    "\n"
+    "Options:\n"
+    "  -h, --help         Print this usage and exit\n"
+    "  -j, --threads N    Index with N threads, 0 for all processors [0]\n"
+    "  -o, --output INDEX Write the index to INDEX\n"
+    "  -q, --query NAME   Print the declarations of NAME\n",
+    progname,
+    progname
+  );
+}
+
+/**
+ * Parse command-line arguments into the program options.
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Program options to write to
+ * @returns `EXIT_SUCCESS` to continue, `EXIT_FAILURE` on error, or -1 if the
+ *  usage was printed and the program should exit successfully
+ */
+static int
+parse_args(int argc, char *argv[], cdindex_options *opts)
+{
+  opts->n_threads = 0;
+  opts->out_path = NULL;
+  opts->name = NULL;
+  opts->args = NULL;
+  opts->n_args = 0;
+  int i;
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      print_usage(stdout, argv[0]);
+      return -1;
+    }
+    else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads")) {
+      const char *text = argv[++i];
+      char *end;
+      errno = 0;
+      unsigned long value = (text) ? strtoul(text, &end, 10) : 0;
+      if (!text || !*text || *end || *text == '-' || errno) {
+        fprintf(stderr, "Error: %s: Invalid %s value\n", argv[0], arg);
+        return EXIT_FAILURE;
+      }
+      opts->n_threads = (unsigned int) value;
+    }
+    else if (!strcmp(arg, "-o") || !strcmp(arg, "--output")) {
+      if (!(opts->out_path = argv[++i])) {
+        fprintf(stderr, "Error: %s: %s requires a value\n", argv[0], arg);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (!strcmp(arg, "-q") || !strcmp(arg, "--query")) {
+      if (!(opts->name = argv[++i])) {
+        fprintf(stderr, "Error: %s: %s requires a value\n", argv[0], arg);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (arg[0] == '-') {
+      fprintf(stderr, "Error: %s: Unknown option %s\n", argv[0], arg);
+      print_usage(stderr, argv[0]);
+      return EXIT_FAILURE;
+    }
+    else
+      break;
+  }
+  opts->args = argv + i;
+  opts->n_args = argc - i;
+  // exactly one of -o and -q. queries take exactly one index
+  if (
+    !opts->out_path == !opts->name ||
+    !opts->n_args ||
+    (opts->name && opts->n_args != 1)
+  ) {
+    print_usage(stderr, argv[0]);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Index the source trees and write the index file.
+ *
+ * @param opts Program options
+ * @returns `EXIT_SUCCESS` on success, `EXIT_FAILURE` on error
+ */
+static int
+build_index(const cdindex_options *opts)
+{
+  int status = EXIT_FAILURE;
+  pdxcp_cdcl_index_paths paths;
+  pdxcp_cdcl_index_paths_init(&paths);
+  for (int i = 0; i < opts->n_args; i++) {
+    if (!pdxcp_cdcl_index_paths_add_tree(&paths, opts->args[i])) {
+      fprintf(stderr, "Error: %s: %s\n", opts->args[i], strerror(errno));
+      goto done;
+    }
+  }
+  FILE *out = fopen(opts->out_path, "wb");
+  if (!out) {
+    fprintf(stderr, "Error: %s: %s\n", opts->out_path, strerror(errno));
+    goto done;
+  }
+  pdxcp_cdcl_index_stats stats;
+  pdxcp_cdcl_parser_status parse_status = pdxcp_cdcl_index_build(
+    &paths, out, opts->n_threads, &stats
+  );
+  if (fclose(out) && PDXCP_CDCL_PARSER_OK(parse_status))
+    parse_status = pdxcp_cdcl_parser_status_out_err;
+  if (!PDXCP_CDCL_PARSER_OK(parse_status)) {
+    fprintf(
+      stderr,
+      "Error: %s: %s\n",
+      opts->out_path,
+      pdxcp_cdcl_parser_status_message(parse_status)
+    );
+    remove(opts->out_path);
+    goto done;
+  }
+  fprintf(
+    stderr,
+    "Indexed %zu declarations from %zu files (%zu skipped, %zu unreadable "
+    "files)\n",
+    stats.n_entries,
+    stats.n_files,
+    stats.n_skipped,
+    stats.n_failed
+  );
+  status = EXIT_SUCCESS;
+done:
+  pdxcp_cdcl_index_paths_destroy(&paths);
+  return status;
+}
+
+/**
+ * Print the declarations of an identifier from a memory-mapped index file.
+ *
+ * @param opts Program options
+ * @returns `EXIT_SUCCESS` if any were found, `EXIT_FAILURE` otherwise
+ */
+static int
+query_index(const cdindex_options *opts)
+{
+  const char *path = opts->args[0];
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return EXIT_FAILURE;
+  }
+  size_t size = (size_t) st.st_size;
+  void *data = (size) ?
+    mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  pdxcp_cdcl_index index;
+  if (data == MAP_FAILED || !pdxcp_cdcl_index_open(&index, data, size)) {
+    fprintf(stderr, "Error: %s: Not a valid index file\n", path);
+    if (data != MAP_FAILED)
+      munmap(data, size);
+    return EXIT_FAILURE;
+  }
+  size_t n_found;
+  size_t first = pdxcp_cdcl_index_find(&index, opts->name, &n_found);
+  int status = (n_found) ? EXIT_SUCCESS : EXIT_FAILURE;
+  for (size_t i = first; i < first + n_found; i++) {
+    pdxcp_cdcl_index_entry entry;
+    if (!pdxcp_cdcl_index_get(&index, i, &entry)) {
+      fprintf(stderr, "Error: %s: Invalid entry %zu\n", path, i);
+      status = EXIT_FAILURE;
+      break;
+    }
+    printf(
+      "%s:%llu: %s\n", entry.path, (unsigned long long) entry.pos, entry.decl
+    );
+  }
+  munmap(data, size);
+  return status;
+}
+
+int
+main(int argc, char *argv[])
+{
+  cdindex_options opts;
+  int status = parse_args(argc, argv, &opts);
+  if (status)
+    return (status < 0) ? EXIT_SUCCESS : status;
+  return (opts.out_path) ? build_index(&opts) : query_index(&opts);
+}
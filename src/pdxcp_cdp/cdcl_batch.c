@@ -0,0 +1,492 @@
+/**
+ * @file cdcl_batch.c
+ * @author Derek Huang
+ * @brief C source for multithreaded batch C declaration parsing
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_batch.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_cache.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+
+/**
+ * Minimum target number of input bytes in each batch work unit.
+ *
+ * Prevents small inputs from being split into units too small to be worth
+ * handing to another thread.
+ */
+#define PDXCP_CDCL_BATCH_MIN_UNIT_SIZE 4096
+
+/**
+ * Number of work units to aim for per thread.
+ *
+ * Having several units per thread lets threads that finish early pick up more
+ * work when declarations take uneven amounts of time to parse.
+ */
+#define PDXCP_CDCL_BATCH_UNITS_PER_THREAD 4
+
+size_t
+pdxcp_cdcl_next_decl_end(const char *in, size_t in_size)
+{
+  // current scan position, always outside of any comment
+  size_t pos = 0;
+  while (pos < in_size) {
+    // find next ';' and check if any '/' precedes it. if not, the ';' cannot
+    // be inside a comment, which is by far the common case
+    const char *semi = memchr(in + pos, ';', in_size - pos);
+    size_t end = (semi) ? (size_t) (semi - in) : in_size;
+    const char *slash = memchr(in + pos, '/', end - pos);
+    if (!slash)
+      return (semi) ? end + 1 : in_size;
+    // otherwise, skip past the '/' and any comment it starts
+    pos = (size_t) (slash - in) + 1;
+    if (pos == in_size)
+      break;
+    // C block comment. skip to the char after the closing "*/"
+    if (in[pos] == '*') {
+      pos++;
+      while (true) {
+        const char *star = memchr(in + pos, '*', in_size - pos);
+        if (!star)
+          return in_size;
+        pos = (size_t) (star - in) + 1;
+        if (pos == in_size)
+          return in_size;
+        if (in[pos] == '/') {
+          pos++;
+          break;
+        }
+      }
+    }
+    // C++ line comment. skip to the char after the newline
+    else if (in[pos] == '/') {
+      const char *newline = memchr(in + pos, '\n', in_size - pos);
+      if (!newline)
+        return in_size;
+      pos = (size_t) (newline - in) + 1;
+    }
+    // a lone '/' is not a comment, so just continue after it
+  }
+  return in_size;
+}
+
+/**
+ * Batch work unit.
+ *
+ * @param offset Offset of the unit's first byte in the input buffer
+ * @param size Number of bytes in the unit
+ * @param out Rendered declarations in input order
+ * @param n_decls Number of declarations successfully parsed
+ * @param status Parser status for the unit
+ * @param errinfo Error info, only written to if there is an error
+ */
+typedef struct {
+  size_t offset;
+  size_t size;
+  pdxcp_bvector out;
+  size_t n_decls;
+  pdxcp_cdcl_parser_status status;
+  pdxcp_cdcl_parser_errinfo errinfo;
+} batch_unit;
+
+/**
+ * Work shared by all the batch parsing threads.
+ *
+ * Each thread claims the next unclaimed unit by incrementing `next_unit`, so
+ * units are claimed in increasing order. Once a unit has an error, there is no
+ * point in parsing the units after it since their output will never be
+ * written, so the index of the first unit with an error is tracked.
+ *
+ * @param in Input buffer
+ * @param format Output format
+ * @param cache_size Per-thread parse result cache capacity, zero for no cache
+ * @param typedefs Typedef name table shared by all the threads' parsers
+ * @param units Work units
+ * @param n_units Number of work units
+ * @param next_unit Index of the next unit to claim
+ * @param err_unit Index of the first unit with an error, `n_units` if none
+ */
+typedef struct {
+  const char *in;
+  pdxcp_cdcl_output_format format;
+  size_t cache_size;
+  pdxcp_cdcl_typedefs typedefs;
+  batch_unit *units;
+  size_t n_units;
+  atomic_size_t next_unit;
+  atomic_size_t err_unit;
+} batch_work;
+
+/**
+ * Write parser error info for an error that has no lexer or parser text.
+ *
+ * @param errinfo Error info structure
+ * @param status Parser status
+ */
+static void
+batch_write_status_err(
+  pdxcp_cdcl_parser_errinfo *errinfo, pdxcp_cdcl_parser_status status)
+{
+  errinfo->lexer.status = pdxcp_cdcl_lexer_status_ok;
+  errinfo->lexer.text[0] = '\0';
+  errinfo->parser.status = status;
+  errinfo->parser.error = pdxcp_cdcl_parser_error_none;
+  errinfo->parser.token = pdxcp_cdcl_token_type_error;
+  errinfo->parser.type = pdxcp_cdcl_token_type_error;
+  errinfo->parser.n_lparen = errinfo->parser.n_rparen = 0;
+  errinfo->parser.name[0] = '\0';
+  errinfo->offset = 0;
+  errinfo->span = 0;
+}
+
+/**
+ * Split the input buffer into work units at declaration boundaries.
+ *
+ * @param in Input buffer
+ * @param in_size Number of bytes in the input buffer
+ * @param unit_size Target number of input bytes in each work unit
+ * @param units Address to write the `malloc`ed work unit array to
+ * @param n_units Address to write the number of work units to
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+batch_split_units(
+  const char *in,
+  size_t in_size,
+  size_t unit_size,
+  batch_unit **units,
+  size_t *n_units)
+{
+  batch_unit *vec = NULL;
+  size_t size = 0;
+  size_t capacity = 0;
+  // consume whole declarations until each unit reaches the target size
+  size_t pos = 0;
+  while (pos < in_size) {
+    size_t end = pos;
+    do {
+      end += pdxcp_cdcl_next_decl_end(in + end, in_size - end);
+    }
+    while (end - pos < unit_size && end < in_size);
+    // grow unit array if necessary
+    if (size == capacity) {
+      capacity = (capacity) ? 2 * capacity : 16;
+      batch_unit *new_vec = realloc(vec, capacity * sizeof *vec);
+      if (!new_vec) {
+        free(vec);
+        return false;
+      }
+      vec = new_vec;
+    }
+    // initialize unit
+    vec[size].offset = pos;
+    vec[size].size = end - pos;
+    pdxcp_bvector_init(&vec[size].out);
+    vec[size].n_decls = 0;
+    vec[size].status = pdxcp_cdcl_parser_status_ok;
+    size++;
+    pos = end;
+  }
+  *units = vec;
+  *n_units = size;
+  return true;
+}
+
+/**
+ * Collect the typedef names declared in the input buffer.
+ *
+ * Each declaration starting with `typedef` is parsed in input order, so it
+ * can use the typedef names declared before it. Other declarations are only
+ * lexed up to their first token. Typedef declarations that fail to parse are
+ * skipped, since the error is reported when the units are parsed.
+ *
+ * @param parser Parser state whose typedef name table is added to
+ * @param in Input buffer
+ * @param in_size Number of bytes in the input buffer
+ * @param complete Address to write `true` to if every typedef declaration
+ *  was parsed and `false` otherwise
+ * @returns `pdxcp_cdcl_parser_status_ok` on success,
+ *  `pdxcp_cdcl_parser_status_no_mem` on allocation failure
+ */
+static pdxcp_cdcl_parser_status
+batch_collect_typedefs(
+  pdxcp_cdcl_parser *parser, const char *in, size_t in_size, bool *complete)
+{
+  *complete = true;
+  size_t pos = 0;
+  while (pos < in_size) {
+    size_t end = pos + pdxcp_cdcl_next_decl_end(in + pos, in_size - pos);
+    pdxcp_cdcl_lexer_buf buf;
+    PDXCP_CDCL_LEXER_BUF_INIT(&buf, in + pos, in_size - pos);
+    pdxcp_cdcl_token token;
+    if (
+      PDXCP_CDCL_LEXER_OK(pdxcp_cdcl_get_token_buf(&buf, &token)) &&
+      token.type == pdxcp_cdcl_token_type_iden &&
+      !strcmp(token.text, "typedef")
+    ) {
+      PDXCP_CDCL_LEXER_BUF_INIT(&buf, in + pos, in_size - pos);
+      pdxcp_arena_reset(&parser->arena);
+      pdxcp_cdcl_decl decl;
+      pdxcp_cdcl_parser_status status = pdxcp_cdcl_parser_parse_decl_buf(
+        parser, &buf, &decl
+      );
+      if (status == pdxcp_cdcl_parser_status_no_mem)
+        return status;
+      if (!PDXCP_CDCL_PARSER_OK(status))
+        *complete = false;
+    }
+    pos = end;
+  }
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Parse callback state for a work unit.
+ *
+ * @param unit Work unit being parsed
+ * @param format Output format
+ */
+typedef struct {
+  batch_unit *unit;
+  pdxcp_cdcl_output_format format;
+} batch_render_state;
+
+/**
+ * Parse callback that renders each declaration into a work unit's output.
+ *
+ * @param parser Parser state
+ * @param status Parser status for the declaration
+ * @param decl Parsed declaration, `NULL` on error
+ * @param data Address of the `batch_render_state` for the unit being parsed
+ * @returns `true` to continue parsing, `false` on render error
+ */
+static bool
+batch_render_decl(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_parser_status status,
+  const pdxcp_cdcl_decl *decl,
+  void *data)
+{
+  (void) parser;
+  batch_render_state *state = data;
+  batch_unit *unit = state->unit;
+  // errors are reported via the parse status
+  if (!decl)
+    return false;
+  // render error is recorded in the unit since buf_parse_all returns ok
+  status = pdxcp_cdcl_decl_render_as(decl, state->format, &unit->out);
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    unit->status = status;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Parse a single work unit.
+ *
+ * @param work Batch work
+ * @param parser Parser state owned by the calling thread
+ * @param cache Parse result cache owned by the calling thread, can be `NULL`
+ * @param unit Work unit to parse
+ */
+static void
+batch_parse_unit(
+  batch_work *work,
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_cache *cache,
+  batch_unit *unit)
+{
+  // parse through the cache if there is one
+  if (cache) {
+    unit->status = pdxcp_cdcl_cache_parse(
+      cache, parser, work->in + unit->offset, unit->size, &unit->out
+    );
+    unit->n_decls = parser->n_decls;
+    if (!PDXCP_CDCL_PARSER_OK(unit->status)) {
+      unit->errinfo = parser->errinfo;
+      unit->errinfo.offset += unit->offset;
+    }
+    return;
+  }
+  // parse all declarations in unit. unit status may be set by callback
+  batch_render_state state = {unit, work->format};
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_buf_parse_all(
+    parser, work->in + unit->offset, unit->size, batch_render_decl, &state
+  );
+  unit->n_decls = parser->n_decls;
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    unit->status = status;
+    unit->errinfo = parser->errinfo;
+    unit->errinfo.offset += unit->offset;
+  }
+  else if (!PDXCP_CDCL_PARSER_OK(unit->status))
+    batch_write_status_err(&unit->errinfo, unit->status);
+}
+
+/**
+ * Batch parsing thread routine.
+ *
+ * @param arg Address of the shared `batch_work`
+ * @returns `NULL`
+ */
+static void *
+batch_worker(void *arg)
+{
+  batch_work *work = arg;
+  // per-thread parser state and cache reused for all units this thread parses
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  parser.typedefs = &work->typedefs;
+  pdxcp_cdcl_cache cache;
+  if (work->cache_size) {
+    pdxcp_cdcl_cache_init(&cache, work->cache_size);
+    cache.format = work->format;
+  }
+  size_t i;
+  while ((i = atomic_fetch_add(&work->next_unit, 1)) < work->n_units) {
+    // units are claimed in order, so all remaining units are after the error
+    if (i > atomic_load(&work->err_unit))
+      break;
+    batch_parse_unit(
+      work, &parser, (work->cache_size) ? &cache : NULL, work->units + i
+    );
+    if (PDXCP_CDCL_PARSER_OK(work->units[i].status))
+      continue;
+    // lower the first error unit index if this unit is earlier
+    size_t err_unit = atomic_load(&work->err_unit);
+    while (
+      i < err_unit &&
+      !atomic_compare_exchange_weak(&work->err_unit, &err_unit, i)
+    );
+  }
+  pdxcp_cdcl_parser_destroy(&parser);
+  if (work->cache_size)
+    pdxcp_cdcl_cache_destroy(&cache);
+  return NULL;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_batch_parse(
+  const char *in,
+  size_t in_size,
+  FILE *out,
+  pdxcp_cdcl_output_format format,
+  unsigned int n_threads,
+  size_t cache_size,
+  size_t *n_decls,
+  pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  // check input buffer and output stream
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  // use all online processors if thread count is unspecified
+  if (!n_threads) {
+    long n_procs = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads = (n_procs > 0) ? (unsigned int) n_procs : 1;
+  }
+  // choose unit size so each thread gets several units
+  size_t unit_size = in_size /
+    ((size_t) n_threads * PDXCP_CDCL_BATCH_UNITS_PER_THREAD);
+  if (unit_size < PDXCP_CDCL_BATCH_MIN_UNIT_SIZE)
+    unit_size = PDXCP_CDCL_BATCH_MIN_UNIT_SIZE;
+  else if (unit_size > PDXCP_CDCL_BATCH_UNIT_SIZE)
+    unit_size = PDXCP_CDCL_BATCH_UNIT_SIZE;
+  // split input into units
+  batch_work work;
+  work.in = in;
+  work.format = format;
+  work.cache_size = cache_size;
+  if (!batch_split_units(in, in_size, unit_size, &work.units, &work.n_units)) {
+    if (errinfo)
+      batch_write_status_err(errinfo, pdxcp_cdcl_parser_status_no_mem);
+    return pdxcp_cdcl_parser_status_no_mem;
+  }
+  atomic_init(&work.next_unit, 0);
+  atomic_init(&work.err_unit, work.n_units);
+  // collect typedef names first so that units can be parsed in any order.
+  // if a typedef declaration could not be parsed, parsing it again may add
+  // its name, so a single thread must do all the parsing
+  pdxcp_cdcl_typedefs_init(&work.typedefs);
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  parser.typedefs = &work.typedefs;
+  bool complete;
+  pdxcp_cdcl_parser_status status = batch_collect_typedefs(
+    &parser, in, in_size, &complete
+  );
+  pdxcp_cdcl_parser_destroy(&parser);
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    if (errinfo)
+      batch_write_status_err(errinfo, status);
+    free(work.units);
+    pdxcp_cdcl_typedefs_destroy(&work.typedefs);
+    return status;
+  }
+  if (!complete)
+    n_threads = 1;
+  // no point in having more threads than units
+  if (n_threads > work.n_units)
+    n_threads = (work.n_units) ? (unsigned int) work.n_units : 1;
+  // start additional threads. the calling thread is also a worker, so if any
+  // threads fail to start, the remaining threads just do more of the work
+  pthread_t *threads = NULL;
+  unsigned int n_started = 0;
+  if (n_threads > 1 && (threads = malloc((n_threads - 1) * sizeof *threads))) {
+    while (
+      n_started < n_threads - 1 &&
+      !pthread_create(threads + n_started, NULL, batch_worker, &work)
+    )
+      n_started++;
+  }
+  batch_worker(&work);
+  for (unsigned int i = 0; i < n_started; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+  // write output in input order, stopping at the first error
+  size_t err_unit = atomic_load(&work.err_unit);
+  size_t n_written = 0;
+  for (size_t i = 0; i < work.n_units && i <= err_unit; i++) {
+    batch_unit *unit = work.units + i;
+    if (
+      unit->out.size &&
+      fwrite(unit->out.data, 1, unit->out.size, out) != unit->out.size
+    ) {
+      status = pdxcp_cdcl_parser_status_out_err;
+      if (errinfo)
+        batch_write_status_err(errinfo, status);
+      break;
+    }
+    n_written += unit->n_decls;
+    if (i == err_unit) {
+      status = unit->status;
+      if (errinfo)
+        *errinfo = unit->errinfo;
+    }
+  }
+  // units after the first error unit may also have been parsed
+  for (size_t i = 0; i < work.n_units; i++)
+    pdxcp_bvector_destroy(&work.units[i].out);
+  free(work.units);
+  pdxcp_cdcl_typedefs_destroy(&work.typedefs);
+  if (n_decls)
+    *n_decls = n_written;
+  return status;
+}
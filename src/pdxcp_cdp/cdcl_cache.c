@@ -0,0 +1,402 @@
+/**
+ * @file cdcl_cache.c
+ * @author Derek Huang
+ * @brief C source for the C declaration parse result cache
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_cache.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_batch.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_render.h"
+#include "pdxcp/strmap.h"
+
+/**
+ * Cache entry.
+ *
+ * The key and rendered text are stored in the same allocation as the entry.
+ *
+ * @param chain Next entry in the same hash bucket
+ * @param prev More recently used entry
+ * @param next Less recently used entry
+ * @param hash Hash of the normalized key
+ * @param key_size Number of bytes in the normalized key
+ * @param text_size Number of bytes in the rendered text
+ * @param data Normalized key followed by the rendered text
+ */
+struct pdxcp_cdcl_cache_entry {
+  struct pdxcp_cdcl_cache_entry *chain;
+  struct pdxcp_cdcl_cache_entry *prev;
+  struct pdxcp_cdcl_cache_entry *next;
+  uint64_t hash;
+  size_t key_size;
+  size_t text_size;
+  char data[];
+};
+
+void
+pdxcp_cdcl_cache_init(pdxcp_cdcl_cache *cache, size_t capacity)
+{
+  cache->buckets = NULL;
+  cache->n_buckets = 0;
+  cache->head = NULL;
+  cache->tail = NULL;
+  cache->size = 0;
+  cache->capacity = (capacity) ? capacity : 1;
+  cache->hits = 0;
+  cache->misses = 0;
+  pdxcp_bvector_init(&cache->key);
+  cache->format = pdxcp_cdcl_output_format_text;
+}
+
+void
+pdxcp_cdcl_cache_destroy(pdxcp_cdcl_cache *cache)
+{
+  pdxcp_cdcl_cache_entry *entry = cache->head;
+  while (entry) {
+    pdxcp_cdcl_cache_entry *next = entry->next;
+    free(entry);
+    entry = next;
+  }
+  free(cache->buckets);
+  pdxcp_bvector_destroy(&cache->key);
+}
+
+/**
+ * Check if a character can be part of an identifier or keyword.
+ *
+ * @param c Character to check
+ */
+#define PDXCP_CDCL_CACHE_IDEN_CHAR(c) \
+  (isalnum((unsigned char) (c)) || (c) == '_')
+
+/**
+ * Normalize a declaration into the cache's scratch key and hash it.
+ *
+ * Comments and whitespace are dropped except for a single space between two
+ * identifier characters, which is exactly what is needed to keep the token
+ * sequence intact. The key is empty if the input has no tokens.
+ *
+ * @param cache Cache whose scratch key is written to
+ * @param in Declaration text
+ * @param in_size Number of bytes in the declaration text
+ * @param hash Address to write the FNV-1a hash of the key to
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+cache_normalize(
+  pdxcp_cdcl_cache *cache, const char *in, size_t in_size, uint64_t *hash)
+{
+  pdxcp_bvector *key = &cache->key;
+  key->size = 0;
+  // key is at most as long as the input
+  while (key->capacity < in_size)
+    if (!pdxcp_bvector_expand(key))
+      return false;
+  // true if whitespace or a comment was skipped since the last emitted char
+  bool skipped = false;
+  size_t i = 0;
+  while (i < in_size) {
+    char c = in[i];
+    // whitespace
+    if (isspace((unsigned char) c)) {
+      skipped = true;
+      i++;
+      continue;
+    }
+    // comments, which act as whitespace
+    if (c == '/' && i + 1 < in_size && (in[i + 1] == '*' || in[i + 1] == '/')) {
+      // C block comment. unterminated comments run to the end of input
+      if (in[i + 1] == '*') {
+        for (i += 2; i + 1 < in_size; i++)
+          if (in[i] == '*' && in[i + 1] == '/')
+            break;
+        i += 2;
+      }
+      // C++ line comment
+      else
+        for (i += 2; i < in_size && in[i] != '\n'; i++);
+      skipped = true;
+      continue;
+    }
+    // keep a single space if needed to separate two identifier chars
+    if (
+      skipped && key->size &&
+      PDXCP_CDCL_CACHE_IDEN_CHAR(key->data[key->size - 1]) &&
+      PDXCP_CDCL_CACHE_IDEN_CHAR(c)
+    ) {
+      key->data[key->size++] = ' ';
+    }
+    skipped = false;
+    key->data[key->size++] = (unsigned char) c;
+    i++;
+  }
+  *hash = pdxcp_strmap_hash_fnv1a((const char *) key->data, key->size);
+  return true;
+}
+
+/**
+ * Unlink an entry from the LRU list.
+ *
+ * @param cache Cache
+ * @param entry Entry to unlink
+ */
+static void
+cache_lru_unlink(pdxcp_cdcl_cache *cache, pdxcp_cdcl_cache_entry *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    cache->head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+}
+
+/**
+ * Link an entry to the front of the LRU list as the most recently used.
+ *
+ * @param cache Cache
+ * @param entry Entry to link
+ */
+static void
+cache_lru_push(pdxcp_cdcl_cache *cache, pdxcp_cdcl_cache_entry *entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head)
+    cache->head->prev = entry;
+  else
+    cache->tail = entry;
+  cache->head = entry;
+}
+
+/**
+ * Find the entry matching the scratch key.
+ *
+ * On success, the entry becomes the most recently used entry.
+ *
+ * @param cache Cache
+ * @param hash Hash of the scratch key
+ * @returns Matching entry, `NULL` if not found
+ */
+static pdxcp_cdcl_cache_entry *
+cache_find(pdxcp_cdcl_cache *cache, uint64_t hash)
+{
+  if (!cache->buckets)
+    return NULL;
+  pdxcp_cdcl_cache_entry *entry = cache->buckets[hash & (cache->n_buckets - 1)];
+  for (; entry; entry = entry->chain) {
+    if (
+      entry->hash == hash &&
+      entry->key_size == cache->key.size &&
+      !memcmp(entry->data, cache->key.data, cache->key.size)
+    ) {
+      cache_lru_unlink(cache, entry);
+      cache_lru_push(cache, entry);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Remove the least recently used entry from the cache.
+ *
+ * @param cache Cache, must be non-empty
+ */
+static void
+cache_evict(pdxcp_cdcl_cache *cache)
+{
+  pdxcp_cdcl_cache_entry *entry = cache->tail;
+  // unlink from bucket chain
+  pdxcp_cdcl_cache_entry **link = cache->buckets +
+    (entry->hash & (cache->n_buckets - 1));
+  while (*link != entry)
+    link = &(*link)->chain;
+  *link = entry->chain;
+  // unlink from LRU list and free
+  cache_lru_unlink(cache, entry);
+  free(entry);
+  cache->size--;
+}
+
+/**
+ * Insert an entry for the scratch key, evicting if the cache is full.
+ *
+ * @param cache Cache
+ * @param hash Hash of the scratch key
+ * @param text Rendered declaration text
+ * @param text_size Number of bytes in the rendered text
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+cache_insert(
+  pdxcp_cdcl_cache *cache, uint64_t hash, const void *text, size_t text_size)
+{
+  // allocate buckets on first insertion. at most half full when at capacity
+  if (!cache->buckets) {
+    size_t n_buckets = 16;
+    while (n_buckets < 2 * cache->capacity)
+      n_buckets *= 2;
+    if (!(cache->buckets = calloc(n_buckets, sizeof *cache->buckets)))
+      return false;
+    cache->n_buckets = n_buckets;
+  }
+  // single allocation holding the entry, key, and text
+  pdxcp_cdcl_cache_entry *entry = malloc(
+    sizeof *entry + cache->key.size + text_size
+  );
+  if (!entry)
+    return false;
+  if (cache->size == cache->capacity)
+    cache_evict(cache);
+  entry->hash = hash;
+  entry->key_size = cache->key.size;
+  entry->text_size = text_size;
+  memcpy(entry->data, cache->key.data, cache->key.size);
+  memcpy(entry->data + cache->key.size, text, text_size);
+  // link into bucket chain and LRU list
+  pdxcp_cdcl_cache_entry **bucket = cache->buckets +
+    (hash & (cache->n_buckets - 1));
+  entry->chain = *bucket;
+  *bucket = entry;
+  cache_lru_push(cache, entry);
+  cache->size++;
+  return true;
+}
+
+/**
+ * Check if a declaration declares or uses a typedef name.
+ *
+ * Only these declarations parse differently depending on the typedef name
+ * table, so they are never cached.
+ *
+ * @param decl Parsed declaration
+ */
+static bool
+cache_uses_typedefs(const pdxcp_cdcl_decl *decl)
+{
+  if (decl->is_typedef)
+    return true;
+  for (const pdxcp_cdcl_decl_node *node = decl->node; node; node = node->next) {
+    if (node->kind == pdxcp_cdcl_decl_kind_function) {
+      for (const pdxcp_cdcl_decl *p = node->params; p; p = p->next)
+        if (cache_uses_typedefs(p))
+          return true;
+    }
+    else if (
+      node->kind == pdxcp_cdcl_decl_kind_type &&
+      node->type == pdxcp_cdcl_token_type_t_name
+    )
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Write parser error info for an error that has no lexer or parser text.
+ *
+ * @param errinfo Error info structure
+ * @param status Parser status
+ */
+static void
+cache_write_status_err(
+  pdxcp_cdcl_parser_errinfo *errinfo, pdxcp_cdcl_parser_status status)
+{
+  errinfo->lexer.status = pdxcp_cdcl_lexer_status_ok;
+  errinfo->lexer.text[0] = '\0';
+  errinfo->parser.status = status;
+  errinfo->parser.error = pdxcp_cdcl_parser_error_none;
+  errinfo->parser.token = pdxcp_cdcl_token_type_error;
+  errinfo->parser.type = pdxcp_cdcl_token_type_error;
+  errinfo->parser.n_lparen = errinfo->parser.n_rparen = 0;
+  errinfo->parser.name[0] = '\0';
+  errinfo->offset = 0;
+  errinfo->span = 0;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_cache_parse(
+  pdxcp_cdcl_cache *cache,
+  pdxcp_cdcl_parser *parser,
+  const char *in,
+  size_t in_size,
+  pdxcp_bvector *out)
+{
+  // check input buffer and output
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  parser->n_decls = 0;
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_parser_status_ok;
+  size_t pos = 0;
+  while (pos < in_size) {
+    size_t end = pos + pdxcp_cdcl_next_decl_end(in + pos, in_size - pos);
+    // normalize declaration. no tokens means only trailing comments remain
+    uint64_t hash;
+    if (!cache_normalize(cache, in + pos, end - pos, &hash)) {
+      status = pdxcp_cdcl_parser_status_no_mem;
+      cache_write_status_err(&parser->errinfo, status);
+      break;
+    }
+    if (!cache->key.size)
+      break;
+    // hit, so just copy the rendered text
+    pdxcp_cdcl_cache_entry *entry = cache_find(cache, hash);
+    if (entry) {
+      cache->hits++;
+      const char *text = entry->data + entry->key_size;
+      if (!pdxcp_bvector_add_n(out, (unsigned char *) text, entry->text_size)) {
+        status = pdxcp_cdcl_parser_status_no_mem;
+        cache_write_status_err(&parser->errinfo, status);
+        break;
+      }
+      parser->n_decls++;
+      pos = end;
+      continue;
+    }
+    // miss, so parse the declaration directly from the buffer
+    cache->misses++;
+    pdxcp_cdcl_lexer_buf buf;
+    PDXCP_CDCL_LEXER_BUF_INIT(&buf, in + pos, in_size - pos);
+    pdxcp_arena_reset(&parser->arena);
+    pdxcp_cdcl_decl decl;
+    status = pdxcp_cdcl_parser_parse_decl_buf(parser, &buf, &decl);
+    // error offset is relative to the declaration, so make it absolute
+    if (!PDXCP_CDCL_PARSER_OK(status)) {
+      parser->errinfo.offset += pos;
+      break;
+    }
+    // render and insert the rendered text into the cache
+    size_t text_offset = out->size;
+    status = pdxcp_cdcl_decl_render_as(&decl, cache->format, out);
+    if (
+      PDXCP_CDCL_PARSER_OK(status) && !cache_uses_typedefs(&decl) &&
+      !cache_insert(
+        cache, hash, out->data + text_offset, out->size - text_offset
+      )
+    )
+      status = pdxcp_cdcl_parser_status_no_mem;
+    if (!PDXCP_CDCL_PARSER_OK(status)) {
+      cache_write_status_err(&parser->errinfo, status);
+      break;
+    }
+    parser->n_decls++;
+    pos = end;
+  }
+  return status;
+}
@@ -0,0 +1,321 @@
+/**
+ * @file cdcl_canon.c
+ * @author Derek Huang
+ * @brief C source for C declaration type canonicalization and hashing
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_canon.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_render.h"
+#include "pdxcp/strmap.h"
+
+/**
+ * Marker ending a function parameter list in the hashed encoding.
+ *
+ * Each parameter starts with `PDXCP_CDCL_TLV_DECL`, so zero is unambiguous.
+ */
+#define PDXCP_CDCL_CANON_PARAMS_END 0x00u
+
+/**
+ * cv-qualifier flags.
+ */
+#define PDXCP_CDCL_CANON_CV (PDXCP_CDCL_QUAL_CONST | PDXCP_CDCL_QUAL_VOLATILE)
+
+/**
+ * Canonical view of a declaration node.
+ *
+ * Views let the hash and comparison see the canonical type without modifying
+ * or copying the declaration.
+ *
+ * @param kind Canonical node kind
+ * @param quals Canonical qualifier flags
+ * @param node Underlying node, for the type, tag name, size, or parameters
+ * @param next Next node of the canonical type, `NULL` after the type node
+ */
+typedef struct {
+  pdxcp_cdcl_decl_kind kind;
+  unsigned int quals;
+  const pdxcp_cdcl_decl_node *node;
+  const pdxcp_cdcl_decl_node *next;
+} canon_view;
+
+/**
+ * Return the canonical qualifier flags of a declaration node.
+ *
+ * @param node Declaration node
+ */
+static unsigned int
+canon_quals(const pdxcp_cdcl_decl_node *node)
+{
+  // int and long are always signed
+  if (
+    node->kind == pdxcp_cdcl_decl_kind_type && (
+      node->type == pdxcp_cdcl_token_type_t_int ||
+      node->type == pdxcp_cdcl_token_type_t_long
+    )
+  )
+    return node->quals & ~PDXCP_CDCL_QUAL_SIGNED;
+  return node->quals;
+}
+
+/**
+ * Fill the canonical view of a declaration node.
+ *
+ * @param view View to fill
+ * @param node Declaration node
+ * @param param `true` if `node` is the outermost node of a parameter
+ */
+static void
+canon_view_init(
+  canon_view *view, const pdxcp_cdcl_decl_node *node, bool param)
+{
+  view->kind = node->kind;
+  view->quals = canon_quals(node);
+  view->node = node;
+  view->next = node->next;
+  if (!param)
+    return;
+  // adjust parameter type and drop top-level cv-qualifiers
+  switch (node->kind) {
+    case pdxcp_cdcl_decl_kind_array:
+      view->kind = pdxcp_cdcl_decl_kind_pointer;
+      view->quals = 0;
+      break;
+    // the function node itself follows the added pointer
+    case pdxcp_cdcl_decl_kind_function:
+      view->kind = pdxcp_cdcl_decl_kind_pointer;
+      view->quals = 0;
+      view->next = node;
+      break;
+    default:
+      view->quals &= ~PDXCP_CDCL_CANON_CV;
+      break;
+  }
+}
+
+bool
+pdxcp_cdcl_decl_canonicalize(pdxcp_cdcl_decl *decl, pdxcp_arena *arena)
+{
+  for (pdxcp_cdcl_decl_node *node = decl->node; node; node = node->next) {
+    node->quals = canon_quals(node);
+    if (node->kind != pdxcp_cdcl_decl_kind_function)
+      continue;
+    // canonicalize parameters, then adjust their outermost nodes
+    for (pdxcp_cdcl_decl *param = node->params; param; param = param->next) {
+      if (!pdxcp_cdcl_decl_canonicalize(param, arena))
+        return false;
+      pdxcp_cdcl_decl_node *head = param->node;
+      switch (head->kind) {
+        case pdxcp_cdcl_decl_kind_array:
+          head->kind = pdxcp_cdcl_decl_kind_pointer;
+          head->quals = 0;
+          head->size = 0;
+          break;
+        case pdxcp_cdcl_decl_kind_function: {
+          pdxcp_cdcl_decl_node *ptr = pdxcp_arena_alloc(arena, sizeof *ptr);
+          if (!ptr)
+            return false;
+          memset(ptr, 0, sizeof *ptr);
+          ptr->kind = pdxcp_cdcl_decl_kind_pointer;
+          ptr->next = head;
+          param->node = ptr;
+          break;
+        }
+        default:
+          head->quals &= ~PDXCP_CDCL_CANON_CV;
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Update a FNV-1a hash with a byte.
+ *
+ * @param hash Current hash
+ * @param byte Byte value
+ */
+static inline uint64_t
+canon_hash_byte(uint64_t hash, unsigned char byte)
+{
+  return pdxcp_strmap_hash_fnv1a_update(hash, (const char *) &byte, 1);
+}
+
+/**
+ * Return the `PDXCP_CDCL_TLV_BASE_*` code for a base type token type.
+ *
+ * @param type Base type token type
+ * @returns `PDXCP_CDCL_TLV_BASE_*` code, zero if not a base type
+ */
+static unsigned char
+canon_base(pdxcp_cdcl_token_type type)
+{
+  switch (type) {
+    case pdxcp_cdcl_token_type_struct:
+      return PDXCP_CDCL_TLV_BASE_STRUCT;
+    case pdxcp_cdcl_token_type_enum:
+      return PDXCP_CDCL_TLV_BASE_ENUM;
+    case pdxcp_cdcl_token_type_t_name:
+      return PDXCP_CDCL_TLV_BASE_TYPEDEF;
+    case pdxcp_cdcl_token_type_t_void:
+      return PDXCP_CDCL_TLV_BASE_VOID;
+    case pdxcp_cdcl_token_type_t_char:
+      return PDXCP_CDCL_TLV_BASE_CHAR;
+    case pdxcp_cdcl_token_type_t_int:
+      return PDXCP_CDCL_TLV_BASE_INT;
+    case pdxcp_cdcl_token_type_t_long:
+      return PDXCP_CDCL_TLV_BASE_LONG;
+    case pdxcp_cdcl_token_type_t_float:
+      return PDXCP_CDCL_TLV_BASE_FLOAT;
+    case pdxcp_cdcl_token_type_t_double:
+      return PDXCP_CDCL_TLV_BASE_DOUBLE;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Update a FNV-1a hash with the encoding of a declaration's canonical type.
+ *
+ * Each node is encoded as its `PDXCP_CDCL_TLV_*` tag followed by the node's
+ * qualifiers, big-endian 64-bit array size, parameters, or base type code
+ * and null-terminated tag name. Recursion only happens for parameter lists,
+ * whose depth is limited by the parser.
+ *
+ * @param hash Current hash
+ * @param decl Parsed declaration
+ * @param param `true` if `decl` is a parameter declaration
+ */
+static uint64_t
+canon_hash_decl(uint64_t hash, const pdxcp_cdcl_decl *decl, bool param)
+{
+  canon_view view;
+  for (
+    const pdxcp_cdcl_decl_node *node = decl->node;
+    node;
+    node = view.next, param = false
+  ) {
+    canon_view_init(&view, node, param);
+    switch (view.kind) {
+      case pdxcp_cdcl_decl_kind_pointer:
+        hash = canon_hash_byte(hash, PDXCP_CDCL_TLV_POINTER);
+        hash = canon_hash_byte(hash, (unsigned char) view.quals);
+        break;
+      case pdxcp_cdcl_decl_kind_array: {
+        hash = canon_hash_byte(hash, PDXCP_CDCL_TLV_ARRAY);
+        uint64_t size = view.node->size;
+        for (int shift = 56; shift >= 0; shift -= 8)
+          hash = canon_hash_byte(hash, (unsigned char) (size >> shift));
+        break;
+      }
+      case pdxcp_cdcl_decl_kind_function: {
+        hash = canon_hash_byte(hash, PDXCP_CDCL_TLV_FUNCTION);
+        const pdxcp_cdcl_decl *p;
+        for (p = view.node->params; p; p = p->next) {
+          hash = canon_hash_byte(hash, PDXCP_CDCL_TLV_DECL);
+          hash = canon_hash_decl(hash, p, true);
+        }
+        hash = canon_hash_byte(hash, PDXCP_CDCL_CANON_PARAMS_END);
+        break;
+      }
+      default: {
+        hash = canon_hash_byte(hash, PDXCP_CDCL_TLV_TYPE);
+        hash = canon_hash_byte(hash, (unsigned char) view.quals);
+        hash = canon_hash_byte(hash, canon_base(view.node->type));
+        const char *name = view.node->name;
+        if (
+          name && (
+            view.node->type == pdxcp_cdcl_token_type_struct ||
+            view.node->type == pdxcp_cdcl_token_type_enum ||
+            view.node->type == pdxcp_cdcl_token_type_t_name
+          )
+        ) {
+          hash = pdxcp_strmap_hash_fnv1a_update(hash, name, strlen(name));
+        }
+        hash = canon_hash_byte(hash, '\0');
+        break;
+      }
+    }
+  }
+  return hash;
+}
+
+uint64_t
+pdxcp_cdcl_decl_type_hash(const pdxcp_cdcl_decl *decl)
+{
+  return canon_hash_decl(PDXCP_STRMAP_FNV1A_OFFSET, decl, false);
+}
+
+/**
+ * Check if two declarations have the same canonical type.
+ *
+ * @param a First parsed declaration
+ * @param b Second parsed declaration
+ * @param param `true` if `a` and `b` are parameter declarations
+ */
+static bool
+canon_decl_equal(
+  const pdxcp_cdcl_decl *a, const pdxcp_cdcl_decl *b, bool param)
+{
+  canon_view va, vb;
+  const pdxcp_cdcl_decl_node *na = a->node;
+  const pdxcp_cdcl_decl_node *nb = b->node;
+  for (; na && nb; na = va.next, nb = vb.next, param = false) {
+    canon_view_init(&va, na, param);
+    canon_view_init(&vb, nb, param);
+    if (va.kind != vb.kind || va.quals != vb.quals)
+      return false;
+    switch (va.kind) {
+      case pdxcp_cdcl_decl_kind_pointer:
+        break;
+      case pdxcp_cdcl_decl_kind_array:
+        if (va.node->size != vb.node->size)
+          return false;
+        break;
+      case pdxcp_cdcl_decl_kind_function: {
+        const pdxcp_cdcl_decl *pa = va.node->params;
+        const pdxcp_cdcl_decl *pb = vb.node->params;
+        for (; pa && pb; pa = pa->next, pb = pb->next) {
+          if (!canon_decl_equal(pa, pb, true))
+            return false;
+        }
+        // parameter counts must match
+        if (pa || pb)
+          return false;
+        break;
+      }
+      default:
+        if (va.node->type != vb.node->type)
+          return false;
+        switch (va.node->type) {
+          case pdxcp_cdcl_token_type_struct:
+          case pdxcp_cdcl_token_type_enum:
+          case pdxcp_cdcl_token_type_t_name:
+            if (strcmp(va.node->name, vb.node->name))
+              return false;
+            break;
+          default:
+            break;
+        }
+        break;
+    }
+  }
+  // node chains must have the same length
+  return !na && !nb;
+}
+
+bool
+pdxcp_cdcl_decl_type_equal(const pdxcp_cdcl_decl *a, const pdxcp_cdcl_decl *b)
+{
+  return canon_decl_equal(a, b, false);
+}
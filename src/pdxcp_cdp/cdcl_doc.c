@@ -0,0 +1,491 @@
+/**
+ * @file cdcl_doc.c
+ * @author Derek Huang
+ * @brief C source for incrementally reparsed C declaration documents
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_doc.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+
+/**
+ * Minimum usable bytes per block of a declaration's arena.
+ *
+ * Each declaration has its own arena so that it can be reparsed without
+ * touching any other declaration, so blocks are kept small to keep documents
+ * with many declarations compact.
+ */
+#define PDXCP_CDCL_DOC_ARENA_BLOCK_SIZE 256
+
+/**
+ * Initial capacity of the token and declaration arrays.
+ */
+#define PDXCP_CDCL_DOC_INIT_CAPACITY 64
+
+void
+pdxcp_cdcl_doc_init(pdxcp_cdcl_doc *doc)
+{
+  pdxcp_bvector_init(&doc->text);
+  doc->tokens = NULL;
+  doc->n_tokens = 0;
+  doc->tokens_capacity = 0;
+  doc->decls = NULL;
+  doc->n_decls = 0;
+  doc->decls_capacity = 0;
+  doc->scratch = NULL;
+  doc->scratch_capacity = 0;
+  doc->n_lexed = 0;
+  doc->first_parsed = 0;
+  doc->n_parsed = 0;
+}
+
+void
+pdxcp_cdcl_doc_destroy(pdxcp_cdcl_doc *doc)
+{
+  for (size_t i = 0; i < doc->n_decls; i++)
+    pdxcp_arena_destroy(&doc->decls[i].arena);
+  free(doc->decls);
+  free(doc->scratch);
+  free(doc->tokens);
+  pdxcp_bvector_destroy(&doc->text);
+}
+
+/**
+ * Grow an array so that it can hold at least the given number of elements.
+ *
+ * The capacity is doubled until it is large enough.
+ *
+ * @param data Address of the array, updated on success
+ * @param capacity Address of the array capacity, updated on success
+ * @param n Number of elements needed
+ * @param elem_size Size of each element
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+doc_reserve(void **data, size_t *capacity, size_t n, size_t elem_size)
+{
+  if (n <= *capacity)
+    return true;
+  size_t new_capacity = (*capacity) ? *capacity : PDXCP_CDCL_DOC_INIT_CAPACITY;
+  while (new_capacity < n) {
+    if (new_capacity > SIZE_MAX / 2)
+      goto no_mem;
+    new_capacity *= 2;
+  }
+  if (new_capacity > SIZE_MAX / elem_size)
+    goto no_mem;
+  void *new_data = realloc(*data, new_capacity * elem_size);
+  if (!new_data)
+    goto no_mem;
+  *data = new_data;
+  *capacity = new_capacity;
+  return true;
+no_mem:
+  errno = ENOMEM;
+  return false;
+}
+
+/**
+ * Empty the document after an allocation failure left it inconsistent.
+ *
+ * @param doc Document
+ */
+static void
+doc_clear(pdxcp_cdcl_doc *doc)
+{
+  for (size_t i = 0; i < doc->n_decls; i++)
+    pdxcp_arena_destroy(&doc->decls[i].arena);
+  doc->n_decls = 0;
+  doc->n_tokens = 0;
+  doc->text.size = 0;
+  doc->n_parsed = 0;
+}
+
+/**
+ * Return the byte offset one past the end of a token.
+ *
+ * @param token Document token
+ */
+#define PDXCP_CDCL_DOC_TOKEN_END(token) ((token)->offset + (token)->size)
+
+/**
+ * Return the index of the first token that ends at or after an offset.
+ *
+ * A token ending exactly at the offset is included since the lexer looked at
+ * the character at the offset to decide where the token ends.
+ *
+ * @param doc Document
+ * @param offset Byte offset
+ * @returns Token index, `doc->n_tokens` if no token ends at or after `offset`
+ */
+static size_t
+doc_first_affected(const pdxcp_cdcl_doc *doc, size_t offset)
+{
+  size_t lo = 0;
+  size_t hi = doc->n_tokens;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (PDXCP_CDCL_DOC_TOKEN_END(doc->tokens + mid) < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/**
+ * Return the index of the declaration containing a token.
+ *
+ * @param doc Document
+ * @param t Token index, must belong to a declaration
+ */
+static size_t
+doc_decl_of(const pdxcp_cdcl_doc *doc, size_t t)
+{
+  size_t lo = 0;
+  size_t hi = doc->n_decls;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (doc->decls[mid].first <= t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo - 1;
+}
+
+/**
+ * Relex the edited text into the scratch tokens until the old tokens resume.
+ *
+ * Lexing starts at the end of the last token before `first`, where the lexer
+ * stopped before, and stops at the first token past the edit that starts
+ * where an old token started after being shifted by the edit. Since the text
+ * from there on is unchanged and the lexer has no state other than its
+ * position, all the old tokens from there on are still valid.
+ *
+ * @param doc Document, with its text already edited
+ * @param first Index of the first token that the edit could change
+ * @param offset Byte offset of the edit
+ * @param n_removed Number of bytes removed
+ * @param n_inserted Number of bytes inserted
+ * @param n_scratch Address to write the number of relexed tokens to
+ * @returns Index of the first old token that is still valid, `doc->n_tokens`
+ *  if none are, or `SIZE_MAX` on error (`errno` is ENOMEM)
+ */
+static size_t
+doc_relex(
+  pdxcp_cdcl_doc *doc,
+  size_t first,
+  size_t offset,
+  size_t n_removed,
+  size_t n_inserted,
+  size_t *n_scratch)
+{
+  *n_scratch = 0;
+  if (!doc->text.size)
+    return doc->n_tokens;
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(
+    &buf, (const char *) doc->text.data, doc->text.size
+  );
+  if (first)
+    buf.pos += PDXCP_CDCL_DOC_TOKEN_END(doc->tokens + first - 1);
+  size_t old = first;
+  pdxcp_cdcl_token token;
+  while (true) {
+    pdxcp_cdcl_lexer_status status = pdxcp_cdcl_get_token_buf(&buf, &token);
+    // only whitespace or comments left. an incomplete token is still a token
+    if (buf.token == buf.end)
+      return doc->n_tokens;
+    doc->n_lexed++;
+    size_t start = (size_t) (buf.token - buf.start);
+    // past the edit, compare against the old token starts shifted by the edit
+    if (start >= offset + n_inserted) {
+      while (
+        old < doc->n_tokens &&
+        doc->tokens[old].offset + n_inserted < start + n_removed
+      )
+        old++;
+      if (
+        old < doc->n_tokens &&
+        doc->tokens[old].offset + n_inserted == start + n_removed
+      )
+        return old;
+    }
+    void *scratch = doc->scratch;
+    if (
+      !doc_reserve(
+        &scratch, &doc->scratch_capacity, *n_scratch + 1, sizeof *doc->scratch
+      )
+    )
+      return SIZE_MAX;
+    doc->scratch = scratch;
+    pdxcp_cdcl_doc_token *out = doc->scratch + (*n_scratch)++;
+    out->offset = start;
+    out->size = (size_t) (buf.pos - buf.token);
+    out->type = (PDXCP_CDCL_LEXER_OK(status)) ?
+      token.type : pdxcp_cdcl_token_type_error;
+  }
+}
+
+/**
+ * Parse a declaration from its tokens' text.
+ *
+ * @param doc Document
+ * @param decl Declaration with its tokens set
+ */
+static void
+doc_parse(const pdxcp_cdcl_doc *doc, pdxcp_cdcl_doc_decl *decl)
+{
+  pdxcp_arena_reset(&decl->arena);
+  const pdxcp_cdcl_doc_token *first = doc->tokens + decl->first;
+  const pdxcp_cdcl_doc_token *last = first + decl->n_tokens - 1;
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(
+    &buf,
+    (const char *) doc->text.data + first->offset,
+    PDXCP_CDCL_DOC_TOKEN_END(last) - first->offset
+  );
+  pdxcp_cdcl_parser_errinfo errinfo;
+  decl->errinfo = NULL;
+  decl->status = pdxcp_cdcl_parse_decl_buf(
+    &buf, &decl->arena, &decl->decl, &errinfo
+  );
+  if (PDXCP_CDCL_PARSER_OK(decl->status))
+    return;
+  decl->decl.iden = NULL;
+  decl->decl.node = NULL;
+  decl->decl.next = NULL;
+  decl->decl.is_typedef = false;
+  if ((decl->errinfo = pdxcp_arena_alloc(&decl->arena, sizeof errinfo)))
+    memcpy(decl->errinfo, &errinfo, sizeof errinfo);
+}
+
+/**
+ * Split the tokens around an edit into declarations and parse them.
+ *
+ * Splitting starts at the first token of the old declaration containing the
+ * first relexed token and stops at the first declaration end past the relexed
+ * tokens that was also an old declaration end. The old declarations in
+ * between are replaced and the rest are reused.
+ *
+ * @param doc Document, with its tokens already updated
+ * @param decl_first Index of the first old declaration to replace
+ * @param token_first Index of the first token of that declaration
+ * @param changed_end Index one past the last relexed token
+ * @param old_end Index of the old token that now has index `changed_end`
+ * @param aligned_end `true` if the old token at `old_end` started an old
+ *  declaration or there were no old tokens from `old_end` on
+ * @param old_end_decl Index of the old declaration starting with the old token
+ *  at `old_end`, `doc->n_decls` if there is none. Only used if `aligned_end`
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+doc_split(
+  pdxcp_cdcl_doc *doc,
+  size_t decl_first,
+  size_t token_first,
+  size_t changed_end,
+  size_t old_end,
+  bool aligned_end,
+  size_t old_end_decl)
+{
+  // count new declarations until a declaration end lines up with an old one
+  size_t end = token_first;
+  size_t n_new = 0;
+  bool aligned = false;
+  for (size_t t = token_first; t < doc->n_tokens && !aligned; t++) {
+    if (doc->tokens[t].type != pdxcp_cdcl_token_type_semicolon)
+      continue;
+    n_new++;
+    end = t + 1;
+    aligned = (end > changed_end || (end == changed_end && aligned_end));
+  }
+  // tokens after the last ';' form an unterminated declaration
+  if (!aligned && end < doc->n_tokens)
+    n_new++;
+  // old declarations [decl_first, decl_end) are replaced
+  size_t decl_end;
+  if (!aligned)
+    decl_end = doc->n_decls;
+  else if (end > changed_end)
+    decl_end = doc_decl_of(doc, end - 1 - changed_end + old_end) + 1;
+  else
+    decl_end = old_end_decl;
+  size_t n_replaced = decl_end - decl_first;
+  size_t n_decls = doc->n_decls - n_replaced + n_new;
+  void *decls = doc->decls;
+  if (
+    !doc_reserve(&decls, &doc->decls_capacity, n_decls, sizeof *doc->decls)
+  )
+    return false;
+  doc->decls = decls;
+  // drop surplus arenas, move the reused declarations, and add new arenas
+  for (size_t i = decl_first + n_new; i < decl_end; i++)
+    pdxcp_arena_destroy(&doc->decls[i].arena);
+  memmove(
+    doc->decls + decl_first + n_new,
+    doc->decls + decl_end,
+    (doc->n_decls - decl_end) * sizeof *doc->decls
+  );
+  for (size_t i = decl_first + n_replaced; i < decl_first + n_new; i++)
+    pdxcp_arena_init(&doc->decls[i].arena, PDXCP_CDCL_DOC_ARENA_BLOCK_SIZE);
+  // reused declarations' tokens moved by the difference in token counts
+  for (size_t i = decl_first + n_new; i < n_decls; i++)
+    doc->decls[i].first = doc->decls[i].first + changed_end - old_end;
+  doc->n_decls = n_decls;
+  // assign tokens to the new declarations and parse them
+  size_t t = token_first;
+  for (size_t i = decl_first; i < decl_first + n_new; i++) {
+    pdxcp_cdcl_doc_decl *decl = doc->decls + i;
+    decl->first = t;
+    while (
+      t < doc->n_tokens &&
+      doc->tokens[t++].type != pdxcp_cdcl_token_type_semicolon
+    )
+      ;
+    decl->n_tokens = t - decl->first;
+    doc_parse(doc, decl);
+  }
+  doc->first_parsed = decl_first;
+  doc->n_parsed = n_new;
+  return true;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_doc_edit(
+  pdxcp_cdcl_doc *doc,
+  size_t offset,
+  size_t n_removed,
+  const char *inserted,
+  size_t n_inserted)
+{
+  size_t old_size = doc->text.size;
+  if (offset > old_size || n_removed > old_size - offset)
+    return pdxcp_cdcl_parser_status_bad_edit;
+  doc->n_lexed = 0;
+  doc->n_parsed = 0;
+  // grow the text first so that failing here leaves the document unchanged
+  size_t new_size = old_size - n_removed;
+  if (n_inserted > SIZE_MAX - new_size)
+    return pdxcp_cdcl_parser_status_no_mem;
+  new_size += n_inserted;
+  while (doc->text.capacity < new_size)
+    if (!pdxcp_bvector_expand(&doc->text))
+      return pdxcp_cdcl_parser_status_no_mem;
+  if (doc->text.data) {
+    memmove(
+      doc->text.data + offset + n_inserted,
+      doc->text.data + offset + n_removed,
+      old_size - offset - n_removed
+    );
+    if (n_inserted)
+      memcpy(doc->text.data + offset, inserted, n_inserted);
+  }
+  doc->text.size = new_size;
+  // relex from the first token the edit could change
+  size_t first = doc_first_affected(doc, offset);
+  size_t n_scratch;
+  size_t old_end = doc_relex(
+    doc, first, offset, n_removed, n_inserted, &n_scratch
+  );
+  if (old_end == SIZE_MAX)
+    goto no_mem;
+  // find what to split before the old tokens are overwritten. appended tokens
+  // extend an unterminated final declaration
+  size_t n_tokens = doc->n_tokens;
+  bool aligned_end = (
+    !old_end || doc->tokens[old_end - 1].type == pdxcp_cdcl_token_type_semicolon
+  );
+  size_t decl_first;
+  if (first < n_tokens)
+    decl_first = doc_decl_of(doc, first);
+  else if (
+    doc->n_decls &&
+    doc->tokens[n_tokens - 1].type != pdxcp_cdcl_token_type_semicolon
+  )
+    decl_first = doc->n_decls - 1;
+  else
+    decl_first = doc->n_decls;
+  size_t token_first = (decl_first < doc->n_decls) ?
+    doc->decls[decl_first].first : first;
+  size_t old_end_decl = (old_end < n_tokens) ?
+    doc_decl_of(doc, old_end) : doc->n_decls;
+  // splice the relexed tokens in and shift the offsets of the reused ones
+  size_t changed_end = first + n_scratch;
+  size_t new_n_tokens = n_tokens - (old_end - first) + n_scratch;
+  void *tokens = doc->tokens;
+  if (
+    !doc_reserve(
+      &tokens, &doc->tokens_capacity, new_n_tokens, sizeof *doc->tokens
+    )
+  )
+    goto no_mem;
+  doc->tokens = tokens;
+  memmove(
+    doc->tokens + changed_end,
+    doc->tokens + old_end,
+    (n_tokens - old_end) * sizeof *doc->tokens
+  );
+  for (size_t t = changed_end; t < new_n_tokens; t++)
+    doc->tokens[t].offset = doc->tokens[t].offset + n_inserted - n_removed;
+  if (n_scratch)
+    memcpy(doc->tokens + first, doc->scratch, n_scratch * sizeof *doc->scratch);
+  doc->n_tokens = new_n_tokens;
+  // edits of only whitespace and comments between declarations change nothing
+  if (!n_scratch && old_end == first && aligned_end)
+    return pdxcp_cdcl_parser_status_ok;
+  if (
+    !doc_split(
+      doc,
+      decl_first,
+      token_first,
+      changed_end,
+      old_end,
+      aligned_end,
+      old_end_decl
+    )
+  )
+    goto no_mem;
+  return pdxcp_cdcl_parser_status_ok;
+no_mem:
+  doc_clear(doc);
+  return pdxcp_cdcl_parser_status_no_mem;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_doc_set(pdxcp_cdcl_doc *doc, const char *text, size_t size)
+{
+  return pdxcp_cdcl_doc_edit(doc, 0, doc->text.size, text, size);
+}
+
+size_t
+pdxcp_cdcl_doc_find(const pdxcp_cdcl_doc *doc, size_t offset)
+{
+  size_t lo = 0;
+  size_t hi = doc->n_decls;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (doc->tokens[doc->decls[mid].first].offset <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (!lo)
+    return doc->n_decls;
+  const pdxcp_cdcl_doc_decl *decl = doc->decls + lo - 1;
+  const pdxcp_cdcl_doc_token *last = doc->tokens + decl->first +
+    decl->n_tokens - 1;
+  return (offset <= PDXCP_CDCL_DOC_TOKEN_END(last)) ? lo - 1 : doc->n_decls;
+}
@@ -0,0 +1,988 @@
+/**
+ * @file cdcl_index.c
+ * @author Derek Huang
+ * @brief C source for the parallel C declaration source tree indexer
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_index.h"
+
+#include <fcntl.h>
+#include <fts.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+
+void
+pdxcp_cdcl_index_paths_init(pdxcp_cdcl_index_paths *paths)
+{
+  pdxcp_arena_init(&paths->arena, 0);
+  paths->paths = NULL;
+  paths->n_paths = 0;
+  paths->capacity = 0;
+}
+
+void
+pdxcp_cdcl_index_paths_destroy(pdxcp_cdcl_index_paths *paths)
+{
+  free(paths->paths);
+  pdxcp_arena_destroy(&paths->arena);
+}
+
+bool
+pdxcp_cdcl_index_paths_add(pdxcp_cdcl_index_paths *paths, const char *path)
+{
+  if (paths->n_paths == paths->capacity) {
+    size_t capacity = (paths->capacity) ? 2 * paths->capacity : 64;
+    const char **new_paths = realloc(
+      paths->paths, capacity * sizeof *new_paths
+    );
+    if (!new_paths) {
+      errno = ENOMEM;
+      return false;
+    }
+    paths->paths = new_paths;
+    paths->capacity = capacity;
+  }
+  const char *copy = pdxcp_arena_strdup(&paths->arena, path);
+  if (!copy) {
+    errno = ENOMEM;
+    return false;
+  }
+  paths->paths[paths->n_paths++] = copy;
+  return true;
+}
+
+/**
+ * Compare `fts` entries by name so trees are walked in a stable order.
+ *
+ * @param a First entry
+ * @param b Second entry
+ */
+static int
+index_fts_compare(const FTSENT **a, const FTSENT **b)
+{
+  return strcmp((*a)->fts_name, (*b)->fts_name);
+}
+
+/**
+ * Check if a file name has a `.c` or `.h` extension.
+ *
+ * @param name File name
+ * @param len Length of the file name
+ */
+static bool
+index_is_source(const char *name, size_t len)
+{
+  return len > 2 && name[len - 2] == '.' &&
+    (name[len - 1] == 'c' || name[len - 1] == 'h');
+}
+
+bool
+pdxcp_cdcl_index_paths_add_tree(
+  pdxcp_cdcl_index_paths *paths, const char *root)
+{
+  // fts_open takes a non-const argv but does not modify the strings
+  char *argv[] = {(char *) root, NULL};
+  FTS *fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR, index_fts_compare);
+  if (!fts)
+    return false;
+  bool ok = true;
+  FTSENT *ent;
+  while (ok && (ent = fts_read(fts))) {
+    switch (ent->fts_info) {
+      case FTS_F:
+        if (
+          ent->fts_level == FTS_ROOTLEVEL ||
+          index_is_source(ent->fts_name, ent->fts_namelen)
+        )
+          ok = pdxcp_cdcl_index_paths_add(paths, ent->fts_path);
+        break;
+      // unreadable directories and files that cannot be stat'ed are only
+      // errors for the root, so one bad subdirectory does not stop the walk
+      case FTS_DNR:
+      case FTS_NS:
+        if (ent->fts_level != FTS_ROOTLEVEL)
+          break;
+        // fall through
+      case FTS_ERR:
+        errno = ent->fts_errno;
+        ok = false;
+        break;
+      default:
+        break;
+    }
+  }
+  // fts_read sets errno to zero at the end of the walk
+  if (ok && errno)
+    ok = false;
+  int err = errno;
+  fts_close(fts);
+  errno = err;
+  return ok;
+}
+
+/**
+ * Check if a byte is C whitespace.
+ *
+ * @param c Byte
+ */
+static inline bool
+index_is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+    c == '\v';
+}
+
+/**
+ * Append a single space to declaration text unless it is empty or already
+ * ends with a space.
+ *
+ * @param text Declaration text
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+index_add_space(pdxcp_bvector *text)
+{
+  if (!text->size || text->data[text->size - 1] == ' ')
+    return true;
+  return pdxcp_bvector_add(text, ' ');
+}
+
+/**
+ * Storage-class and function specifiers removed from declaration text.
+ */
+static const char *const index_specifiers[] = {"extern ", "static ", "inline "};
+
+/**
+ * Number of specifiers in `index_specifiers`.
+ */
+#define INDEX_N_SPECIFIERS (sizeof index_specifiers / sizeof *index_specifiers)
+
+/**
+ * Finish declaration text by removing leading specifiers and trailing spaces
+ * and appending the terminating `;` and null terminator.
+ *
+ * @param text Declaration text
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+index_finish_text(pdxcp_bvector *text)
+{
+  // remove leading specifiers in any order
+  bool removed = true;
+  while (removed) {
+    removed = false;
+    for (size_t i = 0; i < INDEX_N_SPECIFIERS; i++) {
+      size_t len = strlen(index_specifiers[i]);
+      if (
+        text->size >= len &&
+        !memcmp(text->data, index_specifiers[i], len)
+      ) {
+        memmove(text->data, text->data + len, text->size - len);
+        text->size -= len;
+        removed = true;
+      }
+    }
+  }
+  while (text->size && text->data[text->size - 1] == ' ')
+    text->size--;
+  if (!pdxcp_bvector_add(text, ';') || !pdxcp_bvector_add(text, '\0'))
+    return false;
+  // null terminator is not part of the text
+  text->size--;
+  return true;
+}
+
+/**
+ * Check if declaration text is only `extern`, i.e. the start of `extern "C"`.
+ *
+ * @param text Declaration text
+ */
+static bool
+index_is_extern(const pdxcp_bvector *text)
+{
+  return (text->size == 6 || (text->size == 7 && text->data[6] == ' ')) &&
+    !memcmp(text->data, "extern", 6);
+}
+
+/**
+ * Return the offset one past the end of a string or character literal.
+ *
+ * @param in Input buffer
+ * @param in_size Number of bytes in the input buffer
+ * @param pos Offset of the opening quote
+ */
+static size_t
+index_skip_literal(const char *in, size_t in_size, size_t pos)
+{
+  char quote = in[pos++];
+  while (pos < in_size) {
+    if (in[pos] == '\\')
+      pos += 2;
+    else if (in[pos++] == quote || in[pos - 1] == '\n')
+      return pos;
+  }
+  return in_size;
+}
+
+bool
+pdxcp_cdcl_index_next_decl(
+  const char *in,
+  size_t in_size,
+  size_t *pos,
+  size_t *start,
+  pdxcp_bvector *text)
+{
+  size_t i = *pos;
+  // true when only whitespace precedes the current char on its line
+  bool line_start = (!i || in[i - 1] == '\n');
+  // state of the current declaration. skipped declarations are still scanned
+  // so their end is found, while copying stops at an initializer
+  bool in_decl = false;
+  bool skip = false;
+  bool init = false;
+  bool extern_c = false;
+  bool body = false;
+  unsigned int braces = 0;
+  unsigned int parens = 0;
+  // last char before a top-level '{', to tell function definitions apart
+  char last = '\0';
+  text->size = 0;
+  while (i < in_size) {
+    char c = in[i];
+    // whitespace, which is collapsed into a single space
+    if (index_is_space(c)) {
+      if (c == '\n')
+        line_start = true;
+      i++;
+      if (in_decl && !braces && !init && !index_add_space(text))
+        return false;
+      continue;
+    }
+    // preprocessor directive. skip to the first newline not escaped by '\'
+    if (c == '#' && line_start) {
+      while (i < in_size && (in[i] != '\n' || in[i - 1] == '\\'))
+        i++;
+      continue;
+    }
+    line_start = false;
+    // comments, which are treated as whitespace
+    if (c == '/' && i + 1 < in_size && (in[i + 1] == '*' || in[i + 1] == '/')) {
+      if (in[i + 1] == '*') {
+        i += 2;
+        while (i + 1 < in_size && !(in[i] == '*' && in[i + 1] == '/'))
+          i++;
+        i = (i + 1 < in_size) ? i + 2 : in_size;
+      }
+      else {
+        while (i < in_size && in[i] != '\n')
+          i++;
+      }
+      if (in_decl && !braces && !init && !index_add_space(text))
+        return false;
+      continue;
+    }
+    // start a new declaration at the first significant char
+    if (!in_decl) {
+      in_decl = true;
+      skip = init = extern_c = body = false;
+      parens = 0;
+      last = '\0';
+      text->size = 0;
+      *start = i;
+    }
+    // literals are never part of supported declarations but may be part of
+    // initializers and blocks, which are dropped. the linkage literal of
+    // extern "C" is dropped too, leaving an extern that is removed later
+    if (c == '"' || c == '\'') {
+      if (!braces && !init && index_is_extern(text))
+        extern_c = true;
+      else if (!braces && !init)
+        skip = true;
+      i = index_skip_literal(in, in_size, i);
+      continue;
+    }
+    switch (c) {
+      case '{':
+        // extern "C" blocks are transparent
+        if (!braces && extern_c && index_is_extern(text)) {
+          in_decl = false;
+          i++;
+          continue;
+        }
+        // function bodies and braced initializers are dropped, while other
+        // blocks are skipped
+        if (!braces && !init && last == ')')
+          body = true;
+        else if (!init && !body)
+          skip = true;
+        braces++;
+        break;
+      case '}':
+        // closing an extern "C" block or an unmatched '}'
+        if (!braces) {
+          in_decl = false;
+          i++;
+          continue;
+        }
+        // function definitions end at their closing '}' and are indexed as
+        // the declaration preceding their body
+        if (!--braces && body) {
+          i++;
+          in_decl = false;
+          if (skip)
+            continue;
+          if (!index_finish_text(text))
+            return false;
+          *pos = i;
+          return true;
+        }
+        break;
+      case ';':
+        if (braces)
+          break;
+        i++;
+        in_decl = false;
+        if (skip)
+          continue;
+        if (!index_finish_text(text))
+          return false;
+        *pos = i;
+        return true;
+      case '(':
+        parens++;
+        break;
+      case ')':
+        if (parens)
+          parens--;
+        break;
+      // initializer, whose text is dropped
+      case '=':
+        if (!braces && !parens)
+          init = true;
+        break;
+      // several declarators
+      case ',':
+        if (!braces && !parens)
+          skip = true;
+        break;
+      default:
+        break;
+    }
+    // copy top-level declaration text
+    if (!braces && c != '}') {
+      last = c;
+      if (!init && !skip && !pdxcp_bvector_add(text, (unsigned char) c))
+        return false;
+    }
+    i++;
+  }
+  *pos = in_size;
+  return false;
+}
+
+/**
+ * Index record built by a worker thread.
+ *
+ * @param name Identifier, owned by the worker
+ * @param decl Declaration text, owned by the worker
+ * @param file File number
+ * @param pos Byte offset of the declaration in the file
+ */
+typedef struct {
+  const char *name;
+  const char *decl;
+  size_t file;
+  uint64_t pos;
+} index_record;
+
+struct index_work;
+
+/**
+ * Indexing worker state.
+ *
+ * The worker's range of unclaimed file numbers is guarded by `mut` since other
+ * workers steal from its end. Everything else is only used by the worker.
+ *
+ * @param work Shared indexing work
+ * @param id Worker number
+ * @param mut Mutex guarding `begin` and `end`
+ * @param begin First unclaimed file number
+ * @param end One past the last unclaimed file number
+ * @param strings Arena record text is allocated from
+ * @param records Records in the order they were found
+ * @param n_records Number of records
+ * @param capacity Capacity of `records`
+ * @param stats Indexing statistics for the worker's files
+ * @param status Worker status, only changed on allocation failure
+ */
+typedef struct {
+  struct index_work *work;
+  unsigned int id;
+  pthread_mutex_t mut;
+  size_t begin;
+  size_t end;
+  pdxcp_arena strings;
+  index_record *records;
+  size_t n_records;
+  size_t capacity;
+  pdxcp_cdcl_index_stats stats;
+  pdxcp_cdcl_parser_status status;
+} index_worker;
+
+/**
+ * Work shared by all the indexing threads.
+ *
+ * @param paths Source file paths
+ * @param workers Worker states
+ * @param n_workers Number of workers
+ */
+typedef struct index_work {
+  const pdxcp_cdcl_index_paths *paths;
+  index_worker *workers;
+  unsigned int n_workers;
+} index_work;
+
+/**
+ * Claim the next file to index, stealing from another worker if necessary.
+ *
+ * Workers claim files from the start of their own range. An idle worker takes
+ * the upper half of the first nonempty range it finds, so a single large
+ * range is split recursively among idle workers. At most one mutex is held at
+ * any time, so claiming cannot deadlock.
+ *
+ * @param worker Claiming worker
+ * @param file Address to write the claimed file number to
+ * @returns `true` if a file was claimed, `false` if all files are claimed
+ */
+static bool
+index_claim(index_worker *worker, size_t *file)
+{
+  pthread_mutex_lock(&worker->mut);
+  if (worker->begin < worker->end) {
+    *file = worker->begin++;
+    pthread_mutex_unlock(&worker->mut);
+    return true;
+  }
+  pthread_mutex_unlock(&worker->mut);
+  // steal half of the first nonempty range
+  index_work *work = worker->work;
+  for (unsigned int k = 1; k < work->n_workers; k++) {
+    index_worker *victim = work->workers + (worker->id + k) % work->n_workers;
+    pthread_mutex_lock(&victim->mut);
+    size_t n_left = victim->end - victim->begin;
+    if (!n_left) {
+      pthread_mutex_unlock(&victim->mut);
+      continue;
+    }
+    size_t end = victim->end;
+    size_t mid = end - (n_left + 1) / 2;
+    victim->end = mid;
+    pthread_mutex_unlock(&victim->mut);
+    // keep the first stolen file and make the rest our range
+    pthread_mutex_lock(&worker->mut);
+    worker->begin = mid + 1;
+    worker->end = end;
+    pthread_mutex_unlock(&worker->mut);
+    *file = mid;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Add a record to a worker's records.
+ *
+ * @param worker Worker
+ * @param name Identifier
+ * @param text Declaration text
+ * @param file File number
+ * @param pos Byte offset of the declaration in the file
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+index_add_record(
+  index_worker *worker,
+  const char *name,
+  const char *text,
+  size_t file,
+  size_t pos)
+{
+  if (worker->n_records == worker->capacity) {
+    size_t capacity = (worker->capacity) ? 2 * worker->capacity : 256;
+    index_record *records = realloc(
+      worker->records, capacity * sizeof *records
+    );
+    if (!records)
+      return false;
+    worker->records = records;
+    worker->capacity = capacity;
+  }
+  index_record *record = worker->records + worker->n_records;
+  if (
+    !(record->name = pdxcp_arena_strdup(&worker->strings, name)) ||
+    !(record->decl = pdxcp_arena_strdup(&worker->strings, text))
+  )
+    return false;
+  record->file = file;
+  record->pos = pos;
+  worker->n_records++;
+  return true;
+}
+
+/**
+ * Index a single file.
+ *
+ * The file is memory-mapped so its bytes are lexed without copying. Typedef
+ * names declared in the file are types in the rest of the file, so the
+ * entries of a file do not depend on which other files a worker indexed.
+ *
+ * @param worker Worker
+ * @param file File number
+ * @param parser Parser state reused for parsing each declaration
+ * @param text Byte vector reused for declaration text
+ * @returns `true` on success, `false` on allocation failure
+ */
+static bool
+index_file(
+  index_worker *worker,
+  size_t file,
+  pdxcp_cdcl_parser *parser,
+  pdxcp_bvector *text)
+{
+  int fd = open(worker->work->paths->paths[file], O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    if (fd >= 0)
+      close(fd);
+    worker->stats.n_failed++;
+    return true;
+  }
+  worker->stats.n_files++;
+  // empty files cannot be mapped but also have nothing to index
+  size_t in_size = (size_t) st.st_size;
+  if (!in_size) {
+    close(fd);
+    return true;
+  }
+  const char *in = mmap(NULL, in_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (in == MAP_FAILED) {
+    worker->stats.n_files--;
+    worker->stats.n_failed++;
+    return true;
+  }
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  parser->typedefs = &typedefs;
+  bool ok = true;
+  size_t pos = 0;
+  size_t start;
+  while (pdxcp_cdcl_index_next_decl(in, in_size, &pos, &start, text)) {
+    pdxcp_cdcl_lexer_buf buf;
+    PDXCP_CDCL_LEXER_BUF_INIT(&buf, (const char *) text->data, text->size);
+    pdxcp_cdcl_decl decl;
+    pdxcp_cdcl_parser_status status = pdxcp_cdcl_parser_parse_decl_buf(
+      parser, &buf, &decl
+    );
+    if (PDXCP_CDCL_PARSER_OK(status) && decl.iden) {
+      if (!(ok = index_add_record(
+        worker, decl.iden, (const char *) text->data, file, start
+      )))
+        break;
+      worker->stats.n_entries++;
+    }
+    else if (status == pdxcp_cdcl_parser_status_no_mem) {
+      ok = false;
+      break;
+    }
+    else
+      worker->stats.n_skipped++;
+    pdxcp_arena_reset(&parser->arena);
+  }
+  // next_decl also returns false on allocation failure
+  if (ok && pos < in_size)
+    ok = false;
+  parser->typedefs = NULL;
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+  munmap((void *) in, in_size);
+  return ok;
+}
+
+/**
+ * Indexing thread routine.
+ *
+ * @param arg Address of the `index_worker`
+ * @returns `NULL`
+ */
+static void *
+index_worker_main(void *arg)
+{
+  index_worker *worker = arg;
+  // per-thread scratch state reused for all files this thread indexes
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  pdxcp_bvector text;
+  pdxcp_bvector_init(&text);
+  size_t file;
+  while (index_claim(worker, &file)) {
+    if (!index_file(worker, file, &parser, &text)) {
+      worker->status = pdxcp_cdcl_parser_status_no_mem;
+      break;
+    }
+  }
+  pdxcp_bvector_destroy(&text);
+  pdxcp_cdcl_parser_destroy(&parser);
+  return NULL;
+}
+
+/**
+ * Compare index records by identifier, then file number, then offset.
+ *
+ * @param a Address of the first record
+ * @param b Address of the second record
+ */
+static int
+index_record_compare(const void *a, const void *b)
+{
+  const index_record *ra = a;
+  const index_record *rb = b;
+  int cmp = strcmp(ra->name, rb->name);
+  if (cmp)
+    return cmp;
+  if (ra->file != rb->file)
+    return (ra->file < rb->file) ? -1 : 1;
+  if (ra->pos != rb->pos)
+    return (ra->pos < rb->pos) ? -1 : 1;
+  return 0;
+}
+
+/**
+ * Write a little-endian 64-bit value to a byte buffer.
+ *
+ * @param buf Buffer of at least 8 bytes
+ * @param value Value to write
+ */
+static void
+index_store_u64(unsigned char *buf, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+    buf[i] = (unsigned char) (value >> (8 * i));
+}
+
+/**
+ * Read a little-endian 64-bit value from a byte buffer.
+ *
+ * @param buf Buffer of at least 8 bytes
+ */
+static uint64_t
+index_load_u64(const unsigned char *buf)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++)
+    value |= (uint64_t) buf[i] << (8 * i);
+  return value;
+}
+
+/**
+ * Write sorted records as an index file.
+ *
+ * Adjacent records with the same identifier share its string.
+ *
+ * @param paths Source file paths
+ * @param records Sorted records
+ * @param n_records Number of records
+ * @param out Output stream
+ * @returns `true` on success, `false` on write error
+ */
+static bool
+index_write(
+  const pdxcp_cdcl_index_paths *paths,
+  const index_record *records,
+  size_t n_records,
+  FILE *out)
+{
+  unsigned char buf[PDXCP_CDCL_INDEX_ENTRY_SIZE];
+  // header
+  memcpy(buf, PDXCP_CDCL_INDEX_MAGIC, 8);
+  buf[8] = PDXCP_CDCL_INDEX_VERSION;
+  memset(buf + 9, 0, 7);
+  index_store_u64(buf + 16, paths->n_paths);
+  index_store_u64(buf + 24, n_records);
+  if (
+    fwrite(buf, 1, PDXCP_CDCL_INDEX_HEADER_SIZE, out) !=
+    PDXCP_CDCL_INDEX_HEADER_SIZE
+  )
+    return false;
+  // file path offsets. paths come first in the string pool
+  uint64_t offset = 0;
+  for (size_t i = 0; i < paths->n_paths; i++) {
+    index_store_u64(buf, offset);
+    if (fwrite(buf, 1, 8, out) != 8)
+      return false;
+    offset += strlen(paths->paths[i]) + 1;
+  }
+  // entries, followed in the pool by each new identifier and declaration
+  uint64_t name_offset = 0;
+  for (size_t i = 0; i < n_records; i++) {
+    if (!i || strcmp(records[i].name, records[i - 1].name)) {
+      name_offset = offset;
+      offset += strlen(records[i].name) + 1;
+    }
+    index_store_u64(buf, name_offset);
+    index_store_u64(buf + 8, offset);
+    index_store_u64(buf + 16, records[i].file);
+    index_store_u64(buf + 24, records[i].pos);
+    if (fwrite(buf, 1, sizeof buf, out) != sizeof buf)
+      return false;
+    offset += strlen(records[i].decl) + 1;
+  }
+  // string pool, in the same order as the offsets were assigned
+  for (size_t i = 0; i < paths->n_paths; i++) {
+    if (fputs(paths->paths[i], out) == EOF || fputc('\0', out) == EOF)
+      return false;
+  }
+  for (size_t i = 0; i < n_records; i++) {
+    if (!i || strcmp(records[i].name, records[i - 1].name)) {
+      if (fputs(records[i].name, out) == EOF || fputc('\0', out) == EOF)
+        return false;
+    }
+    if (fputs(records[i].decl, out) == EOF || fputc('\0', out) == EOF)
+      return false;
+  }
+  return !fflush(out);
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_index_build(
+  const pdxcp_cdcl_index_paths *paths,
+  FILE *out,
+  unsigned int n_threads,
+  pdxcp_cdcl_index_stats *stats)
+{
+  if (!paths)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  // use all online processors if thread count is unspecified
+  if (!n_threads) {
+    long n_procs = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads = (n_procs > 0) ? (unsigned int) n_procs : 1;
+  }
+  // no point in having more threads than files
+  if (n_threads > paths->n_paths)
+    n_threads = (paths->n_paths) ? (unsigned int) paths->n_paths : 1;
+  index_work work;
+  work.paths = paths;
+  work.n_workers = n_threads;
+  if (!(work.workers = malloc(n_threads * sizeof *work.workers)))
+    return pdxcp_cdcl_parser_status_no_mem;
+  // split files into equal contiguous ranges
+  for (unsigned int i = 0; i < n_threads; i++) {
+    index_worker *worker = work.workers + i;
+    worker->work = &work;
+    worker->id = i;
+    pthread_mutex_init(&worker->mut, NULL);
+    worker->begin = paths->n_paths * i / n_threads;
+    worker->end = paths->n_paths * (i + 1) / n_threads;
+    pdxcp_arena_init(&worker->strings, 0);
+    worker->records = NULL;
+    worker->n_records = worker->capacity = 0;
+    memset(&worker->stats, 0, sizeof worker->stats);
+    worker->status = pdxcp_cdcl_parser_status_ok;
+  }
+  // start additional threads. the calling thread runs the first worker, and
+  // workers whose threads fail to start just have their files stolen
+  pthread_t *threads = NULL;
+  unsigned int n_started = 0;
+  if (n_threads > 1 && (threads = malloc((n_threads - 1) * sizeof *threads))) {
+    while (
+      n_started < n_threads - 1 &&
+      !pthread_create(
+        threads + n_started,
+        NULL,
+        index_worker_main,
+        work.workers + n_started + 1
+      )
+    )
+      n_started++;
+  }
+  index_worker_main(work.workers);
+  for (unsigned int i = 0; i < n_started; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+  // merge statistics and records
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_parser_status_ok;
+  pdxcp_cdcl_index_stats total = {0, 0, 0, 0};
+  size_t n_records = 0;
+  for (unsigned int i = 0; i < n_threads; i++) {
+    index_worker *worker = work.workers + i;
+    if (!PDXCP_CDCL_PARSER_OK(worker->status))
+      status = worker->status;
+    total.n_files += worker->stats.n_files;
+    total.n_failed += worker->stats.n_failed;
+    total.n_entries += worker->stats.n_entries;
+    total.n_skipped += worker->stats.n_skipped;
+    n_records += worker->n_records;
+  }
+  index_record *records = NULL;
+  if (PDXCP_CDCL_PARSER_OK(status) && n_records) {
+    if (!(records = malloc(n_records * sizeof *records)))
+      status = pdxcp_cdcl_parser_status_no_mem;
+  }
+  if (PDXCP_CDCL_PARSER_OK(status)) {
+    size_t n = 0;
+    for (unsigned int i = 0; i < n_threads; i++) {
+      index_worker *worker = work.workers + i;
+      if (worker->n_records)
+        memcpy(
+          records + n,
+          worker->records,
+          worker->n_records * sizeof *records
+        );
+      n += worker->n_records;
+    }
+    // sorting makes the output independent of thread scheduling
+    if (n_records)
+      qsort(records, n_records, sizeof *records, index_record_compare);
+    if (!index_write(paths, records, n_records, out))
+      status = pdxcp_cdcl_parser_status_out_err;
+  }
+  // record text lives in the worker arenas
+  free(records);
+  for (unsigned int i = 0; i < n_threads; i++) {
+    pthread_mutex_destroy(&work.workers[i].mut);
+    free(work.workers[i].records);
+    pdxcp_arena_destroy(&work.workers[i].strings);
+  }
+  free(work.workers);
+  if (stats)
+    *stats = total;
+  return status;
+}
+
+bool
+pdxcp_cdcl_index_open(pdxcp_cdcl_index *index, const void *data, size_t size)
+{
+  const unsigned char *bytes = data;
+  if (
+    !bytes ||
+    size < PDXCP_CDCL_INDEX_HEADER_SIZE ||
+    memcmp(bytes, PDXCP_CDCL_INDEX_MAGIC, 8) ||
+    bytes[8] != PDXCP_CDCL_INDEX_VERSION
+  )
+    return false;
+  // high version bytes and reserved bytes must be zero so that later format
+  // versions can give them a meaning
+  for (size_t i = 9; i < 16; i++)
+    if (bytes[i])
+      return false;
+  uint64_t n_files = index_load_u64(bytes + 16);
+  uint64_t n_entries = index_load_u64(bytes + 24);
+  // check table sizes without overflowing
+  size_t left = size - PDXCP_CDCL_INDEX_HEADER_SIZE;
+  if (n_files > left / 8)
+    return false;
+  left -= (size_t) n_files * 8;
+  if (n_entries > left / PDXCP_CDCL_INDEX_ENTRY_SIZE)
+    return false;
+  left -= (size_t) n_entries * PDXCP_CDCL_INDEX_ENTRY_SIZE;
+  // string pool must end with a null terminator if there are any strings
+  if ((n_files || n_entries) && (!left || bytes[size - 1]))
+    return false;
+  index->data = bytes;
+  index->n_files = (size_t) n_files;
+  index->n_entries = (size_t) n_entries;
+  index->files = bytes + PDXCP_CDCL_INDEX_HEADER_SIZE;
+  index->entries = index->files + index->n_files * 8;
+  index->strings = (const char *) (
+    index->entries + index->n_entries * PDXCP_CDCL_INDEX_ENTRY_SIZE
+  );
+  index->strings_size = left;
+  return true;
+}
+
+/**
+ * Return a string from the index string pool.
+ *
+ * @param index Index view
+ * @param offset String offset
+ * @returns String, `NULL` if the offset is out of range
+ */
+static const char *
+index_string(const pdxcp_cdcl_index *index, uint64_t offset)
+{
+  // pool ends with a null terminator, so all in-range strings are terminated
+  return (offset < index->strings_size) ? index->strings + offset : NULL;
+}
+
+bool
+pdxcp_cdcl_index_get(
+  const pdxcp_cdcl_index *index, size_t i, pdxcp_cdcl_index_entry *entry)
+{
+  const unsigned char *buf = index->entries + i * PDXCP_CDCL_INDEX_ENTRY_SIZE;
+  uint64_t file = index_load_u64(buf + 16);
+  if (file >= index->n_files)
+    return false;
+  entry->name = index_string(index, index_load_u64(buf));
+  entry->decl = index_string(index, index_load_u64(buf + 8));
+  entry->path = index_string(
+    index, index_load_u64(index->files + (size_t) file * 8)
+  );
+  entry->pos = index_load_u64(buf + 24);
+  return entry->name && entry->decl && entry->path;
+}
+
+/**
+ * Return the number of the first entry whose identifier is not less than, or
+ * if `upper` is `true`, greater than the given identifier.
+ *
+ * Entries with invalid identifier offsets compare as empty identifiers.
+ *
+ * @param index Index view
+ * @param name Null-terminated identifier
+ * @param upper `true` to find the upper bound instead of the lower bound
+ */
+static size_t
+index_bound(const pdxcp_cdcl_index *index, const char *name, bool upper)
+{
+  size_t lo = 0;
+  size_t hi = index->n_entries;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const char *mid_name = index_string(
+      index, index_load_u64(index->entries + mid * PDXCP_CDCL_INDEX_ENTRY_SIZE)
+    );
+    int cmp = strcmp((mid_name) ? mid_name : "", name);
+    if (cmp < 0 || (upper && !cmp))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+size_t
+pdxcp_cdcl_index_find(
+  const pdxcp_cdcl_index *index, const char *name, size_t *n_found)
+{
+  size_t first = index_bound(index, name, false);
+  *n_found = index_bound(index, name, true) - first;
+  return first;
+}
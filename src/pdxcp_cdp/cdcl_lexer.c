@@ -8,6 +8,7 @@
 #include "pdxcp/cdcl_lexer.h"
 
 #include <ctype.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -49,6 +50,7 @@ pdxcp_cdcl_token_type_string(pdxcp_cdcl_token_type type)
     PDXCP_STRING_CASE(pdxcp_cdcl_token_type_t_double);
     PDXCP_STRING_CASE(pdxcp_cdcl_token_type_num);
     PDXCP_STRING_CASE(pdxcp_cdcl_token_type_iden);
+    PDXCP_STRING_CASE(pdxcp_cdcl_token_type_t_name);
     default:
       return "(unknown)";
   }
@@ -144,6 +146,18 @@ pdxcp_cdcl_get_iden_text(FILE *in, pdxcp_cdcl_token *token)
   return pdxcp_cdcl_lexer_status_ok;
 }
 
+/**
+ * Check if a character is a digit of a decimal or hexadecimal number.
+ *
+ * @param hex `true` for a hexadecimal digit, `false` for a decimal digit
+ * @param c Character as an `unsigned char` converted to `int`, or `EOF`
+ */
+static bool
+lexer_is_digit(bool hex, int c)
+{
+  return (hex) ? isxdigit(c) : isdigit(c);
+}
+
 /**
  * Get an integral number into the text field of a token.
  *
@@ -171,8 +185,9 @@ pdxcp_cdcl_get_num_text(FILE *in, pdxcp_cdcl_token *token)
   }
   // write c into token text and advance text_out
   *text_out++ = (char) c;
-  // if c is '0', then we can also read 'x' or 'X' for hex
-  if (c == '0' && (c = fgetc(in)) != 'x' && c != 'X') {
+  // if c is '0', then 'x' or 'X' must follow for hex
+  bool hex = (c == '0');
+  if (hex && (c = fgetc(in)) != 'x' && c != 'X') {
     // might be EOF
     if (c == EOF)
       return pdxcp_cdcl_lexer_status_fgetc_eof;
@@ -182,9 +197,12 @@ pdxcp_cdcl_get_num_text(FILE *in, pdxcp_cdcl_token *token)
     strcpy(token->text, "Malformed token read when attempting to parse number");
     return pdxcp_cdcl_lexer_status_bad_token;
   }
-  // read rest of [0-9] string text
+  // keep the 'x' so the text converts with strtol base 0
+  if (hex)
+    *text_out++ = (char) c;
+  // read rest of [0-9] or [0-9a-fA-F] string text
   while (
-    isdigit(c = fgetc(in)) && c != EOF &&
+    lexer_is_digit(hex, c = fgetc(in)) && c != EOF &&
     text_out < token->text + PDXCP_CDCL_MAX_TOKEN_LEN
   )
     *text_out++ = (char) c;
@@ -194,7 +212,7 @@ pdxcp_cdcl_get_num_text(FILE *in, pdxcp_cdcl_token *token)
   if (c != EOF && ungetc(c, in) == EOF)
     return pdxcp_cdcl_lexer_status_ungetc_fail;
   // if c is a valid digit, token is too large, so overwrite front with message
-  if (isdigit(c)) {
+  if (lexer_is_digit(hex, c)) {
     token->type = pdxcp_cdcl_token_type_error;
     memcpy(token->text, long_token_error, sizeof long_token_error - 1);
     return pdxcp_cdcl_lexer_status_bad_token;
@@ -255,6 +273,57 @@ pdxcp_cdcl_set_char_token(pdxcp_cdcl_token *token, char c)
   return pdxcp_cdcl_lexer_status_ok;
 }
 
+/**
+ * Return the token type for identifier text, which may be a keyword.
+ *
+ * For `struct` and `enum` the tag still needs to be read by the caller.
+ *
+ * @param text Null-terminated identifier text
+ * @returns Keyword token type, `pdxcp_cdcl_token_type_iden` if not a keyword
+ */
+static pdxcp_cdcl_token_type
+pdxcp_cdcl_keyword_type(const char *text)
+{
+  // const qualifier
+  if (pdxcp_streq(text, "const"))
+    return pdxcp_cdcl_token_type_q_const;
+  // volatile qualifier
+  if (pdxcp_streq(text, "volatile"))
+    return pdxcp_cdcl_token_type_q_volatile;
+  // signed type qualifier
+  if (pdxcp_streq(text, "signed"))
+    return pdxcp_cdcl_token_type_q_signed;
+  // unsigned type qualifier
+  if (pdxcp_streq(text, "unsigned"))
+    return pdxcp_cdcl_token_type_q_unsigned;
+  // struct (requires another string read)
+  if (pdxcp_streq(text, "struct"))
+    return pdxcp_cdcl_token_type_struct;
+  // enum (requires another string read)
+  if (pdxcp_streq(text, "enum"))
+    return pdxcp_cdcl_token_type_enum;
+  // void
+  if (pdxcp_streq(text, "void"))
+    return pdxcp_cdcl_token_type_t_void;
+  // char
+  if (pdxcp_streq(text, "char"))
+    return pdxcp_cdcl_token_type_t_char;
+  // signed int
+  if (pdxcp_streq(text, "int"))
+    return pdxcp_cdcl_token_type_t_int;
+  // signed long
+  if (pdxcp_streq(text, "long"))
+    return pdxcp_cdcl_token_type_t_long;
+  // float
+  if (pdxcp_streq(text, "float"))
+    return pdxcp_cdcl_token_type_t_float;
+  // double
+  if (pdxcp_streq(text, "double"))
+    return pdxcp_cdcl_token_type_t_double;
+  // identifier
+  return pdxcp_cdcl_token_type_iden;
+}
+
 /**
  * Get a token from an identifier string from the specified input stream.
  *
@@ -274,71 +343,21 @@ pdxcp_cdcl_get_iden_token(FILE *in, pdxcp_cdcl_token *token)
   pdxcp_cdcl_lexer_status status;
   if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text(in, token)))
     return status;
-  // const qualifier
-  if (pdxcp_streq(token->text, "const")) {
-    token->type = pdxcp_cdcl_token_type_q_const;
-    token->text[0] = '\0';
-  }
-  // volatile qualifier
-  else if (pdxcp_streq(token->text, "volatile")) {
-    token->type = pdxcp_cdcl_token_type_q_volatile;
-    token->text[0] = '\0';
-  }
-  // signed type qualifier
-  else if (pdxcp_streq(token->text, "signed")) {
-    token->type = pdxcp_cdcl_token_type_q_signed;
-    token->text[0] = '\0';
-  }
-  // unsigned type qualifier
-  else if (pdxcp_streq(token->text, "unsigned")) {
-    token->type = pdxcp_cdcl_token_type_q_unsigned;
-    token->text[0] = '\0';
-  }
-  // struct (requires another string read)
-  else if (pdxcp_streq(token->text, "struct")) {
-    if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text(in, token)))
-      return status;
-    token->type = pdxcp_cdcl_token_type_struct;
-  }
-  // enum (requires another string read)
-  else if (pdxcp_streq(token->text, "enum")) {
-    if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text(in, token)))
-      return status;
-    token->type = pdxcp_cdcl_token_type_enum;
-  }
-  // void
-  else if (pdxcp_streq(token->text, "void")) {
-    token->type = pdxcp_cdcl_token_type_t_void;
-    token->text[0] = '\0';
-  }
-  // char
-  else if (pdxcp_streq(token->text, "char")) {
-    token->type = pdxcp_cdcl_token_type_t_char;
-    token->text[0] = '\0';
-  }
-  // signed int
-  else if (pdxcp_streq(token->text, "int")) {
-    token->type = pdxcp_cdcl_token_type_t_int;
-    token->text[0] = '\0';
-  }
-  // signed long
-  else if (pdxcp_streq(token->text, "long")) {
-    token->type = pdxcp_cdcl_token_type_t_long;
-    token->text[0] = '\0';
-  }
-  // float
-  else if (pdxcp_streq(token->text, "float")) {
-    token->type = pdxcp_cdcl_token_type_t_float;
-    token->text[0] = '\0';
-  }
-  // double
-  else if (pdxcp_streq(token->text, "double")) {
-    token->type = pdxcp_cdcl_token_type_t_double;
-    token->text[0] = '\0';
+  // classify the text. only identifiers and struct/enum tags keep text
+  pdxcp_cdcl_token_type type = pdxcp_cdcl_keyword_type(token->text);
+  switch (type) {
+    case pdxcp_cdcl_token_type_iden:
+      break;
+    case pdxcp_cdcl_token_type_struct:
+    case pdxcp_cdcl_token_type_enum:
+      if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text(in, token)))
+        return status;
+      break;
+    default:
+      token->text[0] = '\0';
+      break;
   }
-  // identifier
-  else
-    token->type = pdxcp_cdcl_token_type_iden;
+  token->type = type;
   return pdxcp_cdcl_lexer_status_ok;
 }
 
@@ -409,8 +428,8 @@ pdxcp_cdcl_get_token(FILE *in, pdxcp_cdcl_token *token)
   // if EOF, return
   if (c == EOF)
     return pdxcp_cdcl_lexer_status_fgetc_eof;
-  // handle slash. possibly skip C block comment, C++ line comment
-  if (c == '/') {
+  // handle slash. possibly skip C block comments, C++ line comments
+  while (c == '/') {
     // read another char and switch on its value
     c = fgetc(in);
     switch (c) {
@@ -460,3 +479,189 @@ pdxcp_cdcl_get_token(FILE *in, pdxcp_cdcl_token *token)
   // else single-character token. the token text is '\0' in this case
   return pdxcp_cdcl_set_char_token(token, (char) c);
 }
+
+/**
+ * Skip whitespace in the input buffer.
+ *
+ * @param in Input buffer cursor to advance
+ * @returns `true` if there is input left, `false` at the end of the buffer
+ */
+static bool
+pdxcp_cdcl_skip_space_buf(pdxcp_cdcl_lexer_buf *in)
+{
+  while (in->pos < in->end && isspace((unsigned char) *in->pos))
+    in->pos++;
+  return in->pos < in->end;
+}
+
+/**
+ * Get a valid C identifier from the input buffer into the text of a token.
+ *
+ * @param in Input buffer cursor to advance
+ * @param token Token to write identifier text to
+ * @returns `pdxcp_cdcl_lexer_status` status code. If
+ *  `pdxcp_cdcl_lexer_status_bad_token` is returned, the token type is
+ *  `pdxcp_cdcl_token_type_error` and token text has error details
+ */
+static pdxcp_cdcl_lexer_status
+pdxcp_cdcl_get_iden_text_buf(pdxcp_cdcl_lexer_buf *in, pdxcp_cdcl_token *token)
+{
+  // skip whitespace. first char must start an identifier
+  if (!pdxcp_cdcl_skip_space_buf(in))
+    return pdxcp_cdcl_lexer_status_fgetc_eof;
+  if (!isalpha((unsigned char) *in->pos) && *in->pos != '_')
+    return pdxcp_cdcl_lexer_status_not_iden;
+  // find end of [a-zA-Z0-9_] string text
+  const char *first = in->pos;
+  while (
+    in->pos < in->end && (isalnum((unsigned char) *in->pos) || *in->pos == '_')
+  )
+    in->pos++;
+  size_t len = (size_t) (in->pos - first);
+  // token too large. like the stream lexer, overwrite front with message
+  if (len > PDXCP_CDCL_MAX_TOKEN_LEN) {
+    memcpy(token->text, first, PDXCP_CDCL_MAX_TOKEN_LEN);
+    token->text[PDXCP_CDCL_MAX_TOKEN_LEN] = '\0';
+    token->type = pdxcp_cdcl_token_type_error;
+    memcpy(token->text, long_token_error, sizeof long_token_error - 1);
+    return pdxcp_cdcl_lexer_status_bad_token;
+  }
+  memcpy(token->text, first, len);
+  token->text[len] = '\0';
+  return pdxcp_cdcl_lexer_status_ok;
+}
+
+/**
+ * Get an integral number from the input buffer into the text of a token.
+ *
+ * Numbers are lexed exactly as `pdxcp_cdcl_get_num_text` does for streams.
+ *
+ * @param in Input buffer cursor to advance
+ * @param token Token to write number text to
+ * @returns `pdxcp_cdcl_lexer_status` status code. If
+ *  `pdxcp_cdcl_lexer_status_bad_token` is returned, the token type is
+ *  `pdxcp_cdcl_token_type_error` and token text has error details
+ */
+static pdxcp_cdcl_lexer_status
+pdxcp_cdcl_get_num_text_buf(pdxcp_cdcl_lexer_buf *in, pdxcp_cdcl_token *token)
+{
+  // skip whitespace. first char must be a digit
+  if (!pdxcp_cdcl_skip_space_buf(in))
+    return pdxcp_cdcl_lexer_status_fgetc_eof;
+  if (!isdigit((unsigned char) *in->pos))
+    return pdxcp_cdcl_lexer_status_not_num;
+  char *text_out = token->text;
+  *text_out++ = *in->pos++;
+  // if first digit is '0', then 'x' or 'X' must follow for hex
+  bool hex = (text_out[-1] == '0');
+  if (hex) {
+    if (in->pos == in->end)
+      return pdxcp_cdcl_lexer_status_fgetc_eof;
+    if (*in->pos != 'x' && *in->pos != 'X') {
+      in->pos++;
+      token->type = pdxcp_cdcl_token_type_error;
+      strcpy(token->text, "Malformed token read when attempting to parse number");
+      return pdxcp_cdcl_lexer_status_bad_token;
+    }
+    // keep the 'x' so the text converts with strtol base 0
+    *text_out++ = *in->pos++;
+  }
+  // read rest of [0-9] or [0-9a-fA-F] string text
+  while (
+    in->pos < in->end && lexer_is_digit(hex, (unsigned char) *in->pos) &&
+    text_out < token->text + PDXCP_CDCL_MAX_TOKEN_LEN
+  )
+    *text_out++ = *in->pos++;
+  *text_out = '\0';
+  // if more digits follow, token is too large, so overwrite front with message
+  if (in->pos < in->end && lexer_is_digit(hex, (unsigned char) *in->pos)) {
+    token->type = pdxcp_cdcl_token_type_error;
+    memcpy(token->text, long_token_error, sizeof long_token_error - 1);
+    return pdxcp_cdcl_lexer_status_bad_token;
+  }
+  return pdxcp_cdcl_lexer_status_ok;
+}
+
+pdxcp_cdcl_lexer_status
+pdxcp_cdcl_get_token_buf(pdxcp_cdcl_lexer_buf *in, pdxcp_cdcl_token *token)
+{
+  // must be non-NULL
+  if (!in)
+    return pdxcp_cdcl_lexer_status_stream_null;
+  if (!token)
+    return pdxcp_cdcl_lexer_status_token_null;
+  // all EOF returns leave the cursor at the end of the buffer
+  in->token = in->end;
+  // skip whitespace and any comments
+  if (!pdxcp_cdcl_skip_space_buf(in))
+    return pdxcp_cdcl_lexer_status_fgetc_eof;
+  while (*in->pos == '/') {
+    // lone '/' is a token, even if it is the last char in the buffer
+    if (in->pos + 1 == in->end || (in->pos[1] != '*' && in->pos[1] != '/')) {
+      in->token = in->pos++;
+      return pdxcp_cdcl_set_char_token(token, '/');
+    }
+    // C block comment. skip until end of input or end of block comment
+    if (in->pos[1] == '*') {
+      in->pos += 2;
+      while (true) {
+        const char *star = memchr(in->pos, '*', (size_t) (in->end - in->pos));
+        if (!star || star + 1 == in->end) {
+          in->pos = in->end;
+          return pdxcp_cdcl_lexer_status_fgetc_eof;
+        }
+        in->pos = star + 1;
+        if (*in->pos == '/') {
+          in->pos++;
+          break;
+        }
+      }
+    }
+    // C++ line comment. skip rest of the line, which must end with a newline
+    else {
+      const char *newline = memchr(in->pos, '\n', (size_t) (in->end - in->pos));
+      if (!newline) {
+        in->pos = in->end;
+        return pdxcp_cdcl_lexer_status_fgetc_eof;
+      }
+      in->pos = newline + 1;
+    }
+    // finished skipping comment, so skip any additional whitespace
+    if (!pdxcp_cdcl_skip_space_buf(in))
+      return pdxcp_cdcl_lexer_status_fgetc_eof;
+  }
+  // identifier or keyword
+  in->token = in->pos;
+  unsigned char c = (unsigned char) *in->pos;
+  if (isalpha(c) || c == '_') {
+    pdxcp_cdcl_lexer_status status;
+    if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text_buf(in, token)))
+      return status;
+    pdxcp_cdcl_token_type type = pdxcp_cdcl_keyword_type(token->text);
+    switch (type) {
+      case pdxcp_cdcl_token_type_iden:
+        break;
+      case pdxcp_cdcl_token_type_struct:
+      case pdxcp_cdcl_token_type_enum:
+        if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_iden_text_buf(in, token)))
+          return status;
+        break;
+      default:
+        token->text[0] = '\0';
+        break;
+    }
+    token->type = type;
+    return pdxcp_cdcl_lexer_status_ok;
+  }
+  // number
+  if (isdigit(c)) {
+    pdxcp_cdcl_lexer_status status;
+    if (!PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_num_text_buf(in, token)))
+      return status;
+    token->type = pdxcp_cdcl_token_type_num;
+    return pdxcp_cdcl_lexer_status_ok;
+  }
+  // else single-character token. the token text is '\0' in this case
+  in->pos++;
+  return pdxcp_cdcl_set_char_token(token, (char) c);
+}
@@ -8,13 +8,19 @@
 #include "pdxcp/cdcl_parser.h"
 
 #include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
 #include "pdxcp/cdcl_common.h"
 #include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_typedefs.h"
 
 const char *
 pdxcp_cdcl_parser_status_string(pdxcp_cdcl_parser_status status)
@@ -31,6 +37,14 @@ pdxcp_cdcl_parser_status_string(pdxcp_cdcl_parser_status status)
     PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_bad_token);
     PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_null_err_text);
     PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_err_text_too_long);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_arena_null);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_decl_null);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_no_mem);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_out_too_small);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_callback_null);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_buf_open_err);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_bad_format);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_status_bad_edit);
     default:
       return "(unknown)";
   };
@@ -47,7 +61,7 @@ pdxcp_cdcl_parser_status_message(pdxcp_cdcl_parser_status status)
     case pdxcp_cdcl_parser_status_out_null:
       return "Output stream is NULL";
     case pdxcp_cdcl_parser_status_eof:
-      return "Parser read EOF before finishing parser";
+      return "Input ended before the end of the declaration";
     case pdxcp_cdcl_parser_status_lexer_err:
       return "Lexer error, check parser error info lexer text";
     case pdxcp_cdcl_parser_status_token_overflow:
@@ -56,70 +70,350 @@ pdxcp_cdcl_parser_status_message(pdxcp_cdcl_parser_status status)
       return "Error writing parser output to stream";
     case pdxcp_cdcl_parser_status_parse_err:
       return "Parser error, check parser error info";
+    case pdxcp_cdcl_parser_status_arena_null:
+      return "Declaration node arena is NULL";
+    case pdxcp_cdcl_parser_status_decl_null:
+      return "Output declaration is NULL";
+    case pdxcp_cdcl_parser_status_no_mem:
+      return "Memory allocation failure";
+    case pdxcp_cdcl_parser_status_out_too_small:
+      return "Output buffer too small, output truncated";
+    case pdxcp_cdcl_parser_status_callback_null:
+      return "Declaration callback is NULL";
+    case pdxcp_cdcl_parser_status_buf_open_err:
+      return "Failed to open input buffer as a stream";
+    case pdxcp_cdcl_parser_status_bad_format:
+      return "Unknown output format";
+    case pdxcp_cdcl_parser_status_bad_edit:
+      return "Edit range is outside of the document";
     default:
       return "Unknown parser status";
   }
 }
 
+const char *
+pdxcp_cdcl_parser_phase_string(pdxcp_cdcl_parser_phase phase)
+{
+  switch (phase) {
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_phase_to_iden);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_phase_ptrs);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_phase_arrays);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_phase_type);
+    default:
+      return "(unknown)";
+  }
+}
+
+void
+pdxcp_cdcl_parser_stats_init(pdxcp_cdcl_parser_stats *stats)
+{
+  memset(stats, 0, sizeof *stats);
+}
+
+bool
+pdxcp_cdcl_parser_stats_enabled(void)
+{
+#if defined(PDXCP_CDCL_ENABLE_STATS)
+  return true;
+#else
+  return false;
+#endif  // !defined(PDXCP_CDCL_ENABLE_STATS)
+}
+
+const char *
+pdxcp_cdcl_decl_kind_string(pdxcp_cdcl_decl_kind kind)
+{
+  switch (kind) {
+    PDXCP_STRING_CASE(pdxcp_cdcl_decl_kind_type);
+    PDXCP_STRING_CASE(pdxcp_cdcl_decl_kind_pointer);
+    PDXCP_STRING_CASE(pdxcp_cdcl_decl_kind_array);
+    PDXCP_STRING_CASE(pdxcp_cdcl_decl_kind_function);
+    default:
+      return "(unknown)";
+  }
+}
+
+const char *
+pdxcp_cdcl_parser_error_string(pdxcp_cdcl_parser_error error)
+{
+  switch (error) {
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_none);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_ptr_dup_const);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_ptr_dup_volatile);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_ptr_token);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_ptr_no_type);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_paren_mismatch);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_internal);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_dup_langle);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_size_no_langle);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_size_range);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_size_zero);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_size_negative);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_no_langle);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_no_bounds);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_token);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_params_depth);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_params_token);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_params_void);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_return_array);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_return_function);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_array_function);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_dup_const);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_dup_volatile);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_dup_signed);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_dup_unsigned);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_signed_unsigned);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_unsigned_signed);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_redefined);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_token);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_missing);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_type_bad_sign);
+    PDXCP_STRING_CASE(pdxcp_cdcl_parser_error_incomplete);
+    default:
+      return "(unknown)";
+  }
+}
+
+/**
+ * Return the fixed error text for a parser error code.
+ *
+ * @param error Parser error code
+ * @returns Error text, `NULL` if the text depends on other error info
+ */
+static const char *
+parser_error_message(pdxcp_cdcl_parser_error error)
+{
+  switch (error) {
+    case pdxcp_cdcl_parser_error_ptr_dup_const:
+      return "Duplicate pointer const qualifier";
+    case pdxcp_cdcl_parser_error_ptr_dup_volatile:
+      return "Duplicate pointer volatile qualifier";
+    case pdxcp_cdcl_parser_error_ptr_no_type:
+      return "Unexpectedly ran out of tokens when parsing pointers, missing type";
+    case pdxcp_cdcl_parser_error_array_internal:
+      return "Internal parser error: attempted to parse array without langle "
+        "token";
+    case pdxcp_cdcl_parser_error_array_dup_langle:
+      return "Array specifier contains duplicate left angle bracket";
+    case pdxcp_cdcl_parser_error_array_size_no_langle:
+      return "Array specifier size read without matching left angle bracket";
+    case pdxcp_cdcl_parser_error_array_size_range:
+      return "Array specifier size out of range";
+    case pdxcp_cdcl_parser_error_array_size_zero:
+      return "Array specifier size is 0";
+    case pdxcp_cdcl_parser_error_array_size_negative:
+      return "Array specifier size is < 0";
+    case pdxcp_cdcl_parser_error_array_no_langle:
+      return "Array specifier missing matching left angle bracket";
+    case pdxcp_cdcl_parser_error_array_no_bounds:
+      return "Multidimensional array specifier must have bounds for all "
+        "dimensions except for the first";
+    case pdxcp_cdcl_parser_error_params_void:
+      return "A void parameter must be unnamed, unqualified, and the only "
+        "parameter";
+    case pdxcp_cdcl_parser_error_return_array:
+      return "Function cannot return an array";
+    case pdxcp_cdcl_parser_error_return_function:
+      return "Function cannot return a function";
+    case pdxcp_cdcl_parser_error_array_function:
+      return "Array elements cannot be functions";
+    case pdxcp_cdcl_parser_error_type_dup_const:
+      return "Duplicate type const qualifier";
+    case pdxcp_cdcl_parser_error_type_dup_volatile:
+      return "Duplicate type volatile qualifier";
+    case pdxcp_cdcl_parser_error_type_dup_signed:
+      return "Duplicate signed type qualifier";
+    case pdxcp_cdcl_parser_error_type_dup_unsigned:
+      return "Duplicate unsigned type qualifier";
+    case pdxcp_cdcl_parser_error_type_signed_unsigned:
+      return "Type already qualified as unsigned, cannot re-qualify as signed";
+    case pdxcp_cdcl_parser_error_type_unsigned_signed:
+      return "Type already qualified as signed, cannot re-quaifiy as unsigned";
+    case pdxcp_cdcl_parser_error_type_missing:
+      return "Identifier missing required type";
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * Return what was being parsed for an unexpected token error code.
+ *
+ * @param error Parser error code
+ * @returns Description, `NULL` if not an unexpected token error code
+ */
+static const char *
+parser_error_context(pdxcp_cdcl_parser_error error)
+{
+  switch (error) {
+    case pdxcp_cdcl_parser_error_ptr_token:
+      return "pointers";
+    case pdxcp_cdcl_parser_error_array_token:
+      return "array specifiers";
+    case pdxcp_cdcl_parser_error_params_token:
+      return "function parameters";
+    case pdxcp_cdcl_parser_error_type_token:
+      return "identifier type";
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * Format parse error text from the structured parser error info.
+ *
+ * @param errinfo Error info with parser status `pdxcp_cdcl_parser_status_parse_err`
+ * @param buf Output buffer
+ * @param buf_size Output buffer size in bytes
+ * @returns `snprintf` return value
+ */
+static int
+parser_error_format(
+  const pdxcp_cdcl_parser_errinfo *errinfo, char *buf, size_t buf_size)
+{
+  pdxcp_cdcl_parser_error error = errinfo->parser.error;
+  // most errors have fixed text
+  const char *text = parser_error_message(error);
+  if (text)
+    return snprintf(buf, buf_size, "%s", text);
+  // unexpected token
+  const char *context = parser_error_context(error);
+  if (context)
+    return snprintf(
+      buf,
+      buf_size,
+      "Unexpected token type %s with text \"%s\" when parsing %s",
+      // TODO: nicer way to indicate the token + text?
+      pdxcp_cdcl_token_type_string(errinfo->parser.token),
+      errinfo->parser.name,
+      context
+    );
+  switch (error) {
+    case pdxcp_cdcl_parser_error_paren_mismatch:
+      return snprintf(
+        buf,
+        buf_size,
+        "Mismatched parentheses when parsing pointers, read %u '(' %u ')'",
+        errinfo->parser.n_lparen,
+        errinfo->parser.n_rparen
+      );
+    case pdxcp_cdcl_parser_error_params_depth:
+      return snprintf(
+        buf,
+        buf_size,
+        "Function parameter lists nested more than %d levels deep",
+        PDXCP_CDCL_PARSER_MAX_DEPTH
+      );
+    case pdxcp_cdcl_parser_error_type_redefined:
+      return snprintf(
+        buf,
+        buf_size,
+        "Type %s provided when identifier already specified as %s",
+        // TODO: add function that C type string from enum token type
+        pdxcp_cdcl_token_type_string(errinfo->parser.token),
+        pdxcp_cdcl_token_type_string(errinfo->parser.type)
+      );
+    case pdxcp_cdcl_parser_error_type_bad_sign:
+      return snprintf(
+        buf,
+        buf_size,
+        "Only char, int, or long can be signed or unsigned, received %s",
+        // TODO: nicer way to indicate identifier type
+        pdxcp_cdcl_token_type_string(errinfo->parser.token)
+      );
+    case pdxcp_cdcl_parser_error_incomplete:
+      return snprintf(
+        buf,
+        buf_size,
+        "Incomplete declaration for identifier %s",
+        errinfo->parser.name
+      );
+    default:
+      return snprintf(
+        buf,
+        buf_size,
+        "%s",
+        pdxcp_cdcl_parser_status_message(errinfo->parser.status)
+      );
+  }
+}
+
+size_t
+pdxcp_cdcl_parser_errinfo_format(
+  const pdxcp_cdcl_parser_errinfo *errinfo, char *buf, size_t buf_size)
+{
+  int len;
+  switch (errinfo->parser.status) {
+    case pdxcp_cdcl_parser_status_parse_err:
+      len = parser_error_format(errinfo, buf, buf_size);
+      break;
+    // lexer errors have no parser error code, so use lexer status and text
+    case pdxcp_cdcl_parser_status_lexer_err:
+      len = snprintf(
+        buf,
+        buf_size,
+        "%s with text \"%s\"",
+        pdxcp_cdcl_lexer_status_string(errinfo->lexer.status),
+        errinfo->lexer.text
+      );
+      break;
+    default:
+      len = snprintf(
+        buf,
+        buf_size,
+        "%s",
+        pdxcp_cdcl_parser_status_message(errinfo->parser.status)
+      );
+      break;
+  }
+  return (len < 0) ? 0 : (size_t) len;
+}
+
 /**
  * Write parser error info.
  *
+ * Only structured error info is written, which is cheap. All error-specific
+ * parser members are reset so stale values from a previous error never leak
+ * into the formatted text.
+ *
  * @param errinfo Error info structure. If `NULL`, nothing is done
  * @param lexer_status Lexer status
  * @param cur_token Most recent token read by lexer. If the lexer status is
  *  `pdxcp_cdcl_lexer_status_bad_token`, its text will contain the error text.
  *  Ignored unless `lexer_status` is `pdxcp_cdcl_lexer_status_bad_token`.
  * @param parser_status Parser status
- * @param parser_text Null-terminated parser error text for more details when
- *  `parser_status` is `pdxcp_cdcl_parser_status_parse_err` (generic error).
- *  Ignored unless `parser_status` is `pdxcp_cdcl_parser_status_parse_err`. If
- *  `NULL` when expected, errinfo parser status instead becomes
- *  `pdxcp_cdcl_parser_status_null_err_text`.
+ * @param error Parser error code
+ * @returns `errinfo`, so callers can write error-specific members
  */
-static void
+static pdxcp_cdcl_parser_errinfo *
 pdxcp_cdcl_write_errinfo(
   pdxcp_cdcl_parser_errinfo *errinfo,
   pdxcp_cdcl_lexer_status lexer_status,
   const pdxcp_cdcl_token *cur_token,
   pdxcp_cdcl_parser_status parser_status,
-  const char *parser_text)
+  pdxcp_cdcl_parser_error error)
 {
   if (!errinfo)
-    return;
+    return NULL;
   // write status values
   errinfo->lexer.status = lexer_status;
   errinfo->parser.status = parser_status;
+  errinfo->parser.error = error;
   // if the token is bad, copy the token text
-  if (lexer_status == pdxcp_cdcl_lexer_status_bad_token) {
+  if (lexer_status == pdxcp_cdcl_lexer_status_bad_token)
     strcpy(errinfo->lexer.text, cur_token->text);
-    errinfo->lexer.text[strlen(cur_token->text)] = '\0';  // terminate string
-  }
   // otherwise just empty string
   else
     errinfo->lexer.text[0] = '\0';
-  // check parser_text if parser_status is generic error
-  if (parser_status == pdxcp_cdcl_parser_status_parse_err) {
-    // if NULL, use specific error code
-    if (!parser_text) {
-      errinfo->parser.status = pdxcp_cdcl_parser_status_null_err_text;
-      errinfo->parser.text[0] = '\0';
-      return;
-    }
-    // otherwise, write actual error text. first get error text length
-    size_t parser_text_len = strlen(parser_text);
-    // if too long, truncate and use appropriate status
-    if (parser_text_len > PDXCP_CDCL_PARSER_ERROR_TEXT_LEN) {
-      errinfo->parser.status = pdxcp_cdcl_parser_status_err_text_too_long;
-      memcpy(errinfo->parser.text, parser_text, PDXCP_CDCL_PARSER_ERROR_TEXT_LEN);
-      errinfo->parser.text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN] = '\0';
-    }
-    // otherwise, copy null-terminated entire string in
-    else
-      strcpy(errinfo->parser.text, parser_text);
-  }
-  // otherwise just empty string
-  else
-    errinfo->parser.text[0] = '\0';
+  // reset error-specific members. location is written when parsing returns
+  errinfo->parser.token = pdxcp_cdcl_token_type_error;
+  errinfo->parser.type = pdxcp_cdcl_token_type_error;
+  errinfo->parser.n_lparen = 0;
+  errinfo->parser.n_rparen = 0;
+  errinfo->parser.name[0] = '\0';
+  errinfo->offset = 0;
+  errinfo->span = 0;
+  return errinfo;
 }
 
 /**
@@ -139,12 +433,12 @@ pdxcp_cdcl_write_lexer_err(
   pdxcp_cdcl_lexer_status lexer_status,
   const pdxcp_cdcl_token *cur_token)
 {
-  return pdxcp_cdcl_write_errinfo(
+  pdxcp_cdcl_write_errinfo(
     errinfo,
     lexer_status,
     cur_token,
     pdxcp_cdcl_parser_status_lexer_err,
-    NULL
+    pdxcp_cdcl_parser_error_none
   );
 }
 
@@ -154,629 +448,2143 @@ pdxcp_cdcl_write_lexer_err(
  * The parser error status is `pdxcp_cdcl_parser_status_parse_err`.
  *
  * @param errinfo Error info structure. If `NULL`, nothing is done
- * @param parser_text Null-terminated parser error text for more details. If
- *  `NULL` when expected, errinfo parser status instead becomes
- *  `pdxcp_cdcl_parser_status_null_err_text`.
+ * @param error Parser error code
+ * @returns `errinfo`, so callers can write error-specific members
  */
-static void
+static pdxcp_cdcl_parser_errinfo *
 pdxcp_cdcl_write_parse_err(
-  pdxcp_cdcl_parser_errinfo *errinfo, const char *parser_text)
+  pdxcp_cdcl_parser_errinfo *errinfo, pdxcp_cdcl_parser_error error)
 {
   return pdxcp_cdcl_write_errinfo(
     errinfo,
     pdxcp_cdcl_lexer_status_ok,
     NULL,
     pdxcp_cdcl_parser_status_parse_err,
-    parser_text
+    error
   );
 }
 
 /**
- * Read tokens from input stream until an identifier is parsed.
+ * Write parser error info when memory allocation fails.
  *
- * @param in Input stream
- * @param lexer_status Lexer status to update for error reporting
- * @param token_stack Token stack to push previously read tokens onto
- * @param cur_token Most recent token read by the lexer from input stream
- * @returns `pdxcp_cdcl_parser_status`
+ * The parser error status is `pdxcp_cdcl_parser_status_no_mem`.
+ *
+ * @param errinfo Error info structure. If `NULL`, nothing is done
  */
-static pdxcp_cdcl_parser_status
-stream_parse_to_iden(
-  FILE *in,
-  pdxcp_cdcl_lexer_status *lexer_status,
-  pdxcp_cdcl_token_stack *token_stack,
-  pdxcp_cdcl_token *cur_token)
+static void
+pdxcp_cdcl_write_no_mem_err(pdxcp_cdcl_parser_errinfo *errinfo)
 {
-  // read tokens from lexer until error
-  while (
-    PDXCP_CDCL_LEXER_OK(*lexer_status = pdxcp_cdcl_get_token(in, cur_token))
-  ) {
-    // if identifier, break. time to start parsing
-    if (cur_token->type == pdxcp_cdcl_token_type_iden)
-      break;
-    // if token stack is full, can't push token, so error
-    if (PDXCP_CDCL_TOKEN_STACK_FULL(token_stack))
-      return pdxcp_cdcl_parser_status_token_overflow;
-    // push the token and continue
-    PDXCP_CDCL_TOKEN_STACK_PUSH(token_stack, cur_token);
-  }
-  // note lexer error, otherwise success
-  if (!PDXCP_CDCL_LEXER_OK(*lexer_status))
-    return pdxcp_cdcl_parser_status_lexer_err;
-  return pdxcp_cdcl_parser_status_ok;
+  pdxcp_cdcl_write_errinfo(
+    errinfo,
+    pdxcp_cdcl_lexer_status_ok,
+    NULL,
+    pdxcp_cdcl_parser_status_no_mem,
+    pdxcp_cdcl_parser_error_none
+  );
 }
 
 /**
- * Pop tokens off of the token stack to handle pointers in the declaration.
+ * Declaration node list builder.
  *
- * Also handles cv-qualifiers for the tokens and balances any left parenthesis
- * on the token stack against the number of right parentheses already read.
+ * @param arena Arena to allocate declaration nodes from
+ * @param tail Address of the `next` member of the last node in the list, or
+ *  the address of the declaration's first node pointer if the list is empty
+ */
+typedef struct {
+  pdxcp_arena *arena;
+  pdxcp_cdcl_decl_node **tail;
+} decl_builder;
+
+/**
+ * Initialize a declaration node list builder for the given declaration.
  *
- * @param stack Token stack to pop from
- * @param out Output stream
- * @param n_rparen Number of right parentheses already read as part of decl
+ * @param builder Builder to initialize
+ * @param arena Arena to allocate declaration nodes from
+ * @param decl Declaration whose node list is to be built
+ */
+static void
+decl_builder_init(
+  decl_builder *builder, pdxcp_arena *arena, pdxcp_cdcl_decl *decl)
+{
+  decl->node = NULL;
+  builder->arena = arena;
+  builder->tail = &decl->node;
+}
+
+/**
+ * Append a new zero-initialized declaration node to the node list.
+ *
+ * On allocation failure the error info is also written.
+ *
+ * @param builder Builder to append to
+ * @param kind Kind of node to append
  * @param errinfo Error info structure, can be `NULL`
- * @returns `pdxcp_cdcl_parser_status` parser status
+ * @returns New node, `NULL` on error
  */
-static pdxcp_cdcl_parser_status
-stream_parse_ptrs(
-  pdxcp_cdcl_token_stack *stack,
-  FILE *out,
-  unsigned int n_rparen,
+static pdxcp_cdcl_decl_node *
+decl_builder_add(
+  decl_builder *builder,
+  pdxcp_cdcl_decl_kind kind,
   pdxcp_cdcl_parser_errinfo *errinfo)
 {
-  // indicators for cv-qualifiers
-  bool has_const = false;
-  bool has_volatile = false;
-  // number of left parentheses popped off stack
-  unsigned int n_lparen = 0;
-  // pop tokens off stack
-  while (!PDXCP_CDCL_TOKEN_STACK_EMPTY(stack)) {
-    // switch on the token type
-    switch (PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type) {
-      // const qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_const:
-        // already have const, duplicate qualifier
-        if (has_const) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate pointer const qualifier");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // otherwise note const qualifier
-        has_const = true;
-        break;
-      // volatile qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_volatile:
-        // already have volatile, duplicate qualifier
-        if (has_volatile) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate pointer volatile qualifier");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // otherwise note volatile qualifier
-        has_volatile = true;
-        break;
-      // left parenthesis, so increment n_lparen
-      case pdxcp_cdcl_token_type_lparen:
-        n_lparen++;
-        break;
-      // pointer
-      case pdxcp_cdcl_token_type_star:
-        // handle cv-qualification
-        if (has_const && fprintf(out, " const") < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        if (has_volatile && fprintf(out, " volatile") < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        // print pointer + reset cv-qualifiers
-        if (fprintf(out, " pointer to") < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        has_const = has_volatile = false;
-        break;
-      // unexpected token. if either has_const or has_volatile is true, then
-      // definitely this is a parse error, otherwise assume success
-      default:
-        if (has_const || has_volatile) {
-          // format message into buffer
-          char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-          snprintf(
-            errmsg,
-            sizeof errmsg - 1,
-            "Unexpected token type %s with text \"%s\" when parsing pointers",
-            pdxcp_cdcl_token_type_string(PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type),
-            PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->text
-          );
-          errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-          // write result into error info
-          pdxcp_cdcl_write_parse_err(errinfo, errmsg);
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // if n_lparen != n_rparen, mismatched parentheses
-        if (n_lparen != n_rparen) {
-          char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-          snprintf(
-            errmsg,
-            sizeof errmsg - 1,
-            "Mismatched parentheses when parsing pointers, read %u '(' %u ')'",
-            n_lparen,
-            n_rparen
-          );
-          errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-          pdxcp_cdcl_write_parse_err(errinfo, errmsg);
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        return pdxcp_cdcl_parser_status_ok;
-    }
-    // done with token so pop from stack
-    PDXCP_CDCL_TOKEN_STACK_POP(stack);
+  pdxcp_cdcl_decl_node *node = pdxcp_arena_alloc(builder->arena, sizeof *node);
+  if (!node) {
+    pdxcp_cdcl_write_no_mem_err(errinfo);
+    return NULL;
   }
-  // if stack is empty, we are missing tokens, e.g. type, etc.
-  if (PDXCP_CDCL_TOKEN_STACK_EMPTY(stack)) {
-    pdxcp_cdcl_write_parse_err(
-      errinfo,
-      "Unexpectedly ran out of tokens when parsing pointers, missing type"
+  // zero everything, set kind, and link
+  memset(node, 0, sizeof *node);
+  node->kind = kind;
+  *builder->tail = node;
+  builder->tail = &node->next;
+  return node;
+}
+
+bool
+pdxcp_cdcl_token_stack_push(
+  pdxcp_cdcl_token_stack *stack,
+  pdxcp_arena *arena,
+  const pdxcp_cdcl_token *token)
+{
+  // full, so move handles to arena storage with double the capacity. the old
+  // spilled storage, if any, is reclaimed when the arena is reset
+  if (stack->n_tokens == stack->capacity) {
+    pdxcp_cdcl_token_handle *spill = pdxcp_arena_alloc(
+      arena, 2 * stack->capacity * sizeof *spill
     );
-    return pdxcp_cdcl_parser_status_parse_err;
+    if (!spill)
+      return false;
+    memcpy(
+      spill,
+      PDXCP_CDCL_TOKEN_STACK_DATA(stack),
+      stack->n_tokens * sizeof *spill
+    );
+    stack->spill = spill;
+    stack->capacity *= 2;
   }
-  return pdxcp_cdcl_parser_status_ok;
+  // only struct, enum, and typedef name tokens have text that needs copying
+  pdxcp_cdcl_token_handle *handle = PDXCP_CDCL_TOKEN_STACK_HEAD(stack) + 1;
+  handle->type = token->type;
+  if (!token->text[0])
+    handle->text = "";
+  else if (!(handle->text = pdxcp_arena_strdup(arena, token->text)))
+    return false;
+  stack->n_tokens++;
+  return true;
 }
 
 /**
- * Parse array specifiers, reading tokens from input stream until semicolon.
+ * Copy token text or an identifier into the parser error info name.
  *
- * @note A multidimensional array declaration is allowed to omit the size for
- *  the first dimension, but only if declared as a function parameter. This
- *  function is slightly noncompliant by allowing a non-parameter array
- *  declaration to omit the size for the first dimension.
+ * @param errinfo Error info structure
+ * @param text Null-terminated text, truncated if longer than a token can be
+ */
+static void
+pdxcp_cdcl_write_err_name(pdxcp_cdcl_parser_errinfo *errinfo, const char *text)
+{
+  size_t len = strlen(text);
+  if (len > PDXCP_CDCL_MAX_TOKEN_LEN)
+    len = PDXCP_CDCL_MAX_TOKEN_LEN;
+  memcpy(errinfo->parser.name, text, len);
+  errinfo->parser.name[len] = '\0';
+}
+
+/**
+ * Write parser error info for an unexpected token.
  *
- * A precondition for calling this function is that a left bracket token has
- * already been read, with `cur_token` being the pointer to that token.
+ * The parser error status is `pdxcp_cdcl_parser_status_parse_err`.
  *
- * @param in Input stream
- * @param out Output stream
- * @param cur_token Last token read by lexer and modified as this function
- *  runs. On successful completion, the token type is semicolon.
- * @param errinfo Error info structure, can be `NULL`
- * @returns `pdxcp_cdcl_parser_status` parser status
+ * @param errinfo Error info structure. If `NULL`, nothing is done
+ * @param error Unexpected token error code for what was being parsed
+ * @param type Unexpected token type
+ * @param text Null-terminated unexpected token text
  */
-static pdxcp_cdcl_parser_status
-stream_parse_arrays(
-  FILE *in,
-  FILE *out,
-  pdxcp_cdcl_token *cur_token,
-  pdxcp_cdcl_parser_errinfo *errinfo)
+static void
+pdxcp_cdcl_write_token_err(
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  pdxcp_cdcl_parser_error error,
+  pdxcp_cdcl_token_type type,
+  const char *text)
 {
-  // internal error if cur_token is not left bracket
-  if (cur_token->type != pdxcp_cdcl_token_type_langle) {
-    pdxcp_cdcl_write_parse_err(
-      errinfo,
-      "Internal parser error: attempted to parse array without langle token"
-    );
-    return pdxcp_cdcl_parser_status_parse_err;
-  }
-  // indicate if unmatched left angle bracket was read
-  bool unmatched_langle = true;
-  // array size. since it cannot be zero, we use zero to indicate no size
-  size_t array_size = 0;
-  // number of array specifiers read. only first dimension can have no size,
-  // but this is actually only true if this decl is a function parameter
-  unsigned int n_specs = 0;
-  // consume tokens from input stream up to semicolon
-  do {
-    pdxcp_cdcl_lexer_status lexer_status;
-    if (!PDXCP_CDCL_LEXER_OK(lexer_status = pdxcp_cdcl_get_token(in, cur_token))) {
-      pdxcp_cdcl_write_lexer_err(errinfo, lexer_status, cur_token);
-      return pdxcp_cdcl_parser_status_lexer_err;
-    }
-    // switch on token type
-    switch (cur_token->type) {
-      // left bracket
-      case pdxcp_cdcl_token_type_langle:
-        // if already have a left one, mismatch
-        if (unmatched_langle) {
-          pdxcp_cdcl_write_parse_err(
-            errinfo, "Array specifier contains duplicate left angle bracket"
-          );
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // otherwise, unmatched
-        unmatched_langle = true;
-        break;
-      // integral value giving array size
-      case pdxcp_cdcl_token_type_num: {
-        // if no unmatched left bracket, error
-        if (!unmatched_langle) {
-          pdxcp_cdcl_write_parse_err(
-            errinfo,
-            "Array specifier size read without matching left angle bracket"
-          );
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // convert text to array size (handles hex and octal). note that since
-        // we know it will be a number, 0 is not considered an error return
-        long value = strtol(cur_token->text, NULL, 0);
-        // out of range errors
-        if (value == LONG_MIN || value == LONG_MAX) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Array specifier size out of range");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // size cannot be zero or negative
-        if (value == 0) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Array specifier size is 0");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        if (value < 0) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Array specifier size is < 0");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // valid array size
-        array_size = (size_t) value;
-        break;
-      }
-      // right bracket
-      case pdxcp_cdcl_token_type_rangle:
-        // if no unmatched left bracket, mismatch
-        if (!unmatched_langle) {
-          pdxcp_cdcl_write_parse_err(
-            errinfo, "Array specifier missing matching left angle bracket"
-          );
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // if no array size and not the first array specifier, error
-        // note: mildly nonconforming since actual compilers only allow this
-        // if a multidimensional array is declared as a function parameter
-        if (!array_size && n_specs) {
-          pdxcp_cdcl_write_parse_err(
-            errinfo,
-            "Multidimensional array specifier must have bounds for all "
-            "dimensions except for the first"
-          );
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // write array specifier (may or may not have size)
-        if (fprintf(out, " array[") < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        if (array_size && fprintf(out, "%zu", array_size) < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        if (fprintf(out, "] of") < 0)
-          return pdxcp_cdcl_parser_status_out_err;
-        // matched. reset, and increment number of array specifiers read
-        unmatched_langle = false;
-        array_size = 0;
-        n_specs++;
-        break;
-      // if semicolon, we will break from the loop at end of block
-      case pdxcp_cdcl_token_type_semicolon:
-        break;
-      // other tokens. these are errors (e.g. can't have function return array)
-      default: {
-        char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-        snprintf(
-          errmsg,
-          sizeof errmsg - 1,
-          "Unexpected token type %s with text \"%s\" when parsing array specifiers",
-          // TODO: nicer way to indicate the token + text?
-          pdxcp_cdcl_token_type_string(cur_token->type),
-          cur_token->text
-        );
-        errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-        pdxcp_cdcl_write_parse_err(errinfo, errmsg);
-        return pdxcp_cdcl_parser_status_parse_err;
-      }
-    }
-  }
-  while (cur_token->type != pdxcp_cdcl_token_type_semicolon);
-  // done with array specifier
-  return pdxcp_cdcl_parser_status_ok;
+  if (!(errinfo = pdxcp_cdcl_write_parse_err(errinfo, error)))
+    return;
+  errinfo->parser.token = type;
+  pdxcp_cdcl_write_err_name(errinfo, text);
 }
 
 /**
- * Pop tokens off of the token stack to handle the identifier's qualified type.
+ * Write parser error info for mismatched parentheses.
  *
- * Handles cv-qualifiers and sign qualifiers appropriately.
+ * The parser error status is `pdxcp_cdcl_parser_status_parse_err`.
  *
- * @param stack Token stack to pop from
- * @param out Output stream
- * @param errinfo Error info structure, can be `NULL`
- * @returns `pdxcp_cdcl_parser_status` parser status
+ * @param errinfo Error info structure. If `NULL`, nothing is done
+ * @param n_lparen Number of '(' read
+ * @param n_rparen Number of ')' read
  */
-static pdxcp_cdcl_parser_status
-stream_parse_type(
-  pdxcp_cdcl_token_stack *stack, FILE *out, pdxcp_cdcl_parser_errinfo *errinfo)
-{
-  // indicators for cv-qualifiers and sign
-  bool has_const = false;
-  bool has_volatile = false;
-  bool is_signed = false;
-  bool is_unsigned = false;
-  // type token. we mark the type as error so we can distinguish whether or not
-  // a type has already been read off of the token stack
-  pdxcp_cdcl_token type_token;
-  type_token.type = pdxcp_cdcl_token_type_error;
-  // pop tokens off stack to determine type and qualifiers
-  while (!PDXCP_CDCL_TOKEN_STACK_EMPTY(stack)) {
-    // switch on the token type
-    switch (PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type) {
-      // const qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_const:
-        if (has_const) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate type const qualifier");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // otherwise note const qualifier
-        has_const = true;
-        break;
-      // volatile qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_volatile:
-        if (has_volatile) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate type volatile qualifier");
-          return pdxcp_cdcl_parser_status_parse_err;
-        }
-        // otherwise note volatile qualifier
-        has_volatile = true;
+static void
+pdxcp_cdcl_write_paren_err(
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  unsigned int n_lparen,
+  unsigned int n_rparen)
+{
+  if (!(errinfo = pdxcp_cdcl_write_parse_err(
+    errinfo, pdxcp_cdcl_parser_error_paren_mismatch
+  )))
+    return;
+  errinfo->parser.n_lparen = n_lparen;
+  errinfo->parser.n_rparen = n_rparen;
+}
+
+/**
+ * Parser states.
+ *
+ * The declarator is parsed in phases, each of which consumes tokens from the
+ * input or pops them off of the token stack until it reaches a token that
+ * ends the phase. Each phase is its own loop over rule lookups, and the order
+ * of the phases is hard-coded in `stream_parse_declarator`.
+ */
+typedef enum {
+  parse_state_decl,    // tokens preceding a declaration's identifier
+  parse_state_param,   // tokens preceding a parameter's optional identifier
+  parse_state_suffix,  // token following the identifier or a grouping ')'
+  parse_state_arrays,  // tokens following a '[' starting array specifiers
+  parse_state_ptrs,    // tokens popped off the token stack for pointers
+  parse_state_type,    // tokens popped off the token stack for the type
+  parse_state_max      // number of parser states
+} parse_state;
+
+/**
+ * Parser actions.
+ */
+typedef enum {
+  parse_action_none,         // no rule, use the state's default rule
+  parse_action_error,        // unexpected token
+  parse_action_end,          // token ends the current phase
+  parse_action_push,         // push token onto the token stack
+  parse_action_push_lparen,  // push '(' unless it starts a parameter list
+  parse_action_qual,         // qualifier
+  parse_action_pointer,      // pointer
+  parse_action_type,         // type specifier
+  parse_action_langle,       // '[' starting an array specifier
+  parse_action_size,         // array size
+  parse_action_rangle,       // ']' ending an array specifier
+  parse_action_arrays,       // start of array specifiers
+  parse_action_params        // start of a parameter list
+} parse_action;
+
+/**
+ * Parser table entry.
+ *
+ * @param action `parse_action` to take
+ * @param qual For `parse_action_qual`, the `PDXCP_CDCL_QUAL_*` flag to set.
+ *  For `parse_action_type`, the sign qualifier flags the type allows.
+ * @param conflict `PDXCP_CDCL_QUAL_*` flags that conflict with `qual`
+ * @param error `pdxcp_cdcl_parser_error` for `parse_action_error` or for a
+ *  duplicate qualifier
+ * @param conflict_error `pdxcp_cdcl_parser_error` for a conflicting qualifier
+ */
+typedef struct {
+  unsigned char action;
+  unsigned char qual;
+  unsigned char conflict;
+  unsigned char error;
+  unsigned char conflict_error;
+} parse_rule;
+
+/**
+ * Parser rule with the given action.
+ *
+ * @param state `parse_state`
+ * @param type Token type
+ * @param action `parse_action` suffix, e.g. `push`
+ */
+#define PARSE_RULE(state, type, action) \
+  [parse_state_ ## state][pdxcp_cdcl_token_type_ ## type] = { \
+    parse_action_ ## action, 0, 0, 0, 0 \
+  }
+
+/**
+ * Parser rule for an unexpected token.
+ *
+ * @param state `parse_state`
+ * @param type Token type
+ * @param error `pdxcp_cdcl_parser_error` suffix, e.g. `array_token`
+ */
+#define PARSE_ERROR(state, type, error) \
+  [parse_state_ ## state][pdxcp_cdcl_token_type_ ## type] = { \
+    parse_action_error, 0, 0, pdxcp_cdcl_parser_error_ ## error, 0 \
+  }
+
+/**
+ * Parser rule for a qualifier that may not be repeated.
+ *
+ * @param state `parse_state`
+ * @param type Token type
+ * @param qual `PDXCP_CDCL_QUAL_*` flag
+ * @param error `pdxcp_cdcl_parser_error` suffix for a duplicate qualifier
+ */
+#define PARSE_QUAL(state, type, qual, error) \
+  [parse_state_ ## state][pdxcp_cdcl_token_type_ ## type] = { \
+    parse_action_qual, qual, 0, pdxcp_cdcl_parser_error_ ## error, 0 \
+  }
+
+/**
+ * Parser rule for a sign qualifier, which conflicts with the other one.
+ *
+ * @param type Token type
+ * @param qual `PDXCP_CDCL_QUAL_*` flag
+ * @param other `PDXCP_CDCL_QUAL_*` flag of the other sign qualifier
+ * @param error `pdxcp_cdcl_parser_error` suffix for a duplicate qualifier
+ * @param conflict_error `pdxcp_cdcl_parser_error` suffix for a conflict
+ */
+#define PARSE_SIGN(type, qual, other, error, conflict_error) \
+  [parse_state_type][pdxcp_cdcl_token_type_ ## type] = { \
+    parse_action_qual, \
+    qual, \
+    other, \
+    pdxcp_cdcl_parser_error_ ## error, \
+    pdxcp_cdcl_parser_error_ ## conflict_error \
+  }
+
+/**
+ * Parser rule for a type specifier.
+ *
+ * @param type Token type
+ * @param signs Sign qualifier flags the type allows
+ */
+#define PARSE_TYPE(type, signs) \
+  [parse_state_type][pdxcp_cdcl_token_type_ ## type] = { \
+    parse_action_type, signs, 0, 0, 0 \
+  }
+
+/**
+ * Sign qualifier flags.
+ */
+#define PARSE_SIGNS (PDXCP_CDCL_QUAL_SIGNED | PDXCP_CDCL_QUAL_UNSIGNED)
+
+/**
+ * Declarator grammar as a dense parser table indexed by state and token type.
+ *
+ * Only rules that differ from the state's default rule are listed. The
+ * compiler lays the table out densely so each parser step is a single lookup
+ * followed by a switch over a small set of actions.
+ */
+static const parse_rule parse_table[parse_state_max][pdxcp_cdcl_token_type_max] = {
+  // everything preceding the identifier is pushed
+  PARSE_RULE(decl, iden, end),
+  // the identifier may be omitted, so only tokens that may precede it are
+  // pushed. '(' is for grouping unless it starts a parameter list
+  PARSE_RULE(param, lparen, push_lparen),
+  PARSE_RULE(param, star, push),
+  PARSE_RULE(param, struct, push),
+  PARSE_RULE(param, enum, push),
+  PARSE_RULE(param, q_const, push),
+  PARSE_RULE(param, q_volatile, push),
+  PARSE_RULE(param, q_signed, push),
+  PARSE_RULE(param, q_unsigned, push),
+  PARSE_RULE(param, t_void, push),
+  PARSE_RULE(param, t_char, push),
+  PARSE_RULE(param, t_int, push),
+  PARSE_RULE(param, t_long, push),
+  PARSE_RULE(param, t_float, push),
+  PARSE_RULE(param, t_double, push),
+  PARSE_RULE(param, t_name, push),
+  // suffixes bind tighter than pointers
+  PARSE_RULE(suffix, langle, arrays),
+  PARSE_RULE(suffix, lparen, params),
+  // array specifiers. an array of functions cannot be declared
+  PARSE_RULE(arrays, langle, langle),
+  PARSE_RULE(arrays, num, size),
+  PARSE_RULE(arrays, rangle, rangle),
+  PARSE_ERROR(arrays, lparen, array_token),
+  // pointers and their cv-qualifiers
+  PARSE_QUAL(ptrs, q_const, PDXCP_CDCL_QUAL_CONST, ptr_dup_const),
+  PARSE_QUAL(ptrs, q_volatile, PDXCP_CDCL_QUAL_VOLATILE, ptr_dup_volatile),
+  PARSE_RULE(ptrs, star, pointer),
+  // type specifier with its cv-qualifiers and sign qualifiers
+  PARSE_QUAL(type, q_const, PDXCP_CDCL_QUAL_CONST, type_dup_const),
+  PARSE_QUAL(type, q_volatile, PDXCP_CDCL_QUAL_VOLATILE, type_dup_volatile),
+  PARSE_SIGN(
+    q_signed,
+    PDXCP_CDCL_QUAL_SIGNED,
+    PDXCP_CDCL_QUAL_UNSIGNED,
+    type_dup_signed,
+    type_signed_unsigned
+  ),
+  PARSE_SIGN(
+    q_unsigned,
+    PDXCP_CDCL_QUAL_UNSIGNED,
+    PDXCP_CDCL_QUAL_SIGNED,
+    type_dup_unsigned,
+    type_unsigned_signed
+  ),
+  PARSE_TYPE(struct, 0),
+  PARSE_TYPE(enum, 0),
+  PARSE_TYPE(t_void, 0),
+  PARSE_TYPE(t_char, PARSE_SIGNS),
+  PARSE_TYPE(t_int, PARSE_SIGNS),
+  PARSE_TYPE(t_long, PARSE_SIGNS),
+  PARSE_TYPE(t_float, 0),
+  PARSE_TYPE(t_double, 0),
+  PARSE_TYPE(t_name, 0)
+};
+
+/**
+ * Default parser rules for tokens without a rule in the parser table.
+ */
+static const parse_rule parse_defaults[parse_state_max] = {
+  [parse_state_decl] = {parse_action_push, 0, 0, 0, 0},
+  [parse_state_param] = {parse_action_end, 0, 0, 0, 0},
+  [parse_state_suffix] = {parse_action_end, 0, 0, 0, 0},
+  [parse_state_arrays] = {parse_action_end, 0, 0, 0, 0},
+  [parse_state_ptrs] = {parse_action_end, 0, 0, 0, 0},
+  [parse_state_type] = {
+    parse_action_error, 0, 0, pdxcp_cdcl_parser_error_type_token, 0
+  }
+};
+
+/**
+ * Return the parser rule for the given state and token type.
+ *
+ * @param state `parse_state`
+ * @param type Token type
+ */
+static const parse_rule *
+parse_lookup(parse_state state, pdxcp_cdcl_token_type type)
+{
+  const parse_rule *rule = &parse_table[state][type];
+  return (rule->action == parse_action_none) ? &parse_defaults[state] : rule;
+}
+
+/**
+ * Apply a qualifier rule to a set of qualifier flags.
+ *
+ * On error the error info is also written.
+ *
+ * @param errinfo Error info structure, can be `NULL`
+ * @param rule Parser rule with `parse_action_qual` action
+ * @param quals Address of the `PDXCP_CDCL_QUAL_*` flags to update
+ * @returns `true` on success, `false` on duplicate or conflicting qualifier
+ */
+static bool
+parse_qual(
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  const parse_rule *rule,
+  unsigned int *quals)
+{
+  if (*quals & rule->qual) {
+    pdxcp_cdcl_write_parse_err(errinfo, rule->error);
+    return false;
+  }
+  if (*quals & rule->conflict) {
+    pdxcp_cdcl_write_parse_err(errinfo, rule->conflict_error);
+    return false;
+  }
+  *quals |= rule->qual;
+  return true;
+}
+
+/**
+ * Check if a token type is a type specifier or qualifier.
+ *
+ * @param type Token type
+ */
+#define PARSE_IS_SPECIFIER(type) \
+  (parse_table[parse_state_type][type].action != parse_action_none)
+
+/**
+ * Check if a token type is a type specifier or sign qualifier.
+ *
+ * Unlike cv-qualifiers, these cannot precede a typedef name used as a type.
+ *
+ * @param type Token type
+ */
+#define PARSE_IS_TYPE_SPECIFIER(type) \
+  ( \
+    parse_table[parse_state_type][type].action == parse_action_type || \
+    (parse_table[parse_state_type][type].qual & PARSE_SIGNS) \
+  )
+
+/**
+ * Declaration parsing context.
+ *
+ * The parser reads the input stream exactly once with at most one token of
+ * lookahead, which is only needed to tell a grouping '(' from the '(' that
+ * starts the parameter list of an abstract function declarator.
+ *
+ * @param in Input stream, only used if `buf` is `NULL`
+ * @param buf Input buffer cursor, `NULL` to read tokens from `in`
+ * @param arena Arena to allocate declaration nodes and token text from
+ * @param stack Token stack shared by the declaration and its parameters
+ * @param errinfo Error info structure, can be `NULL`
+ * @param lexer_status Status of the most recent lexer call
+ * @param token Current token
+ * @param next Lookahead token, only valid if `has_next` is `true`
+ * @param has_next `true` if a lookahead token has been read
+ * @param depth Current function parameter list nesting depth
+ * @param stats Parser statistics to accumulate into, can be `NULL`. Unused
+ *  unless `PDXCP_CDCL_ENABLE_STATS` is defined
+ * @param typedefs Typedef name table, `NULL` unless parsing is typedef-aware
+ * @param phase Phase currently being timed, `pdxcp_cdcl_parser_phase_max` if
+ *  none is being timed
+ * @param mark Time in nanoseconds at which `phase` was last entered
+ */
+typedef struct {
+  FILE *in;
+  pdxcp_cdcl_lexer_buf *buf;
+  pdxcp_arena *arena;
+  pdxcp_cdcl_token_stack *stack;
+  pdxcp_cdcl_parser_errinfo *errinfo;
+  pdxcp_cdcl_lexer_status lexer_status;
+  pdxcp_cdcl_token token;
+  pdxcp_cdcl_token next;
+  bool has_next;
+  unsigned int depth;
+  pdxcp_cdcl_parser_stats *stats;
+  pdxcp_cdcl_parser_phase phase;
+  uint64_t mark;
+  pdxcp_cdcl_typedefs *typedefs;
+} stream_parse_ctx;
+
+/**
+ * Initialize a declaration parsing context.
+ *
+ * The token stack is also initialized to empty.
+ *
+ * @param ctx Parsing context to initialize
+ * @param in Input stream, only used if `buf` is `NULL`
+ * @param buf Input buffer cursor, `NULL` to read tokens from `in`
+ * @param arena Arena to allocate declaration nodes and token text from
+ * @param stack Token stack
+ * @param errinfo Error info structure, can be `NULL`
+ * @param stats Parser statistics to accumulate into, can be `NULL`
+ * @param typedefs Typedef name table, `NULL` unless parsing is typedef-aware
+ */
+static void
+stream_parse_ctx_init(
+  stream_parse_ctx *ctx,
+  FILE *in,
+  pdxcp_cdcl_lexer_buf *buf,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_token_stack *stack,
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  pdxcp_cdcl_parser_stats *stats,
+  pdxcp_cdcl_typedefs *typedefs)
+{
+  PDXCP_CDCL_TOKEN_STACK_INIT(stack);
+  ctx->in = in;
+  ctx->buf = buf;
+  ctx->arena = arena;
+  ctx->stack = stack;
+  ctx->errinfo = errinfo;
+  ctx->has_next = false;
+  ctx->depth = 0;
+  ctx->stats = stats;
+  ctx->phase = pdxcp_cdcl_parser_phase_max;
+  ctx->mark = 0;
+  ctx->typedefs = typedefs;
+}
+
+#if defined(PDXCP_CDCL_ENABLE_STATS)
+/**
+ * Return the current monotonic time in nanoseconds.
+ */
+static uint64_t
+stream_parse_now(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * Switch the phase being timed.
+ *
+ * The time since the current phase was entered is charged to it, so phase
+ * times are exclusive of any phases nested in them.
+ *
+ * @param ctx Parsing context with non-`NULL` statistics
+ * @param phase Phase to enter, `pdxcp_cdcl_parser_phase_max` for none
+ * @returns Phase that was being timed
+ */
+static pdxcp_cdcl_parser_phase
+stream_parse_enter(stream_parse_ctx *ctx, pdxcp_cdcl_parser_phase phase)
+{
+  pdxcp_cdcl_parser_phase prev = ctx->phase;
+  uint64_t now = stream_parse_now();
+  if (prev != pdxcp_cdcl_parser_phase_max)
+    ctx->stats->phase_ns[prev] += now - ctx->mark;
+  ctx->phase = phase;
+  ctx->mark = now;
+  return prev;
+}
+
+/**
+ * Assign the status returned by a parser phase call, timing the call.
+ *
+ * @param ctx Parsing context
+ * @param phase Phase the call is charged to
+ * @param status Status variable to assign to
+ * @param call Phase function call expression
+ */
+#define STREAM_PARSE_TIMED(ctx, phase, status, call) \
+  do { \
+    if ((ctx)->stats) { \
+      pdxcp_cdcl_parser_phase prev_phase_ = stream_parse_enter(ctx, phase); \
+      status = call; \
+      stream_parse_enter(ctx, prev_phase_); \
+    } \
+    else \
+      status = call; \
+  } \
+  while (false)
+
+/**
+ * Count a successfully lexed token.
+ *
+ * @param ctx Parsing context
+ */
+#define STREAM_PARSE_COUNT_TOKEN(ctx) \
+  do { \
+    if ((ctx)->stats) \
+      (ctx)->stats->n_tokens++; \
+  } \
+  while (false)
+
+/**
+ * Update the maximum token stack depth after a push.
+ *
+ * @param ctx Parsing context
+ */
+#define STREAM_PARSE_UPDATE_DEPTH(ctx) \
+  do { \
+    if ((ctx)->stats && (ctx)->stack->n_tokens > (ctx)->stats->max_depth) \
+      (ctx)->stats->max_depth = (ctx)->stack->n_tokens; \
+  } \
+  while (false)
+#else
+#define STREAM_PARSE_TIMED(ctx, phase, status, call) status = call
+#define STREAM_PARSE_COUNT_TOKEN(ctx) ((void) 0)
+#define STREAM_PARSE_UPDATE_DEPTH(ctx) ((void) 0)
+#endif  // !defined(PDXCP_CDCL_ENABLE_STATS)
+
+/**
+ * Read a token from the input stream or input buffer.
+ *
+ * If parsing is typedef-aware, identifiers in the typedef name table are
+ * returned as `pdxcp_cdcl_token_type_t_name` tokens. On lexer error the error
+ * info is also written.
+ *
+ * @param ctx Parsing context
+ * @param token Token to write to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_lex(stream_parse_ctx *ctx, pdxcp_cdcl_token *token)
+{
+  ctx->lexer_status = (ctx->buf) ?
+    pdxcp_cdcl_get_token_buf(ctx->buf, token) :
+    pdxcp_cdcl_get_token(ctx->in, token);
+  if (!PDXCP_CDCL_LEXER_OK(ctx->lexer_status)) {
+    pdxcp_cdcl_write_lexer_err(ctx->errinfo, ctx->lexer_status, token);
+    return pdxcp_cdcl_parser_status_lexer_err;
+  }
+  if (
+    ctx->typedefs && token->type == pdxcp_cdcl_token_type_iden &&
+    pdxcp_cdcl_typedefs_find(ctx->typedefs, token->text)
+  )
+    token->type = pdxcp_cdcl_token_type_t_name;
+  STREAM_PARSE_COUNT_TOKEN(ctx);
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Advance to the next token, consuming the lookahead token if any.
+ *
+ * On lexer error the error info is also written.
+ *
+ * @param ctx Parsing context
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_advance(stream_parse_ctx *ctx)
+{
+  if (ctx->has_next) {
+    ctx->token = ctx->next;
+    ctx->has_next = false;
+    return pdxcp_cdcl_parser_status_ok;
+  }
+  return stream_parse_lex(ctx, &ctx->token);
+}
+
+/**
+ * Read the lookahead token if it has not already been read.
+ *
+ * On lexer error the error info is also written.
+ *
+ * @param ctx Parsing context
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_peek(stream_parse_ctx *ctx)
+{
+  if (ctx->has_next)
+    return pdxcp_cdcl_parser_status_ok;
+  pdxcp_cdcl_parser_status status = stream_parse_lex(ctx, &ctx->next);
+  ctx->has_next = PDXCP_CDCL_PARSER_OK(status);
+  return status;
+}
+
+/**
+ * Push tokens onto the token stack until the identifier is reached.
+ *
+ * Pushing starts with the current token. For a top-level declaration tokens
+ * are pushed until an identifier is read. For a parameter declaration, which
+ * may be abstract, pushing also stops at the first token that cannot precede
+ * the identifier, e.g. `,`, `)`, `[`, or a `(` starting a parameter list.
+ *
+ * A typedef name following a type specifier or sign qualifier is not a type
+ * but the identifier, e.g. the second `T` in `T T;`, so it is turned back
+ * into one.
+ *
+ * On success the current token is the identifier if there is one, otherwise
+ * the first token following the abstract declarator's prefix.
+ *
+ * @param ctx Parsing context
+ * @param is_param `true` if parsing a parameter declaration
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_to_iden(stream_parse_ctx *ctx, bool is_param)
+{
+  pdxcp_cdcl_parser_status status;
+  parse_state state = (is_param) ? parse_state_param : parse_state_decl;
+  bool has_type = false;
+  while (true) {
+    if (ctx->token.type == pdxcp_cdcl_token_type_t_name && has_type)
+      ctx->token.type = pdxcp_cdcl_token_type_iden;
+    switch (parse_lookup(state, ctx->token.type)->action) {
+      // token precedes the identifier
+      case parse_action_push:
+        break;
+      // '(' is for grouping unless it starts a parameter list, e.g. int (int)
+      case parse_action_push_lparen:
+        if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_peek(ctx)))
+          return status;
+        if (
+          ctx->next.type == pdxcp_cdcl_token_type_rparen ||
+          PARSE_IS_SPECIFIER(ctx->next.type)
+        )
+          return pdxcp_cdcl_parser_status_ok;
+        break;
+      // identifier or, for an abstract declarator, the end of its prefix
+      default:
+        return pdxcp_cdcl_parser_status_ok;
+    }
+    // push the token and continue. stack grows as needed
+    if (!pdxcp_cdcl_token_stack_push(ctx->stack, ctx->arena, &ctx->token)) {
+      pdxcp_cdcl_write_no_mem_err(ctx->errinfo);
+      return pdxcp_cdcl_parser_status_no_mem;
+    }
+    STREAM_PARSE_UPDATE_DEPTH(ctx);
+    if (PARSE_IS_TYPE_SPECIFIER(ctx->token.type))
+      has_type = true;
+    if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+      return status;
+  }
+}
+
+/**
+ * Pop tokens off of the token stack to handle pointers in the declarator.
+ *
+ * Also handles cv-qualifiers for the pointers. Popping stops at the first
+ * token that is not part of a pointer, e.g. a '(' that groups the declarator.
+ *
+ * @param ctx Parsing context
+ * @param builder Declaration node list builder to append pointer nodes to
+ * @param base Number of tokens on the stack that belong to enclosing
+ *  declarations and must not be popped
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_ptrs(stream_parse_ctx *ctx, decl_builder *builder, size_t base)
+{
+  pdxcp_cdcl_token_stack *stack = ctx->stack;
+  // cv-qualifiers for the next pointer
+  unsigned int quals = 0;
+  // pop tokens off stack
+  while (stack->n_tokens > base) {
+    const pdxcp_cdcl_token_handle *head = PDXCP_CDCL_TOKEN_STACK_HEAD(stack);
+    const parse_rule *rule = parse_lookup(parse_state_ptrs, head->type);
+    switch (rule->action) {
+      // cv-qualifier, only one of each allowed
+      case parse_action_qual:
+        if (!parse_qual(ctx->errinfo, rule, &quals))
+          return pdxcp_cdcl_parser_status_parse_err;
         break;
-      // signed qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_signed:
-        if (is_signed) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate signed type qualifier");
+      // pointer. add pointer node with its cv-qualification
+      case parse_action_pointer: {
+        pdxcp_cdcl_decl_node *node = decl_builder_add(
+          builder, pdxcp_cdcl_decl_kind_pointer, ctx->errinfo
+        );
+        if (!node)
+          return pdxcp_cdcl_parser_status_no_mem;
+        node->quals = quals;
+        quals = 0;
+        break;
+      }
+      // end of pointers. if there are cv-qualifiers without a pointer, then
+      // definitely this is a parse error, otherwise assume success
+      default:
+        if (quals) {
+          pdxcp_cdcl_write_token_err(
+            ctx->errinfo,
+            pdxcp_cdcl_parser_error_ptr_token,
+            head->type,
+            head->text
+          );
           return pdxcp_cdcl_parser_status_parse_err;
         }
-        if (is_unsigned) {
+        return pdxcp_cdcl_parser_status_ok;
+    }
+    // done with token so pop from stack
+    PDXCP_CDCL_TOKEN_STACK_POP(stack);
+  }
+  // if stack is empty, we are missing tokens, e.g. type, etc.
+  pdxcp_cdcl_write_parse_err(ctx->errinfo, pdxcp_cdcl_parser_error_ptr_no_type);
+  return pdxcp_cdcl_parser_status_parse_err;
+}
+
+/**
+ * Parse array specifiers following a declarator.
+ *
+ * @note A multidimensional array declaration is allowed to omit the size for
+ *  the first dimension, but only if declared as a function parameter. This
+ *  function is slightly noncompliant by allowing a non-parameter array
+ *  declaration to omit the size for the first dimension.
+ *
+ * A precondition for calling this function is that the current token is a
+ * left bracket. On success the current token is the first token following
+ * the last array specifier.
+ *
+ * @param ctx Parsing context
+ * @param builder Declaration node list builder to append array nodes to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_arrays(stream_parse_ctx *ctx, decl_builder *builder)
+{
+  pdxcp_cdcl_parser_status status;
+  // internal error if current token is not left bracket
+  if (ctx->token.type != pdxcp_cdcl_token_type_langle) {
+    pdxcp_cdcl_write_parse_err(
+      ctx->errinfo, pdxcp_cdcl_parser_error_array_internal
+    );
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // indicate if unmatched left angle bracket was read
+  bool unmatched_langle = true;
+  // array size. since it cannot be zero, we use zero to indicate no size
+  size_t array_size = 0;
+  // number of array specifiers read. only first dimension can have no size,
+  // but this is actually only true if this decl is a function parameter
+  unsigned int n_specs = 0;
+  // consume tokens until the token following the last array specifier
+  while (true) {
+    if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+      return status;
+    const parse_rule *rule = parse_lookup(parse_state_arrays, ctx->token.type);
+    switch (rule->action) {
+      // left bracket
+      case parse_action_langle:
+        // if already have a left one, mismatch
+        if (unmatched_langle) {
           pdxcp_cdcl_write_parse_err(
-            errinfo,
-            "Type already qualified as unsigned, cannot re-qualify as signed"
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_dup_langle
           );
           return pdxcp_cdcl_parser_status_parse_err;
         }
-        // otherwise note signed qualifier
-        is_signed = true;
+        // otherwise, unmatched
+        unmatched_langle = true;
         break;
-      // unsigned qualifier, only one allowed
-      case pdxcp_cdcl_token_type_q_unsigned:
-        if (is_unsigned) {
-          pdxcp_cdcl_write_parse_err(errinfo, "Duplicate unsigned type qualifier");
+      // integral value giving array size
+      case parse_action_size: {
+        // if no unmatched left bracket, error
+        if (!unmatched_langle) {
+          pdxcp_cdcl_write_parse_err(
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_size_no_langle
+          );
           return pdxcp_cdcl_parser_status_parse_err;
         }
-        if (is_signed) {
+        // convert text to array size (handles hex and octal). note that since
+        // we know it will be a number, 0 is not considered an error return
+        long value = strtol(ctx->token.text, NULL, 0);
+        // out of range errors
+        if (value == LONG_MIN || value == LONG_MAX) {
           pdxcp_cdcl_write_parse_err(
-            errinfo,
-            "Type already qualified as signed, cannot re-quaifiy as unsigned"
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_size_range
           );
           return pdxcp_cdcl_parser_status_parse_err;
         }
-        // otherwise note unsigned qualifier
-        is_unsigned = true;
+        // size cannot be zero or negative
+        if (value == 0) {
+          pdxcp_cdcl_write_parse_err(
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_size_zero
+          );
+          return pdxcp_cdcl_parser_status_parse_err;
+        }
+        if (value < 0) {
+          pdxcp_cdcl_write_parse_err(
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_size_negative
+          );
+          return pdxcp_cdcl_parser_status_parse_err;
+        }
+        // valid array size
+        array_size = (size_t) value;
+        break;
+      }
+      // right bracket
+      case parse_action_rangle: {
+        // if no unmatched left bracket, mismatch
+        if (!unmatched_langle) {
+          pdxcp_cdcl_write_parse_err(
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_no_langle
+          );
+          return pdxcp_cdcl_parser_status_parse_err;
+        }
+        // if no array size and not the first array specifier, error
+        // note: mildly nonconforming since actual compilers only allow this
+        // if a multidimensional array is declared as a function parameter
+        if (!array_size && n_specs) {
+          pdxcp_cdcl_write_parse_err(
+            ctx->errinfo, pdxcp_cdcl_parser_error_array_no_bounds
+          );
+          return pdxcp_cdcl_parser_status_parse_err;
+        }
+        // add array node (may or may not have size)
+        pdxcp_cdcl_decl_node *node = decl_builder_add(
+          builder, pdxcp_cdcl_decl_kind_array, ctx->errinfo
+        );
+        if (!node)
+          return pdxcp_cdcl_parser_status_no_mem;
+        node->size = array_size;
+        // matched. reset, and increment number of array specifiers read
+        unmatched_langle = false;
+        array_size = 0;
+        n_specs++;
+        break;
+      }
+      // unexpected token, e.g. '(' as an array of functions cannot be declared
+      case parse_action_error:
+        pdxcp_cdcl_write_token_err(
+          ctx->errinfo, rule->error, ctx->token.type, ctx->token.text
+        );
+        return pdxcp_cdcl_parser_status_parse_err;
+      // other tokens. these end the array specifiers unless inside of one
+      default:
+        if (unmatched_langle) {
+          pdxcp_cdcl_write_token_err(
+            ctx->errinfo,
+            pdxcp_cdcl_parser_error_array_token,
+            ctx->token.type,
+            ctx->token.text
+          );
+          return pdxcp_cdcl_parser_status_parse_err;
+        }
+        return pdxcp_cdcl_parser_status_ok;
+    }
+  }
+}
+
+static pdxcp_cdcl_parser_status
+stream_parse_declarator(
+  stream_parse_ctx *ctx,
+  pdxcp_cdcl_decl *decl,
+  bool is_param,
+  unsigned int *n_groups);
+
+/**
+ * Parse a function parameter list following a declarator.
+ *
+ * Each parameter is a full declaration that may be abstract, i.e. have no
+ * identifier, and is parsed recursively. Recursion only happens for nested
+ * parameter lists and is limited to `PDXCP_CDCL_PARSER_MAX_DEPTH` levels.
+ *
+ * A precondition for calling this function is that the current token is the
+ * left parenthesis starting the parameter list. On success the current token
+ * is the first token following the closing right parenthesis.
+ *
+ * @param ctx Parsing context
+ * @param builder Declaration node list builder to append function node to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_params(stream_parse_ctx *ctx, decl_builder *builder)
+{
+  pdxcp_cdcl_parser_status status;
+  // limit nesting so the C call stack stays bounded
+  if (ctx->depth == PDXCP_CDCL_PARSER_MAX_DEPTH) {
+    pdxcp_cdcl_write_parse_err(
+      ctx->errinfo, pdxcp_cdcl_parser_error_params_depth
+    );
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // add function node + read first token of the parameter list
+  pdxcp_cdcl_decl_node *node = decl_builder_add(
+    builder, pdxcp_cdcl_decl_kind_function, ctx->errinfo
+  );
+  if (!node)
+    return pdxcp_cdcl_parser_status_no_mem;
+  if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+    return status;
+  // parse parameters unless parameter list is empty
+  pdxcp_cdcl_decl **tail = &node->params;
+  while (ctx->token.type != pdxcp_cdcl_token_type_rparen) {
+    pdxcp_cdcl_decl *param = pdxcp_arena_alloc(ctx->arena, sizeof *param);
+    if (!param) {
+      pdxcp_cdcl_write_no_mem_err(ctx->errinfo);
+      return pdxcp_cdcl_parser_status_no_mem;
+    }
+    // parse parameter declaration and link into parameter list
+    unsigned int n_groups;
+    ctx->depth++;
+    status = stream_parse_declarator(ctx, param, true, &n_groups);
+    ctx->depth--;
+    if (!PDXCP_CDCL_PARSER_OK(status))
+      return status;
+    *tail = param;
+    tail = &param->next;
+    // ')' ends the list, ',' separates parameters so another must follow
+    if (ctx->token.type == pdxcp_cdcl_token_type_rparen)
+      break;
+    if (ctx->token.type == pdxcp_cdcl_token_type_comma) {
+      if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+        return status;
+      if (ctx->token.type != pdxcp_cdcl_token_type_rparen)
+        continue;
+    }
+    pdxcp_cdcl_write_token_err(
+      ctx->errinfo,
+      pdxcp_cdcl_parser_error_params_token,
+      ctx->token.type,
+      ctx->token.text
+    );
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // void is only allowed as the sole unnamed parameter, e.g. int f(void)
+  const pdxcp_cdcl_decl *param;
+  for (param = node->params; param; param = param->next) {
+    const pdxcp_cdcl_decl_node *head = param->node;
+    if (
+      head->kind == pdxcp_cdcl_decl_kind_type &&
+      head->type == pdxcp_cdcl_token_type_t_void &&
+      (param->iden || head->quals || param != node->params || param->next)
+    ) {
+      pdxcp_cdcl_write_parse_err(
+        ctx->errinfo, pdxcp_cdcl_parser_error_params_void
+      );
+      return pdxcp_cdcl_parser_status_parse_err;
+    }
+  }
+  // read token following ')'. what the function returns is checked once the
+  // whole declarator has been unwound, see decl_check_nodes
+  return stream_parse_advance(ctx);
+}
+
+/**
+ * Pop tokens off of the token stack to handle the identifier's qualified type.
+ *
+ * Handles cv-qualifiers and sign qualifiers appropriately.
+ *
+ * @param ctx Parsing context
+ * @param builder Declaration node list builder to append the type node to
+ * @param base Number of tokens on the stack that belong to enclosing
+ *  declarations and must not be popped
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_type(stream_parse_ctx *ctx, decl_builder *builder, size_t base)
+{
+  pdxcp_cdcl_token_stack *stack = ctx->stack;
+  pdxcp_cdcl_parser_errinfo *errinfo = ctx->errinfo;
+  // cv-qualifiers and sign qualifiers
+  unsigned int quals = 0;
+  // type token. we mark the type as error so we can distinguish whether or not
+  // a type has already been read off of the token stack
+  pdxcp_cdcl_token_handle type_token;
+  type_token.type = pdxcp_cdcl_token_type_error;
+  // sign qualifiers allowed by the type
+  unsigned int signs = 0;
+  // pop tokens off stack to determine type and qualifiers
+  while (stack->n_tokens > base) {
+    const pdxcp_cdcl_token_handle *head = PDXCP_CDCL_TOKEN_STACK_HEAD(stack);
+    const parse_rule *rule = parse_lookup(parse_state_type, head->type);
+    switch (rule->action) {
+      // qualifier, only one of each allowed and signed excludes unsigned
+      case parse_action_qual:
+        if (!parse_qual(errinfo, rule, &quals))
+          return pdxcp_cdcl_parser_status_parse_err;
         break;
       // fill type token when a type is specified
-      case pdxcp_cdcl_token_type_struct:
-      case pdxcp_cdcl_token_type_enum:
-      case pdxcp_cdcl_token_type_t_void:
-      case pdxcp_cdcl_token_type_t_char:
-      case pdxcp_cdcl_token_type_t_int:
-      case pdxcp_cdcl_token_type_t_long:
-      case pdxcp_cdcl_token_type_t_float:
-      case pdxcp_cdcl_token_type_t_double:
+      case parse_action_type:
         // if already parsed a type, error
         if (type_token.type != pdxcp_cdcl_token_type_error) {
-          // format message
-          char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-          snprintf(
-            errmsg,
-            sizeof errmsg - 1,
-            "Type %s provided when identifier already specified as %s",
-            // TODO: add function that C type string from enum token type
-            pdxcp_cdcl_token_type_string(PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type),
-            pdxcp_cdcl_token_type_string(type_token.type)
-          );
-          errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-          // write result into error info
-          pdxcp_cdcl_write_parse_err(errinfo, errmsg);
+          if (pdxcp_cdcl_write_parse_err(
+            errinfo, pdxcp_cdcl_parser_error_type_redefined
+          )) {
+            errinfo->parser.token = head->type;
+            errinfo->parser.type = type_token.type;
+          }
           return pdxcp_cdcl_parser_status_parse_err;
         }
-        // otherwise, copy token type and text
-        type_token.type = PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type;
-        strcpy(type_token.text, PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->text);
+        // otherwise, copy token handle. text lives in the arena
+        type_token = *head;
+        signs = rule->qual;
         break;
       // unknown token
-      default: {
-        // format message
-        char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-        snprintf(
-          errmsg,
-          sizeof errmsg - 1,
-          "Unexpected token type %s with text \"%s\" when parsing identifier type",
-          // TODO: nicer way to indicate the token + text?
-          pdxcp_cdcl_token_type_string(PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type),
-          PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->text
-        );
-        errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-        // write result into error info
-        pdxcp_cdcl_write_parse_err(errinfo, errmsg);
+      default:
+        pdxcp_cdcl_write_token_err(errinfo, rule->error, head->type, head->text);
         return pdxcp_cdcl_parser_status_parse_err;
-      }
     }
     // done with token so pop from stack
     PDXCP_CDCL_TOKEN_STACK_POP(stack);
   }
-  // if no type, we ran out of tokens
-  if (type_token.type == pdxcp_cdcl_token_type_error)  {
-    pdxcp_cdcl_write_parse_err(errinfo, "Identifier missing required type");
-    return pdxcp_cdcl_parser_status_parse_err;
+  // if no type, we ran out of tokens
+  if (type_token.type == pdxcp_cdcl_token_type_error)  {
+    pdxcp_cdcl_write_parse_err(errinfo, pdxcp_cdcl_parser_error_type_missing);
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // check sign qualifiers against those the type allows
+  if (quals & PARSE_SIGNS & ~signs) {
+    if (pdxcp_cdcl_write_parse_err(
+      errinfo, pdxcp_cdcl_parser_error_type_bad_sign
+    ))
+      errinfo->parser.token = type_token.type;
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // add type node with its qualifiers
+  pdxcp_cdcl_decl_node *node = decl_builder_add(
+    builder, pdxcp_cdcl_decl_kind_type, errinfo
+  );
+  if (!node)
+    return pdxcp_cdcl_parser_status_no_mem;
+  node->type = type_token.type;
+  node->quals = quals;
+  // struct + enum tags and typedef names are already in the arena
+  switch (type_token.type) {
+    case pdxcp_cdcl_token_type_struct:
+    case pdxcp_cdcl_token_type_enum:
+    case pdxcp_cdcl_token_type_t_name:
+      node->name = type_token.text;
+      break;
+    default:
+      break;
+  }
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+
+/**
+ * Check that the layers of a parsed declaration can be composed.
+ *
+ * Functions cannot return arrays or functions and arrays cannot hold
+ * functions. This is checked on the finished node list instead of on the
+ * tokens following a parameter list, since grouping parentheses can separate
+ * the two, e.g. `int (f(void))[3]`.
+ *
+ * @param errinfo Error info structure, can be `NULL`
+ * @param decl Parsed declaration
+ * @returns `true` if the declaration is valid, `false` otherwise
+ */
+static bool
+decl_check_nodes(
+  pdxcp_cdcl_parser_errinfo *errinfo, const pdxcp_cdcl_decl *decl)
+{
+  for (
+    const pdxcp_cdcl_decl_node *node = decl->node;
+    node && node->next;
+    node = node->next
+  ) {
+    pdxcp_cdcl_parser_error error = pdxcp_cdcl_parser_error_none;
+    if (node->kind == pdxcp_cdcl_decl_kind_function) {
+      if (node->next->kind == pdxcp_cdcl_decl_kind_array)
+        error = pdxcp_cdcl_parser_error_return_array;
+      else if (node->next->kind == pdxcp_cdcl_decl_kind_function)
+        error = pdxcp_cdcl_parser_error_return_function;
+    }
+    else if (
+      node->kind == pdxcp_cdcl_decl_kind_array &&
+      node->next->kind == pdxcp_cdcl_decl_kind_function
+    )
+      error = pdxcp_cdcl_parser_error_array_function;
+    if (error != pdxcp_cdcl_parser_error_none) {
+      pdxcp_cdcl_write_parse_err(errinfo, error);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Parse a declarator together with its specifiers into a declaration.
+ *
+ * Tokens preceding the identifier are pushed onto the token stack. Then the
+ * declarator is unwound from the inside out: suffixes to the right, i.e.
+ * array specifiers or a parameter list, then pointers popped off the stack to
+ * the left, repeating after each grouping parenthesis pair until only the
+ * specifiers remain on the stack. Each token is pushed and popped at most once
+ * so parsing takes linear time, and grouping parentheses of any depth use the
+ * token stack instead of the C call stack.
+ *
+ * A precondition for calling this function is that the current token is the
+ * first token of the declaration. On success the current token is the first
+ * token following the declarator.
+ *
+ * @param ctx Parsing context
+ * @param decl Declaration to write parse result to
+ * @param is_param `true` if parsing a parameter declaration, which may be
+ *  abstract, i.e. have no identifier, in which case `decl->iden` is `NULL`
+ * @param n_groups Address to write number of grouping parenthesis pairs to
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_declarator(
+  stream_parse_ctx *ctx,
+  pdxcp_cdcl_decl *decl,
+  bool is_param,
+  unsigned int *n_groups)
+{
+  pdxcp_cdcl_parser_status status;
+  pdxcp_cdcl_token_stack *stack = ctx->stack;
+  // tokens below base belong to enclosing declarations
+  size_t base = stack->n_tokens;
+  *n_groups = 0;
+  // push tokens until identifier
+  STREAM_PARSE_TIMED(
+    ctx,
+    pdxcp_cdcl_parser_phase_to_iden,
+    status,
+    stream_parse_to_iden(ctx, is_param)
+  );
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  // start building the node list
+  decl->iden = NULL;
+  decl->next = NULL;
+  decl->is_typedef = false;
+  decl_builder builder;
+  decl_builder_init(&builder, ctx->arena, decl);
+  // copy identifier text into the arena if not abstract
+  if (ctx->token.type == pdxcp_cdcl_token_type_iden) {
+    if (!(decl->iden = pdxcp_arena_strdup(ctx->arena, ctx->token.text))) {
+      pdxcp_cdcl_write_no_mem_err(ctx->errinfo);
+      return pdxcp_cdcl_parser_status_no_mem;
+    }
+    if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+      return status;
+  }
+  // unwind the declarator one grouping level at a time
+  while (true) {
+    // suffixes bind tighter than pointers. a suffix following another one is
+    // parsed too so decl_check_nodes can reject e.g. a function of an array
+    bool in_suffixes = true;
+    while (in_suffixes) {
+      switch (parse_lookup(parse_state_suffix, ctx->token.type)->action) {
+        case parse_action_arrays:
+          STREAM_PARSE_TIMED(
+            ctx,
+            pdxcp_cdcl_parser_phase_arrays,
+            status,
+            stream_parse_arrays(ctx, &builder)
+          );
+          break;
+        case parse_action_params:
+          status = stream_parse_params(ctx, &builder);
+          break;
+        default:
+          in_suffixes = false;
+          break;
+      }
+      if (!PDXCP_CDCL_PARSER_OK(status))
+        return status;
+    }
+    // pointers. on success there is at least one token above base
+    STREAM_PARSE_TIMED(
+      ctx,
+      pdxcp_cdcl_parser_phase_ptrs,
+      status,
+      stream_parse_ptrs(ctx, &builder, base)
+    );
+    if (!PDXCP_CDCL_PARSER_OK(status))
+      return status;
+    // anything other than '(' starts the specifiers
+    if (PDXCP_CDCL_TOKEN_STACK_HEAD(stack)->type != pdxcp_cdcl_token_type_lparen)
+      break;
+    // '(' must be matched by ')'. count unmatched '(' for the error message
+    if (ctx->token.type != pdxcp_cdcl_token_type_rparen) {
+      unsigned int n_lparen = *n_groups;
+      const pdxcp_cdcl_token_handle *handles = PDXCP_CDCL_TOKEN_STACK_DATA(stack);
+      for (size_t i = base; i < stack->n_tokens; i++)
+        if (handles[i].type == pdxcp_cdcl_token_type_lparen)
+          n_lparen++;
+      pdxcp_cdcl_write_paren_err(ctx->errinfo, n_lparen, *n_groups);
+      return pdxcp_cdcl_parser_status_parse_err;
+    }
+    PDXCP_CDCL_TOKEN_STACK_POP(stack);
+    (*n_groups)++;
+    if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+      return status;
+  }
+  // parse cv-qualified signed/unsigned qualified type
+  STREAM_PARSE_TIMED(
+    ctx,
+    pdxcp_cdcl_parser_phase_type,
+    status,
+    stream_parse_type(ctx, &builder, base)
+  );
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  if (!decl_check_nodes(ctx->errinfo, decl))
+    return pdxcp_cdcl_parser_status_parse_err;
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Parse the tokens of a top-level declaration.
+ *
+ * EOF is reported as a lexer error wherever it is read. `stream_parse_decl`
+ * distinguishes EOF before and inside a declaration.
+ *
+ * @param ctx Parsing context initialized with `stream_parse_ctx_init`
+ * @param decl Declaration to write parse result to
+ * @param at_eof Address to write `true` to if EOF was read before any tokens,
+ *  i.e. there is no declaration left to parse, and `false` otherwise
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_decl_tokens(
+  stream_parse_ctx *ctx, pdxcp_cdcl_decl *decl, bool *at_eof)
+{
+  // read first token. EOF here means there is no declaration
+  pdxcp_cdcl_parser_status status = stream_parse_advance(ctx);
+  *at_eof = (ctx->lexer_status == pdxcp_cdcl_lexer_status_fgetc_eof);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  // typedef-aware parsing also accepts a leading typedef
+  bool is_typedef = false;
+  if (
+    ctx->typedefs && ctx->token.type == pdxcp_cdcl_token_type_iden &&
+    !strcmp(ctx->token.text, "typedef")
+  ) {
+    is_typedef = true;
+    if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+      return status;
+  }
+  // parse declarator, which must have an identifier
+  unsigned int n_groups;
+  if (!PDXCP_CDCL_PARSER_OK(
+    status = stream_parse_declarator(ctx, decl, false, &n_groups)
+  ))
+    return status;
+  // extra ')' following the declarator
+  if (ctx->token.type == pdxcp_cdcl_token_type_rparen) {
+    unsigned int n_rparen = n_groups;
+    do {
+      n_rparen++;
+      if (!PDXCP_CDCL_PARSER_OK(status = stream_parse_advance(ctx)))
+        return status;
+    }
+    while (ctx->token.type == pdxcp_cdcl_token_type_rparen);
+    pdxcp_cdcl_write_paren_err(ctx->errinfo, n_groups, n_rparen);
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // nothing we can do with this identifier if not at the end of declaration
+  if (ctx->token.type != pdxcp_cdcl_token_type_semicolon) {
+    if (pdxcp_cdcl_write_parse_err(
+      ctx->errinfo, pdxcp_cdcl_parser_error_incomplete
+    ))
+      pdxcp_cdcl_write_err_name(ctx->errinfo, decl->iden);
+    return pdxcp_cdcl_parser_status_parse_err;
+  }
+  // learn the typedef name so later declarations can use it. known names are
+  // not added so that a table that already has them is only read
+  decl->is_typedef = is_typedef;
+  if (
+    is_typedef && !pdxcp_cdcl_typedefs_find(ctx->typedefs, decl->iden) &&
+    !pdxcp_cdcl_typedefs_add(ctx->typedefs, decl->iden)
+  ) {
+    pdxcp_cdcl_write_no_mem_err(ctx->errinfo);
+    return pdxcp_cdcl_parser_status_no_mem;
+  }
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Parse a top-level declaration with an initialized parsing context.
+ *
+ * This is the implementation of `pdxcp_cdcl_parse_decl` and
+ * `pdxcp_cdcl_parse_decl_buf`. The context's token stack is supplied by the
+ * caller so that it can be reused across declarations.
+ *
+ * Reading EOF after the first token of a declaration means the input ended
+ * inside it, which is reported as `pdxcp_cdcl_parser_status_eof` instead of
+ * as the lexer's EOF status, for both streams and buffers.
+ *
+ * @param ctx Parsing context initialized with `stream_parse_ctx_init`
+ * @param decl Declaration to write parse result to
+ * @param at_eof Address to write `true` to if EOF was read before any tokens,
+ *  i.e. there is no declaration left to parse, and `false` otherwise
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+stream_parse_decl(stream_parse_ctx *ctx, pdxcp_cdcl_decl *decl, bool *at_eof)
+{
+  pdxcp_cdcl_parser_status status = stream_parse_decl_tokens(ctx, decl, at_eof);
+  if (
+    status == pdxcp_cdcl_parser_status_lexer_err && !*at_eof &&
+    ctx->lexer_status == pdxcp_cdcl_lexer_status_fgetc_eof
+  ) {
+    pdxcp_cdcl_write_errinfo(
+      ctx->errinfo,
+      ctx->lexer_status,
+      &ctx->token,
+      pdxcp_cdcl_parser_status_eof,
+      pdxcp_cdcl_parser_error_none
+    );
+    return pdxcp_cdcl_parser_status_eof;
+  }
+  return status;
+}
+
+/**
+ * Write the location of the token at which parsing failed to the error info.
+ *
+ * This is only done once parsing has failed, so locating errors costs
+ * nothing when parsing succeeds.
+ *
+ * @param ctx Parsing context the error occurred in
+ */
+static void
+stream_parse_locate_err(const stream_parse_ctx *ctx)
+{
+  pdxcp_cdcl_parser_errinfo *errinfo = ctx->errinfo;
+  if (!errinfo)
+    return;
+  // buffer cursor knows where the most recent token starts and ends
+  if (ctx->buf) {
+    errinfo->offset = (size_t) (ctx->buf->token - ctx->buf->start);
+    errinfo->span = (size_t) (ctx->buf->pos - ctx->buf->token);
+    return;
   }
-  // print out cv-qualifiers
-  if (has_const && fprintf(out, " const") < 0)
-    return pdxcp_cdcl_parser_status_out_err;
-  if (has_volatile && fprintf(out, " volatile") < 0)
-    return pdxcp_cdcl_parser_status_out_err;
-  // print out sign qualifiers
-  switch (type_token.type) {
-    // type that can have sign qualifiers
-    case pdxcp_cdcl_token_type_t_char:
-    case pdxcp_cdcl_token_type_t_int:
-    case pdxcp_cdcl_token_type_t_long:
-      if (is_signed && fprintf(out, " signed") < 0)
-        return pdxcp_cdcl_parser_status_out_err;
-      if (is_unsigned && fprintf(out, " unsigned") < 0)
-        return pdxcp_cdcl_parser_status_out_err;
-      break;
-    // unsupported type
-    default:
-      if (is_signed || is_unsigned) {
-        char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-        snprintf(
-          errmsg,
-          sizeof errmsg - 1,
-          "Only char, int, or long can be signed or unsigned, received %s",
-          // TODO: nicer way to indicate identifier type
-          pdxcp_cdcl_token_type_string(type_token.type)
-        );
-        errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-        // write result into error info
-        pdxcp_cdcl_write_parse_err(errinfo, errmsg);
-        return pdxcp_cdcl_parser_status_parse_err;
-      }
-      break;
+  // for streams only the current position is known
+  long pos = ftell(ctx->in);
+  errinfo->offset = (pos < 0) ? SIZE_MAX : (size_t) pos;
+  errinfo->span = 0;
+}
+
+/**
+ * Skip the rest of a declaration that failed to parse.
+ *
+ * Tokens are skipped until the next `;` or until EOF. Bad tokens are skipped
+ * over like any other token. Parentheses and brackets are not counted, as `;`
+ * never appears inside a valid declarator, so an unbalanced `(` or `[` in the
+ * failed declaration cannot swallow the rest of the input.
+ *
+ * If the token at which the error was detected is itself a `;`, e.g. as in
+ * `int;`, the declaration has already ended and nothing is skipped.
+ *
+ * @param ctx Parsing context the error occurred in
+ */
+static void
+stream_parse_sync(stream_parse_ctx *ctx)
+{
+  // the most recently read token is the lookahead token if there is one
+  const pdxcp_cdcl_token *last = (ctx->has_next) ? &ctx->next : &ctx->token;
+  if (ctx->lexer_status == pdxcp_cdcl_lexer_status_fgetc_eof)
+    return;
+  if (
+    PDXCP_CDCL_LEXER_OK(ctx->lexer_status) &&
+    last->type == pdxcp_cdcl_token_type_semicolon
+  )
+    return;
+  // every lexer call consumes input, so this always terminates
+  pdxcp_cdcl_token token;
+  while (true) {
+    ctx->lexer_status = (ctx->buf) ?
+      pdxcp_cdcl_get_token_buf(ctx->buf, &token) :
+      pdxcp_cdcl_get_token(ctx->in, &token);
+    if (ctx->lexer_status == pdxcp_cdcl_lexer_status_fgetc_eof)
+      return;
+    if (
+      PDXCP_CDCL_LEXER_OK(ctx->lexer_status) &&
+      token.type == pdxcp_cdcl_token_type_semicolon
+    )
+      return;
   }
-  // print out type
-  switch (type_token.type) {
+}
+
+/**
+ * Parse a single declaration from the input stream or input buffer.
+ *
+ * This is the implementation of `pdxcp_cdcl_parse_decl`,
+ * `pdxcp_cdcl_parse_decl_buf`, `pdxcp_cdcl_parser_parse_decl_buf`, and
+ * `pdxcp_cdcl_stream_parse_stats`.
+ *
+ * @param in Input stream, only used if `buf` is `NULL`
+ * @param buf Input buffer cursor, `NULL` to read tokens from `in`
+ * @param arena Arena to allocate declaration nodes and token text from
+ * @param decl Declaration to write to
+ * @param errinfo Error info structure, can be `NULL`
+ * @param stats Parser statistics to accumulate into, can be `NULL`
+ * @param typedefs Typedef name table, `NULL` unless parsing is typedef-aware
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+parse_decl(
+  FILE *in,
+  pdxcp_cdcl_lexer_buf *buf,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  pdxcp_cdcl_parser_stats *stats,
+  pdxcp_cdcl_typedefs *typedefs)
+{
+  // parse with a temporary token stack
+  pdxcp_cdcl_token_stack stack;
+  stream_parse_ctx ctx;
+  stream_parse_ctx_init(
+    &ctx, in, buf, arena, &stack, errinfo, stats, typedefs
+  );
+  bool at_eof;
+  pdxcp_cdcl_parser_status status = stream_parse_decl(&ctx, decl, &at_eof);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    stream_parse_locate_err(&ctx);
+  return status;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_decl(
+  FILE *in,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  // check input stream, arena, and output
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!arena)
+    return pdxcp_cdcl_parser_status_arena_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  return parse_decl(in, NULL, arena, decl, errinfo, NULL, NULL);
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_decl_buf(
+  pdxcp_cdcl_lexer_buf *in,
+  pdxcp_arena *arena,
+  pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  // check input buffer, arena, and output
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!arena)
+    return pdxcp_cdcl_parser_status_arena_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  return parse_decl(NULL, in, arena, decl, errinfo, NULL, NULL);
+}
+
+/**
+ * Maximum size of the stack buffer used when writing declarations.
+ *
+ * Descriptions longer than this are rendered into a temporary byte vector.
+ */
+#define PDXCP_CDCL_RENDER_STACK_SIZE 256
+
+/**
+ * Render output sink writing to either a byte vector or a fixed buffer.
+ *
+ * @param vec Byte vector to append to, if `NULL` then `buf` is used
+ * @param buf Fixed output buffer, used only if `vec` is `NULL`
+ * @param buf_size Fixed output buffer size, excluding space for a null
+ * @param len Number of bytes rendered so far, which for a fixed output
+ *  buffer may exceed `buf_size` if the output was truncated
+ * @param trim `true` to drop a leading space from the next write
+ */
+typedef struct {
+  pdxcp_bvector *vec;
+  char *buf;
+  size_t buf_size;
+  size_t len;
+  bool trim;
+} decl_render_sink;
+
+/**
+ * Write bytes to the render sink.
+ *
+ * @param sink Render sink
+ * @param s Bytes to write
+ * @param n Number of bytes to write
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+decl_render_put(decl_render_sink *sink, const char *s, size_t n)
+{
+  // nodes write a leading space, which is unwanted at the start of a parameter
+  if (sink->trim && n && *s == ' ') {
+    s++;
+    n--;
+  }
+  sink->trim = false;
+  // byte vector, so just append
+  if (sink->vec) {
+    if (!pdxcp_bvector_add_n(sink->vec, (const unsigned char *) s, n))
+      return false;
+  }
+  // fixed buffer, so copy as much as fits but count all bytes
+  else if (sink->len < sink->buf_size) {
+    size_t n_fit = sink->buf_size - sink->len;
+    memcpy(sink->buf + sink->len, s, (n < n_fit) ? n : n_fit);
+  }
+  sink->len += n;
+  return true;
+}
+
+/**
+ * Write a string literal to the render sink.
+ *
+ * @param sink Render sink
+ * @param lit String literal
+ */
+#define DECL_RENDER_PUT_LITERAL(sink, lit) \
+  decl_render_put(sink, lit, sizeof lit - 1)
+
+/**
+ * Write a null-terminated string to the render sink.
+ *
+ * @param sink Render sink
+ * @param s Null-terminated string
+ */
+#define DECL_RENDER_PUT_STRING(sink, s) decl_render_put(sink, s, strlen(s))
+
+/**
+ * Write the decimal representation of a size to the render sink.
+ *
+ * @param sink Render sink
+ * @param value Value to write
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+decl_render_put_size(decl_render_sink *sink, size_t value)
+{
+  // enough for 64-bit size_t. digits are written from the end of the buffer
+  char digits[20];
+  char *first = digits + sizeof digits;
+  do {
+    *--first = (char) ('0' + value % 10);
+    value /= 10;
+  }
+  while (value);
+  return decl_render_put(sink, first, (size_t) (digits + sizeof digits - first));
+}
+
+/**
+ * Write the English description of a qualified base type.
+ *
+ * @param sink Render sink
+ * @param node Type declaration node
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+decl_render_type_node(decl_render_sink *sink, const pdxcp_cdcl_decl_node *node)
+{
+  // write cv-qualifiers
+  if (
+    (node->quals & PDXCP_CDCL_QUAL_CONST) &&
+    !DECL_RENDER_PUT_LITERAL(sink, " const")
+  )
+    return pdxcp_cdcl_parser_status_no_mem;
+  if (
+    (node->quals & PDXCP_CDCL_QUAL_VOLATILE) &&
+    !DECL_RENDER_PUT_LITERAL(sink, " volatile")
+  )
+    return pdxcp_cdcl_parser_status_no_mem;
+  // write sign qualifiers
+  if (
+    (node->quals & PDXCP_CDCL_QUAL_SIGNED) &&
+    !DECL_RENDER_PUT_LITERAL(sink, " signed")
+  )
+    return pdxcp_cdcl_parser_status_no_mem;
+  if (
+    (node->quals & PDXCP_CDCL_QUAL_UNSIGNED) &&
+    !DECL_RENDER_PUT_LITERAL(sink, " unsigned")
+  )
+    return pdxcp_cdcl_parser_status_no_mem;
+  // write type
+  bool put_ok;
+  switch (node->type) {
     // struct + enum
     case pdxcp_cdcl_token_type_struct:
-      if (fprintf(out, " struct %s", type_token.text) < 0)
-        return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " struct ") &&
+        DECL_RENDER_PUT_STRING(sink, node->name);
       break;
     case pdxcp_cdcl_token_type_enum:
-      if (fprintf(out, " enum %s", type_token.text) < 0)
-        return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " enum ") &&
+        DECL_RENDER_PUT_STRING(sink, node->name);
       break;
     // other types
     case pdxcp_cdcl_token_type_t_void:
-      if (fprintf(out, " void") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " void");
       break;
     case pdxcp_cdcl_token_type_t_char:
-      if (fprintf(out, " char") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " char");
       break;
     case pdxcp_cdcl_token_type_t_int:
-      if (fprintf(out, " int") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " int");
       break;
     case pdxcp_cdcl_token_type_t_long:
-      if (fprintf(out, " long") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " long");
       break;
     case pdxcp_cdcl_token_type_t_float:
-      if (fprintf(out, " float") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " float");
       break;
     case pdxcp_cdcl_token_type_t_double:
-      if (fprintf(out, " double") < 0) return pdxcp_cdcl_parser_status_out_err;
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " double");
       break;
-    // unsupported type
-    default: {
-      char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-      snprintf(
-        errmsg,
-        sizeof errmsg - 1,
-        "Unknown identifier type %s",
-        // TODO: nicer way to indicate identifier type
-        pdxcp_cdcl_token_type_string(type_token.type)
-      );
-      errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-      // write result into error info
-      pdxcp_cdcl_write_parse_err(errinfo, errmsg);
-      return pdxcp_cdcl_parser_status_parse_err;
+    // typedef name
+    case pdxcp_cdcl_token_type_t_name:
+      put_ok = DECL_RENDER_PUT_LITERAL(sink, " ") &&
+        DECL_RENDER_PUT_STRING(sink, node->name);
+      break;
+    // parser never produces other type nodes
+    default:
+      return pdxcp_cdcl_parser_status_bad_token;
+  }
+  return (put_ok) ? pdxcp_cdcl_parser_status_ok : pdxcp_cdcl_parser_status_no_mem;
+}
+
+static pdxcp_cdcl_parser_status
+decl_render_params(decl_render_sink *sink, const pdxcp_cdcl_decl *params);
+
+/**
+ * Write the English description of a declaration node list to the render sink.
+ *
+ * @param sink Render sink
+ * @param node First (outermost) declaration node
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+decl_render_nodes(decl_render_sink *sink, const pdxcp_cdcl_decl_node *node)
+{
+  // write each declaration layer from outermost to innermost
+  pdxcp_cdcl_parser_status status;
+  for (; node; node = node->next) {
+    switch (node->kind) {
+      // cv-qualified pointer
+      case pdxcp_cdcl_decl_kind_pointer:
+        if (
+          (node->quals & PDXCP_CDCL_QUAL_CONST) &&
+          !DECL_RENDER_PUT_LITERAL(sink, " const")
+        )
+          return pdxcp_cdcl_parser_status_no_mem;
+        if (
+          (node->quals & PDXCP_CDCL_QUAL_VOLATILE) &&
+          !DECL_RENDER_PUT_LITERAL(sink, " volatile")
+        )
+          return pdxcp_cdcl_parser_status_no_mem;
+        if (!DECL_RENDER_PUT_LITERAL(sink, " pointer to"))
+          return pdxcp_cdcl_parser_status_no_mem;
+        break;
+      // array specifier (may or may not have size)
+      case pdxcp_cdcl_decl_kind_array:
+        if (!DECL_RENDER_PUT_LITERAL(sink, " array["))
+          return pdxcp_cdcl_parser_status_no_mem;
+        if (node->size && !decl_render_put_size(sink, node->size))
+          return pdxcp_cdcl_parser_status_no_mem;
+        if (!DECL_RENDER_PUT_LITERAL(sink, "] of"))
+          return pdxcp_cdcl_parser_status_no_mem;
+        break;
+      // function with its parameter list
+      case pdxcp_cdcl_decl_kind_function:
+        if (!DECL_RENDER_PUT_LITERAL(sink, " function("))
+          return pdxcp_cdcl_parser_status_no_mem;
+        if (!PDXCP_CDCL_PARSER_OK(status = decl_render_params(sink, node->params)))
+          return status;
+        if (!DECL_RENDER_PUT_LITERAL(sink, ") returning"))
+          return pdxcp_cdcl_parser_status_no_mem;
+        break;
+      // qualified base type
+      case pdxcp_cdcl_decl_kind_type:
+        if (!PDXCP_CDCL_PARSER_OK(status = decl_render_type_node(sink, node)))
+          return status;
+        break;
+      default:
+        return pdxcp_cdcl_parser_status_bad_token;
+    }
+  }
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Write the English description of a function parameter list.
+ *
+ * Parameters are separated by commas and written as `iden: description`, or
+ * just the description if the parameter is abstract.
+ *
+ * @param sink Render sink
+ * @param params First parameter, `NULL` if the parameter list is empty
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+decl_render_params(decl_render_sink *sink, const pdxcp_cdcl_decl *params)
+{
+  pdxcp_cdcl_parser_status status;
+  for (const pdxcp_cdcl_decl *param = params; param; param = param->next) {
+    if (param != params && !DECL_RENDER_PUT_LITERAL(sink, ", "))
+      return pdxcp_cdcl_parser_status_no_mem;
+    // write identifier if any, otherwise drop the first node's leading space
+    if (param->iden) {
+      if (
+        !DECL_RENDER_PUT_STRING(sink, param->iden) ||
+        !DECL_RENDER_PUT_LITERAL(sink, ":")
+      )
+        return pdxcp_cdcl_parser_status_no_mem;
     }
+    else
+      sink->trim = true;
+    if (!PDXCP_CDCL_PARSER_OK(status = decl_render_nodes(sink, param->node)))
+      return status;
   }
   return pdxcp_cdcl_parser_status_ok;
 }
 
+/**
+ * Write the English description of a parsed declaration to the render sink.
+ *
+ * @param sink Render sink
+ * @param decl Parsed declaration
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+decl_render(decl_render_sink *sink, const pdxcp_cdcl_decl *decl)
+{
+  // write identifer
+  if (
+    !DECL_RENDER_PUT_STRING(sink, decl->iden) ||
+    !DECL_RENDER_PUT_LITERAL(sink, ":")
+  )
+    return pdxcp_cdcl_parser_status_no_mem;
+  // typedef declarations name the type that follows
+  if (decl->is_typedef && !DECL_RENDER_PUT_LITERAL(sink, " typedef for"))
+    return pdxcp_cdcl_parser_status_no_mem;
+  // write declaration layers
+  pdxcp_cdcl_parser_status status = decl_render_nodes(sink, decl->node);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  // final newline
+  if (!DECL_RENDER_PUT_LITERAL(sink, "\n"))
+    return pdxcp_cdcl_parser_status_no_mem;
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render(const pdxcp_cdcl_decl *decl, pdxcp_bvector *out)
+{
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  // on error, restore previous size so no partial output is left behind
+  size_t orig_size = out->size;
+  decl_render_sink sink = {out, NULL, 0, 0, false};
+  pdxcp_cdcl_parser_status status = decl_render(&sink, decl);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    out->size = orig_size;
+  return status;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_buf(
+  const pdxcp_cdcl_decl *decl, char *buf, size_t buf_size, size_t *len)
+{
+  if (!buf && buf_size)
+    return pdxcp_cdcl_parser_status_out_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  // reserve last byte for null terminator
+  decl_render_sink sink = {
+    NULL, buf, (buf_size) ? buf_size - 1 : 0, 0, false
+  };
+  pdxcp_cdcl_parser_status status = decl_render(&sink, decl);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  // null-terminate + report untruncated length
+  if (buf_size)
+    buf[(sink.len < sink.buf_size) ? sink.len : sink.buf_size] = '\0';
+  if (len)
+    *len = sink.len;
+  if (sink.len > sink.buf_size)
+    return pdxcp_cdcl_parser_status_out_too_small;
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Write the English description of a parsed declaration to a stream.
+ *
+ * This is the implementation of `pdxcp_cdcl_decl_write`.
+ *
+ * @param out Output stream
+ * @param decl Parsed declaration
+ * @param len Address to write the number of bytes written to on success
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+decl_write(FILE *out, const pdxcp_cdcl_decl *decl, size_t *len)
+{
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  // most descriptions fit on the stack so no allocation is needed
+  char buf[PDXCP_CDCL_RENDER_STACK_SIZE];
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_decl_render_buf(
+    decl, buf, sizeof buf, len
+  );
+  // commit with a single write
+  if (PDXCP_CDCL_PARSER_OK(status)) {
+    if (fwrite(buf, 1, *len, out) != *len)
+      return pdxcp_cdcl_parser_status_out_err;
+    return pdxcp_cdcl_parser_status_ok;
+  }
+  if (status != pdxcp_cdcl_parser_status_out_too_small)
+    return status;
+  // too long for the stack buffer, so render into a byte vector instead
+  pdxcp_bvector vec;
+  pdxcp_bvector_init(&vec);
+  if (PDXCP_CDCL_PARSER_OK(status = pdxcp_cdcl_decl_render(decl, &vec))) {
+    if (fwrite(vec.data, 1, vec.size, out) != vec.size)
+      status = pdxcp_cdcl_parser_status_out_err;
+    *len = vec.size;
+  }
+  pdxcp_bvector_destroy(&vec);
+  return status;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_write(FILE *out, const pdxcp_cdcl_decl *decl)
+{
+  size_t len;
+  return decl_write(out, decl, &len);
+}
+
 pdxcp_cdcl_parser_status
 pdxcp_cdcl_stream_parse(FILE *in, FILE *out, pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  return pdxcp_cdcl_stream_parse_stats(in, out, errinfo, NULL);
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_stats(
+  FILE *in,
+  FILE *out,
+  pdxcp_cdcl_parser_errinfo *errinfo,
+  pdxcp_cdcl_parser_stats *stats)
 {
   // check streams
   if (!in)
     return pdxcp_cdcl_parser_status_in_null;
   if (!out)
     return pdxcp_cdcl_parser_status_out_null;
-  // allocate + initialize token stack
-  pdxcp_cdcl_token_stack stack;
-  PDXCP_CDCL_TOKEN_STACK_INIT(&stack);
-  // statuses, current token, token holding identifier
-  pdxcp_cdcl_lexer_status lexer_status;
-  pdxcp_cdcl_parser_status parser_status;
-  pdxcp_cdcl_token token, iden_token;
-  // read tokens from lexer until error
-  parser_status = stream_parse_to_iden(in, &lexer_status, &stack, &token);
-  if (!PDXCP_CDCL_PARSER_OK(parser_status)) {
-    pdxcp_cdcl_write_errinfo(errinfo, lexer_status, &token, parser_status, NULL);
-    // no jumping to parse_finalize since nothing gets printed
-    return parser_status;
-  }
-  // copy token contents to identifier token
-  iden_token.type = token.type;
-  strcpy(iden_token.text, token.text);
-  // write identifer token
-  if (fprintf(out, "%s:", token.text) < 0)
-    return pdxcp_cdcl_parser_status_out_err;
-  // read another token, handling lexer error as appropriate
-  if (!PDXCP_CDCL_LEXER_OK(lexer_status = pdxcp_cdcl_get_token(in, &token))) {
-    parser_status = pdxcp_cdcl_parser_status_lexer_err;
-    pdxcp_cdcl_write_errinfo(errinfo, lexer_status, &token, parser_status, NULL);
-    goto parse_finalize;
-  }
-  // number of ')' read so far. this is passed to stream_parse_ptrs
-  // TODO: current structure of pdxcp_cdcl_stream_parse cannot handle something
-  // like int (*x[10])(), even if function handling is implemented, as we need
-  // a recursive call to handle array -> then grouping with parentheses.
-  // stream_parse_arrays also needs to be updated to not parse up to semicolon.
-  unsigned int n_rparen = 0;
-  // handle parentheses around pointers if we see ')'
-  if (token.type == pdxcp_cdcl_token_type_rparen) {
-    // read more tokens until next token is not ')'
-    do {
-      // pre-increment number of ')' read as next token may not be ')' and we
-      // already read a ')' to even be in this block
-      n_rparen++;
-      if (!PDXCP_CDCL_LEXER_OK(lexer_status = pdxcp_cdcl_get_token(in, &token))) {
-        parser_status = pdxcp_cdcl_parser_status_lexer_err;
-        pdxcp_cdcl_write_errinfo(errinfo, lexer_status, &token, parser_status, NULL);
-        goto parse_finalize;
-      }
-    }
-    while (token.type == pdxcp_cdcl_token_type_rparen);
-  }
-  // TODO: handle function declarations
-  // if read left bracket, consume array components
-  if (token.type == pdxcp_cdcl_token_type_langle) {
-    // consume array specifiers, reading more tokens from input
-    parser_status = stream_parse_arrays(in, out, &token, errinfo);
-    if (!PDXCP_CDCL_PARSER_OK(parser_status))
-      goto parse_finalize;
-  }
-  // if read semicolon, end of declaration
-  if (token.type == pdxcp_cdcl_token_type_semicolon) {
-    // consume pointer tokens from stack + also balance any '(' that have been
-    // read as part of the declarastion. parser_status written on error
-    parser_status = stream_parse_ptrs(&stack, out, n_rparen, errinfo);
-    if (!PDXCP_CDCL_PARSER_OK(parser_status))
-      goto parse_finalize;
-    // parse cv-qualified signed/unsigned qualified type
-    parser_status = stream_parse_type(&stack, out, errinfo);
-    goto parse_finalize;
-  }
-  // nothing we can do with this identifier, error
-  else {
-    parser_status = pdxcp_cdcl_parser_status_parse_err;
-    // format error message
-    char errmsg[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
-    snprintf(
-      errmsg,
-      sizeof errmsg - 1,
-      "Incomplete declaration for identifier %s",
-      iden_token.text
+  // parse into temporary arena, write if successful, and clean up
+  pdxcp_arena arena;
+  pdxcp_arena_init(&arena, 0);
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_status status = parse_decl(
+    in, NULL, &arena, &decl, errinfo, stats, NULL
+  );
+  size_t len;
+  if (PDXCP_CDCL_PARSER_OK(status))
+    status = decl_write(out, &decl, &len);
+#if defined(PDXCP_CDCL_ENABLE_STATS)
+  if (stats && PDXCP_CDCL_PARSER_OK(status))
+    stats->out_bytes += len;
+#endif  // defined(PDXCP_CDCL_ENABLE_STATS)
+  pdxcp_arena_destroy(&arena);
+  return status;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parse_buf(
+  const char *in,
+  size_t in_size,
+  char *out,
+  size_t out_size,
+  size_t *len,
+  pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  // check input and output buffers
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!out && out_size)
+    return pdxcp_cdcl_parser_status_out_null;
+  // parse into temporary arena, render if successful, and clean up
+  pdxcp_arena arena;
+  pdxcp_arena_init(&arena, 0);
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(&buf, in, in_size);
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_status status = parse_decl(
+    NULL, &buf, &arena, &decl, errinfo, NULL, NULL
+  );
+  if (PDXCP_CDCL_PARSER_OK(status))
+    status = pdxcp_cdcl_decl_render_buf(&decl, out, out_size, len);
+  pdxcp_arena_destroy(&arena);
+  return status;
+}
+
+void
+pdxcp_cdcl_parser_init(pdxcp_cdcl_parser *parser)
+{
+  pdxcp_arena_init(&parser->arena, 0);
+  pdxcp_bvector_init(&parser->buf);
+  PDXCP_CDCL_TOKEN_STACK_INIT(&parser->stack);
+  pdxcp_cdcl_write_errinfo(
+    &parser->errinfo,
+    pdxcp_cdcl_lexer_status_ok,
+    NULL,
+    pdxcp_cdcl_parser_status_ok,
+    pdxcp_cdcl_parser_error_none
+  );
+  parser->n_decls = 0;
+  parser->recover = false;
+  parser->n_errors = 0;
+  pdxcp_cdcl_parser_stats_init(&parser->stats);
+  parser->typedefs = NULL;
+}
+
+void
+pdxcp_cdcl_parser_destroy(pdxcp_cdcl_parser *parser)
+{
+  pdxcp_arena_destroy(&parser->arena);
+  pdxcp_bvector_destroy(&parser->buf);
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_parser_parse_decl_buf(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_lexer_buf *in,
+  pdxcp_cdcl_decl *decl)
+{
+  // check input buffer and output
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  return parse_decl(
+    NULL, in, &parser->arena, decl, &parser->errinfo, NULL, parser->typedefs
+  );
+}
+
+/**
+ * Parse all declarations from the input stream or input buffer.
+ *
+ * This is the implementation of `pdxcp_cdcl_stream_parse_all` and
+ * `pdxcp_cdcl_buf_parse_all`.
+ *
+ * @param parser Parser state
+ * @param in Input stream, only used if `buf` is `NULL`
+ * @param buf Input buffer cursor, `NULL` to read tokens from `in`
+ * @param callback Callback invoked for each declaration or error
+ * @param data User data passed to `callback`
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+parse_all(
+  pdxcp_cdcl_parser *parser,
+  FILE *in,
+  pdxcp_cdcl_lexer_buf *buf,
+  pdxcp_cdcl_parse_callback callback,
+  void *data)
+{
+  parser->n_decls = 0;
+  parser->n_errors = 0;
+  // parse until EOF, error, or until callback requests a stop
+  stream_parse_ctx ctx;
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_status status;
+  bool at_eof;
+  while (true) {
+    // previous declaration no longer needed, so reuse all its memory
+    pdxcp_arena_reset(&parser->arena);
+    stream_parse_ctx_init(
+      &ctx,
+      in,
+      buf,
+      &parser->arena,
+      &parser->stack,
+      &parser->errinfo,
+      &parser->stats,
+      parser->typedefs
     );
-    errmsg[sizeof errmsg - 1] = '\0';  // guarantee null termination
-    // write error info as usual
-    pdxcp_cdcl_write_errinfo(errinfo, lexer_status, &token, parser_status, errmsg);
-    goto parse_finalize;
-  }
-  // parse complete. just write final newline + returning parser status, as all
-  // the parsing subroutines should have written appropriate error info
-parse_finalize:
-  if (fprintf(out, "\n") < 0)
-    return pdxcp_cdcl_parser_status_out_err;
-  return parser_status;
+    status = stream_parse_decl(&ctx, &decl, &at_eof);
+    // nothing left to parse
+    if (at_eof)
+      return pdxcp_cdcl_parser_status_ok;
+    // locate and report error
+    if (!PDXCP_CDCL_PARSER_OK(status)) {
+      parser->n_errors++;
+      stream_parse_locate_err(&ctx);
+      bool resume = callback(parser, status, NULL, data);
+      // only lexer and parser errors can be skipped over. an unterminated
+      // declaration ends the input, so the next parse finds nothing left
+      if (
+        !parser->recover || !resume ||
+        (
+          status != pdxcp_cdcl_parser_status_lexer_err &&
+          status != pdxcp_cdcl_parser_status_parse_err &&
+          status != pdxcp_cdcl_parser_status_eof
+        )
+      )
+        return status;
+      stream_parse_sync(&ctx);
+      continue;
+    }
+    // report result, stopping if requested
+    parser->n_decls++;
+    if (!callback(parser, status, &decl, data))
+      return pdxcp_cdcl_parser_status_ok;
+  }
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_all(
+  pdxcp_cdcl_parser *parser,
+  FILE *in,
+  pdxcp_cdcl_parse_callback callback,
+  void *data)
+{
+  // check input stream and callback
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!callback)
+    return pdxcp_cdcl_parser_status_callback_null;
+  return parse_all(parser, in, NULL, callback, data);
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_buf_parse_all(
+  pdxcp_cdcl_parser *parser,
+  const char *in,
+  size_t in_size,
+  pdxcp_cdcl_parse_callback callback,
+  void *data)
+{
+  // check input buffer and callback
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!callback)
+    return pdxcp_cdcl_parser_status_callback_null;
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(&buf, in, in_size);
+  return parse_all(parser, NULL, &buf, callback, data);
 }
@@ -0,0 +1,495 @@
+/**
+ * @file cdcl_render.c
+ * @author Derek Huang
+ * @brief C source for machine-readable C declaration renderers
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_render.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_common.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+
+const char *
+pdxcp_cdcl_output_format_string(pdxcp_cdcl_output_format format)
+{
+  switch (format) {
+    PDXCP_STRING_CASE(pdxcp_cdcl_output_format_text);
+    PDXCP_STRING_CASE(pdxcp_cdcl_output_format_json);
+    PDXCP_STRING_CASE(pdxcp_cdcl_output_format_tlv);
+    default:
+      return "(unknown)";
+  }
+}
+
+/**
+ * Append a string literal to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param lit String literal
+ */
+#define RENDER_ADD_LITERAL(vec, lit) \
+  pdxcp_bvector_add_n(vec, (const unsigned char *) lit, sizeof lit - 1)
+
+/**
+ * Append a null-terminated string to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param s Null-terminated string
+ */
+#define RENDER_ADD_STRING(vec, s) \
+  pdxcp_bvector_add_n(vec, (const unsigned char *) s, strlen(s))
+
+/**
+ * Return the C keyword for a base type token type.
+ *
+ * @param type Base type token type
+ * @returns Keyword, `NULL` if the token type is not a base type
+ */
+static const char *
+render_type_name(pdxcp_cdcl_token_type type)
+{
+  switch (type) {
+    case pdxcp_cdcl_token_type_struct:
+      return "struct";
+    case pdxcp_cdcl_token_type_enum:
+      return "enum";
+    case pdxcp_cdcl_token_type_t_void:
+      return "void";
+    case pdxcp_cdcl_token_type_t_char:
+      return "char";
+    case pdxcp_cdcl_token_type_t_int:
+      return "int";
+    case pdxcp_cdcl_token_type_t_long:
+      return "long";
+    case pdxcp_cdcl_token_type_t_float:
+      return "float";
+    case pdxcp_cdcl_token_type_t_double:
+      return "double";
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * Return the TLV base type code for a base type token type.
+ *
+ * @param type Base type token type
+ * @returns `PDXCP_CDCL_TLV_BASE_*` code, zero if not a base type
+ */
+static unsigned char
+render_tlv_base(pdxcp_cdcl_token_type type)
+{
+  switch (type) {
+    case pdxcp_cdcl_token_type_struct:
+      return PDXCP_CDCL_TLV_BASE_STRUCT;
+    case pdxcp_cdcl_token_type_enum:
+      return PDXCP_CDCL_TLV_BASE_ENUM;
+    case pdxcp_cdcl_token_type_t_name:
+      return PDXCP_CDCL_TLV_BASE_TYPEDEF;
+    case pdxcp_cdcl_token_type_t_void:
+      return PDXCP_CDCL_TLV_BASE_VOID;
+    case pdxcp_cdcl_token_type_t_char:
+      return PDXCP_CDCL_TLV_BASE_CHAR;
+    case pdxcp_cdcl_token_type_t_int:
+      return PDXCP_CDCL_TLV_BASE_INT;
+    case pdxcp_cdcl_token_type_t_long:
+      return PDXCP_CDCL_TLV_BASE_LONG;
+    case pdxcp_cdcl_token_type_t_float:
+      return PDXCP_CDCL_TLV_BASE_FLOAT;
+    case pdxcp_cdcl_token_type_t_double:
+      return PDXCP_CDCL_TLV_BASE_DOUBLE;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Append the decimal representation of a size to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param value Value to write
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+render_add_size(pdxcp_bvector *vec, size_t value)
+{
+  // enough for 64-bit size_t. digits are written from the end of the buffer
+  char digits[20];
+  char *first = digits + sizeof digits;
+  do {
+    *--first = (char) ('0' + value % 10);
+    value /= 10;
+  }
+  while (value);
+  size_t n_digits = (size_t) (digits + sizeof digits - first);
+  return pdxcp_bvector_add_n(vec, (const unsigned char *) first, n_digits);
+}
+
+/**
+ * Append a JSON array of qualifier names to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param quals Bitwise OR of `PDXCP_CDCL_QUAL_*` qualifier flags
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+render_json_quals(pdxcp_bvector *vec, unsigned int quals)
+{
+  static const struct {
+    unsigned int flag;
+    const char *name;
+  } names[] = {
+    {PDXCP_CDCL_QUAL_CONST, "\"const\""},
+    {PDXCP_CDCL_QUAL_VOLATILE, "\"volatile\""},
+    {PDXCP_CDCL_QUAL_SIGNED, "\"signed\""},
+    {PDXCP_CDCL_QUAL_UNSIGNED, "\"unsigned\""}
+  };
+  if (!RENDER_ADD_LITERAL(vec, ",\"quals\":["))
+    return false;
+  bool first = true;
+  for (size_t i = 0; i < sizeof names / sizeof *names; i++) {
+    if (!(quals & names[i].flag))
+      continue;
+    if (!first && !pdxcp_bvector_add(vec, ','))
+      return false;
+    if (!RENDER_ADD_STRING(vec, names[i].name))
+      return false;
+    first = false;
+  }
+  return pdxcp_bvector_add(vec, ']');
+}
+
+static pdxcp_cdcl_parser_status
+render_json_decl(pdxcp_bvector *vec, const pdxcp_cdcl_decl *decl);
+
+/**
+ * Append a JSON array of declaration node objects to a byte vector.
+ *
+ * Identifiers and tags only ever contain identifier characters so they are
+ * written without escaping.
+ *
+ * @param vec Byte vector
+ * @param node First (outermost) declaration node
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+render_json_nodes(pdxcp_bvector *vec, const pdxcp_cdcl_decl_node *node)
+{
+  pdxcp_cdcl_parser_status status;
+  if (!pdxcp_bvector_add(vec, '['))
+    return pdxcp_cdcl_parser_status_no_mem;
+  for (const pdxcp_cdcl_decl_node *cur = node; cur; cur = cur->next) {
+    if (cur != node && !pdxcp_bvector_add(vec, ','))
+      return pdxcp_cdcl_parser_status_no_mem;
+    bool add_ok;
+    switch (cur->kind) {
+      case pdxcp_cdcl_decl_kind_pointer:
+        add_ok = RENDER_ADD_LITERAL(vec, "{\"kind\":\"pointer\"") &&
+          render_json_quals(vec, cur->quals);
+        break;
+      case pdxcp_cdcl_decl_kind_array:
+        add_ok = RENDER_ADD_LITERAL(vec, "{\"kind\":\"array\",\"size\":") &&
+          (
+            (cur->size) ?
+              render_add_size(vec, cur->size) : RENDER_ADD_LITERAL(vec, "null")
+          );
+        break;
+      case pdxcp_cdcl_decl_kind_function:
+        if (!RENDER_ADD_LITERAL(vec, "{\"kind\":\"function\",\"params\":["))
+          return pdxcp_cdcl_parser_status_no_mem;
+        for (const pdxcp_cdcl_decl *p = cur->params; p; p = p->next) {
+          if (p != cur->params && !pdxcp_bvector_add(vec, ','))
+            return pdxcp_cdcl_parser_status_no_mem;
+          if (!PDXCP_CDCL_PARSER_OK(status = render_json_decl(vec, p)))
+            return status;
+        }
+        add_ok = pdxcp_bvector_add(vec, ']');
+        break;
+      case pdxcp_cdcl_decl_kind_type: {
+        // typedef names are written as is
+        if (cur->type == pdxcp_cdcl_token_type_t_name) {
+          add_ok = RENDER_ADD_LITERAL(vec, "{\"kind\":\"type\"") &&
+            render_json_quals(vec, cur->quals) &&
+            RENDER_ADD_LITERAL(vec, ",\"name\":\"") &&
+            RENDER_ADD_STRING(vec, cur->name) &&
+            RENDER_ADD_LITERAL(vec, "\",\"typedef\":true");
+          break;
+        }
+        const char *name = render_type_name(cur->type);
+        if (!name)
+          return pdxcp_cdcl_parser_status_bad_token;
+        add_ok = RENDER_ADD_LITERAL(vec, "{\"kind\":\"type\"") &&
+          render_json_quals(vec, cur->quals) &&
+          RENDER_ADD_LITERAL(vec, ",\"name\":\"") &&
+          RENDER_ADD_STRING(vec, name) &&
+          pdxcp_bvector_add(vec, '"');
+        if (
+          add_ok &&
+          (
+            cur->type == pdxcp_cdcl_token_type_struct ||
+            cur->type == pdxcp_cdcl_token_type_enum
+          )
+        )
+          add_ok = RENDER_ADD_LITERAL(vec, ",\"tag\":\"") &&
+            RENDER_ADD_STRING(vec, cur->name) &&
+            pdxcp_bvector_add(vec, '"');
+        break;
+      }
+      default:
+        return pdxcp_cdcl_parser_status_bad_token;
+    }
+    if (!add_ok || !pdxcp_bvector_add(vec, '}'))
+      return pdxcp_cdcl_parser_status_no_mem;
+  }
+  if (!pdxcp_bvector_add(vec, ']'))
+    return pdxcp_cdcl_parser_status_no_mem;
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+/**
+ * Append a JSON declaration object to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param decl Parsed declaration
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+render_json_decl(pdxcp_bvector *vec, const pdxcp_cdcl_decl *decl)
+{
+  bool add_ok = RENDER_ADD_LITERAL(vec, "{\"iden\":") &&
+    (
+      (decl->iden) ?
+        (
+          pdxcp_bvector_add(vec, '"') &&
+          RENDER_ADD_STRING(vec, decl->iden) &&
+          pdxcp_bvector_add(vec, '"')
+        ) :
+        RENDER_ADD_LITERAL(vec, "null")
+    ) &&
+    (!decl->is_typedef || RENDER_ADD_LITERAL(vec, ",\"typedef\":true")) &&
+    RENDER_ADD_LITERAL(vec, ",\"type\":");
+  if (!add_ok)
+    return pdxcp_cdcl_parser_status_no_mem;
+  pdxcp_cdcl_parser_status status = render_json_nodes(vec, decl->node);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  if (!pdxcp_bvector_add(vec, '}'))
+    return pdxcp_cdcl_parser_status_no_mem;
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_json(const pdxcp_cdcl_decl *decl, pdxcp_bvector *out)
+{
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  // on error, restore previous size so no partial output is left behind
+  size_t orig_size = out->size;
+  pdxcp_cdcl_parser_status status = render_json_decl(out, decl);
+  if (PDXCP_CDCL_PARSER_OK(status) && !pdxcp_bvector_add(out, '\n'))
+    status = pdxcp_cdcl_parser_status_no_mem;
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    out->size = orig_size;
+  return status;
+}
+
+/**
+ * Begin a TLV record, leaving room for the length to be filled in later.
+ *
+ * @param vec Byte vector
+ * @param tag `PDXCP_CDCL_TLV_*` record tag
+ * @param offset Address to write the offset of the record header to
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+render_tlv_begin(pdxcp_bvector *vec, unsigned char tag, size_t *offset)
+{
+  static const unsigned char zero_len[PDXCP_CDCL_TLV_HEADER_SIZE - 1] = {0};
+  *offset = vec->size;
+  return pdxcp_bvector_add(vec, tag) &&
+    pdxcp_bvector_add_n(vec, zero_len, sizeof zero_len);
+}
+
+/**
+ * End a TLV record by filling in its length.
+ *
+ * Lengths are patched in afterwards since nested record sizes are not known
+ * until their contents are written, and declarations are small enough that
+ * a 32-bit length is never exceeded.
+ *
+ * @param vec Byte vector
+ * @param offset Offset of the record header
+ */
+static void
+render_tlv_end(pdxcp_bvector *vec, size_t offset)
+{
+  uint32_t len = (uint32_t) (vec->size - offset - PDXCP_CDCL_TLV_HEADER_SIZE);
+  unsigned char *p = vec->data + offset + 1;
+  p[0] = (unsigned char) (len >> 24);
+  p[1] = (unsigned char) (len >> 16);
+  p[2] = (unsigned char) (len >> 8);
+  p[3] = (unsigned char) len;
+}
+
+/**
+ * Append a TLV declaration record to a byte vector.
+ *
+ * @param vec Byte vector
+ * @param decl Parsed declaration
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+render_tlv_decl(pdxcp_bvector *vec, const pdxcp_cdcl_decl *decl)
+{
+  pdxcp_cdcl_parser_status status;
+  size_t decl_offset, offset;
+  if (!render_tlv_begin(vec, PDXCP_CDCL_TLV_DECL, &decl_offset))
+    return pdxcp_cdcl_parser_status_no_mem;
+  // identifier, omitted for abstract parameters
+  if (decl->iden) {
+    if (
+      !render_tlv_begin(vec, PDXCP_CDCL_TLV_IDEN, &offset) ||
+      !RENDER_ADD_STRING(vec, decl->iden)
+    )
+      return pdxcp_cdcl_parser_status_no_mem;
+    render_tlv_end(vec, offset);
+  }
+  // empty marker for typedef declarations
+  if (decl->is_typedef) {
+    if (!render_tlv_begin(vec, PDXCP_CDCL_TLV_TYPEDEF, &offset))
+      return pdxcp_cdcl_parser_status_no_mem;
+    render_tlv_end(vec, offset);
+  }
+  // one record per node
+  for (const pdxcp_cdcl_decl_node *node = decl->node; node; node = node->next) {
+    bool add_ok;
+    switch (node->kind) {
+      case pdxcp_cdcl_decl_kind_pointer:
+        add_ok = render_tlv_begin(vec, PDXCP_CDCL_TLV_POINTER, &offset) &&
+          pdxcp_bvector_add(vec, (unsigned char) node->quals);
+        break;
+      case pdxcp_cdcl_decl_kind_array: {
+        unsigned char size[8];
+        uint64_t value = node->size;
+        for (int i = 7; i >= 0; i--) {
+          size[i] = (unsigned char) value;
+          value >>= 8;
+        }
+        add_ok = render_tlv_begin(vec, PDXCP_CDCL_TLV_ARRAY, &offset) &&
+          pdxcp_bvector_add_n(vec, size, sizeof size);
+        break;
+      }
+      case pdxcp_cdcl_decl_kind_function:
+        if (!render_tlv_begin(vec, PDXCP_CDCL_TLV_FUNCTION, &offset))
+          return pdxcp_cdcl_parser_status_no_mem;
+        for (const pdxcp_cdcl_decl *p = node->params; p; p = p->next)
+          if (!PDXCP_CDCL_PARSER_OK(status = render_tlv_decl(vec, p)))
+            return status;
+        add_ok = true;
+        break;
+      case pdxcp_cdcl_decl_kind_type: {
+        unsigned char base = render_tlv_base(node->type);
+        if (!base)
+          return pdxcp_cdcl_parser_status_bad_token;
+        add_ok = render_tlv_begin(vec, PDXCP_CDCL_TLV_TYPE, &offset) &&
+          pdxcp_bvector_add(vec, (unsigned char) node->quals) &&
+          pdxcp_bvector_add(vec, base);
+        if (
+          add_ok &&
+          (
+            base == PDXCP_CDCL_TLV_BASE_STRUCT ||
+            base == PDXCP_CDCL_TLV_BASE_ENUM ||
+            base == PDXCP_CDCL_TLV_BASE_TYPEDEF
+          )
+        )
+          add_ok = RENDER_ADD_STRING(vec, node->name);
+        break;
+      }
+      default:
+        return pdxcp_cdcl_parser_status_bad_token;
+    }
+    if (!add_ok)
+      return pdxcp_cdcl_parser_status_no_mem;
+    render_tlv_end(vec, offset);
+  }
+  render_tlv_end(vec, decl_offset);
+  return pdxcp_cdcl_parser_status_ok;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_tlv(const pdxcp_cdcl_decl *decl, pdxcp_bvector *out)
+{
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  if (!decl)
+    return pdxcp_cdcl_parser_status_decl_null;
+  // on error, restore previous size so no partial output is left behind
+  size_t orig_size = out->size;
+  pdxcp_cdcl_parser_status status = render_tlv_decl(out, decl);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    out->size = orig_size;
+  return status;
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_decl_render_as(
+  const pdxcp_cdcl_decl *decl,
+  pdxcp_cdcl_output_format format,
+  pdxcp_bvector *out)
+{
+  switch (format) {
+    case pdxcp_cdcl_output_format_text:
+      return pdxcp_cdcl_decl_render(decl, out);
+    case pdxcp_cdcl_output_format_json:
+      return pdxcp_cdcl_decl_render_json(decl, out);
+    case pdxcp_cdcl_output_format_tlv:
+      return pdxcp_cdcl_decl_render_tlv(decl, out);
+    default:
+      return pdxcp_cdcl_parser_status_bad_format;
+  }
+}
+
+pdxcp_cdcl_parser_status
+pdxcp_cdcl_stream_parse_as(
+  FILE *in,
+  FILE *out,
+  pdxcp_cdcl_output_format format,
+  pdxcp_cdcl_parser_errinfo *errinfo)
+{
+  // check streams
+  if (!in)
+    return pdxcp_cdcl_parser_status_in_null;
+  if (!out)
+    return pdxcp_cdcl_parser_status_out_null;
+  // parse into temporary arena, render and write if successful, and clean up
+  pdxcp_arena arena;
+  pdxcp_arena_init(&arena, 0);
+  pdxcp_bvector vec;
+  pdxcp_bvector_init(&vec);
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_status status = pdxcp_cdcl_parse_decl(
+    in, &arena, &decl, errinfo
+  );
+  if (PDXCP_CDCL_PARSER_OK(status))
+    status = pdxcp_cdcl_decl_render_as(&decl, format, &vec);
+  if (
+    PDXCP_CDCL_PARSER_OK(status) &&
+    fwrite(vec.data, 1, vec.size, out) != vec.size
+  )
+    status = pdxcp_cdcl_parser_status_out_err;
+  pdxcp_bvector_destroy(&vec);
+  pdxcp_arena_destroy(&arena);
+  return status;
+}
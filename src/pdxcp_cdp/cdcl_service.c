@@ -0,0 +1,464 @@
+/**
+ * @file cdcl_service.c
+ * @author Derek Huang
+ * @brief C source for the C declaration Unix domain socket service
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_service.h"
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_cache.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+
+/**
+ * Flags for `sendmsg`.
+ *
+ * A peer that disconnects mid-response should be an error return and not a
+ * `SIGPIPE` that kills the whole service, so it is suppressed where possible.
+ */
+#if defined(MSG_NOSIGNAL)
+#define PDXCP_CDCL_SERVICE_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define PDXCP_CDCL_SERVICE_SEND_FLAGS 0
+#endif  // !defined(MSG_NOSIGNAL)
+
+/**
+ * Maximum number of bytes of error text in a response.
+ *
+ * Enough for the lexer status name, the token text, and some formatting.
+ */
+#define PDXCP_CDCL_SERVICE_ERROR_TEXT_LEN \
+  (PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + PDXCP_CDCL_MAX_TOKEN_LEN + 64)
+
+/**
+ * Write a 32-bit unsigned integer in big-endian byte order.
+ *
+ * @param p Address to write 4 bytes to
+ * @param value Value to write
+ */
+static void
+service_put_u32(unsigned char *p, uint32_t value)
+{
+  p[0] = (unsigned char) (value >> 24);
+  p[1] = (unsigned char) (value >> 16);
+  p[2] = (unsigned char) (value >> 8);
+  p[3] = (unsigned char) value;
+}
+
+/**
+ * Read a 32-bit unsigned integer in big-endian byte order.
+ *
+ * @param p Address to read 4 bytes from
+ */
+static uint32_t
+service_get_u32(const unsigned char *p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+    ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+/**
+ * Read exactly the requested number of bytes unless EOF is reached first.
+ *
+ * On a blocking socket `recv` only fails with `EAGAIN` when the receive
+ * timeout expires, which is reported as `ETIMEDOUT` instead.
+ *
+ * @param fd File descriptor to read from
+ * @param buf Buffer to read into
+ * @param size Number of bytes to read
+ * @param n_read Address to write the number of bytes read to, written on
+ *  error too
+ * @returns `true` on success or EOF, `false` on error with `errno` set
+ */
+static bool
+service_recv_all(int fd, void *buf, size_t size, size_t *n_read)
+{
+  size_t total = 0;
+  while (total < size) {
+    ssize_t n = recv(fd, (char *) buf + total, size - total, 0);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        errno = ETIMEDOUT;
+      *n_read = total;
+      return false;
+    }
+    if (!n)
+      break;
+    total += (size_t) n;
+  }
+  *n_read = total;
+  return true;
+}
+
+/**
+ * Send all the bytes described by an I/O vector.
+ *
+ * The I/O vector is modified to handle partial writes.
+ *
+ * @param fd Socket file descriptor to write to
+ * @param iov I/O vector
+ * @param iov_len Number of I/O vector elements
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+static bool
+service_send_all(int fd, struct iovec *iov, size_t iov_len)
+{
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iov_len;
+  while (msg.msg_iovlen) {
+    ssize_t n = sendmsg(fd, &msg, PDXCP_CDCL_SERVICE_SEND_FLAGS);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    // skip fully written elements then advance into the partial one
+    size_t left = (size_t) n;
+    while (msg.msg_iovlen && left >= msg.msg_iov->iov_len) {
+      left -= msg.msg_iov->iov_len;
+      msg.msg_iov++;
+      msg.msg_iovlen--;
+    }
+    if (msg.msg_iovlen) {
+      msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + left;
+      msg.msg_iov->iov_len -= left;
+    }
+  }
+  return true;
+}
+
+/**
+ * Grow a byte vector until it can hold the given number of bytes.
+ *
+ * @param vec Byte vector
+ * @param size Number of bytes needed
+ * @returns `true` on success, `false` on error (`errno` is ENOMEM)
+ */
+static bool
+service_reserve(pdxcp_bvector *vec, size_t size)
+{
+  while (vec->capacity < size)
+    if (!pdxcp_bvector_expand(vec))
+      return false;
+  return true;
+}
+
+void
+pdxcp_cdcl_service_response_init(pdxcp_cdcl_service_response *response)
+{
+  response->status = pdxcp_cdcl_parser_status_ok;
+  response->n_decls = 0;
+  response->text_size = 0;
+  response->err_offset = 0;
+  pdxcp_bvector_init(&response->data);
+}
+
+void
+pdxcp_cdcl_service_response_destroy(pdxcp_cdcl_service_response *response)
+{
+  pdxcp_bvector_destroy(&response->data);
+}
+
+void
+pdxcp_cdcl_service_worker_init(
+  pdxcp_cdcl_service_worker *worker, size_t cache_size)
+{
+  pdxcp_cdcl_parser_init(&worker->parser);
+  pdxcp_cdcl_typedefs_init(&worker->typedefs);
+  worker->parser.typedefs = &worker->typedefs;
+  worker->use_cache = (cache_size != 0);
+  if (worker->use_cache)
+    pdxcp_cdcl_cache_init(&worker->cache, cache_size);
+  pdxcp_bvector_init(&worker->in);
+  pdxcp_bvector_init(&worker->out);
+  worker->n_requests = 0;
+}
+
+void
+pdxcp_cdcl_service_worker_destroy(pdxcp_cdcl_service_worker *worker)
+{
+  pdxcp_bvector_destroy(&worker->out);
+  pdxcp_bvector_destroy(&worker->in);
+  if (worker->use_cache)
+    pdxcp_cdcl_cache_destroy(&worker->cache);
+  pdxcp_cdcl_typedefs_destroy(&worker->typedefs);
+  pdxcp_cdcl_parser_destroy(&worker->parser);
+}
+
+/**
+ * Parse callback state for uncached service requests.
+ *
+ * @param out Byte vector to render declarations into
+ * @param status Render status, only written to on error
+ */
+typedef struct {
+  pdxcp_bvector *out;
+  pdxcp_cdcl_parser_status status;
+} service_render_state;
+
+/**
+ * Parse callback that renders each declaration into the response text.
+ *
+ * @param parser Parser state
+ * @param status Parser status for the declaration
+ * @param decl Parsed declaration, `NULL` on error
+ * @param data Address of the `service_render_state`
+ * @returns `true` to continue parsing, `false` on render error
+ */
+static bool
+service_render_decl(
+  pdxcp_cdcl_parser *parser,
+  pdxcp_cdcl_parser_status status,
+  const pdxcp_cdcl_decl *decl,
+  void *data)
+{
+  (void) parser;
+  service_render_state *state = data;
+  if (!decl)
+    return false;
+  status = pdxcp_cdcl_decl_render(decl, state->out);
+  if (!PDXCP_CDCL_PARSER_OK(status)) {
+    state->status = status;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Parse the request in the worker's input buffer into its output buffer.
+ *
+ * @param worker Worker state
+ * @param err_text Buffer to write the null-terminated error text to
+ * @param err_offset Address to write the error's byte offset in the request
+ *  to, zero if there is no error or if it is not an input error
+ * @returns `pdxcp_cdcl_parser_status` parser status
+ */
+static pdxcp_cdcl_parser_status
+service_parse(
+  pdxcp_cdcl_service_worker *worker,
+  char err_text[PDXCP_CDCL_SERVICE_ERROR_TEXT_LEN + 1],
+  size_t *err_offset)
+{
+  pdxcp_cdcl_parser *parser = &worker->parser;
+  const char *in = (worker->in.data) ? (const char *) worker->in.data : "";
+  pdxcp_cdcl_parser_status status;
+  worker->out.size = 0;
+  err_text[0] = '\0';
+  *err_offset = 0;
+  // cached parse writes its own error info
+  if (worker->use_cache)
+    status = pdxcp_cdcl_cache_parse(
+      &worker->cache, parser, in, worker->in.size, &worker->out
+    );
+  // uncached render errors have no error info, so only the status is known
+  else {
+    service_render_state state = {&worker->out, pdxcp_cdcl_parser_status_ok};
+    status = pdxcp_cdcl_buf_parse_all(
+      parser, in, worker->in.size, service_render_decl, &state
+    );
+    if (PDXCP_CDCL_PARSER_OK(status) && !PDXCP_CDCL_PARSER_OK(state.status)) {
+      snprintf(
+        err_text,
+        PDXCP_CDCL_SERVICE_ERROR_TEXT_LEN + 1,
+        "%s",
+        pdxcp_cdcl_parser_status_message(state.status)
+      );
+      return state.status;
+    }
+  }
+  if (PDXCP_CDCL_PARSER_OK(status))
+    return status;
+  pdxcp_cdcl_parser_errinfo_format(
+    &parser->errinfo, err_text, PDXCP_CDCL_SERVICE_ERROR_TEXT_LEN + 1
+  );
+  *err_offset = parser->errinfo.offset;
+  return status;
+}
+
+bool
+pdxcp_cdcl_service_serve(pdxcp_cdcl_service_worker *worker, int fd)
+{
+  unsigned char header[PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE];
+  char err_text[PDXCP_CDCL_SERVICE_ERROR_TEXT_LEN + 1];
+  size_t n_read;
+  // typedef names do not carry over from the previous connection
+  pdxcp_cdcl_typedefs_destroy(&worker->typedefs);
+  pdxcp_cdcl_typedefs_init(&worker->typedefs);
+  while (true) {
+    // read request header. EOF or a timeout before any header byte is a
+    // clean close, so idle clients do not hold on to the worker
+    if (
+      !service_recv_all(
+        fd, header, PDXCP_CDCL_SERVICE_REQUEST_HEADER_SIZE, &n_read
+      )
+    )
+      return !n_read && errno == ETIMEDOUT;
+    if (!n_read)
+      return true;
+    if (n_read < PDXCP_CDCL_SERVICE_REQUEST_HEADER_SIZE) {
+      errno = EPROTO;
+      return false;
+    }
+    // read request body into reused buffer
+    size_t in_size = service_get_u32(header);
+    if (in_size > PDXCP_CDCL_SERVICE_MAX_REQUEST) {
+      errno = EMSGSIZE;
+      return false;
+    }
+    if (!service_reserve(&worker->in, in_size))
+      return false;
+    if (!service_recv_all(fd, worker->in.data, in_size, &n_read))
+      return false;
+    if (n_read < in_size) {
+      errno = EPROTO;
+      return false;
+    }
+    worker->in.size = in_size;
+    // parse and send response header, rendered text, and error text at once
+    size_t err_offset;
+    pdxcp_cdcl_parser_status status = service_parse(
+      worker, err_text, &err_offset
+    );
+    size_t err_size = strlen(err_text);
+    service_put_u32(header, (uint32_t) status);
+    service_put_u32(header + 4, (uint32_t) worker->parser.n_decls);
+    service_put_u32(header + 8, (uint32_t) worker->out.size);
+    service_put_u32(header + 12, (uint32_t) err_size);
+    // requests are limited to PDXCP_CDCL_SERVICE_MAX_REQUEST bytes
+    service_put_u32(header + 16, (uint32_t) err_offset);
+    struct iovec iov[3] = {
+      {header, PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE},
+      {worker->out.data, worker->out.size},
+      {err_text, err_size}
+    };
+    if (!service_send_all(fd, iov, 3))
+      return false;
+    worker->n_requests++;
+  }
+}
+
+bool
+pdxcp_cdcl_service_request(
+  int fd,
+  const char *in,
+  size_t in_size,
+  pdxcp_cdcl_service_response *response)
+{
+  if (in_size > PDXCP_CDCL_SERVICE_MAX_REQUEST) {
+    errno = EMSGSIZE;
+    return false;
+  }
+  // send request header and body at once
+  unsigned char header[PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE];
+  service_put_u32(header, (uint32_t) in_size);
+  struct iovec iov[2] = {
+    {header, PDXCP_CDCL_SERVICE_REQUEST_HEADER_SIZE},
+    {(void *) in, in_size}
+  };
+  if (!service_send_all(fd, iov, 2))
+    return false;
+  // read response header
+  size_t n_read;
+  if (
+    !service_recv_all(
+      fd, header, PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE, &n_read
+    )
+  )
+    return false;
+  if (n_read < PDXCP_CDCL_SERVICE_RESPONSE_HEADER_SIZE) {
+    errno = EPROTO;
+    return false;
+  }
+  response->status = (pdxcp_cdcl_parser_status) service_get_u32(header);
+  response->n_decls = service_get_u32(header + 4);
+  response->text_size = service_get_u32(header + 8);
+  response->err_offset = service_get_u32(header + 16);
+  // read rendered text and error text
+  size_t data_size = response->text_size + service_get_u32(header + 12);
+  if (!service_reserve(&response->data, data_size))
+    return false;
+  if (!service_recv_all(fd, response->data.data, data_size, &n_read))
+    return false;
+  if (n_read < data_size) {
+    errno = EPROTO;
+    return false;
+  }
+  response->data.size = data_size;
+  return true;
+}
+
+/**
+ * Create a Unix domain stream socket and fill in its address.
+ *
+ * @param path Socket path
+ * @param addr Socket address to write to
+ * @returns Socket file descriptor, -1 on error with `errno` set
+ */
+static int
+service_socket(const char *path, struct sockaddr_un *addr)
+{
+  // path must fit with its null terminator
+  if (strlen(path) >= sizeof addr->sun_path) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  memset(addr, 0, sizeof *addr);
+  addr->sun_family = AF_UNIX;
+  strcpy(addr->sun_path, path);
+  return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+int
+pdxcp_cdcl_service_listen(const char *path, int backlog)
+{
+  struct sockaddr_un addr;
+  int fd = service_socket(path, &addr);
+  if (fd < 0)
+    return -1;
+  if (
+    bind(fd, (struct sockaddr *) &addr, sizeof addr) ||
+    listen(fd, backlog)
+  ) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+  return fd;
+}
+
+int
+pdxcp_cdcl_service_connect(const char *path)
+{
+  struct sockaddr_un addr;
+  int fd = service_socket(path, &addr);
+  if (fd < 0)
+    return -1;
+  if (connect(fd, (struct sockaddr *) &addr, sizeof addr)) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+  return fd;
+}
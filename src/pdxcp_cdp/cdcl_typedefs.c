@@ -0,0 +1,37 @@
+/**
+ * @file cdcl_typedefs.c
+ * @author Derek Huang
+ * @brief C source for the C declaration parser typedef name table
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_typedefs.h"
+
+#include <stdbool.h>
+
+#include "pdxcp/strmap.h"
+
+void
+pdxcp_cdcl_typedefs_init(pdxcp_cdcl_typedefs *typedefs)
+{
+  pdxcp_strmap_init(&typedefs->names);
+}
+
+void
+pdxcp_cdcl_typedefs_destroy(pdxcp_cdcl_typedefs *typedefs)
+{
+  pdxcp_strmap_destroy(&typedefs->names);
+}
+
+bool
+pdxcp_cdcl_typedefs_add(pdxcp_cdcl_typedefs *typedefs, const char *name)
+{
+  // names already in the table are found instead (sets errno)
+  return pdxcp_strmap_insert(&typedefs->names, name, NULL) != NULL;
+}
+
+bool
+pdxcp_cdcl_typedefs_find(const pdxcp_cdcl_typedefs *typedefs, const char *name)
+{
+  return pdxcp_strmap_find(&typedefs->names, name) != NULL;
+}
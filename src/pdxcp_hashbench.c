@@ -0,0 +1,526 @@
+/**
+ * @file pdxcp_hashbench.c
+ * @author Derek Huang
+ * @brief String map hash function benchmark on a path corpus
+ * @copyright MIT License
+ */
+
+#include <pthread.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/strmap.h"
+
+/**
+ * Longest probe length, in groups, given its own histogram column.
+ *
+ * Longer probe sequences are counted in a final column together.
+ */
+#define HASHBENCH_MAX_PROBE 8
+
+/**
+ * Sink for hash values so the timed hash calls are not optimized out.
+ */
+static volatile uint64_t hashbench_sink;
+
+/**
+ * Program options.
+ *
+ * @param book `true` to also benchmark the book's `hash_filename`
+ * @param n_rounds Number of times every path is looked up
+ * @param n_threads Maximum number of threads for concurrent lookups, zero to
+ *  skip the concurrent lookup benchmark
+ * @param paths Input file paths, `-` for standard input
+ * @param n_paths Number of input file paths
+ */
+typedef struct {
+  bool book;
+  unsigned long n_rounds;
+  unsigned long n_threads;
+  char **paths;
+  int n_paths;
+} hashbench_options;
+
+/**
+ * Print the program usage to the given stream.
+ *
+ * @param out Output stream
+ * @param progname Program name
+ */
+static void
+print_usage(FILE *out, const char *progname)
+{
+  fprintf(
+    out,
+    "Usage: %s [-h] [-b] [-r N] [-j N] [FILE...]\n"
+    "\n"
+    "Benchmark the pdxcp_strmap hash functions on a corpus of paths read one\n"
+    "per line from each FILE, or from standard input if no FILE is given. A\n"
+    "real corpus can be made with e.g. find / -xdev > paths.txt.\n"
+    "\n"
+    "For each hash function, all the paths are inserted into a string map and\n"
+    "the distribution of the number of slot groups probed to find each path\n"
+    "is printed, followed by the mean time to hash a path and to look one up.\n"
+    "With -j, the paths are then inserted into a pdxcp_strmap_sync and looked\n"
+    "up by 1, 2, 4, ... up to N threads at once to measure how lookups scale.\n"
+    "\n"
+    "Options:\n"
+    "  -h, --help         Print this usage and exit\n"
+    "  -b, --book         Also benchmark the book's hash_filename. Its probe\n"
+    "                     sequences grow with the corpus, so keep it small\n"
+    "  -r, --rounds N     Look up every path N times [5]\n"
+    "  -j, --threads N    Also look up paths with up to N threads at once\n",
+    progname
+  );
+}
+
+/**
+ * Parse a positive count option value.
+ *
+ * @param progname Program name
+ * @param opt Option name
+ * @param text Option value, `NULL` if the option is the last argument
+ * @param value Address to write the count to
+ * @returns `true` on success, `false` after printing an error
+ */
+static bool
+parse_count(
+  const char *progname, const char *opt, const char *text, unsigned long *value)
+{
+  char *end;
+  errno = 0;
+  unsigned long count = (text) ? strtoul(text, &end, 10) : 0;
+  if (!text || !*text || *end || *text == '-' || errno || !count) {
+    fprintf(stderr, "Error: %s: Invalid %s value\n", progname, opt);
+    return false;
+  }
+  *value = count;
+  return true;
+}
+
+/**
+ * Parse command-line arguments into the program options.
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Program options to write to
+ * @returns `EXIT_SUCCESS` to continue, `EXIT_FAILURE` on error, or -1 if the
+ *  usage was printed and the program should exit successfully
+ */
+static int
+parse_args(int argc, char *argv[], hashbench_options *opts)
+{
+  opts->book = false;
+  opts->n_rounds = 5;
+  opts->n_threads = 0;
+  opts->paths = NULL;
+  opts->n_paths = 0;
+  int i;
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      print_usage(stdout, argv[0]);
+      return -1;
+    }
+    else if (!strcmp(arg, "-b") || !strcmp(arg, "--book"))
+      opts->book = true;
+    else if (!strcmp(arg, "-r") || !strcmp(arg, "--rounds")) {
+      if (!parse_count(argv[0], arg, argv[++i], &opts->n_rounds))
+        return EXIT_FAILURE;
+    }
+    else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads")) {
+      if (!parse_count(argv[0], arg, argv[++i], &opts->n_threads))
+        return EXIT_FAILURE;
+    }
+    else if (arg[0] == '-' && arg[1]) {
+      fprintf(stderr, "Error: %s: Unknown option %s\n", argv[0], arg);
+      print_usage(stderr, argv[0]);
+      return EXIT_FAILURE;
+    }
+    else
+      break;
+  }
+  opts->paths = argv + i;
+  opts->n_paths = argc - i;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Compute the book's `hash_filename` hash of a file name.
+ *
+ * This is the original hash without the final `% FILE_HASH`, since the map
+ * masks the hash with its own number of slots. Only the length, the first
+ * character, and the middle character contribute, so the values span just a
+ * few thousand slots and paths sharing a prefix collide heavily.
+ *
+ * @param key File name bytes
+ * @param len Number of file name bytes, nonzero
+ */
+static uint64_t
+hash_book(const char *key, size_t len)
+{
+  return len + 4 * (key[0] + 4 * key[len / 2]);
+}
+
+/**
+ * Hash function under test.
+ *
+ * @param name Hash function name
+ * @param hash Hash function
+ */
+typedef struct {
+  const char *name;
+  pdxcp_strmap_hash_fn hash;
+} hashbench_hash;
+
+/**
+ * Read all bytes from the input stream, appending to a byte vector.
+ *
+ * @param in Input stream
+ * @param buf Byte vector to append to
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+static bool
+read_all(FILE *in, pdxcp_bvector *buf)
+{
+  unsigned char chunk[BUFSIZ];
+  size_t n_read;
+  while ((n_read = fread(chunk, 1, sizeof chunk, in)))
+    if (!pdxcp_bvector_add_n(buf, chunk, n_read))
+      return false;
+  if (ferror(in)) {
+    errno = EIO;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Split the corpus into null-terminated lines, skipping empty lines.
+ *
+ * @param buf Corpus bytes ending in a newline, newlines are replaced in place
+ * @param n_keys Address to write the number of lines to
+ * @returns Dynamically-allocated array of line pointers, `NULL` on error
+ */
+static const char **
+split_lines(pdxcp_bvector *buf, size_t *n_keys)
+{
+  size_t n_lines = 0;
+  for (size_t i = 0; i < buf->size; i++)
+    n_lines += buf->data[i] == '\n';
+  // allocate at least one pointer so an empty corpus is not an error
+  const char **keys = malloc((n_lines + !n_lines) * sizeof *keys);
+  if (!keys)
+    return NULL;
+  *n_keys = 0;
+  char *line = (char *) buf->data;
+  for (size_t i = 0; i < buf->size; i++) {
+    if (buf->data[i] != '\n')
+      continue;
+    buf->data[i] = '\0';
+    if (*line)
+      keys[(*n_keys)++] = line;
+    line = (char *) buf->data + i + 1;
+  }
+  return keys;
+}
+
+/**
+ * Return nanoseconds elapsed since the given monotonic clock time.
+ *
+ * @param start Start time from `clock_gettime(CLOCK_MONOTONIC, ...)`
+ */
+static double
+elapsed_ns(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return 1e9 * (double) (now.tv_sec - start->tv_sec) +
+    (double) (now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Benchmark a hash function on the corpus and print the results.
+ *
+ * @param hash Hash function under test
+ * @param keys Corpus paths
+ * @param n_keys Number of corpus paths
+ * @param n_rounds Number of times every path is looked up
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+static bool
+bench_hash(
+  const hashbench_hash *hash,
+  const char **keys,
+  size_t n_keys,
+  unsigned long n_rounds)
+{
+  pdxcp_strmap map;
+  pdxcp_strmap_init_hash(&map, hash->hash);
+  for (size_t i = 0; i < n_keys; i++) {
+    if (!pdxcp_strmap_insert(&map, keys[i], NULL)) {
+      pdxcp_strmap_destroy(&map);
+      return false;
+    }
+  }
+  // probe length histogram. an entry is found after probing every group from
+  // its home group up to its own, as described in strmap.h
+  size_t hist[HASHBENCH_MAX_PROBE + 1] = {0};
+  size_t max_probe = 0;
+  double n_probes = 0;
+  size_t group_mask = map.capacity / PDXCP_STRMAP_GROUP_SIZE - 1;
+  for (size_t i = 0; i < map.capacity; i++) {
+    if (!PDXCP_STRMAP_CTRL_FULL(map.ctrl[i]))
+      continue;
+    size_t home = (size_t) (map.entries[i]->hash >> 7) & group_mask;
+    size_t probe = ((i / PDXCP_STRMAP_GROUP_SIZE - home) & group_mask) + 1;
+    hist[((probe > HASHBENCH_MAX_PROBE) ? HASHBENCH_MAX_PROBE : probe - 1)]++;
+    max_probe = (probe > max_probe) ? probe : max_probe;
+    n_probes += (double) probe;
+  }
+  // time hashing alone
+  struct timespec start;
+  uint64_t sum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned long r = 0; r < n_rounds; r++)
+    for (size_t i = 0; i < n_keys; i++)
+      sum += hash->hash(keys[i], strlen(keys[i]));
+  double hash_ns = elapsed_ns(&start);
+  hashbench_sink = sum;
+  // time lookups, which include hashing
+  size_t n_found = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned long r = 0; r < n_rounds; r++)
+    for (size_t i = 0; i < n_keys; i++)
+      n_found += pdxcp_strmap_find(&map, keys[i]) != NULL;
+  double find_ns = elapsed_ns(&start);
+  double n_ops = (double) n_keys * (double) n_rounds;
+  printf(
+    "%-8s %10zu %10zu %6zu %8.3f %10.1f %10.1f",
+    hash->name,
+    map.size,
+    map.capacity,
+    max_probe,
+    (map.size) ? n_probes / (double) map.size : 0.,
+    hash_ns / n_ops,
+    find_ns / n_ops
+  );
+  for (size_t i = 0; i < HASHBENCH_MAX_PROBE + 1; i++)
+    printf(" %zu", hist[i]);
+  // every path was inserted so every lookup must succeed
+  printf("%s\n", (n_found != n_keys * n_rounds) ? " (missing keys)" : "");
+  pdxcp_strmap_destroy(&map);
+  return true;
+}
+
+/**
+ * Lookup thread arguments.
+ *
+ * @param map Concurrent string map holding all the corpus paths
+ * @param keys Corpus paths
+ * @param n_keys Number of corpus paths
+ * @param offset Index of the first path looked up, so threads do not look up
+ *  the same paths in lockstep
+ * @param n_rounds Number of times every path is looked up
+ * @param n_found Number of paths found, written by the thread
+ */
+typedef struct {
+  pdxcp_strmap_sync *map;
+  const char **keys;
+  size_t n_keys;
+  size_t offset;
+  unsigned long n_rounds;
+  size_t n_found;
+} hashbench_lookup_args;
+
+/**
+ * Look up the corpus paths in a concurrent string map.
+ *
+ * @param arg `hashbench_lookup_args *` thread arguments
+ * @returns `NULL`
+ */
+static void *
+lookup_paths(void *arg)
+{
+  hashbench_lookup_args *args = arg;
+  size_t n_found = 0;
+  for (unsigned long r = 0; r < args->n_rounds; r++) {
+    for (size_t i = 0; i < args->n_keys; i++) {
+      const char *key = args->keys[(args->offset + i) % args->n_keys];
+      n_found += pdxcp_strmap_sync_find(args->map, key) != NULL;
+    }
+  }
+  args->n_found = n_found;
+  return NULL;
+}
+
+/**
+ * Benchmark concurrent lookups of the corpus and print the results.
+ *
+ * Each thread looks up every path in each round, so the total number of
+ * lookups grows with the thread count. Perfect scaling keeps the time per
+ * lookup in each thread constant while the total lookup rate grows.
+ *
+ * @param keys Corpus paths
+ * @param n_keys Number of corpus paths
+ * @param n_rounds Number of times every path is looked up by each thread
+ * @param max_threads Maximum number of lookup threads
+ * @returns `true` on success, `false` on error with `errno` set
+ */
+static bool
+bench_sync(
+  const char **keys,
+  size_t n_keys,
+  unsigned long n_rounds,
+  unsigned long max_threads)
+{
+  pdxcp_strmap_sync map;
+  if (!pdxcp_strmap_sync_init(&map, 0))
+    return false;
+  bool ok = false;
+  pthread_t *threads = malloc(max_threads * sizeof *threads);
+  hashbench_lookup_args *args = malloc(max_threads * sizeof *args);
+  if (!threads || !args)
+    goto done;
+  for (size_t i = 0; i < n_keys; i++)
+    if (!pdxcp_strmap_sync_insert(&map, keys[i], NULL, NULL))
+      goto done;
+  printf(
+    "\n%-8s %10s %10s %10s\n", "threads", "ns/find", "Mfind/s", "shards"
+  );
+  for (unsigned long n = 1; ; n = (2 * n < max_threads) ? 2 * n : max_threads) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long n_started;
+    for (n_started = 0; n_started < n; n_started++) {
+      args[n_started] = (hashbench_lookup_args) {
+        &map, keys, n_keys, n_started * n_keys / n, n_rounds, 0
+      };
+      int status = pthread_create(
+        threads + n_started, NULL, lookup_paths, args + n_started
+      );
+      if (status) {
+        errno = status;
+        break;
+      }
+    }
+    size_t n_found = 0;
+    for (unsigned long i = 0; i < n_started; i++) {
+      pthread_join(threads[i], NULL);
+      n_found += args[i].n_found;
+    }
+    if (n_started < n)
+      goto done;
+    double find_ns = elapsed_ns(&start);
+    double n_ops = (double) n_keys * (double) n_rounds;
+    printf(
+      "%-8lu %10.1f %10.2f %10zu%s\n",
+      n,
+      (n_keys) ? find_ns / n_ops : 0.,
+      (find_ns) ? 1e3 * n_ops * (double) n / find_ns : 0.,
+      map.n_shards,
+      (n_found != n_keys * n_rounds * n) ? " (missing keys)" : ""
+    );
+    if (n == max_threads)
+      break;
+  }
+  ok = true;
+done:
+  free(args);
+  free(threads);
+  pdxcp_strmap_sync_destroy(&map);
+  return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+  hashbench_options opts;
+  int status = parse_args(argc, argv, &opts);
+  if (status)
+    return (status < 0) ? EXIT_SUCCESS : status;
+  // read from stdin if no files are given
+  static char stdin_path[] = "-";
+  static char *stdin_paths[] = {stdin_path};
+  if (!opts.n_paths) {
+    opts.paths = stdin_paths;
+    opts.n_paths = 1;
+  }
+  pdxcp_bvector buf;
+  pdxcp_bvector_init(&buf);
+  const char **keys = NULL;
+  status = EXIT_FAILURE;
+  for (int i = 0; i < opts.n_paths; i++) {
+    const char *path = opts.paths[i];
+    bool use_stdin = !strcmp(path, "-");
+    FILE *in = (use_stdin) ? stdin : fopen(path, "rb");
+    if (!in) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+      goto done;
+    }
+    bool read_ok = read_all(in, &buf);
+    int read_err = errno;
+    if (!use_stdin)
+      fclose(in);
+    if (!read_ok) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(read_err));
+      goto done;
+    }
+    // separate files that do not end in a newline
+    if (!pdxcp_bvector_add(&buf, '\n')) {
+      fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+      goto done;
+    }
+  }
+  size_t n_keys;
+  if (!(keys = split_lines(&buf, &n_keys))) {
+    fprintf(stderr, "Error: %s: %s\n", argv[0], strerror(errno));
+    goto done;
+  }
+  const hashbench_hash hashes[] = {
+    {"wyhash", pdxcp_strmap_hash_wyhash},
+    {"fnv1a", pdxcp_strmap_hash_fnv1a},
+    {"book", hash_book}
+  };
+  printf("Default hash: %s\n", pdxcp_strmap_hash_default_name());
+  printf(
+    "%-8s %10s %10s %6s %8s %10s %10s groups[1..%d, %d+]\n",
+    "hash",
+    "keys",
+    "slots",
+    "max",
+    "groups",
+    "ns/hash",
+    "ns/find",
+    HASHBENCH_MAX_PROBE,
+    HASHBENCH_MAX_PROBE + 1
+  );
+  for (size_t i = 0; i < sizeof hashes / sizeof *hashes; i++) {
+    if (hashes[i].hash == hash_book && !opts.book)
+      continue;
+    if (!bench_hash(hashes + i, keys, n_keys, opts.n_rounds)) {
+      fprintf(stderr, "Error: %s: %s\n", hashes[i].name, strerror(errno));
+      goto done;
+    }
+  }
+  if (
+    opts.n_threads &&
+    !bench_sync(keys, n_keys, opts.n_rounds, opts.n_threads)
+  ) {
+    fprintf(stderr, "Error: %s: %s\n", argv[0], strerror(errno));
+    goto done;
+  }
+  status = EXIT_SUCCESS;
+done:
+  free(keys);
+  pdxcp_bvector_destroy(&buf);
+  return status;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file arena_test.cc
+ * @author Derek Huang
+ * @brief arena.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Base testing fixture for arena tests.
+ */
+class ArenaTest : public ::testing::Test {};
+
+/**
+ * Test that all allocations are aligned for any object type.
+ */
+TEST_F(ArenaTest, AlignmentTest)
+{
+  pdxcp::testing::unique_arena arena{64};
+  for (std::size_t size : {1, 3, 7, 8, 13, 64, 65, 200}) {
+    auto ptr = pdxcp_arena_alloc(arena, size);
+    ASSERT_TRUE(ptr) << "ENOMEM allocating " << size << " bytes";
+    EXPECT_EQ(
+      0u, reinterpret_cast<std::uintptr_t>(ptr) % alignof(std::max_align_t)
+    );
+  }
+}
+
+/**
+ * Test that allocations spanning several blocks do not overlap.
+ */
+TEST_F(ArenaTest, MultiBlockTest)
+{
+  pdxcp::testing::unique_arena arena{128};
+  std::vector<unsigned char*> ptrs;
+  // each allocation is filled with its index so overlap clobbers earlier data
+  for (unsigned i = 0; i < 100; i++) {
+    auto ptr = static_cast<unsigned char*>(pdxcp_arena_alloc(arena, 24));
+    ASSERT_TRUE(ptr) << "ENOMEM on allocation " << i;
+    std::memset(ptr, i, 24);
+    ptrs.push_back(ptr);
+  }
+  for (unsigned i = 0; i < ptrs.size(); i++)
+    for (unsigned j = 0; j < 24; j++)
+      ASSERT_EQ(i, ptrs[i][j]) << "allocation " << i << " clobbered";
+}
+
+/**
+ * Test that allocations larger than the block size still succeed.
+ */
+TEST_F(ArenaTest, LargeAllocTest)
+{
+  pdxcp::testing::unique_arena arena{32};
+  auto small = pdxcp_arena_alloc(arena, 16);
+  auto large = static_cast<unsigned char*>(pdxcp_arena_alloc(arena, 1000));
+  ASSERT_TRUE(small);
+  ASSERT_TRUE(large);
+  std::memset(large, 0xff, 1000);
+  EXPECT_EQ(0xff, large[999]);
+}
+
+/**
+ * Test that resetting the arena reuses previously allocated blocks.
+ */
+TEST_F(ArenaTest, ResetReuseTest)
+{
+  pdxcp::testing::unique_arena arena{256};
+  // first pass through the arena, recording the addresses
+  std::set<void*> first_pass;
+  for (unsigned i = 0; i < 50; i++) {
+    auto ptr = pdxcp_arena_alloc(arena, 32);
+    ASSERT_TRUE(ptr);
+    first_pass.insert(ptr);
+  }
+  // after reset, the same allocation sequence reuses the same memory
+  pdxcp_arena_reset(arena);
+  for (unsigned i = 0; i < 50; i++) {
+    auto ptr = pdxcp_arena_alloc(arena, 32);
+    ASSERT_TRUE(ptr);
+    EXPECT_NE(first_pass.end(), first_pass.find(ptr));
+  }
+}
+
+/**
+ * Test that strings are copied into the arena correctly.
+ */
+TEST_F(ArenaTest, StrdupTest)
+{
+  pdxcp::testing::unique_arena arena;
+  const char text[] = "the quick fox jumps over the brown dog";
+  auto copy = pdxcp_arena_strdup(arena, text);
+  ASSERT_TRUE(copy);
+  EXPECT_NE(text, copy);
+  EXPECT_STREQ(text, copy);
+}
+
+}  // namespace
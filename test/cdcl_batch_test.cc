@@ -0,0 +1,279 @@
+/**
+ * @file cdcl_batch_test.cc
+ * @author Derek Huang
+ * @brief cdcl_batch.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_batch.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/cdcl_parser.h"
+
+namespace {
+
+/**
+ * Return the formatted error text for the given error info.
+ *
+ * @param errinfo Parser error info
+ */
+std::string errinfo_text(const pdxcp_cdcl_parser_errinfo& errinfo)
+{
+  char text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
+  pdxcp_cdcl_parser_errinfo_format(&errinfo, text, sizeof text);
+  return text;
+}
+
+/**
+ * Base test fixture for batch parsing tests.
+ */
+class BatchTest : public ::testing::Test {
+protected:
+  /**
+   * Number of declarations in the generated batch input.
+   */
+  static constexpr unsigned n_decls_ = 20000;
+
+  /**
+   * Generate batch input and the expected batch output.
+   *
+   * Declarations cycle through a few forms so that work units differ.
+   *
+   * @param input Input to write to
+   * @param output Expected output to write to
+   * @param n Number of declarations to generate
+   */
+  static void generate(std::string& input, std::string& output, unsigned n)
+  {
+    for (unsigned i = 0; i < n; i++) {
+      auto iden = "x" + std::to_string(i);
+      switch (i % 4) {
+        case 0:
+          input += "int *" + iden + ";\n";
+          output += iden + ": pointer to int\n";
+          break;
+        case 1:
+          input += "const char " + iden + "[10]; /* comment; */\n";
+          output += iden + ": array[10] of const char\n";
+          break;
+        case 2:
+          input += "volatile long *" + iden + "[5]; // comment;\n";
+          output += iden + ": array[5] of pointer to volatile long\n";
+          break;
+        default:
+          input += "unsigned char **const " + iden + ";";
+          output += iden + ": const pointer to pointer to unsigned char\n";
+      }
+    }
+  }
+
+  /**
+   * Batch parse the input, returning the output written.
+   *
+   * @param input Input to parse
+   * @param n_threads Number of threads to use
+   * @param cache_size Per-thread cache capacity, zero for no cache
+   * @param status Parser status to write to
+   * @param n_decls Number of declarations written to write to
+   * @param errinfo Error info to write to
+   */
+  static auto parse(
+    const std::string& input,
+    unsigned n_threads,
+    std::size_t cache_size,
+    pdxcp_cdcl_parser_status& status,
+    std::size_t& n_decls,
+    pdxcp_cdcl_parser_errinfo& errinfo)
+  {
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> out{
+      std::tmpfile(), &std::fclose
+    };
+    if (!out)
+      throw std::runtime_error{"tmpfile() failed"};
+    status = pdxcp_cdcl_batch_parse(
+      input.c_str(),
+      input.size(),
+      out.get(),
+      pdxcp_cdcl_output_format_text,
+      n_threads,
+      cache_size,
+      &n_decls,
+      &errinfo
+    );
+    // read back everything that was written
+    std::string output;
+    std::rewind(out.get());
+    char buf[4096];
+    std::size_t n_read;
+    while ((n_read = std::fread(buf, 1, sizeof buf, out.get())))
+      output.append(buf, n_read);
+    return output;
+  }
+};
+
+/**
+ * Struct holding the input for a `BatchNextDeclEndParamTest`.
+ *
+ * @param input Input buffer contents
+ * @param end Expected offset one past the end of the next declaration
+ */
+struct BatchNextDeclEndInput {
+  const std::string input;
+  const std::size_t end;
+};
+
+/**
+ * Google Test value printer for `BatchNextDeclEndInput`.
+ */
+void PrintTo(const BatchNextDeclEndInput& input, std::ostream* out)
+{
+  *out << input.input;
+}
+
+/**
+ * Parametrized test fixture for finding the end of the next declaration.
+ */
+class BatchNextDeclEndParamTest
+  : public BatchTest,
+    public ::testing::WithParamInterface<BatchNextDeclEndInput> {};
+
+/**
+ * Test that declaration ends are found while skipping comments.
+ */
+TEST_P(BatchNextDeclEndParamTest, Test)
+{
+  const auto& input = GetParam().input;
+  EXPECT_EQ(
+    GetParam().end, pdxcp_cdcl_next_decl_end(input.c_str(), input.size())
+  );
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Base,
+  BatchNextDeclEndParamTest,
+  ::testing::Values(
+    BatchNextDeclEndInput{"int x; char y;", 6},
+    BatchNextDeclEndInput{"int x", 5},
+    BatchNextDeclEndInput{"", 0},
+    BatchNextDeclEndInput{"/* ; */ int x; char y;", 14},
+    BatchNextDeclEndInput{"/* ; **/ int x;", 15},
+    BatchNextDeclEndInput{"// ;\nint x; char y;", 11},
+    BatchNextDeclEndInput{"int / x; char y;", 8},
+    BatchNextDeclEndInput{"int x /* ;", 10},
+    BatchNextDeclEndInput{"int x // ;", 10}
+  )
+);
+
+/**
+ * Test that batch output matches sequential output for various thread counts.
+ */
+TEST_F(BatchTest, OrderTest)
+{
+  std::string input;
+  std::string expected;
+  generate(input, expected, n_decls_);
+  for (unsigned n_threads : {1u, 2u, 4u, 0u}) {
+    for (std::size_t cache_size : {0u, 256u}) {
+      pdxcp_cdcl_parser_status status;
+      std::size_t n_decls;
+      pdxcp_cdcl_parser_errinfo errinfo;
+      auto output = parse(
+        input, n_threads, cache_size, status, n_decls, errinfo
+      );
+      ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+        pdxcp_cdcl_parser_status_string(status);
+      EXPECT_EQ(expected, output) << "n_threads: " << n_threads <<
+        ", cache_size: " << cache_size;
+      EXPECT_EQ(n_decls_, n_decls);
+    }
+  }
+}
+
+/**
+ * Test that batch output stops at the first error in input order.
+ */
+TEST_F(BatchTest, ErrorTest)
+{
+  // valid declarations, then a bad one, then more valid declarations
+  std::string input;
+  std::string expected;
+  generate(input, expected, n_decls_ / 2);
+  input += "int bad z;\n";
+  std::string tail_expected;
+  generate(input, tail_expected, n_decls_ / 2);
+  for (unsigned n_threads : {1u, 4u}) {
+    for (std::size_t cache_size : {0u, 256u}) {
+      pdxcp_cdcl_parser_status status;
+      std::size_t n_decls;
+      pdxcp_cdcl_parser_errinfo errinfo;
+      auto output = parse(
+        input, n_threads, cache_size, status, n_decls, errinfo
+      );
+      EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+        "status: " << pdxcp_cdcl_parser_status_string(status);
+      EXPECT_EQ(status, errinfo.parser.status);
+      EXPECT_EQ(
+        "Incomplete declaration for identifier bad", errinfo_text(errinfo)
+      );
+      // offset is from the start of the whole input
+      EXPECT_EQ(input.find("z;"), errinfo.offset);
+      EXPECT_EQ(1u, errinfo.span);
+      EXPECT_EQ(expected, output) << "n_threads: " << n_threads <<
+        ", cache_size: " << cache_size;
+      EXPECT_EQ(n_decls_ / 2, n_decls);
+    }
+  }
+}
+
+/**
+ * Test that typedef names are types in every work unit.
+ */
+TEST_F(BatchTest, TypedefTest)
+{
+  // typedefs at the start, middle, and end of the input, with uses of each
+  // typedef name spread over the later work units
+  std::string input{"typedef unsigned long word;\n"};
+  std::string expected{"word: typedef for unsigned long\n"};
+  generate(input, expected, n_decls_ / 2);
+  input += "typedef word *word_ptr;\n";
+  expected += "word_ptr: typedef for pointer to word\n";
+  for (unsigned i = 0; i < n_decls_ / 2; i++) {
+    auto iden = "w" + std::to_string(i);
+    if (i % 2) {
+      input += "const word " + iden + ";\n";
+      expected += iden + ": const word\n";
+    }
+    else {
+      input += "word_ptr " + iden + "[2];\n";
+      expected += iden + ": array[2] of word_ptr\n";
+    }
+  }
+  input += "typedef word_ptr (*word_fn)(word);";
+  expected += "word_fn: typedef for pointer to function(word) returning "
+    "word_ptr\n";
+  for (unsigned n_threads : {1u, 4u}) {
+    for (std::size_t cache_size : {0u, 256u}) {
+      pdxcp_cdcl_parser_status status;
+      std::size_t n_decls;
+      pdxcp_cdcl_parser_errinfo errinfo;
+      auto output = parse(
+        input, n_threads, cache_size, status, n_decls, errinfo
+      );
+      ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+        pdxcp_cdcl_parser_status_string(status);
+      EXPECT_EQ(expected, output) << "n_threads: " << n_threads <<
+        ", cache_size: " << cache_size;
+      EXPECT_EQ(n_decls_ + 3, n_decls);
+    }
+  }
+}
+
+}  // namespace
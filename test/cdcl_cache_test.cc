@@ -0,0 +1,220 @@
+/**
+ * @file cdcl_cache_test.cc
+ * @author Derek Huang
+ * @brief cdcl_cache.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_cache.h"
+
+#include <cstddef>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Return the formatted error text for the given error info.
+ *
+ * @param errinfo Parser error info
+ */
+std::string errinfo_text(const pdxcp_cdcl_parser_errinfo& errinfo)
+{
+  char text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
+  pdxcp_cdcl_parser_errinfo_format(&errinfo, text, sizeof text);
+  return text;
+}
+
+/**
+ * Base test fixture for parse result cache tests.
+ *
+ * Manages the cache, parser state, and output byte vector for each test.
+ */
+class CacheTest : public ::testing::Test {
+protected:
+  /**
+   * Default cache capacity.
+   */
+  static constexpr std::size_t capacity_ = 64;
+
+  /**
+   * Ctor.
+   */
+  CacheTest()
+  {
+    pdxcp_cdcl_cache_init(&cache_, capacity_);
+    pdxcp_cdcl_parser_init(&parser_);
+    pdxcp_bvector_init(&out_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~CacheTest()
+  {
+    pdxcp_bvector_destroy(&out_);
+    pdxcp_cdcl_parser_destroy(&parser_);
+    pdxcp_cdcl_cache_destroy(&cache_);
+  }
+
+  /**
+   * Reinitialize the cache with a different capacity.
+   *
+   * @param capacity Maximum number of cache entries
+   */
+  void reset_cache(std::size_t capacity)
+  {
+    pdxcp_cdcl_cache_destroy(&cache_);
+    pdxcp_cdcl_cache_init(&cache_, capacity);
+  }
+
+  /**
+   * Parse input through the cache, clearing the output first.
+   *
+   * @param input Input declarations
+   */
+  auto parse(const std::string& input)
+  {
+    out_.size = 0;
+    return pdxcp_cdcl_cache_parse(
+      &cache_, &parser_, input.c_str(), input.size(), &out_
+    );
+  }
+
+  /**
+   * Return the output as a string.
+   */
+  auto output() const
+  {
+    return pdxcp::testing::to_string(out_);
+  }
+
+  pdxcp_cdcl_cache cache_;
+  pdxcp_cdcl_parser parser_;
+  pdxcp_bvector out_;
+};
+
+/**
+ * Test that repeated declarations hit regardless of whitespace or comments.
+ */
+TEST_F(CacheTest, HitMissTest)
+{
+  auto status = parse(
+    "char *argv[];\n"
+    "const char *name;\n"
+    "char  * argv [ ] ; /* comment */ const char*name;\n"
+    "const /* comment */ char *name; // comment\n"
+    "int x;"
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    "argv: array[] of pointer to char\n"
+    "name: pointer to const char\n"
+    "argv: array[] of pointer to char\n"
+    "name: pointer to const char\n"
+    "name: pointer to const char\n"
+    "x: int\n",
+    output()
+  );
+  EXPECT_EQ(6u, parser_.n_decls);
+  EXPECT_EQ(3u, cache_.hits);
+  EXPECT_EQ(3u, cache_.misses);
+  EXPECT_EQ(3u, cache_.size);
+}
+
+/**
+ * Test that whitespace separating identifier characters is kept in the key.
+ */
+TEST_F(CacheTest, KeyTest)
+{
+  auto status = parse("unsigned long x; unsigned long  x; long x; long/**/x;");
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    "x: unsigned long\nx: unsigned long\nx: long\nx: long\n", output()
+  );
+  EXPECT_EQ(2u, cache_.hits);
+  EXPECT_EQ(2u, cache_.misses);
+}
+
+/**
+ * Test that the least recently used entry is evicted when full.
+ */
+TEST_F(CacheTest, EvictTest)
+{
+  reset_cache(2);
+  // a is used again before c is inserted, so b is evicted instead of a
+  auto status = parse("int a; int b; int a; int c; int a; int b;");
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ("a: int\nb: int\na: int\nc: int\na: int\nb: int\n", output());
+  EXPECT_EQ(2u, cache_.hits);
+  EXPECT_EQ(4u, cache_.misses);
+  EXPECT_EQ(2u, cache_.size);
+}
+
+/**
+ * Test that cached results are reused across calls.
+ */
+TEST_F(CacheTest, ReuseTest)
+{
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, parse("double *d[4];"));
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, parse("  double*d[4];  "));
+  EXPECT_EQ("d: array[4] of pointer to double\n", output());
+  EXPECT_EQ(1u, cache_.hits);
+  EXPECT_EQ(1u, cache_.misses);
+}
+
+/**
+ * Test that parsing stops at the first error with preceding output kept.
+ */
+TEST_F(CacheTest, ErrorTest)
+{
+  const std::string input{"int x; int x; int bad z; int y;"};
+  auto status = parse(input);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(status, parser_.errinfo.parser.status);
+  EXPECT_EQ(
+    "Incomplete declaration for identifier bad", errinfo_text(parser_.errinfo)
+  );
+  EXPECT_EQ(input.find("z;"), parser_.errinfo.offset);
+  EXPECT_EQ("x: int\nx: int\n", output());
+  EXPECT_EQ(2u, parser_.n_decls);
+}
+
+/**
+ * Test that declarations using typedef names are parsed but not cached.
+ */
+TEST_F(CacheTest, TypedefTest)
+{
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  parser_.typedefs = &typedefs;
+  auto status = parse("typedef long T; T x; T x; int y; int y;");
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    "T: typedef for long\nx: T\nx: T\ny: int\ny: int\n", output()
+  );
+  EXPECT_EQ(1u, cache_.hits);
+  EXPECT_EQ(4u, cache_.misses);
+  EXPECT_EQ(1u, cache_.size);
+  // with another typedef name table, T is not a type
+  pdxcp_cdcl_typedefs other;
+  pdxcp_cdcl_typedefs_init(&other);
+  parser_.typedefs = &other;
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, parse("T x;"));
+  parser_.typedefs = nullptr;
+  pdxcp_cdcl_typedefs_destroy(&other);
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+}
+
+}  // namespace
@@ -0,0 +1,173 @@
+/**
+ * @file cdcl_canon_test.cc
+ * @author Derek Huang
+ * @brief cdcl_canon.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_canon.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Base test fixture for canonicalization tests.
+ *
+ * Manages the arena declarations are parsed into.
+ */
+class CanonTest : public ::testing::Test {
+protected:
+  /**
+   * Parse a single declaration from a string.
+   *
+   * @param input Input declaration
+   */
+  auto parse(const std::string& input)
+  {
+    return pdxcp::testing::parse_decl(arena_, input);
+  }
+
+  /**
+   * Return the English description of a parsed declaration.
+   *
+   * @param decl Parsed declaration
+   */
+  static std::string describe(const pdxcp_cdcl_decl& decl)
+  {
+    pdxcp_bvector out;
+    pdxcp_bvector_init(&out);
+    pdxcp_cdcl_decl_render(&decl, &out);
+    auto text = pdxcp::testing::to_string(out);
+    pdxcp_bvector_destroy(&out);
+    return text;
+  }
+
+  pdxcp::testing::unique_arena arena_;
+};
+
+/**
+ * Struct holding the input for a `CanonParamTest`.
+ *
+ * @param first First input declaration
+ * @param second Second input declaration
+ * @param same `true` if the declarations have the same canonical type
+ */
+struct CanonInput {
+  const std::string first;
+  const std::string second;
+  const bool same;
+};
+
+/**
+ * Google Test value printer for `CanonInput`.
+ */
+void PrintTo(const CanonInput& input, std::ostream* out)
+{
+  *out << "{" << input.first << ", " << input.second << ", " << input.same <<
+    "}";
+}
+
+/**
+ * Parametrized test fixture for comparing canonical types.
+ */
+class CanonParamTest
+  : public CanonTest,
+    public ::testing::WithParamInterface<CanonInput> {};
+
+/**
+ * Test that hashes and comparison agree on which types are the same.
+ */
+TEST_P(CanonParamTest, Test)
+{
+  auto first = parse(GetParam().first);
+  auto second = parse(GetParam().second);
+  EXPECT_EQ(GetParam().same, pdxcp_cdcl_decl_type_equal(&first, &second));
+  EXPECT_EQ(
+    GetParam().same,
+    pdxcp_cdcl_decl_type_hash(&first) == pdxcp_cdcl_decl_type_hash(&second)
+  );
+  // canonicalizing does not change the hash or the comparison
+  auto hash = pdxcp_cdcl_decl_type_hash(&first);
+  ASSERT_TRUE(pdxcp_cdcl_decl_canonicalize(&first, arena_));
+  EXPECT_EQ(hash, pdxcp_cdcl_decl_type_hash(&first));
+  EXPECT_EQ(GetParam().same, pdxcp_cdcl_decl_type_equal(&first, &second));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Same,
+  CanonParamTest,
+  ::testing::Values(
+    CanonInput{"signed int x;", "int y;", true},
+    CanonInput{"const volatile long x;", "volatile const signed long y;", true},
+    CanonInput{"char *const volatile p;", "char *volatile const q;", true},
+    CanonInput{"struct s *a[4];", "struct s *b[4];", true},
+    CanonInput{"void f(int a[10]);", "void g(int *);", true},
+    CanonInput{"void f(const int x);", "void g(int);", true},
+    CanonInput{"void f(char *const p);", "void g(char *);", true},
+    CanonInput{"void f(int h(char));", "void g(int (*)(char));", true},
+    CanonInput{"int (*f)(signed int, long);", "int (*g)(int x, long y);", true}
+  )
+);
+
+INSTANTIATE_TEST_SUITE_P(
+  Different,
+  CanonParamTest,
+  ::testing::Values(
+    CanonInput{"char c;", "signed char c;", false},
+    CanonInput{"int x;", "unsigned int x;", false},
+    CanonInput{"int *const p;", "int *p;", false},
+    CanonInput{"const int x;", "int x;", false},
+    CanonInput{"int a[10];", "int a[11];", false},
+    CanonInput{"int a[10];", "int *a;", false},
+    CanonInput{"struct a x;", "struct b x;", false},
+    CanonInput{"struct a x;", "enum a x;", false},
+    CanonInput{"int f();", "int f(void);", false},
+    CanonInput{"int f(int);", "int f(int, int);", false},
+    CanonInput{"void f(const char *p);", "void f(char *p);", false},
+    CanonInput{"int **x;", "int *x;", false}
+  )
+);
+
+/**
+ * Test that canonicalization rewrites declarations as documented.
+ */
+TEST_F(CanonTest, CanonicalizeTest)
+{
+  auto decl = parse(
+    "signed long f(const int a[10], int g(char), signed char *const c);"
+  );
+  ASSERT_TRUE(pdxcp_cdcl_decl_canonicalize(&decl, arena_));
+  EXPECT_EQ(
+    describe(parse("long f(const int *a, int (*g)(char), signed char *c);")),
+    describe(decl)
+  );
+}
+
+/**
+ * Test that hashes are stable.
+ *
+ * These values must only change if the hashed encoding changes.
+ */
+TEST_F(CanonTest, StableHashTest)
+{
+  auto decl = parse("int x;");
+  // FNV-1a of 0x13 0x00 0x03 0x00
+  std::uint64_t expected = 0xcbf29ce484222325u;
+  for (auto byte : {0x13u, 0x00u, 0x03u, 0x00u})
+    expected = (expected ^ byte) * 0x100000001b3u;
+  EXPECT_EQ(expected, pdxcp_cdcl_decl_type_hash(&decl));
+  // identifiers are not part of the type
+  auto other = parse("signed int y;");
+  EXPECT_EQ(expected, pdxcp_cdcl_decl_type_hash(&other));
+}
+
+}  // namespace
@@ -0,0 +1,317 @@
+/**
+ * @file cdcl_doc_test.cc
+ * @author Derek Huang
+ * @brief cdcl_doc.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_doc.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Test fixture managing a document.
+ */
+class DocTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  DocTest()
+  {
+    pdxcp_cdcl_doc_init(&doc_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~DocTest()
+  {
+    pdxcp_cdcl_doc_destroy(&doc_);
+  }
+
+  /**
+   * Replace the document text.
+   *
+   * @param text New text
+   */
+  void set(const std::string& text)
+  {
+    auto status = pdxcp_cdcl_doc_set(&doc_, text.c_str(), text.size());
+    if (!PDXCP_CDCL_PARSER_OK(status))
+      throw std::runtime_error{
+        std::string{"pdxcp_cdcl_doc_set() failed: "} +
+        pdxcp_cdcl_parser_status_string(status)
+      };
+  }
+
+  /**
+   * Edit the document text.
+   *
+   * @param offset Byte offset of the edit
+   * @param n_removed Number of bytes removed
+   * @param inserted Text inserted
+   */
+  void edit(
+    std::size_t offset, std::size_t n_removed, const std::string& inserted)
+  {
+    auto status = pdxcp_cdcl_doc_edit(
+      &doc_, offset, n_removed, inserted.c_str(), inserted.size()
+    );
+    if (!PDXCP_CDCL_PARSER_OK(status))
+      throw std::runtime_error{
+        std::string{"pdxcp_cdcl_doc_edit() failed: "} +
+        pdxcp_cdcl_parser_status_string(status)
+      };
+  }
+
+  /**
+   * Return the document text.
+   *
+   * @param doc Document
+   */
+  static std::string text(const pdxcp_cdcl_doc& doc)
+  {
+    return pdxcp::testing::to_string(doc.text);
+  }
+
+  /**
+   * Return a description of a document declaration.
+   *
+   * Successfully parsed declarations are rendered in English while errors
+   * are described by their status, error codes, and offset.
+   *
+   * @param doc Document
+   * @param i Declaration index
+   */
+  static std::string describe(const pdxcp_cdcl_doc& doc, std::size_t i)
+  {
+    const auto& decl = doc.decls[i];
+    std::stringstream ss;
+    ss << decl.first << "+" << decl.n_tokens << " ";
+    if (PDXCP_CDCL_PARSER_OK(decl.status)) {
+      pdxcp_bvector out;
+      pdxcp_bvector_init(&out);
+      pdxcp_cdcl_decl_render(&decl.decl, &out);
+      ss.write(reinterpret_cast<const char*>(out.data), out.size);
+      pdxcp_bvector_destroy(&out);
+    }
+    else {
+      ss << pdxcp_cdcl_parser_status_string(decl.status);
+      if (decl.errinfo) {
+        const auto& errinfo = *decl.errinfo;
+        ss << " " << pdxcp_cdcl_parser_error_string(errinfo.parser.error) <<
+          " " << errinfo.lexer.status << " @" << errinfo.offset;
+      }
+    }
+    return ss.str();
+  }
+
+  /**
+   * Return a description of all of a document's tokens and declarations.
+   *
+   * @param doc Document
+   */
+  static std::string describe(const pdxcp_cdcl_doc& doc)
+  {
+    std::stringstream ss;
+    for (std::size_t i = 0; i < doc.n_tokens; i++) {
+      const auto& token = doc.tokens[i];
+      ss << pdxcp_cdcl_token_type_string(token.type) << "@" << token.offset <<
+        "+" << token.size << "\n";
+    }
+    for (std::size_t i = 0; i < doc.n_decls; i++)
+      ss << describe(doc, i);
+    return ss.str();
+  }
+
+  /**
+   * Return the description of a document with the same text parsed from
+   * scratch, for comparison with an incrementally reparsed document.
+   */
+  std::string describe_fresh() const
+  {
+    pdxcp_cdcl_doc fresh;
+    pdxcp_cdcl_doc_init(&fresh);
+    auto content = text(doc_);
+    pdxcp_cdcl_doc_set(&fresh, content.c_str(), content.size());
+    auto desc = describe(fresh);
+    pdxcp_cdcl_doc_destroy(&fresh);
+    return desc;
+  }
+
+  pdxcp_cdcl_doc doc_;
+};
+
+/**
+ * Test that a document is split into declarations that are each parsed.
+ */
+TEST_F(DocTest, SetTest)
+{
+  set("int x;\n/* ; */ char *argv[];  long (*f)(double) ;\nvoid g(");
+  ASSERT_EQ(4u, doc_.n_decls);
+  EXPECT_EQ(0u, doc_.first_parsed);
+  EXPECT_EQ(4u, doc_.n_parsed);
+  EXPECT_EQ("0+3 x: int\n", describe(doc_, 0));
+  EXPECT_EQ("3+6 argv: array[] of pointer to char\n", describe(doc_, 1));
+  EXPECT_EQ(
+    "9+9 f: pointer to function(double) returning long\n", describe(doc_, 2)
+  );
+  // unterminated final declaration
+  EXPECT_EQ(18u, doc_.decls[3].first);
+  EXPECT_EQ(3u, doc_.decls[3].n_tokens);
+  EXPECT_FALSE(PDXCP_CDCL_PARSER_OK(doc_.decls[3].status));
+  ASSERT_NE(nullptr, doc_.decls[3].errinfo);
+  EXPECT_EQ(doc_.decls[3].decl.node, nullptr);
+  // lookups by offset
+  EXPECT_EQ(0u, pdxcp_cdcl_doc_find(&doc_, 0));
+  EXPECT_EQ(0u, pdxcp_cdcl_doc_find(&doc_, 6));
+  EXPECT_EQ(doc_.n_decls, pdxcp_cdcl_doc_find(&doc_, 7));
+  EXPECT_EQ(1u, pdxcp_cdcl_doc_find(&doc_, 17));
+  EXPECT_EQ(3u, pdxcp_cdcl_doc_find(&doc_, text(doc_).size()));
+  // clearing the document
+  set("");
+  EXPECT_EQ(0u, doc_.n_tokens);
+  EXPECT_EQ(0u, doc_.n_decls);
+}
+
+/**
+ * Test that edits outside of the document are rejected.
+ */
+TEST_F(DocTest, BadEditTest)
+{
+  set("int x;");
+  EXPECT_EQ(
+    pdxcp_cdcl_parser_status_bad_edit,
+    pdxcp_cdcl_doc_edit(&doc_, 7, 0, "y", 1)
+  );
+  EXPECT_EQ(
+    pdxcp_cdcl_parser_status_bad_edit,
+    pdxcp_cdcl_doc_edit(&doc_, 4, 3, nullptr, 0)
+  );
+  EXPECT_EQ("int x;", text(doc_));
+  EXPECT_EQ(1u, doc_.n_decls);
+}
+
+/**
+ * Test that an edit in a large document only relexes and reparses locally.
+ */
+TEST_F(DocTest, LocalEditTest)
+{
+  std::string content;
+  for (unsigned i = 0; i < 5000; i++)
+    content += "char *name" + std::to_string(i) + "[4];\n";
+  set(content);
+  ASSERT_EQ(5000u, doc_.n_decls);
+  // rename an identifier in the middle of the document
+  auto offset = content.find("name2500[");
+  edit(offset, 4, "item");
+  EXPECT_EQ(3u, doc_.n_lexed);
+  EXPECT_EQ(2500u, doc_.first_parsed);
+  EXPECT_EQ(1u, doc_.n_parsed);
+  EXPECT_EQ(
+    "17500+7 item2500: array[4] of pointer to char\n", describe(doc_, 2500)
+  );
+  // splitting a declaration in two only parses the two halves
+  edit(offset - 1, 0, "x; char ");
+  EXPECT_EQ(2500u, doc_.first_parsed);
+  EXPECT_EQ(2u, doc_.n_parsed);
+  EXPECT_EQ(5001u, doc_.n_decls);
+  EXPECT_EQ("17500+3 x: char\n", describe(doc_, 2500));
+  // joining them again
+  edit(offset - 1, 8, "");
+  EXPECT_EQ(2500u, doc_.first_parsed);
+  EXPECT_EQ(1u, doc_.n_parsed);
+  EXPECT_EQ(5000u, doc_.n_decls);
+  // whitespace between declarations needs no parsing
+  edit(offset - 6, 0, "\n\n");
+  EXPECT_EQ(0u, doc_.n_parsed);
+  EXPECT_EQ(1u, doc_.n_lexed);
+  // declarations after the edit are shifted
+  EXPECT_EQ(
+    content.find("name4999") + 2,
+    doc_.tokens[doc_.decls[4999].first + 2].offset
+  );
+  EXPECT_EQ(describe_fresh(), describe(doc_));
+}
+
+/**
+ * Test that opening a comment relexes up to the end of the comment.
+ */
+TEST_F(DocTest, CommentEditTest)
+{
+  set("int a; int b; int c; int d;");
+  edit(7, 0, "/*");
+  EXPECT_EQ("int a; /*int b; int c; int d;", text(doc_));
+  EXPECT_EQ(1u, doc_.n_decls);
+  EXPECT_EQ(describe_fresh(), describe(doc_));
+  edit(text(doc_).find(" int d"), 0, "*/");
+  EXPECT_EQ(2u, doc_.n_decls);
+  EXPECT_EQ("3+3 d: int\n", describe(doc_, 1));
+  EXPECT_EQ(describe_fresh(), describe(doc_));
+}
+
+/**
+ * Test that typing a declaration one character at a time parses it once done.
+ */
+TEST_F(DocTest, TypingTest)
+{
+  set("int x;\n\nlong y;\n");
+  const std::string typed{"const char *(*f)(int);"};
+  std::size_t offset = 7;
+  for (auto c : typed) {
+    edit(offset++, 0, std::string(1, c));
+    EXPECT_EQ(describe_fresh(), describe(doc_)) << text(doc_);
+  }
+  ASSERT_EQ(3u, doc_.n_decls);
+  EXPECT_EQ(
+    "3+11 f: pointer to function(int) returning pointer to const char\n",
+    describe(doc_, 1)
+  );
+  EXPECT_EQ("14+3 y: long\n", describe(doc_, 2));
+}
+
+/**
+ * Test that random edits give the same result as parsing from scratch.
+ */
+TEST_F(DocTest, RandomEditTest)
+{
+  const std::string snippets[] = {
+    "int ", "x", "y1", ";", "; ", " ", "\n", "*", "(", ")", "[10]", "[",
+    "/*", "*/", "//", "char", "struct s ", "enum", "0x1", "0", "const ",
+    "void", "unsigned ", "(*f)(int, char *)", ",", "@", "7"
+  };
+  std::mt19937 gen{8675309};
+  set("int x; char *y[2]; long (*f)(void);");
+  for (unsigned i = 0; i < 3000; i++) {
+    auto size = doc_.text.size;
+    std::uniform_int_distribution<std::size_t> offset_dist{0, size};
+    auto offset = offset_dist(gen);
+    std::uniform_int_distribution<std::size_t> removed_dist{
+      0, std::min<std::size_t>(size - offset, (size > 200) ? 12 : 3)
+    };
+    auto n_removed = removed_dist(gen);
+    std::uniform_int_distribution<std::size_t> snippet_dist{
+      0, sizeof snippets / sizeof *snippets - 1
+    };
+    edit(offset, n_removed, snippets[snippet_dist(gen)]);
+    ASSERT_EQ(describe_fresh(), describe(doc_)) << "edit " << i << ": " <<
+      text(doc_);
+  }
+}
+
+}  // namespace
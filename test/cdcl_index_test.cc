@@ -0,0 +1,336 @@
+/**
+ * @file cdcl_index_test.cc
+ * @author Derek Huang
+ * @brief cdcl_index.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_index.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_parser.h"
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Test that top-level declarations are extracted from C source text.
+ */
+TEST(IndexNextDeclTest, Test)
+{
+  const std::string input{
+    "#include <stdio.h>\n"
+    "#define MAX(a, b) \\\n"
+    "  ((a) > (b) ? (a) : (b))\n"
+    "/* leading; comment */\n"
+    "extern const char *names[10];\n"
+    "static int counter = 0;\n"
+    "int a, b;\n"
+    "int main(int argc, char *argv[])\n"
+    "{\n"
+    "  if (argc > 1) { puts(\"}\"); }\n"
+    "  return 0;\n"
+    "}\n"
+    "static inline int h(void) { return 0; }\n"
+    "extern \"C\" int g(void);\n"
+    "struct point { int x; int y; };\n"
+    "#ifdef __cplusplus\n"
+    "extern \"C\" {\n"
+    "#endif\n"
+    "double hypot2(double x, // x coordinate\n"
+    "  double y);\n"
+    "#ifdef __cplusplus\n"
+    "}\n"
+    "#endif\n"
+    "const char *msg = \"hi; there\";\n"
+    "int v[3] = {1, 2, 3};\n"
+    "typedef unsigned long size_type;"
+  };
+  const std::vector<std::pair<std::string, std::size_t>> expected{
+    {"const char *names[10];", input.find("extern const")},
+    {"int counter;", input.find("static int")},
+    {"int main(int argc, char *argv[]);", input.find("int main")},
+    {"int h(void);", input.find("static inline")},
+    {"int g(void);", input.find("extern \"C\" int")},
+    {"double hypot2(double x, double y);", input.find("double hypot2")},
+    {"const char *msg;", input.find("const char *msg")},
+    {"int v[3];", input.find("int v[3]")},
+    {"typedef unsigned long size_type;", input.find("typedef")}
+  };
+  pdxcp_bvector text;
+  pdxcp_bvector_init(&text);
+  std::vector<std::pair<std::string, std::size_t>> actual;
+  std::size_t pos = 0;
+  std::size_t start;
+  while (
+    pdxcp_cdcl_index_next_decl(
+      input.c_str(), input.size(), &pos, &start, &text
+    )
+  ) {
+    // text is also null-terminated
+    EXPECT_EQ('\0', text.data[text.size]);
+    actual.emplace_back(pdxcp::testing::to_string(text), start);
+  }
+  pdxcp_bvector_destroy(&text);
+  EXPECT_EQ(input.size(), pos);
+  EXPECT_EQ(expected, actual);
+}
+
+/**
+ * Test fixture managing a temporary source tree.
+ */
+class IndexTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   *
+   * Creates the temporary tree root.
+   */
+  IndexTest()
+  {
+    auto tmpdir = std::getenv("TMPDIR");
+    root_ = std::string{(tmpdir && *tmpdir) ? tmpdir : "/tmp"} +
+      "/pdxcp_index_XXXXXX";
+    if (!mkdtemp(root_.data()))
+      throw std::runtime_error{"mkdtemp() failed"};
+    dirs_.push_back(root_);
+    pdxcp_cdcl_index_paths_init(&paths_);
+  }
+
+  /**
+   * Dtor.
+   *
+   * Removes the temporary tree, deepest entries first.
+   */
+  ~IndexTest()
+  {
+    pdxcp_cdcl_index_paths_destroy(&paths_);
+    for (const auto& file : files_)
+      std::remove(file.c_str());
+    for (auto it = dirs_.rbegin(); it != dirs_.rend(); it++)
+      rmdir(it->c_str());
+  }
+
+  /**
+   * Create a subdirectory of the tree root.
+   *
+   * @param path Path relative to the tree root
+   */
+  void add_dir(const std::string& path)
+  {
+    auto full = root_ + "/" + path;
+    if (mkdir(full.c_str(), 0700))
+      throw std::runtime_error{"mkdir() failed"};
+    dirs_.push_back(std::move(full));
+  }
+
+  /**
+   * Create a file in the tree.
+   *
+   * @param path Path relative to the tree root
+   * @param content File contents
+   */
+  void add_file(const std::string& path, const std::string& content)
+  {
+    auto full = root_ + "/" + path;
+    std::ofstream{full, std::ios::binary} << content;
+    files_.push_back(std::move(full));
+  }
+
+  /**
+   * Index the tree, returning the index data.
+   *
+   * @param n_threads Number of threads to use
+   * @param stats Indexing statistics to write to
+   */
+  auto build(unsigned n_threads, pdxcp_cdcl_index_stats& stats)
+  {
+    if (
+      !paths_.n_paths &&
+      !pdxcp_cdcl_index_paths_add_tree(&paths_, root_.c_str())
+    )
+      throw std::runtime_error{"pdxcp_cdcl_index_paths_add_tree() failed"};
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> out{
+      std::tmpfile(), &std::fclose
+    };
+    if (!out)
+      throw std::runtime_error{"tmpfile() failed"};
+    auto status = pdxcp_cdcl_index_build(
+      &paths_, out.get(), n_threads, &stats
+    );
+    if (!PDXCP_CDCL_PARSER_OK(status))
+      throw std::runtime_error{
+        std::string{"pdxcp_cdcl_index_build() failed: "} +
+        pdxcp_cdcl_parser_status_string(status)
+      };
+    // read back everything that was written
+    std::string data;
+    std::rewind(out.get());
+    char buf[4096];
+    std::size_t n_read;
+    while ((n_read = std::fread(buf, 1, sizeof buf, out.get())))
+      data.append(buf, n_read);
+    return data;
+  }
+
+  /**
+   * Return the entries for an identifier.
+   *
+   * @param index Index view
+   * @param name Identifier
+   */
+  static auto find(const pdxcp_cdcl_index& index, const char* name)
+  {
+    std::size_t n_found;
+    auto first = pdxcp_cdcl_index_find(&index, name, &n_found);
+    std::vector<pdxcp_cdcl_index_entry> entries(n_found);
+    for (std::size_t i = 0; i < n_found; i++) {
+      if (!pdxcp_cdcl_index_get(&index, first + i, &entries[i]))
+        throw std::runtime_error{"pdxcp_cdcl_index_get() failed"};
+    }
+    return entries;
+  }
+
+  std::string root_;
+  std::vector<std::string> dirs_;
+  std::vector<std::string> files_;
+  pdxcp_cdcl_index_paths paths_;
+};
+
+/**
+ * Test that a source tree is indexed and queried correctly.
+ */
+TEST_F(IndexTest, BuildTest)
+{
+  add_dir("sub");
+  add_file("a.h", "int x;\nchar *f(int);\nt z;\n");
+  add_file("empty.c", "");
+  add_file("notes.txt", "int ignored;\n");
+  add_file(
+    "sub/b.c",
+    "long x[4];\ndouble g(void);\nint h(int n) { return n; }\ntypedef int t;\n"
+    "t y;\n"
+  );
+  pdxcp_cdcl_index_stats stats;
+  auto data = build(1, stats);
+  EXPECT_EQ(3u, stats.n_files);
+  EXPECT_EQ(0u, stats.n_failed);
+  EXPECT_EQ(7u, stats.n_entries);
+  EXPECT_EQ(1u, stats.n_skipped);
+  pdxcp_cdcl_index index;
+  ASSERT_TRUE(pdxcp_cdcl_index_open(&index, data.data(), data.size()));
+  EXPECT_EQ(3u, index.n_files);
+  EXPECT_EQ(7u, index.n_entries);
+  // declarations of x are ordered by file
+  auto x = find(index, "x");
+  ASSERT_EQ(2u, x.size());
+  EXPECT_EQ(root_ + "/a.h", x[0].path);
+  EXPECT_STREQ("int x;", x[0].decl);
+  EXPECT_EQ(0u, x[0].pos);
+  EXPECT_EQ(root_ + "/sub/b.c", x[1].path);
+  EXPECT_STREQ("long x[4];", x[1].decl);
+  auto g = find(index, "g");
+  ASSERT_EQ(1u, g.size());
+  EXPECT_STREQ("double g(void);", g[0].decl);
+  EXPECT_EQ(11u, g[0].pos);
+  // definitions are indexed by the declaration before their body
+  auto h = find(index, "h");
+  ASSERT_EQ(1u, h.size());
+  EXPECT_STREQ("int h(int n);", h[0].decl);
+  EXPECT_EQ(27u, h[0].pos);
+  // typedef names are types in the rest of the file declaring them only
+  auto t = find(index, "t");
+  ASSERT_EQ(1u, t.size());
+  EXPECT_STREQ("typedef int t;", t[0].decl);
+  auto y = find(index, "y");
+  ASSERT_EQ(1u, y.size());
+  EXPECT_STREQ("t y;", y[0].decl);
+  EXPECT_TRUE(find(index, "z").empty());
+  // files without a source extension are skipped
+  EXPECT_TRUE(find(index, "ignored").empty());
+  EXPECT_TRUE(find(index, "").empty());
+  EXPECT_TRUE(find(index, "zzz").empty());
+  // output does not depend on the number of threads
+  EXPECT_EQ(data, build(4, stats));
+}
+
+/**
+ * Test that many files are all indexed when work is stolen.
+ */
+TEST_F(IndexTest, StealTest)
+{
+  constexpr unsigned n_files = 300;
+  // one large file so the thread that gets it falls behind
+  std::string large;
+  for (unsigned i = 0; i < 20000; i++)
+    large += "int large" + std::to_string(i) + ";\n";
+  add_file("0.c", large);
+  for (unsigned i = 1; i < n_files; i++)
+    add_file(std::to_string(i) + ".h", "long v" + std::to_string(i) + ";\n");
+  pdxcp_cdcl_index_stats stats;
+  auto data = build(8, stats);
+  EXPECT_EQ(n_files, stats.n_files);
+  EXPECT_EQ(20000u + n_files - 1, stats.n_entries);
+  pdxcp_cdcl_index index;
+  ASSERT_TRUE(pdxcp_cdcl_index_open(&index, data.data(), data.size()));
+  for (unsigned i = 1; i < n_files; i++) {
+    auto name = "v" + std::to_string(i);
+    ASSERT_EQ(1u, find(index, name.c_str()).size()) << name;
+  }
+  EXPECT_EQ(1u, find(index, "large19999").size());
+  EXPECT_EQ(data, build(1, stats));
+}
+
+/**
+ * Test that invalid index data is rejected.
+ */
+TEST_F(IndexTest, OpenTest)
+{
+  pdxcp_cdcl_index_stats stats;
+  add_file("a.h", "int x;\n");
+  auto data = build(1, stats);
+  pdxcp_cdcl_index index;
+  ASSERT_TRUE(pdxcp_cdcl_index_open(&index, data.data(), data.size()));
+  // truncated header and tables
+  EXPECT_FALSE(pdxcp_cdcl_index_open(&index, data.data(), 0));
+  EXPECT_FALSE(
+    pdxcp_cdcl_index_open(
+      &index, data.data(), PDXCP_CDCL_INDEX_HEADER_SIZE + 8
+    )
+  );
+  // string pool not null-terminated
+  EXPECT_FALSE(pdxcp_cdcl_index_open(&index, data.data(), data.size() - 1));
+  // bad magic
+  auto bad = data;
+  bad[0] = 'X';
+  EXPECT_FALSE(pdxcp_cdcl_index_open(&index, bad.data(), bad.size()));
+  // nonzero version high bytes or reserved bytes
+  for (std::size_t i = 9; i < 16; i++) {
+    bad = data;
+    bad[i] = 1;
+    EXPECT_FALSE(pdxcp_cdcl_index_open(&index, bad.data(), bad.size())) << i;
+  }
+  // bad file number is caught when reading the entry
+  bad = data;
+  bad[PDXCP_CDCL_INDEX_HEADER_SIZE + 8 + 16] = 1;
+  ASSERT_TRUE(pdxcp_cdcl_index_open(&index, bad.data(), bad.size()));
+  pdxcp_cdcl_index_entry entry;
+  EXPECT_FALSE(pdxcp_cdcl_index_get(&index, 0, &entry));
+}
+
+}  // namespace
@@ -306,6 +306,30 @@ TEST_P(LexerMultipleTokenTest, Test)
 #endif  // !defined(PDXCP_HAS_FMEMOPEN)
 }
 
+/**
+ * Check that lexing from a buffer yields the same tokens as from a stream.
+ */
+TEST_P(LexerMultipleTokenTest, BufTest)
+{
+  const auto& input = GetParam().input;
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(&buf, input.c_str(), input.size());
+  // push tokens into vector until non-ok status detected
+  pdxcp_cdcl_lexer_status status;
+  std::vector<pdxcp_cdcl_token> tokens;
+  do {
+    pdxcp_cdcl_token token;
+    if (PDXCP_CDCL_LEXER_OK(status = pdxcp_cdcl_get_token_buf(&buf, &token)))
+      tokens.push_back(token);
+  }
+  while (PDXCP_CDCL_LEXER_OK(status));
+  // end of buffer is reported as EOF
+  ASSERT_EQ(pdxcp_cdcl_lexer_status_fgetc_eof, status) << "Lexer status: " <<
+    pdxcp_cdcl_lexer_status_message(status);
+  EXPECT_EQ(GetParam().tokens, tokens);
+  EXPECT_EQ(input.c_str() + input.size(), buf.pos);
+}
+
 // simple declarations
 INSTANTIATE_TEST_SUITE_P(
   SimpleDecls,
@@ -364,6 +388,18 @@ INSTANTIATE_TEST_SUITE_P(
         create_cdcl_token(pdxcp_cdcl_token_type_rangle, ""),
         create_cdcl_token(pdxcp_cdcl_token_type_semicolon, "")
       }
+    },
+    // hex numbers keep their 0x prefix
+    LexerParamTestInput{
+      "char buf[0x1aF];",
+      {
+        create_cdcl_token(pdxcp_cdcl_token_type_t_char, ""),
+        create_cdcl_token(pdxcp_cdcl_token_type_iden, "buf"),
+        create_cdcl_token(pdxcp_cdcl_token_type_langle, ""),
+        create_cdcl_token(pdxcp_cdcl_token_type_num, "0x1aF"),
+        create_cdcl_token(pdxcp_cdcl_token_type_rangle, ""),
+        create_cdcl_token(pdxcp_cdcl_token_type_semicolon, "")
+      }
     }
   )
 );
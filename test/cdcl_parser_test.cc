@@ -7,16 +7,38 @@
 
 #include "pdxcp/cdcl_parser.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <ostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_typedefs.h"
 #include "pdxcp/string.hh"
+#include "testing.hh"
 
 namespace {
 
+/**
+ * Return the formatted error text for the given error info.
+ *
+ * @param errinfo Parser error info
+ */
+std::string errinfo_text(const pdxcp_cdcl_parser_errinfo& errinfo)
+{
+  char text[PDXCP_CDCL_PARSER_ERROR_TEXT_LEN + 1];
+  pdxcp_cdcl_parser_errinfo_format(&errinfo, text, sizeof text);
+  return text;
+}
+
 /**
  * C declaration parser test fixture base.
  */
@@ -67,7 +89,7 @@ TEST_P(ParserParamTest, PureTest)
     pdxcp_cdcl_parser_status_string(status) << "\nParser error text: " <<
     (
       (status == pdxcp_cdcl_parser_status_parse_err) ?
-        errinfo.parser.text : "(none)"
+        errinfo_text(errinfo) : "(none)"
     );
 #else
   GTEST_SKIP();
@@ -124,6 +146,19 @@ INSTANTIATE_TEST_SUITE_P(
   )
 );
 
+// function and function pointer declarations
+INSTANTIATE_TEST_SUITE_P(
+  FunctionDecls,
+  ParserParamTest,
+  ::testing::Values(
+    ParserParamTestInput{"void f(void);"},
+    ParserParamTestInput{"int (*x[10])();"},
+    ParserParamTestInput{"char *(*f)(int, char *);"},
+    ParserParamTestInput{"int main(int argc, char *argv[]);"},
+    ParserParamTestInput{"void (*signal(int sig, void (*func)(int)))(int);"}
+  )
+);
+
 /**
  * Struct holding the input for a `ParserErrorParamTest`.
  *
@@ -156,44 +191,48 @@ class ParserErrorParamTest
 
 /**
  * Test that the correct status and error are emitted on parsing failures.
+ *
+ * Each input is parsed both from a stream and directly from a buffer, which
+ * must report the same status and error message.
  */
 TEST_P(ParserErrorParamTest, ErrorTest)
 {
+  const auto& input = GetParam().input;
+  // check the status and error info returned by one of the parse functions
+  auto check = [this](
+    const char* path,
+    pdxcp_cdcl_parser_status status,
+    const pdxcp_cdcl_parser_errinfo& errinfo)
+  {
+    SCOPED_TRACE(path);
+    // check that returned status and errinfo status are the same
+    ASSERT_EQ(status, errinfo.parser.status) << "Parser returned " <<
+      pdxcp_cdcl_parser_status_string(status) << " while errinfo received " <<
+      pdxcp_cdcl_parser_status_string(errinfo.parser.status);
+    // check that error status and message are as expected
+    EXPECT_EQ(GetParam().status, errinfo.parser.status) << "expected: " <<
+      pdxcp_cdcl_parser_status_string(GetParam().status) << ", actual: " <<
+      pdxcp_cdcl_parser_status_string(errinfo.parser.status);
+    // parser error text meaningful only if pdxcp_cdcl_parser_status_parse_err.
+    // we use braces because GTEST_AMBIGUOUS_ELSE_BLOCKER_ doesn't actually
+    // work with GCC 11.3 as the Google Test writers may have expected
+    if (status == pdxcp_cdcl_parser_status_parse_err) {
+      EXPECT_EQ(GetParam().message, errinfo_text(errinfo));
+    }
+  };
+  // parse directly from the input string and write error info
+  pdxcp_cdcl_parser_errinfo buf_errinfo;
+  auto status = pdxcp_cdcl_parse_buf(
+    input.c_str(), input.size(), nullptr, 0, nullptr, &buf_errinfo
+  );
+  check("pdxcp_cdcl_parse_buf", status, buf_errinfo);
 #if defined(PDXCP_HAS_FMEMOPEN)
-  // create input stream
-  auto stream = pdxcp::memopen_string(GetParam().input);
-  // parse and write error info
+  // parse from an input stream and write error info
+  auto stream = pdxcp::memopen_string(input);
   pdxcp_cdcl_parser_errinfo errinfo;
-  auto status = pdxcp_cdcl_stream_parse(stream, stdout, &errinfo);
-  // check that returned status and errinfo status are the same
-  ASSERT_EQ(status, errinfo.parser.status) << "Parser returned " <<
-    pdxcp_cdcl_parser_status_string(status) << " while errinfo received " <<
-    pdxcp_cdcl_parser_status_string(errinfo.parser.status);
-  // check that error status and message are as expected
-  EXPECT_EQ(GetParam().status, errinfo.parser.status) << "expected: " <<
-    pdxcp_cdcl_parser_status_string(GetParam().status) << ", actual: " <<
-    pdxcp_cdcl_parser_status_string(errinfo.parser.status);
-  // check error info based on the status
-  switch (status) {
-    // TODO: consider handling pdxcp_cdcl_parser_status_lexer_err so we can
-    // check the lexer error status and possible message if any
-    // parser error
-    case pdxcp_cdcl_parser_status_parse_err:
-      EXPECT_EQ(GetParam().message, errinfo.parser.text);
-      break;
-    // no-op
-    default:
-      break;
-  }
-  // parser error text meaningful only if pdxcp_cdcl_parser_status_parse_err.
-  // we use braces because GTEST_AMBIGUOUS_ELSE_BLOCKER_ doesn't actually work
-  // with GCC 11.3 as the Google Test writers may have expected
-  if (status == pdxcp_cdcl_parser_status_parse_err) {
-    EXPECT_EQ(GetParam().message, errinfo.parser.text);
-  }
-#else
-  GTEST_SKIP();
-#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+  status = pdxcp_cdcl_stream_parse(stream, stdout, &errinfo);
+  check("pdxcp_cdcl_stream_parse", status, errinfo);
+#endif  // defined(PDXCP_HAS_FMEMOPEN)
 }
 
 // simple declaration mishaps
@@ -201,8 +240,10 @@ INSTANTIATE_TEST_SUITE_P(
   SimpleDecls,
   ParserErrorParamTest,
   ::testing::Values(
-    ParserErrorParamTestInput{"int **;", pdxcp_cdcl_parser_status_lexer_err, ""},
-    ParserErrorParamTestInput{"int a", pdxcp_cdcl_parser_status_lexer_err, ""},
+    // input ending inside a declaration is not reported as a lexer error.
+    // with no identifier, the ';' is read as part of the declarator
+    ParserErrorParamTestInput{"int **;", pdxcp_cdcl_parser_status_eof, ""},
+    ParserErrorParamTestInput{"int a", pdxcp_cdcl_parser_status_eof, ""},
     ParserErrorParamTestInput{
       "*y;",
       pdxcp_cdcl_parser_status_parse_err,
@@ -282,10 +323,1064 @@ INSTANTIATE_TEST_SUITE_P(
     },
     ParserErrorParamTestInput{
       "const double b[100][50]",
-      pdxcp_cdcl_parser_status_lexer_err,
+      pdxcp_cdcl_parser_status_eof,
       ""
     }
   )
 );
 
+// invalid function declarations
+INSTANTIATE_TEST_SUITE_P(
+  FunctionDecls,
+  ParserErrorParamTest,
+  ::testing::Values(
+    ParserErrorParamTestInput{
+      "int f(int)[10];",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Function cannot return an array"
+    },
+    ParserErrorParamTestInput{
+      "int (*g(void))(char)(long);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Function cannot return a function"
+    },
+    // grouping parentheses do not hide what a function returns
+    ParserErrorParamTestInput{
+      "int (f(void))[3];",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Function cannot return an array"
+    },
+    ParserErrorParamTestInput{
+      "int (f(void))(void);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Function cannot return a function"
+    },
+    ParserErrorParamTestInput{
+      "int (a[3])(void);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Array elements cannot be functions"
+    },
+    ParserErrorParamTestInput{
+      "int f(int,);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Unexpected token type pdxcp_cdcl_token_type_rparen with text \"\" when "
+      "parsing function parameters"
+    },
+    ParserErrorParamTestInput{
+      "int f(void, void);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "A void parameter must be unnamed, unqualified, and the only parameter"
+    },
+    ParserErrorParamTestInput{
+      "int f(int, void);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "A void parameter must be unnamed, unqualified, and the only parameter"
+    },
+    ParserErrorParamTestInput{
+      "int f(void x);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "A void parameter must be unnamed, unqualified, and the only parameter"
+    },
+    ParserErrorParamTestInput{
+      "double h(int x y);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Unexpected token type pdxcp_cdcl_token_type_iden with text \"y\" when "
+      "parsing function parameters"
+    },
+    ParserErrorParamTestInput{
+      "long k(*);",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Unexpectedly ran out of tokens when parsing pointers, missing type"
+    },
+    ParserErrorParamTestInput{
+      "int f(int;",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Unexpected token type pdxcp_cdcl_token_type_semicolon with text \"\" "
+      "when parsing function parameters"
+    }
+  )
+);
+
+// invalid qualifiers
+INSTANTIATE_TEST_SUITE_P(
+  QualDecls,
+  ParserErrorParamTest,
+  ::testing::Values(
+    ParserErrorParamTestInput{
+      "int *const const p;",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Duplicate pointer const qualifier"
+    },
+    ParserErrorParamTestInput{
+      "const volatile volatile int x;",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Duplicate type volatile qualifier"
+    },
+    ParserErrorParamTestInput{
+      "signed unsigned int x;",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Type already qualified as unsigned, cannot re-qualify as signed"
+    },
+    ParserErrorParamTestInput{
+      "unsigned float f;",
+      pdxcp_cdcl_parser_status_parse_err,
+      "Only char, int, or long can be signed or unsigned, received "
+      "pdxcp_cdcl_token_type_t_float"
+    }
+  )
+);
+
+/**
+ * Struct holding the expected contents of a single declaration node.
+ *
+ * @param kind Node kind
+ * @param quals Bitwise OR of `PDXCP_CDCL_QUAL_*` qualifier flags
+ * @param type Base type token type, ignored unless kind is type
+ * @param text Struct or enum tag, array size as text, or empty
+ */
+struct ParserDeclNodeSpec {
+  pdxcp_cdcl_decl_kind kind;
+  unsigned int quals;
+  pdxcp_cdcl_token_type type;
+  std::string text;
+};
+
+/**
+ * Return a pointer node spec.
+ *
+ * @param quals Pointer cv-qualifiers
+ */
+auto pointer_spec(unsigned int quals = 0)
+{
+  return ParserDeclNodeSpec{
+    pdxcp_cdcl_decl_kind_pointer, quals, pdxcp_cdcl_token_type_error, ""
+  };
+}
+
+/**
+ * Return an array node spec.
+ *
+ * @param size Array size, zero if unspecified
+ */
+auto array_spec(std::size_t size = 0)
+{
+  return ParserDeclNodeSpec{
+    pdxcp_cdcl_decl_kind_array,
+    0,
+    pdxcp_cdcl_token_type_error,
+    (size) ? std::to_string(size) : ""
+  };
+}
+
+/**
+ * Return a function node spec.
+ */
+auto function_spec()
+{
+  return ParserDeclNodeSpec{
+    pdxcp_cdcl_decl_kind_function, 0, pdxcp_cdcl_token_type_error, ""
+  };
+}
+
+/**
+ * Return a type node spec.
+ *
+ * @param type Base type token type
+ * @param quals Type qualifiers
+ * @param name Struct or enum tag
+ */
+auto type_spec(
+  pdxcp_cdcl_token_type type, unsigned int quals = 0, const std::string& name = "")
+{
+  return ParserDeclNodeSpec{pdxcp_cdcl_decl_kind_type, quals, type, name};
+}
+
+/**
+ * Struct holding the input for a `ParserDeclParamTest`.
+ *
+ * @param input Input declaration to parse
+ * @param iden Expected identifier
+ * @param nodes Expected declaration nodes from outermost to innermost
+ */
+struct ParserDeclParamTestInput {
+  const std::string input;
+  const std::string iden;
+  const std::vector<ParserDeclNodeSpec> nodes;
+};
+
+/**
+ * Google Test value printer for `ParserDeclParamTestInput`.
+ */
+void PrintTo(const ParserDeclParamTestInput& input, std::ostream* out)
+{
+  *out << input.input;
+}
+
+/**
+ * C declaration parser parametrized test fixture for declaration node trees.
+ */
+class ParserDeclParamTest
+  : public ParserTest,
+    public ::testing::WithParamInterface<ParserDeclParamTestInput> {};
+
+/**
+ * Test that the parser builds the expected declaration node list.
+ */
+TEST_P(ParserDeclParamTest, NodeTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  // create input stream + arena
+  auto stream = pdxcp::memopen_string(GetParam().input);
+  pdxcp::testing::unique_arena arena;
+  // parse into declaration
+  pdxcp_cdcl_parser_errinfo errinfo;
+  pdxcp_cdcl_decl decl;
+  auto status = pdxcp_cdcl_parse_decl(stream, arena, &decl, &errinfo);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(GetParam().iden, decl.iden);
+  // compare each node against the expected nodes
+  const auto& specs = GetParam().nodes;
+  auto node = decl.node;
+  for (std::size_t i = 0; i < specs.size(); i++, node = node->next) {
+    ASSERT_TRUE(node) << "Missing node " << i;
+    const auto& spec = specs[i];
+    EXPECT_EQ(spec.kind, node->kind) << "node " << i << " expected " <<
+      pdxcp_cdcl_decl_kind_string(spec.kind) << ", actual " <<
+      pdxcp_cdcl_decl_kind_string(node->kind);
+    EXPECT_EQ(spec.quals, node->quals) << "node " << i;
+    switch (node->kind) {
+      case pdxcp_cdcl_decl_kind_array:
+        EXPECT_EQ(spec.text, (node->size) ? std::to_string(node->size) : "");
+        break;
+      case pdxcp_cdcl_decl_kind_type:
+        EXPECT_EQ(spec.type, node->type);
+        EXPECT_EQ(spec.text, (node->name) ? node->name : "");
+        break;
+      default:
+        break;
+    }
+  }
+  EXPECT_FALSE(node) << "Extra nodes after " << specs.size() << " nodes";
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Base,
+  ParserDeclParamTest,
+  ::testing::Values(
+    ParserDeclParamTestInput{
+      "int **x;",
+      "x",
+      {pointer_spec(), pointer_spec(), type_spec(pdxcp_cdcl_token_type_t_int)}
+    },
+    ParserDeclParamTestInput{
+      "const char *const argv[10];",
+      "argv",
+      {
+        array_spec(10),
+        pointer_spec(PDXCP_CDCL_QUAL_CONST),
+        type_spec(pdxcp_cdcl_token_type_t_char, PDXCP_CDCL_QUAL_CONST)
+      }
+    },
+    ParserDeclParamTestInput{
+      "volatile unsigned long arr[][50];",
+      "arr",
+      {
+        array_spec(),
+        array_spec(50),
+        type_spec(
+          pdxcp_cdcl_token_type_t_long,
+          PDXCP_CDCL_QUAL_VOLATILE | PDXCP_CDCL_QUAL_UNSIGNED
+        )
+      }
+    },
+    ParserDeclParamTestInput{
+      "struct my_struct *volatile *const (s);",
+      "s",
+      {
+        pointer_spec(PDXCP_CDCL_QUAL_CONST),
+        pointer_spec(PDXCP_CDCL_QUAL_VOLATILE),
+        type_spec(pdxcp_cdcl_token_type_struct, 0, "my_struct")
+      }
+    },
+    ParserDeclParamTestInput{
+      "float (*const x)[4];",
+      "x",
+      {
+        pointer_spec(PDXCP_CDCL_QUAL_CONST),
+        array_spec(4),
+        type_spec(pdxcp_cdcl_token_type_t_float)
+      }
+    },
+    ParserDeclParamTestInput{
+      "char *(*f)(int);",
+      "f",
+      {
+        pointer_spec(),
+        function_spec(),
+        pointer_spec(),
+        type_spec(pdxcp_cdcl_token_type_t_char)
+      }
+    }
+  )
+);
+
+/**
+ * Struct holding the input for a `ParserRenderParamTest`.
+ *
+ * @param input Input declaration to parse
+ * @param output Expected rendered description
+ */
+struct ParserRenderParamTestInput {
+  const std::string input;
+  const std::string output;
+};
+
+/**
+ * Google Test value printer for `ParserRenderParamTestInput`.
+ */
+void PrintTo(const ParserRenderParamTestInput& input, std::ostream* out)
+{
+  *out << input.input;
+}
+
+/**
+ * C declaration parser parametrized test fixture for rendered descriptions.
+ */
+class ParserRenderParamTest
+  : public ParserTest,
+    public ::testing::WithParamInterface<ParserRenderParamTestInput> {
+protected:
+  /**
+   * Parse the test input into the declaration, failing on parser error.
+   */
+  void SetUp() override
+  {
+#if defined(PDXCP_HAS_FMEMOPEN)
+    auto stream = pdxcp::memopen_string(GetParam().input);
+    auto status = pdxcp_cdcl_parse_decl(stream, arena_, &decl_, nullptr);
+    ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+      pdxcp_cdcl_parser_status_string(status);
+#else
+    GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+  }
+
+  pdxcp::testing::unique_arena arena_;
+  pdxcp_cdcl_decl decl_;
+};
+
+/**
+ * Test that rendering into a reused byte vector gives the expected text.
+ */
+TEST_P(ParserRenderParamTest, VectorTest)
+{
+  pdxcp_bvector vec;
+  pdxcp_bvector_init(&vec);
+  // render twice, resetting size, to check byte vector reuse
+  for (unsigned i = 0; i < 2; i++) {
+    vec.size = 0;
+    auto status = pdxcp_cdcl_decl_render(&decl_, &vec);
+    ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Render status: " <<
+      pdxcp_cdcl_parser_status_string(status);
+    EXPECT_EQ(GetParam().output, pdxcp::testing::to_string(vec));
+  }
+  pdxcp_bvector_destroy(&vec);
+}
+
+/**
+ * Test that rendering into a fixed buffer gives the expected text.
+ */
+TEST_P(ParserRenderParamTest, BufferTest)
+{
+  char buf[256];
+  std::size_t len;
+  auto status = pdxcp_cdcl_decl_render_buf(&decl_, buf, sizeof buf, &len);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Render status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(GetParam().output.size(), len);
+  EXPECT_EQ(GetParam().output, buf);
+}
+
+/**
+ * Test that rendering into a small fixed buffer truncates the output.
+ */
+TEST_P(ParserRenderParamTest, TruncateTest)
+{
+  char buf[8];
+  std::size_t len;
+  auto status = pdxcp_cdcl_decl_render_buf(&decl_, buf, sizeof buf, &len);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_out_too_small, status) << "Render "
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(GetParam().output.size(), len);
+  EXPECT_EQ(GetParam().output.substr(0, sizeof buf - 1), buf);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Base,
+  ParserRenderParamTest,
+  ::testing::Values(
+    ParserRenderParamTestInput{"int **x;", "x: pointer to pointer to int\n"},
+    ParserRenderParamTestInput{
+      "const char *const argv[10];",
+      "argv: array[10] of const pointer to const char\n"
+    },
+    ParserRenderParamTestInput{
+      "volatile unsigned long arr[][50];",
+      "arr: array[] of array[50] of volatile unsigned long\n"
+    },
+    ParserRenderParamTestInput{
+      "volatile enum new_enum (**const *c)[90];",
+      "c: pointer to const pointer to pointer to array[90] of volatile enum "
+      "new_enum\n"
+    },
+    ParserRenderParamTestInput{
+      "int (*x[10])();",
+      "x: array[10] of pointer to function() returning int\n"
+    },
+    ParserRenderParamTestInput{
+      "char *(*f)(int, char *);",
+      "f: pointer to function(int, pointer to char) returning pointer to char\n"
+    },
+    ParserRenderParamTestInput{
+      "int main(int argc, const char *argv[]);",
+      "main: function(argc: int, argv: array[] of pointer to const char) "
+      "returning int\n"
+    },
+    ParserRenderParamTestInput{
+      "void (*signal(int sig, void (*func)(int)))(int);",
+      "signal: function(sig: int, func: pointer to function(int) returning "
+      "void) returning pointer to function(int) returning void\n"
+    },
+    ParserRenderParamTestInput{
+      "double (*(*m)[3])(unsigned long (*)[4], struct s (void));",
+      "m: pointer to array[3] of pointer to function(pointer to array[4] of "
+      "unsigned long, function(void) returning struct s) returning double\n"
+    }
+  )
+);
+
+/**
+ * Parser state wrapper class that ensures we never forget to free memory.
+ */
+class decl_parser {
+public:
+  /**
+   * Default ctor.
+   */
+  decl_parser()
+  {
+    pdxcp_cdcl_parser_init(&parser_);
+  }
+
+  /**
+   * Deleted copy ctor.
+   */
+  decl_parser(const decl_parser&) = delete;
+
+  /**
+   * Dtor.
+   */
+  ~decl_parser()
+  {
+    pdxcp_cdcl_parser_destroy(&parser_);
+  }
+
+  /**
+   * Allow implicit conversion to pointer for working with C functions.
+   */
+  operator pdxcp_cdcl_parser*() noexcept
+  {
+    return &parser_;
+  }
+
+  /**
+   * Member access operator for convenience.
+   */
+  pdxcp_cdcl_parser* operator->() noexcept
+  {
+    return &parser_;
+  }
+
+private:
+  pdxcp_cdcl_parser parser_;
+};
+
+/**
+ * Callback state used by the multi-declaration parser tests.
+ *
+ * @param texts Rendered declaration texts, one per parsed declaration
+ * @param statuses Parser statuses passed to the callback
+ * @param max_decls Number of declarations to accept before stopping
+ */
+struct ParserCollectState {
+  std::vector<std::string> texts;
+  std::vector<pdxcp_cdcl_parser_status> statuses;
+  std::vector<std::size_t> err_offsets;
+  std::size_t max_decls = static_cast<std::size_t>(-1);
+};
+
+/**
+ * Parse callback that renders each declaration into the parser byte vector.
+ */
+bool collect_decls(
+  pdxcp_cdcl_parser* parser,
+  pdxcp_cdcl_parser_status status,
+  const pdxcp_cdcl_decl* decl,
+  void* data)
+{
+  auto state = static_cast<ParserCollectState*>(data);
+  state->statuses.push_back(status);
+  // keep going after errors only in recovery mode
+  if (!decl) {
+    state->err_offsets.push_back(parser->errinfo.offset);
+    return parser->recover;
+  }
+  // reuse the parser byte vector for rendering
+  parser->buf.size = 0;
+  if (pdxcp_cdcl_decl_render(decl, &parser->buf))
+    return false;
+  state->texts.push_back(pdxcp::testing::to_string(parser->buf));
+  return state->texts.size() < state->max_decls;
+}
+
+/**
+ * Test that many declarations are parsed from a single stream.
+ */
+TEST_F(ParserTest, StreamAllTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  // backing string must outlive the stream
+  const std::string input{
+    "int **x;\n"
+    "const char *const argv[10];\n"
+    "  volatile unsigned long arr[][50];  \n"
+    "char c;"
+  };
+  auto stream = pdxcp::memopen_string(input);
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_stream_parse_all(parser, stream, collect_decls, &state);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(4u, parser->n_decls);
+  EXPECT_EQ(
+    std::vector<std::string>({
+      "x: pointer to pointer to int\n",
+      "argv: array[10] of const pointer to const char\n",
+      "arr: array[] of array[50] of volatile unsigned long\n",
+      "c: char\n"
+    }),
+    state.texts
+  );
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that parsing many declarations stops on the first error.
+ */
+TEST_F(ParserTest, StreamAllErrorTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  const std::string input{"int x; char y[10] z; long w;"};
+  auto stream = pdxcp::memopen_string(input);
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_stream_parse_all(parser, stream, collect_decls, &state);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(1u, parser->n_decls);
+  EXPECT_EQ(std::vector<std::string>({"x: int\n"}), state.texts);
+  // callback saw the error status after the successful declaration
+  ASSERT_EQ(2u, state.statuses.size());
+  EXPECT_EQ(status, state.statuses.back());
+  EXPECT_EQ(status, parser->errinfo.parser.status);
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that parsing many declarations stops when the callback returns false.
+ */
+TEST_F(ParserTest, StreamAllStopTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  const std::string input{"int x; char y; long z;"};
+  auto stream = pdxcp::memopen_string(input);
+  decl_parser parser;
+  ParserCollectState state;
+  state.max_decls = 2;
+  auto status = pdxcp_cdcl_stream_parse_all(parser, stream, collect_decls, &state);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(2u, parser->n_decls);
+  EXPECT_EQ(std::vector<std::string>({"x: int\n", "y: char\n"}), state.texts);
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that a declaration is parsed from one buffer and described in another.
+ */
+TEST_F(ParserTest, BufTest)
+{
+  // not null-terminated after the declaration
+  const std::string input{"char *(*f)(int);int"};
+  const std::string expected{
+    "f: pointer to function(int) returning pointer to char\n"
+  };
+  char out[16];
+  std::size_t len;
+  // truncated like snprintf but full length still reported
+  auto status = pdxcp_cdcl_parse_buf(
+    input.c_str(), input.size() - 3, out, sizeof out, &len, nullptr
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_out_too_small, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(expected.size(), len);
+  EXPECT_EQ(expected.substr(0, sizeof out - 1), out);
+  // large enough buffer
+  std::string text(len, '\0');
+  status = pdxcp_cdcl_parse_buf(
+    input.c_str(), input.size() - 3, text.data(), len + 1, &len, nullptr
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(expected, text);
+  // errors are located relative to the start of the buffer
+  pdxcp_cdcl_parser_errinfo errinfo;
+  status = pdxcp_cdcl_parse_buf(
+    "int x y;", 8, out, sizeof out, &len, &errinfo
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(6u, errinfo.offset);
+}
+
+/**
+ * Test that many declarations are parsed directly from a buffer.
+ */
+TEST_F(ParserTest, BufAllTest)
+{
+  // not null-terminated after the last declaration
+  const std::string input{
+    "int (*f)(char *, double); /* comment */ // comment\n"
+    "const char *const argv[10];char c;int x;"
+  };
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size() - 6, collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(3u, parser->n_decls);
+  EXPECT_EQ(
+    std::vector<std::string>({
+      "f: pointer to function(pointer to char, double) returning int\n",
+      "argv: array[10] of const pointer to const char\n",
+      "c: char\n"
+    }),
+    state.texts
+  );
+}
+
+/**
+ * Test that parsing many declarations from a buffer stops on the first error.
+ */
+TEST_F(ParserTest, BufAllErrorTest)
+{
+  const std::string input{"int x; char y[10] z; long w;"};
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(1u, parser->n_decls);
+  EXPECT_EQ(std::vector<std::string>({"x: int\n"}), state.texts);
+  EXPECT_EQ(status, parser->errinfo.parser.status);
+}
+
+/**
+ * Test that buffer parse errors are recorded as structured error info.
+ */
+TEST_F(ParserTest, BufErrinfoTest)
+{
+  pdxcp::testing::unique_arena arena;
+  const std::string input{"double h(int x yy);"};
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(&buf, input.c_str(), input.size());
+  pdxcp_cdcl_decl decl;
+  pdxcp_cdcl_parser_errinfo errinfo;
+  auto status = pdxcp_cdcl_parse_decl_buf(&buf, arena, &decl, &errinfo);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(pdxcp_cdcl_parser_error_params_token, errinfo.parser.error) <<
+    "Parser error: " << pdxcp_cdcl_parser_error_string(errinfo.parser.error);
+  EXPECT_EQ(pdxcp_cdcl_token_type_iden, errinfo.parser.token);
+  EXPECT_EQ(input.find("yy"), errinfo.offset);
+  EXPECT_EQ(2u, errinfo.span);
+  // text is only produced on request
+  EXPECT_EQ(
+    "Unexpected token type pdxcp_cdcl_token_type_iden with text \"yy\" when "
+      "parsing function parameters",
+    errinfo_text(errinfo)
+  );
+}
+
+/**
+ * Test that recovery mode skips malformed declarations and keeps parsing.
+ */
+TEST_F(ParserTest, BufRecoverTest)
+{
+  const std::string input{
+    "int x; char y[10] z; long w;\n"
+    "int @ [1;2] q; int (v;\n"
+    "int f(a b; c); double d;"
+  };
+  decl_parser parser;
+  parser->recover = true;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(3u, parser->n_decls);
+  EXPECT_EQ(6u, parser->n_errors);
+  EXPECT_EQ(
+    std::vector<std::string>({"x: int\n", "w: long\n", "d: double\n"}),
+    state.texts
+  );
+  EXPECT_EQ(
+    std::vector<pdxcp_cdcl_parser_status>({
+      pdxcp_cdcl_parser_status_ok,
+      pdxcp_cdcl_parser_status_parse_err,
+      pdxcp_cdcl_parser_status_ok,
+      pdxcp_cdcl_parser_status_lexer_err,
+      pdxcp_cdcl_parser_status_parse_err,
+      pdxcp_cdcl_parser_status_parse_err,
+      pdxcp_cdcl_parser_status_parse_err,
+      pdxcp_cdcl_parser_status_parse_err,
+      pdxcp_cdcl_parser_status_ok
+    }),
+    state.statuses
+  );
+  // offsets are of the token at which each error was detected. skipping stops
+  // at the first ';' even inside brackets, so "2] q;" is parsed on its own
+  EXPECT_EQ(
+    std::vector<std::size_t>({
+      input.find("z;"),
+      input.find("@"),
+      input.find("q;") + 1,
+      input.find("v;") + 1,
+      input.find("b;"),
+      input.find(");")
+    }),
+    state.err_offsets
+  );
+}
+
+/**
+ * Test that an unbalanced '(' in a failed declaration does not hide the rest.
+ */
+TEST_F(ParserTest, BufRecoverParenTest)
+{
+  const std::string input{"int x x(; int y; int z;"};
+  decl_parser parser;
+  parser->recover = true;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(2u, parser->n_decls);
+  EXPECT_EQ(1u, parser->n_errors);
+  EXPECT_EQ(
+    std::vector<std::string>({"y: int\n", "z: int\n"}), state.texts
+  );
+}
+
+/**
+ * Test that recovery mode reports error offsets in streams.
+ */
+TEST_F(ParserTest, StreamRecoverTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  // backing string must outlive the stream
+  const std::string input{"int x y;\nlong 1x; char c;"};
+  auto stream = pdxcp::memopen_string(input);
+  decl_parser parser;
+  parser->recover = true;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_stream_parse_all(parser, stream, collect_decls, &state);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(1u, parser->n_decls);
+  EXPECT_EQ(2u, parser->n_errors);
+  EXPECT_EQ(std::vector<std::string>({"c: char\n"}), state.texts);
+  EXPECT_EQ(
+    std::vector<std::size_t>({input.find("y;") + 1, input.find("x;") + 2}),
+    state.err_offsets
+  );
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that deeply nested declarations spill the token stack correctly.
+ *
+ * Each declaration pushes far more tokens than fit in the inline storage, and
+ * several are parsed in a row so spilled storage is reused after arena reset.
+ */
+TEST_F(ParserTest, DeepStackTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  constexpr unsigned n_ptrs = 10 * PDXCP_CDCL_PARSER_STACK_SIZE;
+  // build pointer-heavy declaration and its expected description
+  std::string decl_text{"struct deep_tag "};
+  std::string description;
+  for (unsigned i = 0; i < n_ptrs; i++) {
+    decl_text += (i % 2) ? "*const " : "*";
+    description = ((i % 2) ? "const pointer to " : "pointer to ") + description;
+  }
+  description += "struct deep_tag\n";
+  // parse several declarations with different identifiers
+  std::string input;
+  std::vector<std::string> expected;
+  for (auto iden : {"a", "b", "c"}) {
+    input += decl_text + iden + ";\n";
+    expected.push_back(std::string{iden} + ": " + description);
+  }
+  auto stream = pdxcp::memopen_string(input);
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_stream_parse_all(parser, stream, collect_decls, &state);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(expected, state.texts);
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that parameter list nesting is limited to bound parser recursion.
+ */
+TEST_F(ParserTest, MaxDepthTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  // build declaration with the given number of nested parameter lists
+  auto nested = [](unsigned depth)
+  {
+    std::string text{"int x"};
+    for (unsigned i = 0; i < depth; i++)
+      text = "int f" + std::to_string(i) + "(" + text + ")";
+    return text + ";";
+  };
+  // parse declaration with the given nesting depth
+  pdxcp::testing::unique_arena arena;
+  pdxcp_cdcl_parser_errinfo errinfo;
+  auto parse = [&arena, &errinfo, &nested](unsigned depth)
+  {
+    const auto input = nested(depth);
+    auto stream = pdxcp::memopen_string(input);
+    pdxcp_cdcl_decl decl;
+    return pdxcp_cdcl_parse_decl(stream, arena, &decl, &errinfo);
+  };
+  // maximum depth is fine
+  auto status = parse(PDXCP_CDCL_PARSER_MAX_DEPTH);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  // one more level is an error
+  status = parse(PDXCP_CDCL_PARSER_MAX_DEPTH + 1);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    "Function parameter lists nested more than " +
+      std::to_string(PDXCP_CDCL_PARSER_MAX_DEPTH) + " levels deep",
+    errinfo_text(errinfo)
+  );
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that parser statistics are collected only when compiled in.
+ */
+TEST_F(ParserTest, StreamStatsTest)
+{
+#if defined(PDXCP_HAS_FMEMOPEN)
+  const std::string input{"int **x;"};
+  auto stream = pdxcp::memopen_string(input);
+  std::unique_ptr<std::FILE, decltype(&std::fclose)> out{
+    std::tmpfile(), &std::fclose
+  };
+  ASSERT_TRUE(out) << "tmpfile() failed";
+  pdxcp_cdcl_parser_stats stats;
+  pdxcp_cdcl_parser_stats_init(&stats);
+  auto status = pdxcp_cdcl_stream_parse_stats(
+    stream, out.get(), nullptr, &stats
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  // without statistics compiled in nothing is touched
+  if (!pdxcp_cdcl_parser_stats_enabled()) {
+    EXPECT_EQ(0u, stats.n_tokens);
+    EXPECT_EQ(0u, stats.max_depth);
+    EXPECT_EQ(0u, stats.out_bytes);
+    for (auto ns : stats.phase_ns)
+      EXPECT_EQ(0u, ns);
+    GTEST_SKIP();
+  }
+  // int, *, *, x, ;
+  EXPECT_EQ(5u, stats.n_tokens);
+  // x is the current token when pushing stops
+  EXPECT_EQ(3u, stats.max_depth);
+  EXPECT_EQ(std::strlen("x: pointer to pointer to int\n"), stats.out_bytes);
+  EXPECT_EQ(static_cast<long>(stats.out_bytes), std::ftell(out.get()));
+  // every phase ran, though the clock may be too coarse to see each one
+  std::uint64_t total_ns = 0;
+  for (auto ns : stats.phase_ns)
+    total_ns += ns;
+  EXPECT_GT(total_ns, 0u);
+#else
+  GTEST_SKIP();
+#endif  // !defined(PDXCP_HAS_FMEMOPEN)
+}
+
+/**
+ * Test that parser statistics accumulate over many declarations.
+ */
+TEST_F(ParserTest, BufAllStatsTest)
+{
+  const std::string input{"int x; char *argv[10]; long (*f)(double, int *);"};
+  decl_parser parser;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  ASSERT_EQ(3u, parser->n_decls);
+  const auto& stats = parser->stats;
+  if (!pdxcp_cdcl_parser_stats_enabled()) {
+    EXPECT_EQ(0u, stats.n_tokens);
+    EXPECT_EQ(0u, stats.max_depth);
+    GTEST_SKIP();
+  }
+  // 3 + 7 + 12 tokens
+  EXPECT_EQ(22u, stats.n_tokens);
+  // long, (, * or, once the grouping is unwound, long with int, * on top
+  EXPECT_EQ(3u, stats.max_depth);
+  // callbacks do the writing
+  EXPECT_EQ(0u, stats.out_bytes);
+  // parsing again accumulates
+  status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status);
+  EXPECT_EQ(44u, stats.n_tokens);
+  EXPECT_EQ(3u, stats.max_depth);
+}
+
+/**
+ * Test that typedef names are parsed as types and typedefs are learned.
+ */
+TEST_F(ParserTest, BufTypedefTest)
+{
+  const std::string input{
+    "size_t n;\n"
+    "typedef unsigned long word;\n"
+    "const word *w[2];\n"
+    "FILE *f(const char *, word);\n"
+    "word word;\n"
+    "long size_t;\n"
+    "typedef int (*cmp_fn)(word, word);\n"
+    "cmp_fn c;"
+  };
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs, "size_t"));
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs, "FILE"));
+  decl_parser parser;
+  parser->typedefs = &typedefs;
+  ParserCollectState state;
+  auto status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status) << "\nParser error text: " <<
+    errinfo_text(parser->errinfo);
+  EXPECT_EQ(
+    std::vector<std::string>({
+      "n: size_t\n",
+      "word: typedef for unsigned long\n",
+      "w: array[2] of pointer to const word\n",
+      "f: function(pointer to const char, word) returning pointer to FILE\n",
+      // a typedef name following a type is the identifier
+      "word: word\n",
+      "size_t: long\n",
+      "cmp_fn: typedef for pointer to function(word, word) returning int\n",
+      "c: cmp_fn\n"
+    }),
+    state.texts
+  );
+  EXPECT_EQ(4u, typedefs.names.size);
+  EXPECT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs, "word"));
+  EXPECT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs, "cmp_fn"));
+  // without a typedef name table typedef names are identifiers as before
+  parser->typedefs = nullptr;
+  state = ParserCollectState{};
+  status = pdxcp_cdcl_buf_parse_all(
+    parser, input.c_str(), input.size(), collect_decls, &state
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status);
+  EXPECT_TRUE(state.texts.empty());
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+}
+
+/**
+ * Test that single declarations are parsed with the parser's typedef names.
+ */
+TEST_F(ParserTest, BufDeclTypedefTest)
+{
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  decl_parser parser;
+  parser->typedefs = &typedefs;
+  auto parse = [&parser](const std::string& input, pdxcp_cdcl_decl& decl)
+  {
+    pdxcp_cdcl_lexer_buf buf;
+    PDXCP_CDCL_LEXER_BUF_INIT(&buf, input.c_str(), input.size());
+    return pdxcp_cdcl_parser_parse_decl_buf(parser, &buf, &decl);
+  };
+  pdxcp_cdcl_decl decl;
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, parse("typedef char T;", decl));
+  EXPECT_TRUE(decl.is_typedef);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, parse("T *x;", decl));
+  ASSERT_NE(nullptr, decl.node->next);
+  EXPECT_EQ(pdxcp_cdcl_token_type_t_name, decl.node->next->type);
+  EXPECT_STREQ("T", decl.node->next->name);
+  // known names are not added again
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, parse("typedef char T;", decl));
+  EXPECT_EQ(1u, typedefs.names.size);
+  // errors are written to the parser's error info
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, parse("U y;", decl));
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, parser->errinfo.parser.status);
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+}
+
 }  // namespace
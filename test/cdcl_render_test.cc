@@ -0,0 +1,334 @@
+/**
+ * @file cdcl_render_test.cc
+ * @author Derek Huang
+ * @brief cdcl_render.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_render.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_cache.h"
+#include "pdxcp/cdcl_parser.h"
+#include "pdxcp/cdcl_typedefs.h"
+#include "testing.hh"
+
+namespace {
+
+/**
+ * Base test fixture for machine-readable renderer tests.
+ *
+ * Manages the arena declarations are parsed into and the output byte vector.
+ */
+class RenderTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  RenderTest()
+  {
+    pdxcp_bvector_init(&out_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~RenderTest()
+  {
+    pdxcp_bvector_destroy(&out_);
+  }
+
+  /**
+   * Parse a single declaration from a string.
+   *
+   * @param input Input declaration
+   */
+  auto parse(const std::string& input)
+  {
+    return pdxcp::testing::parse_decl(arena_, input);
+  }
+
+  /**
+   * Return the output as a string.
+   */
+  auto output() const
+  {
+    return pdxcp::testing::to_string(out_);
+  }
+
+  pdxcp::testing::unique_arena arena_;
+  pdxcp_bvector out_;
+};
+
+/**
+ * Struct holding the input and output for a `RenderJsonParamTest`.
+ *
+ * @param input Input declaration
+ * @param output Expected JSON output, excluding the trailing newline
+ */
+struct RenderJsonInput {
+  const std::string input;
+  const std::string output;
+};
+
+/**
+ * Google Test value printer for `RenderJsonInput`.
+ */
+void PrintTo(const RenderJsonInput& input, std::ostream* out)
+{
+  *out << input.input;
+}
+
+/**
+ * Parametrized test fixture for JSON rendering.
+ */
+class RenderJsonParamTest
+  : public RenderTest,
+    public ::testing::WithParamInterface<RenderJsonInput> {};
+
+/**
+ * Test that declarations are rendered as the expected JSON.
+ */
+TEST_P(RenderJsonParamTest, Test)
+{
+  auto decl = parse(GetParam().input);
+  auto status = pdxcp_cdcl_decl_render_json(&decl, &out_);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(GetParam().output + "\n", output());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Base,
+  RenderJsonParamTest,
+  ::testing::Values(
+    RenderJsonInput{
+      "int x;",
+      R"({"iden":"x","type":[{"kind":"type","quals":[],"name":"int"}]})"
+    },
+    RenderJsonInput{
+      "const char *argv[10];",
+      R"({"iden":"argv","type":[{"kind":"array","size":10},)"
+      R"({"kind":"pointer","quals":[]},)"
+      R"({"kind":"type","quals":["const"],"name":"char"}]})"
+    },
+    RenderJsonInput{
+      "volatile unsigned long *const volatile p[][4];",
+      R"({"iden":"p","type":[{"kind":"array","size":null},)"
+      R"({"kind":"array","size":4},)"
+      R"({"kind":"pointer","quals":["const","volatile"]},)"
+      R"({"kind":"type","quals":["volatile","unsigned"],"name":"long"}]})"
+    },
+    RenderJsonInput{
+      "int (*f)(char *, struct s x);",
+      R"({"iden":"f","type":[{"kind":"pointer","quals":[]},)"
+      R"({"kind":"function","params":[)"
+      R"({"iden":null,"type":[{"kind":"pointer","quals":[]},)"
+      R"({"kind":"type","quals":[],"name":"char"}]},)"
+      R"({"iden":"x","type":[)"
+      R"({"kind":"type","quals":[],"name":"struct","tag":"s"}]}]},)"
+      R"({"kind":"type","quals":[],"name":"int"}]})"
+    },
+    RenderJsonInput{
+      "enum e g();",
+      R"({"iden":"g","type":[{"kind":"function","params":[]},)"
+      R"({"kind":"type","quals":[],"name":"enum","tag":"e"}]})"
+    }
+  )
+);
+
+/**
+ * Test that TLV records have the documented layout.
+ */
+TEST_F(RenderTest, TlvTest)
+{
+  auto decl = parse("const int *a[3];");
+  auto status = pdxcp_cdcl_decl_render_tlv(&decl, &out_);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  const std::string expected{
+    // declaration record containing 4 child records, 32 bytes in total
+    "\x01\x00\x00\x00\x20"
+    // identifier
+    "\x02\x00\x00\x00\x01" "a"
+    // array of size 3
+    "\x11\x00\x00\x00\x08" "\x00\x00\x00\x00\x00\x00\x00\x03"
+    // unqualified pointer
+    "\x10\x00\x00\x00\x01" "\x00"
+    // const int
+    "\x13\x00\x00\x00\x02" "\x01\x03",
+    5 + 6 + 13 + 6 + 7
+  };
+  EXPECT_EQ(expected, output());
+}
+
+/**
+ * Test that TLV function records nest parameter declaration records.
+ */
+TEST_F(RenderTest, TlvFunctionTest)
+{
+  auto decl = parse("void f(struct s *);");
+  auto status = pdxcp_cdcl_decl_render_tlv(&decl, &out_);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  const std::string expected{
+    "\x01\x00\x00\x00\x25"
+    "\x02\x00\x00\x00\x01" "f"
+    // function with one abstract parameter record
+    "\x12\x00\x00\x00\x13"
+    "\x01\x00\x00\x00\x0e"
+    "\x10\x00\x00\x00\x01" "\x00"
+    "\x13\x00\x00\x00\x03" "\x00\x07" "s"
+    // void
+    "\x13\x00\x00\x00\x02" "\x00\x01",
+    5 + 6 + 5 + 5 + 6 + 8 + 7
+  };
+  EXPECT_EQ(expected, output());
+}
+
+/**
+ * Test that rendering dispatches on the output format.
+ */
+TEST_F(RenderTest, RenderAsTest)
+{
+  auto decl = parse("char c;");
+  for (auto format : {
+    pdxcp_cdcl_output_format_text,
+    pdxcp_cdcl_output_format_json,
+    pdxcp_cdcl_output_format_tlv
+  }) {
+    pdxcp_bvector expected;
+    pdxcp_bvector_init(&expected);
+    switch (format) {
+      case pdxcp_cdcl_output_format_text:
+        pdxcp_cdcl_decl_render(&decl, &expected);
+        break;
+      case pdxcp_cdcl_output_format_json:
+        pdxcp_cdcl_decl_render_json(&decl, &expected);
+        break;
+      default:
+        pdxcp_cdcl_decl_render_tlv(&decl, &expected);
+    }
+    out_.size = 0;
+    EXPECT_EQ(
+      pdxcp_cdcl_parser_status_ok,
+      pdxcp_cdcl_decl_render_as(&decl, format, &out_)
+    );
+    EXPECT_EQ(
+      pdxcp::testing::to_string(expected),
+      output()
+    ) << "format: " << pdxcp_cdcl_output_format_string(format);
+    pdxcp_bvector_destroy(&expected);
+  }
+  // unknown format leaves output untouched
+  out_.size = 0;
+  EXPECT_EQ(
+    pdxcp_cdcl_parser_status_bad_format,
+    pdxcp_cdcl_decl_render_as(
+      &decl, static_cast<pdxcp_cdcl_output_format>(-1), &out_
+    )
+  );
+  EXPECT_EQ(0u, out_.size);
+}
+
+/**
+ * Test that cached parsing renders in the cache's output format.
+ */
+TEST_F(RenderTest, CacheFormatTest)
+{
+  pdxcp_cdcl_cache cache;
+  pdxcp_cdcl_cache_init(&cache, 16);
+  cache.format = pdxcp_cdcl_output_format_json;
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  const std::string input{"long x; long  x;"};
+  auto status = pdxcp_cdcl_cache_parse(
+    &cache, &parser, input.c_str(), input.size(), &out_
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  const std::string line{
+    R"({"iden":"x","type":[{"kind":"type","quals":[],"name":"long"}]})" "\n"
+  };
+  EXPECT_EQ(line + line, output());
+  EXPECT_EQ(1u, cache.hits);
+  pdxcp_cdcl_parser_destroy(&parser);
+  pdxcp_cdcl_cache_destroy(&cache);
+}
+
+/**
+ * Test that typedef declarations and typedef names are marked in the output.
+ */
+TEST_F(RenderTest, TypedefTest)
+{
+  // render each declaration in the requested format
+  struct render_state {
+    pdxcp_bvector* out;
+    pdxcp_cdcl_output_format format;
+  };
+  auto render = [](
+    pdxcp_cdcl_parser* /*parser*/,
+    pdxcp_cdcl_parser_status status,
+    const pdxcp_cdcl_decl* decl,
+    void* data)
+  {
+    auto state = static_cast<render_state*>(data);
+    return decl &&
+      PDXCP_CDCL_PARSER_OK(status) &&
+      PDXCP_CDCL_PARSER_OK(
+        pdxcp_cdcl_decl_render_as(decl, state->format, state->out)
+      );
+  };
+  pdxcp_cdcl_typedefs typedefs;
+  pdxcp_cdcl_typedefs_init(&typedefs);
+  pdxcp_cdcl_parser parser;
+  pdxcp_cdcl_parser_init(&parser);
+  parser.typedefs = &typedefs;
+  const std::string input{"typedef long T; T x;"};
+  // JSON
+  render_state state{&out_, pdxcp_cdcl_output_format_json};
+  auto status = pdxcp_cdcl_buf_parse_all(
+    &parser, input.c_str(), input.size(), render, &state
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    R"({"iden":"T","typedef":true,)"
+    R"("type":[{"kind":"type","quals":[],"name":"long"}]})" "\n"
+    R"({"iden":"x",)"
+    R"("type":[{"kind":"type","quals":[],"name":"T","typedef":true}]})" "\n",
+    output()
+  );
+  // TLV
+  out_.size = 0;
+  state.format = pdxcp_cdcl_output_format_tlv;
+  status = pdxcp_cdcl_buf_parse_all(
+    &parser, input.c_str(), input.size(), render, &state
+  );
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  const std::string expected{
+    "\x01\x00\x00\x00\x12"
+    "\x02\x00\x00\x00\x01" "T"
+    // empty typedef marker
+    "\x03\x00\x00\x00\x00"
+    "\x13\x00\x00\x00\x02" "\x00\x04"
+    "\x01\x00\x00\x00\x0e"
+    "\x02\x00\x00\x00\x01" "x"
+    // typedef name
+    "\x13\x00\x00\x00\x03" "\x00\x09" "T",
+    5 + 6 + 5 + 7 + 5 + 6 + 8
+  };
+  EXPECT_EQ(expected, output());
+  pdxcp_cdcl_parser_destroy(&parser);
+  pdxcp_cdcl_typedefs_destroy(&typedefs);
+}
+
+}  // namespace
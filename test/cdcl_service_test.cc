@@ -0,0 +1,253 @@
+/**
+ * @file cdcl_service_test.cc
+ * @author Derek Huang
+ * @brief cdcl_service.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_service.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/cdcl_parser.h"
+
+namespace {
+
+/**
+ * Base test fixture for service tests.
+ *
+ * A worker serves one end of a socket pair on a separate thread while the
+ * test sends requests on the other end.
+ */
+class ServiceTest : public ::testing::Test {
+protected:
+  /**
+   * Worker cache capacity.
+   */
+  static constexpr std::size_t cache_size_ = 64;
+
+  /**
+   * Ctor.
+   *
+   * Creates the socket pair and starts serving the server end.
+   */
+  ServiceTest()
+  {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+      throw std::runtime_error{"socketpair() failed"};
+    client_ = fds[0];
+    server_ = fds[1];
+    pdxcp_cdcl_service_worker_init(&worker_, cache_size_);
+    pdxcp_cdcl_service_response_init(&response_);
+    thread_ = std::thread{
+      [this] { serve_ok_ = pdxcp_cdcl_service_serve(&worker_, server_); }
+    };
+  }
+
+  /**
+   * Dtor.
+   */
+  ~ServiceTest()
+  {
+    stop();
+    pdxcp_cdcl_service_response_destroy(&response_);
+    pdxcp_cdcl_service_worker_destroy(&worker_);
+    close(server_);
+  }
+
+  /**
+   * Close the client end and wait for the worker to finish serving.
+   */
+  void stop()
+  {
+    if (!thread_.joinable())
+      return;
+    close(client_);
+    thread_.join();
+  }
+
+  /**
+   * Send a request, returning `true` on success.
+   *
+   * @param input Input declarations
+   */
+  bool request(const std::string& input)
+  {
+    return pdxcp_cdcl_service_request(
+      client_, input.c_str(), input.size(), &response_
+    );
+  }
+
+  /**
+   * Return the rendered text from the last response.
+   */
+  auto text() const
+  {
+    return std::string(
+      reinterpret_cast<const char*>(response_.data.data), response_.text_size
+    );
+  }
+
+  /**
+   * Return the error text from the last response.
+   */
+  auto error() const
+  {
+    return std::string(
+      reinterpret_cast<const char*>(response_.data.data) + response_.text_size,
+      response_.data.size - response_.text_size
+    );
+  }
+
+  int client_;
+  int server_;
+  pdxcp_cdcl_service_worker worker_;
+  pdxcp_cdcl_service_response response_;
+  std::thread thread_;
+  bool serve_ok_ = false;
+};
+
+/**
+ * Test that many requests are served on one connection with a warm cache.
+ */
+TEST_F(ServiceTest, RequestTest)
+{
+  ASSERT_TRUE(request("char *argv[]; int (*f)(double);")) <<
+    std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, response_.status);
+  EXPECT_EQ(2u, response_.n_decls);
+  EXPECT_EQ(
+    "argv: array[] of pointer to char\n"
+    "f: pointer to function(double) returning int\n",
+    text()
+  );
+  EXPECT_EQ("", error());
+  // same declarations again are served from the cache
+  ASSERT_TRUE(request("char*argv[];")) << std::strerror(errno);
+  EXPECT_EQ("argv: array[] of pointer to char\n", text());
+  ASSERT_TRUE(request("")) << std::strerror(errno);
+  EXPECT_EQ(0u, response_.n_decls);
+  EXPECT_EQ("", text());
+  stop();
+  EXPECT_TRUE(serve_ok_);
+  EXPECT_EQ(3u, worker_.n_requests);
+  EXPECT_EQ(1u, worker_.cache.hits);
+}
+
+/**
+ * Test that parse errors are reported without ending the connection.
+ */
+TEST_F(ServiceTest, ErrorTest)
+{
+  ASSERT_TRUE(request("int x; int bad z; int y;")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, response_.status);
+  EXPECT_EQ(1u, response_.n_decls);
+  EXPECT_EQ("x: int\n", text());
+  EXPECT_EQ("Incomplete declaration for identifier bad", error());
+  EXPECT_EQ(std::strlen("int x; int bad "), response_.err_offset);
+  // lexer errors report the lexer status and token text
+  ASSERT_TRUE(request("int @;")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_lexer_err, response_.status);
+  EXPECT_NE(std::string::npos, error().find("with text"));
+  // unterminated declarations report the end of input
+  ASSERT_TRUE(request("int x; int y")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_eof, response_.status);
+  EXPECT_EQ(1u, response_.n_decls);
+  EXPECT_EQ("Input ended before the end of the declaration", error());
+  ASSERT_TRUE(request("long z;")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, response_.status);
+  EXPECT_EQ("z: long\n", text());
+  stop();
+  EXPECT_TRUE(serve_ok_);
+}
+
+/**
+ * Test that typedef names are types in later requests on the same connection.
+ */
+TEST_F(ServiceTest, TypedefTest)
+{
+  ASSERT_TRUE(request("typedef unsigned long word;")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, response_.status);
+  EXPECT_EQ("word: typedef for unsigned long\n", text());
+  ASSERT_TRUE(request("word *w; word *w;")) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_ok, response_.status);
+  EXPECT_EQ("w: pointer to word\nw: pointer to word\n", text());
+  stop();
+  EXPECT_TRUE(serve_ok_);
+  // typedef names do not carry over to the next connection
+  int fds[2];
+  ASSERT_FALSE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) <<
+    std::strerror(errno);
+  std::thread thread{
+    [this, &fds] { serve_ok_ = pdxcp_cdcl_service_serve(&worker_, fds[1]); }
+  };
+  const std::string input{"word *w;"};
+  EXPECT_TRUE(
+    pdxcp_cdcl_service_request(fds[0], input.c_str(), input.size(), &response_)
+  ) << std::strerror(errno);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, response_.status);
+  close(fds[0]);
+  thread.join();
+  close(fds[1]);
+  EXPECT_TRUE(serve_ok_);
+}
+
+/**
+ * Test that an oversized request ends the connection.
+ */
+TEST_F(ServiceTest, OversizeTest)
+{
+  // header claiming one byte more than the maximum
+  unsigned char header[] = {0x01, 0x00, 0x00, 0x01};
+  ASSERT_EQ(
+    static_cast<ssize_t>(sizeof header),
+    write(client_, header, sizeof header)
+  );
+  stop();
+  EXPECT_FALSE(serve_ok_);
+  EXPECT_EQ(0u, worker_.n_requests);
+}
+
+/**
+ * Test that a receive timeout ends idle connections but not partial requests.
+ */
+TEST(ServiceTimeoutTest, IdleTest)
+{
+  int fds[2];
+  ASSERT_FALSE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) <<
+    std::strerror(errno);
+  timeval tv{0, 50000};
+  ASSERT_FALSE(setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv)) <<
+    std::strerror(errno);
+  pdxcp_cdcl_service_worker worker;
+  pdxcp_cdcl_service_worker_init(&worker, 0);
+  // idle between requests is treated like a close by the peer
+  EXPECT_TRUE(pdxcp_cdcl_service_serve(&worker, fds[1])) <<
+    std::strerror(errno);
+  // stalling partway through a request header is an error
+  unsigned char partial[] = {0x00, 0x00};
+  ASSERT_EQ(
+    static_cast<ssize_t>(sizeof partial),
+    write(fds[0], partial, sizeof partial)
+  );
+  EXPECT_FALSE(pdxcp_cdcl_service_serve(&worker, fds[1]));
+  EXPECT_EQ(ETIMEDOUT, errno);
+  EXPECT_EQ(0u, worker.n_requests);
+  pdxcp_cdcl_service_worker_destroy(&worker);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+}  // namespace
@@ -0,0 +1,260 @@
+/**
+ * @file cdcl_test.cc
+ * @author Derek Huang
+ * @brief cdcl.hh unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl.hh"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+#include "testing.hh"
+
+namespace {
+
+// parsed and described entirely at compile time
+constexpr auto argv_decls = pdxcp::cdcl::parse_literal("const char *argv[10];");
+static_assert(argv_decls.size() == 1);
+static_assert(argv_decls[0].iden == "argv");
+static_assert(
+  argv_decls.node_at(argv_decls[0].node).kind == pdxcp_cdcl_decl_kind_array
+);
+static_assert(argv_decls.node_at(argv_decls[0].node).size == 10);
+static_assert(
+  pdxcp::cdcl::describe(argv_decls).view() ==
+    "argv: array[10] of pointer to const char\n"
+);
+static_assert(
+  pdxcp::cdcl::describe_literal("int (*f)(char, struct s *p);").view() ==
+    "f: pointer to function(char, p: pointer to struct s) returning int\n"
+);
+// 0x numbers are hexadecimal
+static_assert(
+  pdxcp::cdcl::describe_literal("int a[0x10];").view() ==
+    "a: array[16] of int\n"
+);
+
+/**
+ * Test fixture comparing compile-time parsing with the C parser.
+ */
+class LiteralTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  LiteralTest()
+  {
+    pdxcp_cdcl_parser_init(&parser_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~LiteralTest()
+  {
+    pdxcp_cdcl_parser_destroy(&parser_);
+  }
+
+  /**
+   * Parse callback appending the description of each declaration.
+   *
+   * @param parser Parser state
+   * @param status Parser status for the declaration
+   * @param decl Parsed declaration, `NULL` on error
+   * @param data Address of the `std::string` output
+   * @returns `true` to continue parsing, `false` on error
+   */
+  static bool append_decl(
+    pdxcp_cdcl_parser* parser,
+    pdxcp_cdcl_parser_status status,
+    const pdxcp_cdcl_decl* decl,
+    void* data)
+  {
+    if (!decl)
+      return false;
+    parser->buf.size = 0;
+    if (!PDXCP_CDCL_PARSER_OK(pdxcp_cdcl_decl_render(decl, &parser->buf)))
+      return false;
+    *static_cast<std::string*>(data) += pdxcp::testing::to_string(parser->buf);
+    return PDXCP_CDCL_PARSER_OK(status);
+  }
+
+  /**
+   * Return the C parser's description of the given input.
+   *
+   * @param input Input declarations
+   * @param status Address to write the parser status to
+   */
+  std::string describe_c(const std::string& input, pdxcp_cdcl_parser_status& status)
+  {
+    std::string output;
+    status = pdxcp_cdcl_buf_parse_all(
+      &parser_, input.c_str(), input.size(), append_decl, &output
+    );
+    return output;
+  }
+
+  /**
+   * Check that the compile-time and C parsers describe a literal the same way.
+   *
+   * @tparam N Size of the string literal, including the null terminator
+   *
+   * @param input String literal
+   */
+  template <std::size_t N>
+  void expect_same(const char (&input)[N])
+  {
+    pdxcp_cdcl_parser_status status;
+    auto expected = describe_c(input, status);
+    ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+      pdxcp_cdcl_parser_status_string(status);
+    EXPECT_EQ(expected, pdxcp::cdcl::describe_literal(input).view()) <<
+      "input: " << input;
+  }
+
+  /**
+   * Check that the compile-time and C parsers fail the same way on a literal.
+   *
+   * @tparam N Size of the string literal, including the null terminator
+   *
+   * @param input String literal
+   */
+  template <std::size_t N>
+  void expect_same_error(const char (&input)[N])
+  {
+    pdxcp_cdcl_parser_status status;
+    describe_c(input, status);
+    ASSERT_FALSE(PDXCP_CDCL_PARSER_OK(status)) << "input: " << input;
+    try {
+      pdxcp::cdcl::parse_literal(input);
+      ADD_FAILURE() << "input: " << input << " did not throw";
+    }
+    catch (const pdxcp::cdcl::parse_error& exc) {
+      EXPECT_EQ(status, exc.status()) << "input: " << input << ", status: " <<
+        pdxcp_cdcl_parser_status_string(exc.status()) << ", what: " <<
+        exc.what();
+      EXPECT_EQ(parser_.errinfo.parser.error, exc.error()) << "input: " <<
+        input << ", error: " << pdxcp_cdcl_parser_error_string(exc.error());
+    }
+  }
+
+  pdxcp_cdcl_parser parser_;
+};
+
+/**
+ * Test that descriptions match those from the C parser.
+ */
+TEST_F(LiteralTest, DescribeTest)
+{
+  expect_same("int **x;");
+  expect_same("volatile unsigned long *const volatile p[][4];");
+  expect_same("struct my_struct_1 **z; enum e g();");
+  expect_same("int (*x[10])(char *, double);");
+  expect_same("void (*signal(int sig, void (*func)(int)))(int);");
+  expect_same("char (*(*x())[5])();");
+  expect_same("long a[0x10]; /* comment */ double b[7] // trailing\n;");
+  expect_same("char c[0x19];");
+  expect_same("char c[0xfF];");
+  expect_same("int f(int (*)(long), const char *const);");
+  expect_same("");
+}
+
+/**
+ * Test that errors match those from the C parser.
+ */
+TEST_F(LiteralTest, ErrorTest)
+{
+  expect_same_error("*y;");
+  expect_same_error("double *yyy * x;");
+  expect_same_error("enum my_enum * [ const volatile abc;");
+  expect_same_error("const double ((**(*x));");
+  expect_same_error("const volatile int ((**(*x)))));");
+  expect_same_error("volatile void *x[100[];");
+  expect_same_error("unsigned int z[88]]];");
+  expect_same_error("double **a[100][];");
+  expect_same_error("int f(int)[10];");
+  expect_same_error("int (f(void))[3];");
+  expect_same_error("int (a[3])(void);");
+  expect_same_error("int (f(void))(void);");
+  expect_same_error("int f(int,);");
+  expect_same_error("int f(void, void);");
+  expect_same_error("double h(int x y);");
+  expect_same_error("int f(int;");
+  expect_same_error("signed double d;");
+  expect_same_error("int char c;");
+  expect_same_error("int x[0x];");
+  expect_same_error("int @;");
+  expect_same_error("int x");
+}
+
+/**
+ * Test that parse errors report the offset of the offending token.
+ */
+TEST_F(LiteralTest, OffsetTest)
+{
+  try {
+    pdxcp::cdcl::parse_literal("int x; char y[10] z;");
+    FAIL() << "parse_literal did not throw";
+  }
+  catch (const pdxcp::cdcl::parse_error& exc) {
+    EXPECT_EQ(pdxcp_cdcl_parser_error_incomplete, exc.error());
+    EXPECT_EQ(18u, exc.offset());
+  }
+}
+
+/**
+ * Test that runtime parsing reuses the output string across declarations.
+ */
+TEST(ParseTest, ReuseTest)
+{
+  std::string text;
+  auto status = pdxcp::cdcl::parse("int x;", text);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ("x: int\n", text);
+  // longer description grows the string
+  std::string_view input{"const char *(*handlers[16])(int, void *);int y"};
+  status = pdxcp::cdcl::parse(input.substr(0, input.size() - 5), text);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(
+    "handlers: array[16] of pointer to function(int, pointer to void) "
+      "returning pointer to const char\n",
+    text
+  );
+  // shorter description reuses the storage
+  auto data = text.data();
+  status = pdxcp::cdcl::parse("long z;", text);
+  ASSERT_EQ(pdxcp_cdcl_parser_status_ok, status) << "Parser status: " <<
+    pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ("z: long\n", text);
+  EXPECT_EQ(data, text.data());
+}
+
+/**
+ * Test that runtime parse errors leave the output string empty.
+ */
+TEST(ParseTest, ErrorTest)
+{
+  std::string text{"stale"};
+  pdxcp_cdcl_parser_errinfo errinfo;
+  auto status = pdxcp::cdcl::parse("char y[10] z;", text, &errinfo);
+  EXPECT_EQ(pdxcp_cdcl_parser_status_parse_err, status) << "Parser " <<
+    "status: " << pdxcp_cdcl_parser_status_string(status);
+  EXPECT_EQ(11u, errinfo.offset);
+  EXPECT_TRUE(text.empty());
+  // empty input has nothing to parse
+  status = pdxcp::cdcl::parse({}, text);
+  EXPECT_FALSE(PDXCP_CDCL_PARSER_OK(status));
+  EXPECT_TRUE(text.empty());
+}
+
+}  // namespace
@@ -0,0 +1,84 @@
+/**
+ * @file cdcl_typedefs_test.cc
+ * @author Derek Huang
+ * @brief cdcl_typedefs.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/cdcl_typedefs.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * Test fixture managing a typedef name table.
+ */
+class TypedefsTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  TypedefsTest()
+  {
+    pdxcp_cdcl_typedefs_init(&typedefs_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~TypedefsTest()
+  {
+    pdxcp_cdcl_typedefs_destroy(&typedefs_);
+  }
+
+  pdxcp_cdcl_typedefs typedefs_;
+};
+
+/**
+ * Test that names are found once added and that duplicates are ignored.
+ */
+TEST_F(TypedefsTest, AddFindTest)
+{
+  EXPECT_FALSE(pdxcp_cdcl_typedefs_find(&typedefs_, "size_t"));
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs_, "size_t"));
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs_, "FILE"));
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs_, "size_t"));
+  EXPECT_EQ(2u, typedefs_.names.size);
+  EXPECT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs_, "size_t"));
+  EXPECT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs_, "FILE"));
+  EXPECT_FALSE(pdxcp_cdcl_typedefs_find(&typedefs_, "size"));
+  EXPECT_FALSE(pdxcp_cdcl_typedefs_find(&typedefs_, "file"));
+  // names are copied into the table
+  std::string name{"uint32_t"};
+  ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs_, name.c_str()));
+  name[0] = 'x';
+  EXPECT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs_, "uint32_t"));
+  EXPECT_FALSE(pdxcp_cdcl_typedefs_find(&typedefs_, name.c_str()));
+}
+
+/**
+ * Test that all names are still found after the table grows many times.
+ */
+TEST_F(TypedefsTest, GrowTest)
+{
+  constexpr unsigned n_names = 10000;
+  for (unsigned i = 0; i < n_names; i++) {
+    auto name = "type" + std::to_string(i) + "_t";
+    ASSERT_TRUE(pdxcp_cdcl_typedefs_add(&typedefs_, name.c_str()));
+  }
+  EXPECT_EQ(n_names, typedefs_.names.size);
+  // table is kept within its maximum load
+  EXPECT_LE(
+    typedefs_.names.size, PDXCP_STRMAP_MAX_LOAD(typedefs_.names.capacity)
+  );
+  for (unsigned i = 0; i < n_names; i++) {
+    auto name = "type" + std::to_string(i) + "_t";
+    ASSERT_TRUE(pdxcp_cdcl_typedefs_find(&typedefs_, name.c_str())) << name;
+  }
+  EXPECT_FALSE(pdxcp_cdcl_typedefs_find(&typedefs_, "type10000_t"));
+}
+
+}  // namespace
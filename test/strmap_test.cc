@@ -0,0 +1,353 @@
+/**
+ * @file strmap_test.cc
+ * @author Derek Huang
+ * @brief strmap.h unit tests
+ * @copyright MIT License
+ */
+
+#include "pdxcp/strmap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * Return the file path used for the given index.
+ *
+ * @param i Path index
+ */
+std::string path(std::size_t i)
+{
+  return "/usr/local/lib/pkg" + std::to_string(i % 97) + "/lib" +
+    std::to_string(i) + ".so";
+}
+
+/**
+ * Test fixture managing a string map.
+ */
+class StrmapTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  StrmapTest()
+  {
+    pdxcp_strmap_init(&map_);
+  }
+
+  /**
+   * Dtor.
+   */
+  ~StrmapTest()
+  {
+    pdxcp_strmap_destroy(&map_);
+  }
+
+  pdxcp_strmap map_;
+};
+
+/**
+ * Test that inserted keys are found and that reinsertion finds the same entry.
+ */
+TEST_F(StrmapTest, InsertFindTest)
+{
+  EXPECT_EQ(nullptr, pdxcp_strmap_find(&map_, "/usr/bin/ls"));
+  bool inserted;
+  auto ls = pdxcp_strmap_insert(&map_, "/usr/bin/ls", &inserted);
+  ASSERT_NE(nullptr, ls);
+  EXPECT_TRUE(inserted);
+  EXPECT_STREQ("/usr/bin/ls", ls->key);
+  EXPECT_EQ(pdxcp_strmap_hash_default("/usr/bin/ls", 11), ls->hash);
+  EXPECT_EQ(nullptr, ls->value);
+  ls->value = &map_;
+  auto cc = pdxcp_strmap_insert(&map_, "/usr/bin/cc", &inserted);
+  ASSERT_NE(nullptr, cc);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(ls, pdxcp_strmap_insert(&map_, "/usr/bin/ls", &inserted));
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(2u, map_.size);
+  EXPECT_EQ(ls, pdxcp_strmap_find(&map_, "/usr/bin/ls"));
+  EXPECT_EQ(&map_, ls->value);
+  EXPECT_EQ(cc, pdxcp_strmap_find(&map_, "/usr/bin/cc"));
+  EXPECT_EQ(nullptr, pdxcp_strmap_find(&map_, "/usr/bin/l"));
+  // keys are copied into the map
+  std::string key{"/etc/hosts"};
+  ASSERT_NE(nullptr, pdxcp_strmap_insert(&map_, key.c_str(), nullptr));
+  key[1] = 'x';
+  EXPECT_NE(nullptr, pdxcp_strmap_find(&map_, "/etc/hosts"));
+  EXPECT_EQ(nullptr, pdxcp_strmap_find(&map_, key.c_str()));
+}
+
+/**
+ * Test that erased keys are no longer found and their values are returned.
+ */
+TEST_F(StrmapTest, EraseTest)
+{
+  int value;
+  ASSERT_NE(nullptr, pdxcp_strmap_insert(&map_, "/a", nullptr));
+  auto b = pdxcp_strmap_insert(&map_, "/b", nullptr);
+  ASSERT_NE(nullptr, b);
+  b->value = &value;
+  void* erased = nullptr;
+  EXPECT_FALSE(pdxcp_strmap_erase(&map_, "/c", &erased));
+  EXPECT_TRUE(pdxcp_strmap_erase(&map_, "/b", &erased));
+  EXPECT_EQ(&value, erased);
+  EXPECT_EQ(1u, map_.size);
+  EXPECT_EQ(nullptr, pdxcp_strmap_find(&map_, "/b"));
+  EXPECT_NE(nullptr, pdxcp_strmap_find(&map_, "/a"));
+  EXPECT_FALSE(pdxcp_strmap_erase(&map_, "/b", nullptr));
+  // erased keys can be inserted again, reusing the erased entry's memory
+  bool inserted;
+  EXPECT_EQ(b, pdxcp_strmap_insert(&map_, "/b", &inserted));
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(nullptr, b->value);
+  EXPECT_EQ(2u, map_.size);
+  // same for a different key of similar length
+  ASSERT_TRUE(pdxcp_strmap_erase(&map_, "/b", nullptr));
+  EXPECT_EQ(b, pdxcp_strmap_insert(&map_, "/cc", nullptr));
+  EXPECT_STREQ("/cc", b->key);
+  EXPECT_NE(nullptr, pdxcp_strmap_find(&map_, "/cc"));
+}
+
+/**
+ * Test that deleted slots are reclaimed instead of growing the map.
+ */
+TEST_F(StrmapTest, ChurnTest)
+{
+  constexpr std::size_t n_keys = 100;
+  for (std::size_t i = 0; i < n_keys; i++)
+    ASSERT_NE(nullptr, pdxcp_strmap_insert(&map_, path(i).c_str(), nullptr));
+  // replace the keys one by one many times over
+  std::size_t max_deleted = 0;
+  for (std::size_t i = n_keys; i < 100 * n_keys; i++) {
+    ASSERT_TRUE(pdxcp_strmap_erase(&map_, path(i - n_keys).c_str(), nullptr));
+    ASSERT_NE(nullptr, pdxcp_strmap_insert(&map_, path(i).c_str(), nullptr));
+    ASSERT_EQ(n_keys, map_.size);
+    ASSERT_LE(
+      map_.size + map_.n_deleted, PDXCP_STRMAP_MAX_LOAD(map_.capacity)
+    );
+    max_deleted = (map_.n_deleted > max_deleted) ? map_.n_deleted : max_deleted;
+  }
+  // deleted slots did build up but the capacity stayed bounded
+  EXPECT_LT(0u, max_deleted);
+  EXPECT_GE(4 * n_keys, map_.capacity);
+  for (std::size_t i = 99 * n_keys; i < 100 * n_keys; i++)
+    EXPECT_NE(nullptr, pdxcp_strmap_find(&map_, path(i).c_str())) << path(i);
+  EXPECT_EQ(nullptr, pdxcp_strmap_find(&map_, path(99 * n_keys - 1).c_str()));
+}
+
+/**
+ * Test that the map grows to keep its load factor and probes stay short.
+ */
+TEST_F(StrmapTest, GrowTest)
+{
+  constexpr std::size_t n_keys = 100000;
+  for (std::size_t i = 0; i < n_keys; i++) {
+    auto entry = pdxcp_strmap_insert(&map_, path(i).c_str(), nullptr);
+    ASSERT_NE(nullptr, entry) << path(i);
+    // entry addresses are stable across resizes
+    entry->value = reinterpret_cast<void*>(i + 1);
+  }
+  EXPECT_EQ(n_keys, map_.size);
+  EXPECT_LE(map_.size, PDXCP_STRMAP_MAX_LOAD(map_.capacity));
+  // entries are almost always in or near their home group
+  auto group_mask = map_.capacity / PDXCP_STRMAP_GROUP_SIZE - 1;
+  std::size_t max_probe = 0;
+  for (std::size_t i = 0; i < map_.capacity; i++) {
+    if (!PDXCP_STRMAP_CTRL_FULL(map_.ctrl[i]))
+      continue;
+    auto home = (map_.entries[i]->hash >> 7) & group_mask;
+    auto probe = ((i / PDXCP_STRMAP_GROUP_SIZE - home) & group_mask) + 1;
+    max_probe = (probe > max_probe) ? probe : max_probe;
+  }
+  EXPECT_GE(16u, max_probe);
+  for (std::size_t i = 0; i < n_keys; i++) {
+    auto entry = pdxcp_strmap_find(&map_, path(i).c_str());
+    ASSERT_NE(nullptr, entry) << path(i);
+    EXPECT_EQ(reinterpret_cast<void*>(i + 1), entry->value);
+  }
+  // erase every other key
+  for (std::size_t i = 0; i < n_keys; i += 2)
+    ASSERT_TRUE(pdxcp_strmap_erase(&map_, path(i).c_str(), nullptr));
+  EXPECT_EQ(n_keys / 2, map_.size);
+  for (std::size_t i = 0; i < n_keys; i++)
+    EXPECT_EQ(i % 2 != 0, !!pdxcp_strmap_find(&map_, path(i).c_str()));
+}
+
+/**
+ * Test that a map using a non-default hash behaves the same.
+ */
+TEST_F(StrmapTest, InitHashTest)
+{
+  pdxcp_strmap_destroy(&map_);
+  pdxcp_strmap_init_hash(&map_, pdxcp_strmap_hash_fnv1a);
+  for (std::size_t i = 0; i < 1000; i++)
+    ASSERT_NE(nullptr, pdxcp_strmap_insert(&map_, path(i).c_str(), nullptr));
+  EXPECT_EQ(1000u, map_.size);
+  auto entry = pdxcp_strmap_find(&map_, path(500).c_str());
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(
+    pdxcp_strmap_hash_fnv1a(path(500).c_str(), path(500).size()), entry->hash
+  );
+}
+
+/**
+ * Test fixture managing a concurrent string map.
+ */
+class StrmapSyncTest : public ::testing::Test {
+protected:
+  /**
+   * Ctor.
+   */
+  StrmapSyncTest()
+  {
+    // the shard count is small so that threads collide often
+    if (!pdxcp_strmap_sync_init(&map_, 3))
+      throw std::runtime_error{"pdxcp_strmap_sync_init failed"};
+  }
+
+  /**
+   * Dtor.
+   */
+  ~StrmapSyncTest()
+  {
+    pdxcp_strmap_sync_destroy(&map_);
+  }
+
+  pdxcp_strmap_sync map_;
+};
+
+/**
+ * Test that insert-if-absent only stores the value of the first insertion.
+ */
+TEST_F(StrmapSyncTest, InsertFindTest)
+{
+  // shard count is rounded up to a power of two
+  EXPECT_EQ(4u, map_.n_shards);
+  int a, b;
+  EXPECT_EQ(nullptr, pdxcp_strmap_sync_find(&map_, "/usr/bin/ls"));
+  bool inserted;
+  auto ls = pdxcp_strmap_sync_insert(&map_, "/usr/bin/ls", &a, &inserted);
+  ASSERT_NE(nullptr, ls);
+  EXPECT_TRUE(inserted);
+  EXPECT_STREQ("/usr/bin/ls", ls->key);
+  // same default hash as the single-threaded map
+  EXPECT_EQ(pdxcp_strmap_hash_default("/usr/bin/ls", 11), ls->hash);
+  EXPECT_EQ(&a, ls->value);
+  EXPECT_EQ(ls, pdxcp_strmap_sync_insert(&map_, "/usr/bin/ls", &b, &inserted));
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(&a, ls->value);
+  EXPECT_EQ(ls, pdxcp_strmap_sync_find(&map_, "/usr/bin/ls"));
+  EXPECT_EQ(1u, pdxcp_strmap_sync_size(&map_));
+  void* erased = nullptr;
+  EXPECT_FALSE(pdxcp_strmap_sync_erase(&map_, "/usr/bin/cc", &erased));
+  EXPECT_TRUE(pdxcp_strmap_sync_erase(&map_, "/usr/bin/ls", &erased));
+  EXPECT_EQ(&a, erased);
+  EXPECT_EQ(nullptr, pdxcp_strmap_sync_find(&map_, "/usr/bin/ls"));
+  EXPECT_EQ(0u, pdxcp_strmap_sync_size(&map_));
+}
+
+/**
+ * Test that threads racing to insert the same keys all get the same entries.
+ */
+TEST_F(StrmapSyncTest, ConcurrentInsertTest)
+{
+  constexpr std::size_t n_threads = 8;
+  constexpr std::size_t n_keys = 20000;
+  // entries each thread got and the number of keys each thread inserted
+  std::vector<std::vector<pdxcp_strmap_entry*>> entries(n_threads);
+  std::vector<std::size_t> n_inserted(n_threads);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < n_threads; t++) {
+    threads.emplace_back(
+      [this, t, &entries, &n_inserted]
+      {
+        entries[t].resize(n_keys);
+        // each thread walks the keys from a different starting point
+        for (std::size_t j = 0; j < n_keys; j++) {
+          auto i = (j + t * n_keys / n_threads) % n_keys;
+          bool inserted;
+          entries[t][i] = pdxcp_strmap_sync_insert(
+            &map_, path(i).c_str(), &entries[t], &inserted
+          );
+          n_inserted[t] += inserted;
+          // an entry is never seen without the value it was inserted with
+          if (entries[t][i] && !entries[t][i]->value)
+            entries[t][i] = nullptr;
+        }
+      }
+    );
+  }
+  for (auto& thread : threads)
+    thread.join();
+  std::size_t total_inserted = 0;
+  for (auto n : n_inserted)
+    total_inserted += n;
+  EXPECT_EQ(n_keys, total_inserted);
+  EXPECT_EQ(n_keys, pdxcp_strmap_sync_size(&map_));
+  for (std::size_t i = 0; i < n_keys; i++) {
+    auto entry = pdxcp_strmap_sync_find(&map_, path(i).c_str());
+    ASSERT_NE(nullptr, entry) << path(i);
+    for (std::size_t t = 0; t < n_threads; t++)
+      ASSERT_EQ(entry, entries[t][i]) << path(i);
+  }
+}
+
+/**
+ * Test that the FNV-1a hash matches the published test vectors.
+ */
+TEST(StrmapHashTest, Fnv1aTest)
+{
+  EXPECT_EQ(0xcbf29ce484222325u, pdxcp_strmap_hash_fnv1a("", 0));
+  EXPECT_EQ(0xaf63dc4c8601ec8cu, pdxcp_strmap_hash_fnv1a("a", 1));
+  EXPECT_EQ(0x85944171f73967e8u, pdxcp_strmap_hash_fnv1a("foobar", 6));
+  // hashing piece by piece gives the same result
+  EXPECT_EQ(
+    0x85944171f73967e8u,
+    pdxcp_strmap_hash_fnv1a_update(
+      pdxcp_strmap_hash_fnv1a_update(PDXCP_STRMAP_FNV1A_OFFSET, "foo", 3),
+      "bar",
+      3
+    )
+  );
+}
+
+/**
+ * Test that each hash only reads the given bytes and separates prefixes.
+ *
+ * Every prefix length exercises a different path through wyhash, from the
+ * short key loads up to the three-lane bulk loop.
+ */
+TEST(StrmapHashTest, PrefixTest)
+{
+  const std::string path{
+    "/usr/lib/x86_64-linux-gnu/perl5/5.34/auto/List/Util/Util.so"
+    "/usr/lib/x86_64-linux-gnu/perl5/5.34/auto/Socket/Socket.so"
+  };
+  for (auto hash : {pdxcp_strmap_hash_fnv1a, pdxcp_strmap_hash_wyhash}) {
+    std::set<std::uint64_t> hashes;
+    for (std::size_t len = 0; len <= path.size(); len++) {
+      auto value = hash(path.c_str(), len);
+      // bytes past the length are ignored
+      EXPECT_EQ(value, hash(path.substr(0, len).c_str(), len)) << len;
+      hashes.insert(value);
+    }
+    EXPECT_EQ(path.size() + 1, hashes.size());
+  }
+  EXPECT_EQ(
+    pdxcp_strmap_hash_default(path.c_str(), path.size()),
+    (std::string{pdxcp_strmap_hash_default_name()} == "fnv1a") ?
+      pdxcp_strmap_hash_fnv1a(path.c_str(), path.size()) :
+      pdxcp_strmap_hash_wyhash(path.c_str(), path.size())
+  );
+}
+
+}  // namespace
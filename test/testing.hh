@@ -0,0 +1,96 @@
+/**
+ * @file testing.hh
+ * @author Derek Huang
+ * @brief C++ header for helpers shared by the unit tests
+ * @copyright MIT License
+ */
+
+#ifndef PDXCP_TEST_TESTING_HH_
+#define PDXCP_TEST_TESTING_HH_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "pdxcp/arena.h"
+#include "pdxcp/bvector.h"
+#include "pdxcp/cdcl_lexer.h"
+#include "pdxcp/cdcl_parser.h"
+
+namespace pdxcp {
+namespace testing {
+
+/**
+ * Arena wrapper class that ensures we never forget to free memory.
+ */
+class unique_arena {
+public:
+  /**
+   * Ctor.
+   *
+   * @param block_size Minimum usable bytes per block, zero for default
+   */
+  explicit unique_arena(std::size_t block_size = 0)
+  {
+    pdxcp_arena_init(&arena_, block_size);
+  }
+
+  /**
+   * Deleted copy ctor.
+   */
+  unique_arena(const unique_arena&) = delete;
+
+  /**
+   * Dtor.
+   */
+  ~unique_arena()
+  {
+    pdxcp_arena_destroy(&arena_);
+  }
+
+  /**
+   * Allow implicit conversion to pointer for working with C functions.
+   */
+  operator pdxcp_arena*() noexcept
+  {
+    return &arena_;
+  }
+
+private:
+  pdxcp_arena arena_;
+};
+
+/**
+ * Return the contents of a byte vector as a string.
+ *
+ * @param vec Byte vector
+ */
+inline std::string to_string(const pdxcp_bvector& vec)
+{
+  return {reinterpret_cast<const char*>(vec.data), vec.size};
+}
+
+/**
+ * Parse a single declaration from a string, throwing on error.
+ *
+ * @param arena Arena to allocate the declaration nodes from
+ * @param input Input declaration
+ */
+inline auto parse_decl(pdxcp_arena* arena, const std::string& input)
+{
+  pdxcp_cdcl_lexer_buf buf;
+  PDXCP_CDCL_LEXER_BUF_INIT(&buf, input.c_str(), input.size());
+  pdxcp_cdcl_decl decl;
+  auto status = pdxcp_cdcl_parse_decl_buf(&buf, arena, &decl, nullptr);
+  if (!PDXCP_CDCL_PARSER_OK(status))
+    throw std::runtime_error{
+      "Failed to parse \"" + input + "\": " +
+      pdxcp_cdcl_parser_status_string(status)
+    };
+  return decl;
+}
+
+}  // namespace testing
+}  // namespace pdxcp
+
+#endif  // PDXCP_TEST_TESTING_HH_